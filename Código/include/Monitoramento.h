@@ -2,15 +2,31 @@
 #define MONITORAMENTO_H
 
 #include <Arduino.h>
+#include "hal.h"
+#include "fusao.h"
 
-extern bool alarmeSensorPressao;
-extern bool alarmeSensorMovimento;
-extern bool alarmeSensorLuz;
-extern float medida;
-extern int distanciaCM;
-extern int leituraLDR;
+// Ultimas leituras dos sensores de alarme. Passada por copia (fila) para a tarefa de
+// rede, no lugar das antigas variaveis globais compartilhadas. Os alarmes por sensor e
+// o fundido saem das tabelas de fusao.h (compilarFusao() antes de iniciar).
+struct LeituraSensores
+{
+    bool alarmePressao;
+    bool alarmeMovimento;
+    bool alarmeLuz;
+    bool alarme;         // Fundido
+    uint8_t causaAlarme; // CausaAlarme
+    float medida; // kg
+    int distanciaCM; // -1: nada no alcance do sensor
+    int leituraLDR;
+    unsigned long instante; // millis() da leitura
+};
 
 void iniciarMonitoramento();
-void atualizarMonitoramento();
+// Retorna true quando algum sensor foi lido nesta chamada.
+bool atualizarMonitoramento();
+const LeituraSensores &leituraMonitoramento();
+// Qualquer tarefa; aplicado pela tarefa de sensores na proxima atualizacao. Antes de
+// iniciarMonitoramento() define o perfil inicial.
+void definirPerfilDistancia(PerfilDistancia perfil);
 
-#endif
\ No newline at end of file
+#endif
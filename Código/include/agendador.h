@@ -0,0 +1,113 @@
+#ifndef AGENDADOR_H
+#define AGENDADOR_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// AGENDADOR COOPERATIVO (RODA DE TEMPORIZADORES)
+// ====================================================================================
+// Trabalhos periodicos e de uma vez so, com resolucao de 1 ms, numa roda hierarquica
+// de 4 niveis de 64 posicoes (1 ms, 64 ms, 4 s e 4,4 min por posicao, 4,6 h no total).
+// Cada trabalho fica numa lista da posicao do seu prazo:
+//   - agendar, parar e executar custam O(1), sem varrer os outros trabalhos;
+//   - um trabalho de um nivel alto desce de nivel quando a roda chega a sua posicao,
+//     no maximo uma vez por nivel;
+//   - as posicoes vazias sao puladas pelos mapas de bits, entao um executar() depois
+//     de um tempo ocioso custa o numero de trabalhos vencidos, nao o de milissegundos.
+// msAteProximo() diz quanto a tarefa pode dormir sem atrasar nenhum trabalho.
+//
+// Cada trabalho acumula o atraso do inicio em relacao ao prazo, os periodos perdidos
+// (atrasos maiores que o periodo) e as execucoes mais longas que o seu orcamento.
+//
+// Cada agendador pertence a uma tarefa: todos os metodos sao chamados so por ela,
+// inclusive de dentro dos trabalhos.
+
+typedef void (*FuncaoTrabalho)(void *contexto);
+
+const uint16_t SEM_TRABALHO = 0xFFFF;
+
+struct EstatisticasTrabalho
+{
+    const char *nome;
+    unsigned long execucoes;
+    unsigned long perdidos;   // Periodos pulados por atraso
+    unsigned long estouros;   // Execucoes acima do orcamento
+    uint32_t atrasoMaximoMs;  // Inicio - prazo
+    uint32_t atrasoTotalMs;   // Para o atraso medio
+    uint32_t duracaoMaximaUs;
+    uint32_t duracaoTotalUs;
+};
+
+struct TrabalhoAgendado
+{
+    const char *nome;
+    FuncaoTrabalho funcao;
+    void *contexto;
+    uint32_t periodoMs;   // 0: uma vez so
+    uint32_t orcamentoUs; // 0: sem limite
+    uint32_t prazo;       // ms
+    uint16_t anterior;
+    uint16_t proximo;
+    uint16_t posicao;     // Nivel * 64 + indice na roda, ou a lista dos vencidos
+    uint8_t estado;
+    EstatisticasTrabalho estatisticas;
+};
+
+class Agendador
+{
+public:
+    static const uint8_t NIVEIS = 4;
+    static const uint8_t BITS_NIVEL = 6;
+    static const uint8_t POSICOES = 1 << BITS_NIVEL;
+
+    // Cria o trabalho parado. Retorna o id, ou SEM_TRABALHO sem espaco.
+    uint16_t registrar(const char *nome, FuncaoTrabalho funcao, void *contexto,
+                       uint32_t periodoMs = 0, uint32_t orcamentoUs = 0);
+
+    // Proxima execucao daqui a atrasoMs (a partir de millis()). Um trabalho ja agendado
+    // e remarcado; um periodico segue no periodo a partir dessa execucao.
+    bool agendar(uint16_t id, uint32_t atrasoMs);
+    bool parar(uint16_t id);
+    bool agendado(uint16_t id) const;
+
+    // Executa os trabalhos com prazo ate `agora`. Retorna quantos rodaram.
+    uint16_t executar(unsigned long agora);
+
+    // Milissegundos ate o proximo prazo (0: algum vencido), ou UINT32_MAX sem nenhum.
+    // Pode adiantar um pouco (a descida de nivel), nunca atrasar.
+    uint32_t msAteProximo(unsigned long agora) const;
+
+    uint16_t quantidade() const { return _quantidade; }
+    EstatisticasTrabalho estatisticas(uint16_t id) const;
+
+protected:
+    Agendador(TrabalhoAgendado *trabalhos, uint16_t capacidade);
+
+private:
+    TrabalhoAgendado *_trabalhos;
+    uint16_t _capacidade;
+    uint16_t _quantidade = 0;
+    uint32_t _atual = 0; // Proximo milissegundo ainda nao processado
+    bool _iniciado = false;
+    uint16_t _listas[NIVEIS * POSICOES + 1]; // A ultima: vencidos, em execucao
+    uint64_t _ocupadas[NIVEIS] = {};         // Bit por posicao com alguma lista
+
+    void inserir(uint16_t id);
+    void retirar(uint16_t id);
+    void descer(uint8_t nivel, uint8_t indice);
+    uint32_t distanciaProximo() const;
+    void rodar(uint16_t id, unsigned long agora);
+};
+
+// Agendador com espaco para N trabalhos, sem heap.
+template <uint16_t N>
+class AgendadorFixo : public Agendador
+{
+public:
+    AgendadorFixo() : Agendador(_espaco, N) {}
+
+private:
+    TrabalhoAgendado _espaco[N];
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef AMOSTRAGEM_H
+#define AMOSTRAGEM_H
+
+#include <Arduino.h>
+#include "quadroBinario.h"
+
+// ====================================================================================
+// AMOSTRAGEM DE ALTA TAXA
+// ====================================================================================
+// Alem dos alarmes, cada leitura dos sensores pode ser guardada com o seu instante num
+// anel por sensor (FilaSpsc: a tarefa de sensores produz, a de rede consome). A tarefa
+// de rede junta as amostras em quadros de ate N (quadroBinario.h) e publica um quadro
+// cheio, ou o que houver quando a primeira amostra passa da idade maxima. Assim a taxa
+// de mensagens no broker fica perto de (amostras/s) / N.
+//
+// As amostras nao passam pela caixa de saida: sem broker o quadro e descartado e o
+// anel cheio descarta as amostras novas, sem nunca segurar a tarefa de sensores.
+
+enum SensorAmostrado
+{
+    AMOSTRA_PRESSAO,   // Gramas
+    AMOSTRA_DISTANCIA, // mm (-1: nada no alcance)
+    AMOSTRA_LUZ,       // Contagem do ADC (12 bits), sobreamostrada e filtrada
+    NUM_SENSORES_AMOSTRADOS
+};
+
+struct ConfiguracaoAmostragem
+{
+    bool ativa;                // false: so os alarmes
+    uint8_t amostrasPorQuadro; // 1 a QUADRO_MAX_AMOSTRAS
+    uint16_t idadeMaximaMs;    // Publica um quadro incompleto depois disso
+};
+
+struct EstatisticasAmostragem
+{
+    unsigned long amostras[NUM_SENSORES_AMOSTRADOS];
+    unsigned long descartadas[NUM_SENSORES_AMOSTRADOS]; // Anel cheio
+    unsigned long quadros;
+};
+
+// Sem amostras. Os intervalos de leitura de cada sensor sao da configuracao em tempo de
+// execucao (configuracao.h): por padrao a pressao a cada conversao do HX711 (10 por
+// segundo, ja filtrada), o movimento a cada medida do VL53L0X e a luz a cada 500 ms.
+const ConfiguracaoAmostragem AMOSTRAGEM_PADRAO = {false, 1, 1000};
+
+// Trocar a configuracao apenas antes das tarefas comecarem (ou com elas paradas).
+void configurarAmostragem(const ConfiguracaoAmostragem &configuracao);
+const ConfiguracaoAmostragem &configuracaoAmostragem();
+
+// Tarefa de sensores: guarda a amostra se a amostragem estiver ativa.
+void registrarAmostra(SensorAmostrado sensor, int32_t valor, unsigned long instante);
+
+// Tarefa de rede: esvazia o anel do sensor no quadro em montagem e retorna true (com
+// `quadro` preenchido, menos o cabecalho comum) quando ha um quadro pronto.
+bool montarQuadroAmostras(SensorAmostrado sensor, unsigned long agora, QuadroAmostras &quadro);
+
+EstatisticasAmostragem estatisticasAmostragem();
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <Arduino.h>
+
+// Backoff exponencial limitado com jitter: a espera dobra a cada falha seguida, de
+// `minimo` ate `maximo`. Metade da espera e fixa e a outra metade e sorteada, para que
+// varios dispositivos derrubados pela mesma queda nao tentem no mesmo instante.
+inline unsigned long esperaBackoff(unsigned long minimo, unsigned long maximo, uint8_t falhas, uint32_t sorteio)
+{
+    unsigned long espera = maximo;
+    if (falhas < 16 && (minimo << falhas) < maximo)
+        espera = minimo << falhas;
+
+    return espera / 2 + sorteio % (espera / 2 + 1);
+}
+
+#endif
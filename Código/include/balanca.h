@@ -0,0 +1,35 @@
+#ifndef BALANCA_H
+#define BALANCA_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// BALANCA (HX711) COM FILTRO CONTINUO
+// ====================================================================================
+// Cada conversao do HX711 chega pelo callback de halBalancaContinua() e passa por um
+// filtro em ponto fixo: mediana movel de 5 conversoes (descarta picos isolados) seguida
+// de um IIR de primeira ordem com alfa = 1/4 (constante de tempo de ~4 conversoes, 0,4 s
+// a 10 amostras/s). O peso filtrado fica publicado em variaveis atomicas, entao
+// qualquer tarefa le o valor atual em O(1), sem esperar por conversao nenhuma.
+//
+// Substitui o antigo get_units(5), que bloqueava o loop() por 5 conversoes (~500 ms).
+
+struct LeituraBalanca
+{
+    int32_t gramas;         // Peso filtrado menos a tara
+    uint32_t conversoes;    // Conversoes recebidas desde o inicio (muda a cada valor novo)
+    unsigned long instante; // millis() da ultima conversao
+};
+
+// Inicia a leitura continua; contagensPorKg e a calibracao da celula de carga.
+bool iniciarBalanca(int pinoDout, int pinoSck, int32_t contagensPorKg);
+
+// Troca a calibracao com a leitura em andamento; o peso atual e recalculado na hora.
+bool calibrarBalanca(int32_t contagensPorKg);
+
+// Usa o valor filtrado atual como zero. Chamar depois de o filtro assentar.
+void tararBalanca();
+
+LeituraBalanca leituraBalanca();
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef CAIXA_DE_SAIDA_H
+#define CAIXA_DE_SAIDA_H
+
+#include <Arduino.h>
+#include "hal.h"
+
+// ====================================================================================
+// CAIXA DE SAIDA PERSISTENTE (STORE-AND-FORWARD)
+// ====================================================================================
+// Todo evento e gravado na flash (particao "caixa", via halFlash*) com um numero de
+// sequencia antes de ir ao broker, e so sai da caixa depois de publicado. Assim uma
+// queda do Wi-Fi ou do broker, ou um reinicio da placa, nao perde eventos de acesso.
+//
+// A particao e um anel de setores gravado so para frente (log):
+//   - cada registro e cabecalho (12 bytes) + dados, e nunca atravessa um setor;
+//   - um setor so e apagado quando a escrita volta a ele; se ainda houver registros
+//     pendentes nele, os mais antigos sao perdidos (e contados) para caber os novos;
+//   - a entrega e marcada zerando um byte do ultimo registro de cada lote, sem apagar.
+// Cada byte de evento e gravado uma unica vez e cada setor e apagado uma vez por volta
+// do anel, o que limita o desgaste da flash.
+//
+// A entrega e "pelo menos uma vez": um reinicio no meio de um lote reenvia esse lote.
+// O consumidor descarta repetidos pela sequencia.
+
+const uint16_t CAIXA_TAMANHO_MAXIMO = 64; // Dados por registro
+
+struct ConfiguracaoCaixaDeSaida
+{
+    uint8_t loteMaximo;       // Registros publicados por lote
+    uint16_t intervaloLoteMs; // Espera minima entre dois lotes
+};
+
+struct EstatisticasCaixaDeSaida
+{
+    unsigned long anexados;
+    unsigned long entregues;
+    unsigned long perdidos;     // Sobrescritos antes da entrega (anel cheio)
+    unsigned long lotes;
+    unsigned long falhasFlash;
+};
+
+// Publica um registro; retorna false para interromper o lote (ele sera repetido).
+typedef bool (*PublicarRegistro)(uint32_t sequencia, const uint8_t *dados, uint16_t tamanho);
+
+class CaixaDeSaida
+{
+public:
+    explicit CaixaDeSaida(const ConfiguracaoCaixaDeSaida &configuracao) : _configuracao(configuracao) {}
+
+    // Varre a particao e retoma depois do ultimo lote entregue. false sem particao.
+    bool iniciar();
+
+    // Grava o evento e retorna a sua sequencia (0 se nao foi gravado).
+    uint32_t anexar(const uint8_t *dados, uint16_t tamanho);
+
+    // Publica ate um lote, se o intervalo desde o ultimo ja passou. Retorna quantos sairam.
+    unsigned drenar(unsigned long agora, PublicarRegistro publicar);
+
+    uint32_t pendentes() const { return _proximaSequencia - _sequenciaLeitura; }
+    uint32_t proximaSequencia() const { return _proximaSequencia; }
+    uint32_t capacidadeBytes() const { return _setores * HAL_SETOR_FLASH; }
+    const EstatisticasCaixaDeSaida &estatisticas() const { return _estatisticas; }
+
+private:
+    struct Cabecalho
+    {
+        uint8_t marca;
+        uint8_t entregue; // 0xFF; zerado no ultimo registro de cada lote entregue
+        uint16_t tamanho;
+        uint32_t sequencia;
+        uint32_t crc; // Sequencia, tamanho e dados: detecta gravacao interrompida
+    };
+
+    ConfiguracaoCaixaDeSaida _configuracao;
+    EstatisticasCaixaDeSaida _estatisticas = {};
+    uint32_t _setores = 0;
+    uint32_t _escrita = 0; // Endereco do proximo registro
+    uint32_t _leitura = 0; // Endereco do registro pendente mais antigo
+    uint32_t _proximaSequencia = 1;
+    uint32_t _sequenciaLeitura = 1;
+    unsigned long _ultimoLote = 0;
+    uint8_t _registro[sizeof(Cabecalho) + CAIXA_TAMANHO_MAXIMO];
+
+    bool lerRegistro(uint32_t endereco, Cabecalho &cabecalho);
+    bool proximoPendente(Cabecalho &cabecalho);
+    void liberarSetor(uint32_t endereco);
+    uint32_t proximoSetor(uint32_t endereco) const;
+};
+
+#endif
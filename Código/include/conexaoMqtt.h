@@ -0,0 +1,40 @@
+#ifndef CONEXAO_MQTT_H
+#define CONEXAO_MQTT_H
+
+#include <Arduino.h>
+
+// Estados da conexao com o broker
+enum EstadoMqtt
+{
+    MQTT_DESCONECTADO, // Sem Wi-Fi: nenhuma tentativa e feita
+    MQTT_AGUARDANDO,   // Esperando o fim do backoff para a proxima tentativa
+    MQTT_CONECTANDO,   // Tentativa em andamento, uma etapa por passagem
+    MQTT_CONECTADO
+};
+
+// Contadores para acompanhar a recuperacao depois de quedas do broker
+struct EstatisticasMqtt
+{
+    unsigned long tentativas;
+    unsigned long falhas;
+    unsigned long reconexoes;
+    unsigned long ultimoTempoReconexao; // ms entre a queda e a reconexao
+    unsigned long maiorTempoReconexao;
+};
+
+void iniciarMqtt(const char *servidor, int porta, const char *id);
+// Assina o topico a cada conexao (o broker esquece as assinaturas numa queda). O
+// callback roda na tarefa de rede, dentro de atualizarMqtt(). Ate MAX_ASSINATURAS_MQTT.
+const uint8_t MAX_ASSINATURAS_MQTT = 8;
+bool assinarMqtt(const char *topico, void (*aoReceber)(const uint8_t *dados, unsigned int tamanho));
+// podeConectar false adia a tentativa de conexao (a que estiver em andamento fica
+// parada); o cliente conectado segue atendido.
+void atualizarMqtt(bool podeConectar = true);
+bool mqttConectado(void);
+EstadoMqtt estadoMqtt(void);
+const EstatisticasMqtt &estatisticasMqtt(void);
+
+// Espera antes da proxima tentativa: backoff exponencial limitado com jitter.
+unsigned long esperaReconexaoMqtt(uint8_t falhasSeguidas, uint32_t sorteio);
+
+#endif
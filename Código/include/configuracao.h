@@ -0,0 +1,86 @@
+#ifndef CONFIGURACAO_H
+#define CONFIGURACAO_H
+
+#include <Arduino.h>
+#include "amostragem.h"
+
+// ====================================================================================
+// CONFIGURACAO EM TEMPO DE EXECUCAO
+// ====================================================================================
+// Os ajustes de campo (armado, limiares, intervalos, tempos da porta e calibracao)
+// chegam por MQTT como um JSON parcial, sao validados juntos, gravados na NVS e
+// aplicados sem reiniciar. Uma mensagem com qualquer campo desconhecido ou fora da faixa
+// e recusada inteira: nunca fica meia configuracao aplicada.
+//
+// A configuracao vigente fica em dois buffers com um contador de geracao. O escritor
+// (uma unica tarefa: a de rede) preenche o buffer livre e publica a nova geracao; os
+// leitores copiam sem trava e repetem a copia se a geracao mudou no meio. No caminho
+// quente basta atualizarConfiguracao(), que so le o contador quando nada mudou.
+
+struct ConfiguracaoSafezone
+{
+    // Alarmes (fusao.h e luz.h)
+    int32_t armado; // 1: as regras de MODO_ARMADO valem; 0: desarmado
+    int32_t limiarPesoG;
+    int32_t histeresePesoG;       // Desliga em limiar - histerese
+    int32_t limiarDistanciaMM;
+    int32_t histereseDistanciaMM; // Desliga em limiar + histerese
+    int32_t limiarLuz;            // Desvio minimo do detector, contagens de 12 bits
+    int32_t limiarLuzPercentual;  // Desvio relativo a linha de base
+    // Leituras e publicacao
+    int32_t intervaloMs[NUM_SENSORES_AMOSTRADOS]; // 0: cada resultado novo do sensor
+    int32_t intervaloBordaMs;                     // Entre bordas publicadas do mesmo sensor
+    int32_t heartbeatMs;
+    // Acesso
+    int32_t destravamentoMs; // Tempo que a porta fica aberta
+    int32_t desarmeMs;       // Alarme suspenso apos um acesso: abrir, entrar e fechar
+    // Calibracao
+    int32_t contagensPorKg; // Celula de carga
+};
+
+// Os valores que antes eram constantes no codigo.
+const ConfiguracaoSafezone CONFIGURACAO_PADRAO = {
+    1, 5000, 500, 400, 100, 40, 25,
+    {0, 0, 500}, 1000, 60000,
+    3000, 15000,
+    41795,
+};
+
+enum ResultadoConfiguracao
+{
+    CONFIGURACAO_APLICADA,
+    CONFIGURACAO_SEM_MUDANCA,
+    CONFIGURACAO_INVALIDA,    // Nada foi aplicado
+    CONFIGURACAO_NAO_GRAVADA, // Aplicada, mas a NVS falhou: volta a anterior ao reiniciar
+};
+
+// Espaco para o JSON de serializarConfiguracao().
+const size_t TAMANHO_CONFIGURACAO_JSON = 512;
+
+// Carrega a configuracao gravada na NVS ou, sem ela (ou invalida), o padrao. Chamar no
+// setup(), antes das tarefas. Retorna true se veio da NVS.
+bool iniciarConfiguracao(const ConfiguracaoSafezone &padrao);
+
+// Qualquer tarefa, sem trava.
+ConfiguracaoSafezone configuracaoAtual();
+uint32_t geracaoConfiguracao();
+// Atualiza a copia da tarefa se houver uma geracao nova (geracao comeca em 0). Retorna
+// true quando a copia mudou.
+bool atualizarConfiguracao(ConfiguracaoSafezone &copia, uint32_t &geracao);
+
+// Nome do primeiro campo invalido, ou nullptr.
+const char *validarConfiguracao(const ConfiguracaoSafezone &configuracao);
+
+// Apenas a tarefa de rede (um escritor).
+ResultadoConfiguracao aplicarConfiguracao(const ConfiguracaoSafezone &nova);
+// JSON com os campos a trocar (os nomes de serializarConfiguracao()). Em
+// CONFIGURACAO_INVALIDA, `erro` aponta o campo recusado ("json" se nao der para ler).
+ResultadoConfiguracao aplicarConfiguracaoJson(const uint8_t *dados, size_t tamanho, const char *&erro);
+
+// Configuracao vigente como JSON, com a geracao, o status e o timestamp. Retorna o
+// tamanho escrito (0 se nao couber).
+size_t serializarConfiguracao(char *buffer, size_t capacidade, const char *status, time_t timestamp);
+
+const char *nomeResultadoConfiguracao(ResultadoConfiguracao resultado);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef DIAGNOSTICO_H
+#define DIAGNOSTICO_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "hal.h"
+
+// ====================================================================================
+// PERFIL DAS ETAPAS E DIAGNOSTICO
+// ====================================================================================
+// Cada etapa do firmware (Wi-Fi, MQTT, sensores, envio, botao e digital, liberacao)
+// e medida com o contador de ciclos da CPU e cai num histograma log-linear de memoria
+// fixa. Periodicamente a tarefa de rede publica p50, p99 e maximo de cada etapa, o
+// heap livre (agora e o minimo desde o boot), as mensagens de registro descartadas e os
+// passos por segundo de cada tarefa no topico de diagnostico, e comeca uma janela nova.
+//
+// Medir uma etapa:
+//     uint32_t marca = marcarEtapa();
+//     ...
+//     marca = medirEtapa(ETAPA_PRESSAO, marca); // Retorna a marca da etapa seguinte
+//
+// Com -D SAFEZONE_PERFIL=0 as duas funcoes sao vazias e inline, os histogramas nao
+// existem e nada e publicado: custo zero.
+
+#ifndef SAFEZONE_PERFIL
+#define SAFEZONE_PERFIL 1
+#endif
+
+enum EtapaPerfil
+{
+    ETAPA_WIFI,           // checkWiFi()
+    ETAPA_MQTT_CONEXAO,   // Cada etapa da tentativa de conexao ao broker
+    ETAPA_MQTT_LOOP,      // Cliente MQTT, com as mensagens recebidas
+    ETAPA_ENVIO_LEITURAS, // enviarLeituraSensores()
+    ETAPA_PRESSAO,        // atualizarMonitoramento(), por sensor
+    ETAPA_DISTANCIA,
+    ETAPA_LUZ,
+    ETAPA_FUSAO,
+    ETAPA_BOTAO_DIGITAL, // Botao e verificacao da digital
+    ETAPA_LIBERAR_ACESSO,
+    ETAPA_ESPERA_DIGITAL, // Do aperto do botao (ou do toque no sensor) ate a decisao e a trava
+    ETAPA_BUSCA_QUENTE,   // Busca na particao quente (particaoQuente.h), do comando a resposta
+    ETAPA_BUSCA_COMPLETA, // Busca no resto da biblioteca (ou nela toda, sem particao)
+    ETAPA_DESTRAVAR,      // Da resposta da busca lida ate a borda do pino da trava
+    NUM_ETAPAS
+};
+
+// ------------------- HISTOGRAMA LOG-LINEAR -------------------
+// 8 faixas lineares por potencia de 2 (erro relativo de no maximo 1/16 no ponto medio
+// da faixa), de 0 a 2^32 ciclos em 240 contadores. Um unico escritor (a tarefa que
+// mede a etapa); outra tarefa pode ler e pedir para zerar, o que o escritor faz na
+// proxima medida.
+class HistogramaLogLinear
+{
+public:
+    static const uint8_t BITS_FAIXA = 3;
+    static const uint16_t NUM_FAIXAS = (32 - BITS_FAIXA + 1) << BITS_FAIXA;
+
+    void registrar(uint32_t valor);
+    void zerar() { _zerar.store(true, std::memory_order_relaxed); }
+
+    uint32_t amostras() const;
+    uint32_t maximo() const;
+    // Ponto medio da faixa do percentil p (0 a 100), limitado ao maximo.
+    uint32_t percentil(double p) const;
+
+    static uint16_t faixa(uint32_t valor);
+    static uint32_t inicioFaixa(uint16_t faixa);
+    static uint32_t larguraFaixa(uint16_t faixa);
+
+private:
+    std::atomic<uint32_t> _contagens[NUM_FAIXAS] = {};
+    std::atomic<uint32_t> _amostras{0};
+    std::atomic<uint32_t> _maximo{0};
+    std::atomic<bool> _zerar{false};
+};
+
+struct EstatisticasEtapa
+{
+    const char *nome;
+    uint32_t amostras;
+    float p50Us;
+    float p99Us;
+    float maximoUs;
+};
+
+#if SAFEZONE_PERFIL
+inline uint32_t marcarEtapa()
+{
+    return halCiclos();
+}
+uint32_t medirEtapa(EtapaPerfil etapa, uint32_t marca);
+#else
+inline uint32_t marcarEtapa()
+{
+    return 0;
+}
+inline uint32_t medirEtapa(EtapaPerfil, uint32_t)
+{
+    return 0;
+}
+#endif
+
+// Da janela atual.
+EstatisticasEtapa estatisticasEtapa(EtapaPerfil etapa);
+const char *nomeEtapa(EtapaPerfil etapa);
+
+// Espaco para o JSON de serializarDiagnostico() (cabe no buffer do cliente MQTT).
+const size_t TAMANHO_DIAGNOSTICO_JSON = 768;
+
+// Diagnostico da janela que termina em `agora` (ms) como JSON; zera os histogramas e
+// comeca a janela seguinte. Apenas uma tarefa (a de rede). Retorna o tamanho escrito
+// (0 se nao couber ou com o perfil desligado).
+size_t serializarDiagnostico(char *buffer, size_t capacidade, unsigned long agora, time_t timestamp);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+#include <Arduino.h>
+#include "listaDeAcesso.h"
+
+// Resultado de uma tentativa de acesso, entregue pela tarefa de acesso a tarefa de rede.
+struct EventoAcesso
+{
+    bool liberado;
+    unsigned long instante; // millis() da decisao
+    uint16_t dedo;          // fingerID encontrado (0 sem digital)
+    uint16_t usuario;       // Da lista de acesso
+    DecisaoAcesso decisao;
+};
+
+#endif
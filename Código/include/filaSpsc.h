@@ -0,0 +1,72 @@
+#ifndef FILA_SPSC_H
+#define FILA_SPSC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// ====================================================================================
+// FILA CIRCULAR SEM TRAVAS (UM PRODUTOR, UM CONSUMIDOR)
+// ====================================================================================
+// Liga duas tarefas sem mutex: so o produtor chama enviar() e so o consumidor chama
+// receber(). Com a fila cheia o item novo e descartado e contado, para que o produtor
+// (ex.: a tarefa de sensores) nunca espere pelo consumidor (ex.: a tarefa de rede).
+
+template <typename T, size_t N>
+class FilaSpsc
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "A capacidade da fila deve ser potencia de 2");
+
+public:
+    bool enviar(const T &item)
+    {
+        uint32_t fim = _fim.load(std::memory_order_relaxed);
+        uint32_t inicio = _inicio.load(std::memory_order_acquire);
+        if (fim - inicio >= N)
+        {
+            _descartes.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        _itens[fim & (N - 1)] = item;
+        _fim.store(fim + 1, std::memory_order_release);
+        _enviados.fetch_add(1, std::memory_order_relaxed);
+
+        uint32_t ocupacao = fim + 1 - inicio;
+        if (ocupacao > _maiorOcupacao.load(std::memory_order_relaxed))
+            _maiorOcupacao.store(ocupacao, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool receber(T &item)
+    {
+        uint32_t inicio = _inicio.load(std::memory_order_relaxed);
+        uint32_t fim = _fim.load(std::memory_order_acquire);
+        if (inicio == fim)
+            return false;
+
+        item = _itens[inicio & (N - 1)];
+        _inicio.store(inicio + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t tamanho() const
+    {
+        return _fim.load(std::memory_order_acquire) - _inicio.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacidade() { return N; }
+    uint32_t enviados() const { return _enviados.load(std::memory_order_relaxed); }
+    uint32_t descartes() const { return _descartes.load(std::memory_order_relaxed); }
+    uint32_t maiorOcupacao() const { return _maiorOcupacao.load(std::memory_order_relaxed); }
+
+private:
+    T _itens[N];
+    std::atomic<uint32_t> _inicio{0};
+    std::atomic<uint32_t> _fim{0};
+    std::atomic<uint32_t> _enviados{0};
+    std::atomic<uint32_t> _descartes{0};
+    std::atomic<uint32_t> _maiorOcupacao{0};
+};
+
+#endif
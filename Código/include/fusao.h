@@ -0,0 +1,129 @@
+#ifndef FUSAO_H
+#define FUSAO_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// FUSAO DOS ALARMES POR TABELA DE REGRAS
+// ====================================================================================
+// Dois niveis, ambos declarados como tabelas e compilados uma vez em compilarFusao():
+//   - condicoes: uma entrada (peso, distancia ou detector de luz) comparada com dois
+//     limiares, um para ligar e outro para desligar (histerese), com tempo de
+//     confirmacao antes de ligar e duracao minima depois de ligada;
+//   - regras: um conjunto de condicoes que precisam ser ativadas dentro de uma janela
+//     ("movimento E peso em ate 2 s"), os modos em que valem (armado, desarmado) e a
+//     causa publicada. A primeira regra da tabela tem a maior prioridade.
+// O resultado e um unico alarme fundido, com a causa, mantido pela retencao da regra.
+//
+// Uma regra armada so considera ativacoes posteriores a mudanca de modo: o que ja
+// estava ativo quando o alarme foi armado (ou a suspensao acabou) precisa desligar e
+// ligar de novo para contar.
+//
+// avaliarFusao() roda so na tarefa de sensores; armarFusao() e suspenderFusao() podem
+// ser chamadas de qualquer tarefa.
+
+const uint8_t MAX_CONDICOES_FUSAO = 8; // Uma mascara de 8 bits
+const uint8_t MAX_REGRAS_FUSAO = 8;
+const int32_t FUSAO_SEM_MEDIDA = INT32_MIN; // Entrada sem valor: condicao do lado de desligar
+
+enum EntradaFusao
+{
+    ENTRADA_PESO,      // g
+    ENTRADA_DISTANCIA, // mm, ou FUSAO_SEM_MEDIDA sem nada no alcance
+    ENTRADA_LUZ,       // 1 com o detector de mudanca brusca (luz.h) ativo
+    NUM_ENTRADAS_FUSAO
+};
+
+enum ComparacaoFusao
+{
+    FUSAO_ACIMA,  // Liga com valor >= liga, desliga com valor < desliga
+    FUSAO_ABAIXO  // Liga com valor <= liga, desliga com valor > desliga
+};
+
+// Codigo publicado junto com o alarme fundido. Os valores vao nos quadros binarios:
+// so acrescentar ao fim.
+enum CausaAlarme
+{
+    CAUSA_NENHUMA,
+    CAUSA_INTRUSAO, // Movimento e peso juntos
+    CAUSA_LANTERNA, // Movimento e mudanca brusca de luz juntos
+    CAUSA_PRESENCA, // Alguem parado na frente do sensor
+    CAUSA_LUZ,      // Mudanca brusca de luz sozinha
+    NUM_CAUSAS_ALARME
+};
+
+const uint8_t MODO_ARMADO = 1 << 0;
+const uint8_t MODO_DESARMADO = 1 << 1; // Desarmado ou suspenso por um acesso autorizado
+
+struct CondicaoFusao
+{
+    EntradaFusao entrada;
+    ComparacaoFusao comparacao;
+    int32_t liga;
+    int32_t desliga;        // Do outro lado de `liga`: a faixa entre os dois e a histerese
+    uint16_t confirmacaoMs; // Tempo seguido do lado de ligar antes de ativar
+    uint16_t retencaoMs;    // Duracao minima ativa
+};
+
+struct RegraFusao
+{
+    uint8_t condicoes;   // Bits (1 << indice na tabela de condicoes), todos exigidos
+    uint16_t janelaMs;   // Ativacoes dentro desta janela (0: basta estarem ativas juntas)
+    uint8_t modos;       // MODO_*
+    CausaAlarme causa;
+    uint16_t retencaoMs; // Duracao minima do alarme fundido
+};
+
+struct ResultadoFusao
+{
+    uint8_t condicoes; // Bits das condicoes ativas
+    uint8_t entradas;  // Bit (1 << EntradaFusao) com alguma condicao da entrada ativa
+    bool alarme;
+    CausaAlarme causa; // CAUSA_NENHUMA com o alarme desligado
+};
+
+// ------------------- TABELAS DO FIRMWARE -------------------
+// Os alarmes por sensor publicados sao as condicoes de cada entrada: peso e distancia
+// com os limiares antigos (5 kg, 40 cm) e uma faixa de histerese, para que um valor
+// parado no limiar nao fique ligando e desligando.
+
+enum
+{
+    CONDICAO_PESO = 1 << 0,
+    CONDICAO_MOVIMENTO = 1 << 1,
+    CONDICAO_LUZ = 1 << 2,
+    CONDICAO_PRESENCA = 1 << 3,
+};
+
+const CondicaoFusao CONDICOES_PADRAO[] = {
+    {ENTRADA_PESO, FUSAO_ACIMA, 5000, 4500, 200, 1000},     // 2 conversoes do HX711
+    {ENTRADA_DISTANCIA, FUSAO_ABAIXO, 400, 500, 60, 1000}, // 2 medidas no perfil rapido
+    {ENTRADA_LUZ, FUSAO_ACIMA, 1, 1, 0, 0},                // O detector ja retem 2 s
+    {ENTRADA_DISTANCIA, FUSAO_ABAIXO, 400, 500, 5000, 0},  // Parado na frente por 5 s
+};
+const uint8_t NUM_CONDICOES_PADRAO = sizeof(CONDICOES_PADRAO) / sizeof(CONDICOES_PADRAO[0]);
+
+const RegraFusao REGRAS_PADRAO[] = {
+    {CONDICAO_MOVIMENTO | CONDICAO_PESO, 2000, MODO_ARMADO, CAUSA_INTRUSAO, 10000},
+    {CONDICAO_MOVIMENTO | CONDICAO_LUZ, 5000, MODO_ARMADO, CAUSA_LANTERNA, 10000},
+    {CONDICAO_PRESENCA, 0, MODO_ARMADO, CAUSA_PRESENCA, 5000},
+    {CONDICAO_LUZ, 0, MODO_ARMADO, CAUSA_LUZ, 5000},
+};
+const uint8_t NUM_REGRAS_PADRAO = sizeof(REGRAS_PADRAO) / sizeof(REGRAS_PADRAO[0]);
+
+// Valida e compila as tabelas, zerando o estado. Tabelas invalidas sao recusadas e as
+// anteriores continuam valendo. Chamar antes de iniciar a tarefa de sensores.
+bool compilarFusao(const CondicaoFusao *condicoes, uint8_t numCondicoes,
+                   const RegraFusao *regras, uint8_t numRegras);
+
+// Avalia uma vez com os valores atuais das entradas. Custo constante, sem alocacao.
+ResultadoFusao avaliarFusao(const int32_t entradas[NUM_ENTRADAS_FUSAO], unsigned long agora);
+
+// Vem do campo `armado` da configuracao (configuracao.h).
+void armarFusao(bool armado);
+// Muda para MODO_DESARMADO pelos proximos duracaoMs (ex.: porta aberta apos um acesso).
+void suspenderFusao(unsigned long duracaoMs);
+
+const char *nomeCausaAlarme(uint8_t causa);
+
+#endif
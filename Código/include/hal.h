@@ -0,0 +1,156 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// ====================================================================================
+// CAMADA DE ABSTRACAO DE HARDWARE (HAL)
+// ====================================================================================
+// Os modulos do firmware falam com os perifericos apenas por estas funcoes.
+// src/esp32/hal.cpp usa as bibliotecas reais (HX711, VL53L0X, WiFi, PubSubClient,
+// ezTime) e src/native/hal.cpp usa os sensores e o broker simulados do build nativo.
+// Tempo, GPIO, ADC e portas seriais seguem a API do Arduino nos dois builds.
+
+// ------------------- SENSOR DE PRESSAO (HX711) -------------------
+// Leitura continua: a cada conversao (10 por segundo com RATE em nivel baixo) o
+// callback recebe o valor bruto de 24 bits, sem ninguem esperar pela conversao. No
+// ESP32 ele roda numa tarefa acordada pela borda de descida de DOUT; no build nativo,
+// num evento agendado do simulador. Deve ser curto e nao bloquear.
+void halBalancaIniciar(int pinoDout, int pinoSck);
+void halBalancaLigar();
+bool halBalancaContinua(void (*aoConverter)(int32_t bruto));
+
+// ------------------- SENSOR DE MOVIMENTO (VL53L0X) -------------------
+// Medida continua (uma atras da outra): o sensor avisa pelo GPIO1 quando ha resultado
+// novo e halDistanciaLer() so fala com ele nesse caso; senao retorna na hora. O perfil
+// troca o orcamento de tempo de cada medida e pode mudar com o sensor em uso.
+enum PerfilDistancia
+{
+    DISTANCIA_RAPIDO, // 20 ms por medida, ate ~1,2 m
+    DISTANCIA_PADRAO, // 33 ms, ate ~1,2 m
+    DISTANCIA_LONGO,  // 33 ms com limite de sinal menor, ate ~2 m (pior sob luz forte)
+    NUM_PERFIS_DISTANCIA
+};
+
+enum MedidaDistancia
+{
+    DISTANCIA_PENDENTE,     // Nenhuma medida nova desde a ultima leitura
+    DISTANCIA_VALIDA,       // mm preenchido
+    DISTANCIA_FORA_ALCANCE, // RangeStatus diferente de 0: nada no alcance ou medida ruim
+};
+
+bool halDistanciaIniciar(int pinoPronto, PerfilDistancia perfil);
+bool halDistanciaPerfil(PerfilDistancia perfil);
+MedidaDistancia halDistanciaLer(uint16_t &mm);
+
+// ------------------- SENSOR DE LUZ (LDR NO ADC) -------------------
+// Amostragem continua do ADC: a cada 1 ms o callback recebe um bloco de
+// HAL_ADC_AMOSTRAS_POR_BLOCO conversoes de 12 bits seguidas (4 kHz no total). No ESP32
+// roda numa tarefa periodica curta; no build nativo, num evento agendado. Deve ser
+// curto e nao bloquear.
+const uint8_t HAL_ADC_AMOSTRAS_POR_BLOCO = 4;
+const uint32_t HAL_ADC_BLOCO_US = 1000;
+
+bool halAdcContinuo(uint8_t pino, void (*aoAmostrar)(const uint16_t *amostras, uint8_t quantidade));
+
+// ------------------- SENSOR DE DIGITAIS (SAIDA DE TOQUE) -------------------
+// Modulos com saida de toque (TOUCH do R503, WAK do R307/AS608) sobem o pino quando um
+// dedo encosta no vidro, sem nenhum comando pela UART. A interrupcao da borda so guarda
+// o instante (halCiclos()); halToqueLer() retorna true uma vez por toque, com esse
+// instante em `ciclos`. No build nativo o toque e o dedo simulado encostando.
+bool halToqueIniciar(int pino);
+bool halToqueLer(uint32_t &ciclos);
+
+// ------------------- WIFI -------------------
+// No ESP32 o callback de eventos roda na tarefa de eventos do driver, fora do loop:
+// deve apenas registrar o evento para ser tratado depois.
+enum EventoWiFi
+{
+    WIFI_EVENTO_CONECTADO,
+    WIFI_EVENTO_DESCONECTADO
+};
+
+void halWiFiAoEvento(void (*callback)(EventoWiFi evento));
+void halWiFiIniciar(const char *ssid, const char *senha);
+bool halWiFiConectado();
+String halWiFiIP();
+int halWiFiRSSI();
+
+// ------------------- MQTT -------------------
+void halMqttServidor(const char *servidor, uint16_t porta);
+void halMqttTimeoutConexao(uint16_t timeoutMs);
+// Conexao em etapas, sem esperar pela rede: halMqttIniciarConexao() pede o endereco do
+// broker ou abre o socket (false se nem isso deu) e halMqttAndamentoConexao() avanca a
+// tentativa a cada chamada (DNS, TCP, CONNECT, CONNACK) ate a conexao, a recusa ou o
+// timeout. Nenhuma das duas espera por DNS, TCP ou resposta do broker.
+// halMqttCancelarConexao() fecha uma tentativa pendente.
+enum AndamentoConexaoMqtt
+{
+    CONEXAO_MQTT_PENDENTE,
+    CONEXAO_MQTT_PRONTA,
+    CONEXAO_MQTT_FALHOU
+};
+
+bool halMqttIniciarConexao(const char *id);
+AndamentoConexaoMqtt halMqttAndamentoConexao();
+void halMqttCancelarConexao();
+bool halMqttConectado();
+int halMqttEstado();
+void halMqttLoop();
+bool halMqttPublicar(const char *topico, const char *payload);
+bool halMqttPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho);
+// Mensagens dos topicos assinados chegam ao callback dentro de halMqttLoop(), na tarefa
+// que o chama. As assinaturas se perdem com a conexao: assinar de novo ao reconectar.
+void halMqttAoReceber(void (*callback)(const char *topico, const uint8_t *dados, unsigned int tamanho));
+bool halMqttAssinar(const char *topico);
+
+// ------------------- FLASH (PARTICAO "caixa") -------------------
+// Particao de dados brutos do partitions.csv no ESP32; um arquivo no build nativo.
+// Semantica de NOR flash: apagar um setor deixa tudo em 0xFF e escrever so leva bits
+// de 1 para 0, entao um byte ja escrito pode ser zerado sem apagar o setor.
+const uint32_t HAL_SETOR_FLASH = 4096;
+
+uint32_t halFlashTamanho(); // 0 se a particao nao existe
+bool halFlashLer(uint32_t endereco, void *dados, size_t tamanho);
+bool halFlashEscrever(uint32_t endereco, const void *dados, size_t tamanho);
+bool halFlashApagarSetor(uint32_t endereco);
+
+// ------------------- NVS (CHAVE-VALOR PERSISTENTE) -------------------
+// Particao "nvs" no ESP32 (Preferences, namespace "safezone"); um arquivo no build
+// nativo. Cada valor e gravado inteiro, e a leitura so aceita o tamanho esperado.
+bool halNvsLer(const char *chave, void *dados, size_t tamanho);
+bool halNvsGravar(const char *chave, const void *dados, size_t tamanho);
+
+// ------------------- RELOGIO -------------------
+// halRelogioLocal() busca o fuso pela rede (ezTime): so com o Wi-Fi conectado, e nunca
+// na tarefa de acesso. halRelogioSincronizado() diz se o NTP ja acertou a hora.
+void halRelogioLocal(const char *local);
+bool halRelogioSincronizado();
+time_t halRelogioAgora();
+
+// ------------------- TAREFAS -------------------
+// xTaskCreatePinnedToCore no ESP32; std::thread no build nativo (prioridade e nucleo
+// ignorados). halMultitarefa() diz se o firmware deve dividir o trabalho em tarefas.
+// halEncerrarTarefa() encerra a tarefa que chama (vTaskDelete(NULL) no ESP32); no build
+// nativo retorna, e a thread termina quando a funcao da tarefa retornar.
+bool halMultitarefa();
+bool halCriarTarefa(const char *nome, void (*funcao)(void *parametro), void *parametro,
+                    uint32_t pilha, uint8_t prioridade, int8_t nucleo);
+void halEncerrarTarefa();
+
+// ------------------- CPU E MEMORIA -------------------
+// Contador de ciclos da CPU (CCOUNT no ESP32: um registrador, da a volta em ~17 s a
+// 240 MHz), para medir trechos curtos sem o custo de micros(). No build nativo segue o
+// relogio simulado, em nanossegundos, como um ESP32 a 240 MHz.
+uint32_t halCiclos();
+uint32_t halCiclosPorUs();
+// Heap livre agora e o menor valor desde o boot, em bytes.
+uint32_t halHeapLivre();
+uint32_t halHeapMinimo();
+
+// ------------------- ALEATORIO -------------------
+// Diferente em cada dispositivo (RNG de hardware no ESP32), usado para jitter.
+uint32_t halAleatorio();
+
+#endif
@@ -1,7 +1,18 @@
 #ifndef INTERNET_H
 #define INTERNET_H
 
+// Qualidade da conexao, publicada periodicamente pelo main.cpp
+struct QualidadeWiFi
+{
+    bool conectado;
+    int rssi;                  // dBm (0 sem conexao)
+    unsigned long conectadoHa; // ms desde a ultima conexao
+    unsigned long reconexoes;
+    unsigned long quedas;
+};
+
 void conectaWiFi(void);
 void checkWiFi(void);
+QualidadeWiFi qualidadeWiFi(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,105 @@
+#ifndef LISTA_DE_ACESSO_H
+#define LISTA_DE_ACESSO_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// LISTA DE ACESSO LOCAL
+// ====================================================================================
+// Quem pode entrar e quando, decidido no proprio no e sem rede. A lista e um vetor plano
+// indexado pela posicao do modelo no sensor de digitais (fingerID): a busca e um acesso
+// direto, sem procura. Cada posicao guarda o usuario, a confianca minima exigida do
+// fingerFastSearch(), a marca de revogado e ate duas janelas de horario (dias da semana
+// e minutos do dia), avaliadas na hora local do ezTime.
+//
+// A lista vive na RAM e e gravada inteira na NVS a cada mudanca. As mudancas chegam por
+// MQTT como patches: cada um troca uma posicao e leva a versao da lista em que se baseia
+// (`base`) e a versao nova. Um patch fora de ordem e recusado e o servidor reenvia a
+// partir da versao publicada no topico da lista vigente.
+//
+// Enquanto nenhuma lista foi recebida vale o comportamento antigo: qualquer digital
+// encontrada no sensor libera.
+//
+// Um unico escritor (a tarefa de rede); a tarefa de acesso le sem trava: um contador
+// de sequencia fica impar enquanto uma posicao e trocada e a leitura repete se ele mudou.
+
+// Posicoes 0 a 200: o menu cadastra de 1 a capacity (200 no AS608/R503).
+const uint16_t MAX_SLOTS_ACESSO = 201;
+const uint8_t JANELAS_POR_SLOT = 2;
+
+// Bits de `dias`: bit 0 domingo ... bit 6 sabado.
+const uint8_t TODOS_OS_DIAS = 0x7F;
+const uint16_t MINUTOS_POR_DIA = 1440;
+
+// 16 bytes, alinhado: o vetor inteiro ocupa pouco mais de 3 KB.
+struct EntradaAcesso
+{
+    uint16_t usuario;         // 0: posicao livre
+    uint16_t confiancaMinima; // 0: qualquer digital encontrada
+    uint8_t revogado;
+    uint8_t dias[JANELAS_POR_SLOT]; // 0: janela sem uso; nenhuma janela: qualquer horario
+    uint8_t reservado;
+    // Minuto do dia, fim exclusivo. Fim menor que o inicio passa da meia-noite (o dia
+    // da janela e o do inicio); fim igual ao inicio e o dia inteiro.
+    uint16_t inicioMin[JANELAS_POR_SLOT];
+    uint16_t fimMin[JANELAS_POR_SLOT];
+};
+
+enum DecisaoAcesso : uint8_t
+{
+    ACESSO_LIBERADO,
+    ACESSO_NAO_ENCONTRADO, // Digital fora do sensor (ou erro na verificacao)
+    ACESSO_SEM_CADASTRO,   // Posicao sem usuario na lista
+    ACESSO_REVOGADO,
+    ACESSO_CONFIANCA_BAIXA,
+    ACESSO_FORA_DO_HORARIO,
+    ACESSO_SEM_RELOGIO, // Entrada com janela e hora ainda nao sincronizada: nega
+    NUM_DECISOES_ACESSO
+};
+
+struct ResultadoAcesso
+{
+    DecisaoAcesso decisao;
+    uint16_t usuario; // 0 sem lista ou sem cadastro
+};
+
+enum ResultadoPatchAcesso
+{
+    PATCH_APLICADO,
+    PATCH_REPETIDO,      // Versao ja aplicada: nada muda
+    PATCH_FORA_DE_ORDEM, // `base` diferente da versao atual
+    PATCH_INVALIDO,
+    PATCH_NAO_GRAVADO, // Aplicado, mas a NVS falhou: volta a anterior ao reiniciar
+};
+
+// Espaco para o JSON de serializarListaDeAcesso().
+const size_t TAMANHO_LISTA_ACESSO_JSON = 128;
+
+// Carrega a lista gravada na NVS (sem ela, ou invalida, fica sem lista). Chamar no
+// setup(), antes das tarefas. Retorna true se havia uma lista.
+bool iniciarListaDeAcesso();
+// Posicoes aceitas nos patches: 0 a min(capacidade do sensor, MAX_SLOTS_ACESSO - 1).
+void limitarSlotsAcesso(uint16_t capacidade);
+
+// Qualquer tarefa, sem trava e sem alocacao. `agoraLocal` e halRelogioAgora().
+ResultadoAcesso avaliarAcesso(uint16_t slot, uint16_t confianca, time_t agoraLocal);
+
+// Apenas a tarefa de rede (um escritor). usuario == 0 apaga a posicao.
+ResultadoPatchAcesso aplicarPatchAcesso(uint32_t base, uint32_t versao, uint16_t slot, const EntradaAcesso &entrada);
+// JSON plano de um patch: versao, base, slot e os campos da entrada (usuario, confianca,
+// revogado, dias, inicio, fim, dias2, inicio2, fim2; hora em minutos do dia). Em
+// PATCH_INVALIDO, `erro` aponta o campo recusado ("json" se nao der para ler).
+ResultadoPatchAcesso aplicarPatchAcessoJson(const uint8_t *dados, size_t tamanho, const char *&erro);
+
+bool listaDeAcessoAtiva();
+uint32_t versaoListaDeAcesso();
+uint16_t cadastrosListaDeAcesso();
+
+// Versao, cadastros, status e timestamp como JSON. Retorna o tamanho escrito (0 se nao
+// couber).
+size_t serializarListaDeAcesso(char *buffer, size_t capacidade, const char *status, time_t timestamp);
+
+const char *nomeDecisaoAcesso(DecisaoAcesso decisao);
+const char *nomeResultadoPatchAcesso(ResultadoPatchAcesso resultado);
+
+#endif
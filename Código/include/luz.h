@@ -0,0 +1,55 @@
+#ifndef LUZ_H
+#define LUZ_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// SENSOR DE LUZ (LDR) COM DETECTOR DE MUDANCA BRUSCA
+// ====================================================================================
+// O ADC amostra o LDR continuamente a 4 kHz (halAdcContinuo). Cada 16 conversoes viram
+// uma amostra de 14 bits (sobreamostragem: +2 bits, 250 amostras/s), que passa por:
+//   - um IIR rapido (constante de tempo de ~32 ms) que tira o ruido do ADC e a
+//     cintilacao de lampadas;
+//   - uma linha de base lenta (~4 s), que acompanha o anoitecer, nuvens e lampadas
+//     acesas ha tempo;
+//   - um detector que exige, ao mesmo tempo, desvio grande da linha de base e variacao
+//     grande dentro da janela curta, no mesmo sentido. Uma mudanca lenta nao passa na
+//     variacao, mesmo que o nivel absoluto mude muito.
+// Tudo em ponto fixo. O resultado fica em variaveis atomicas, lido em O(1).
+//
+// Substitui analogRead(33) > 100 duas vezes por segundo: uma unica conversao ruidosa
+// contra um nivel fixo, que oscilava no anoitecer e nao via a luz se apagando.
+
+struct ConfiguracaoLuz
+{
+    uint16_t limiarMinimo;    // Desvio minimo em contagens de 12 bits...
+    uint8_t limiarPercentual; // ...ou esta porcentagem da linha de base, o que for maior
+    uint16_t janelaMs;        // Janela da variacao (ate 256 ms)
+    uint16_t retencaoMs;      // Duracao minima do alarme
+};
+
+const ConfiguracaoLuz LUZ_PADRAO = {40, 25, 200, 2000};
+
+struct LeituraLuz
+{
+    uint16_t nivel;         // Filtrado, em contagens de 12 bits (0 a 4095)
+    uint16_t linhaDeBase;   // Idem
+    bool alarme;            // Mudanca brusca recente, para mais ou para menos
+    uint32_t amostras;      // Amostras decimadas desde o inicio (muda a cada valor novo)
+    unsigned long instante; // millis() da ultima amostra
+};
+
+// Zera o detector. Chamar antes de iniciarLuz() ou com a amostragem parada.
+void configurarLuz(const ConfiguracaoLuz &configuracao);
+// Troca so os limiares, de qualquer tarefa e com a amostragem em andamento.
+void ajustarLimiaresLuz(uint16_t limiarMinimo, uint8_t limiarPercentual);
+
+bool iniciarLuz(uint8_t pino);
+
+LeituraLuz leituraLuz();
+
+// Entrada de um bloco de conversoes de 12 bits: o callback da HAL. Publica para que a
+// bancada reproduza tracos gravados sem passar pelo ADC.
+void alimentarLuz(const uint16_t *amostras, uint8_t quantidade);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef MENSAGENS_H
+#define MENSAGENS_H
+
+#include "serializadorJson.h"
+
+// ====================================================================================
+// LAYOUTS DAS MENSAGENS PUBLICADAS
+// ====================================================================================
+// Os nomes e a ordem dos campos sao os que o Esp Subscriber ja interpreta. "seq" e a
+// sequencia da caixa de saida: mensagens repetidas apos um reinicio tem a mesma. Campos
+// novos entram no fim, como "alarme" e "causa" (alarme fundido, fusao.h).
+
+struct LayoutEventoAcesso
+{
+    static constexpr CampoJson campos[] = {
+        {"liberar_Acesso", JSON_BOOL, 0},
+        {"timestamp", JSON_INTEIRO, 0},
+        {"seq", JSON_INTEIRO, 0},
+        {"dedo", JSON_INTEIRO, 0},    // fingerID encontrado (0 sem digital)
+        {"usuario", JSON_INTEIRO, 0}, // Da lista de acesso (0 sem lista ou sem cadastro)
+        {"decisao", JSON_TEXTO, 16},  // nomeDecisaoAcesso()
+    };
+};
+
+struct LayoutLeituraSensores
+{
+    static constexpr CampoJson campos[] = {
+        {"sensor_luz", JSON_BOOL, 0},
+        {"sensor_movimento", JSON_BOOL, 0},
+        {"sensor_pressao", JSON_BOOL, 0},
+        {"motivo", JSON_TEXTO, 9},
+        {"timestamp", JSON_INTEIRO, 0},
+        {"seq", JSON_INTEIRO, 0},
+        {"alarme", JSON_BOOL, 0},
+        {"causa", JSON_TEXTO, 8},
+    };
+};
+
+struct LayoutQualidadeWiFi
+{
+    static constexpr CampoJson campos[] = {
+        {"wifi_rssi", JSON_INTEIRO, 0},
+        {"wifi_conectado_s", JSON_INTEIRO, 0},
+        {"wifi_reconexoes", JSON_INTEIRO, 0},
+        {"wifi_quedas", JSON_INTEIRO, 0},
+        {"timestamp", JSON_INTEIRO, 0},
+    };
+};
+
+constexpr size_t maiorTamanho(size_t a, size_t b) { return a > b ? a : b; }
+
+// Buffer unico de publicacao: comporta qualquer uma das mensagens acima.
+constexpr size_t TAMANHO_MENSAGEM_MQTT =
+    maiorTamanho(tamanhoMaximoJson(LayoutEventoAcesso::campos),
+                 maiorTamanho(tamanhoMaximoJson(LayoutLeituraSensores::campos),
+                              tamanhoMaximoJson(LayoutQualidadeWiFi::campos))) +
+    1;
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef MODELOS_DIGITAIS_H
+#define MODELOS_DIGITAIS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ====================================================================================
+// PEDACOS DE MODELOS DE DIGITAIS (COPIA, RESTAURACAO E PROVISIONAMENTO)
+// ====================================================================================
+// Os modelos gravados no sensor saem um a um (loadModel + upload) e viajam em pedacos
+// autocontidos: cada pedaco leva um modelo inteiro, a posicao de origem, o indice dele
+// na transferencia e um CRC-32. Um arquivo de copia e so a sequencia dos pedacos; o
+// mesmo pedaco serve ao MQTT, a um arquivo no servidor ou a outro canal local. Como
+// quadroBinario.h, este par de arquivos nao depende do Arduino.
+//
+// Pedaco (528 bytes, little-endian):
+//   0  'D' (0x44)                 8   total de modelos da transferencia (uint16)
+//   1  versao                     10  posicao no sensor (uint16)
+//   2  transferencia (uint32)     12  modelo (512 bytes, como sai do sensor)
+//   6  indice (uint16)            524 CRC-32 dos bytes 0 a 523
+//
+// Quem recebe marca cada indice gravado num mapa de bits (ProgressoTransferencia): um
+// pedaco repetido nao regrava o sensor e, depois de uma queda ou de um reinicio, o envio
+// continua do primeiro indice que falta, sem recomecar.
+
+const uint8_t PEDACO_MARCA = 0x44;
+const uint8_t PEDACO_VERSAO = 1;
+const size_t TAMANHO_MODELO = 512; // CharBuffer do R307/AS608
+const size_t TAMANHO_PEDACO = 12 + TAMANHO_MODELO + 4;
+const uint16_t MAX_MODELOS_TRANSFERENCIA = 1024; // Maior capacidade da familia (R307)
+
+struct PedacoModelo
+{
+    uint32_t transferencia;
+    uint16_t indice;
+    uint16_t total;
+    uint16_t slot;
+    uint8_t modelo[TAMANHO_MODELO];
+};
+
+enum ResultadoPedaco
+{
+    PEDACO_OK,
+    PEDACO_CURTO,
+    PEDACO_MARCA_ERRADA,
+    PEDACO_VERSAO_DESCONHECIDA,
+    PEDACO_CRC_ERRADO,
+    PEDACO_FORA_DO_LIMITE // indice >= total ou total acima de MAX_MODELOS_TRANSFERENCIA
+};
+
+// Retorna o tamanho escrito (TAMANHO_PEDACO), ou 0 se nao couber em `capacidade`.
+size_t codificarPedaco(const PedacoModelo &pedaco, uint8_t *buffer, size_t capacidade);
+ResultadoPedaco decodificarPedaco(const uint8_t *dados, size_t tamanho, PedacoModelo &pedaco);
+const char *descreverResultadoPedaco(ResultadoPedaco resultado);
+
+// CRC-32 (polinomio 0xEDB88320, o do zlib). `crc` 0 no primeiro trecho. Tambem usado
+// pela caixa de saida.
+uint32_t crc32Pedaco(uint32_t crc, const uint8_t *dados, size_t tamanho);
+
+// ------------------- PROGRESSO DE UMA TRANSFERENCIA -------------------
+// Estrutura simples, sem ponteiros: pode ser gravada como esta na NVS.
+
+class ProgressoTransferencia
+{
+public:
+    // Uma transferencia por vez: outra `transferencia` (ou outro total) recomeca do zero.
+    void comecar(uint32_t transferencia, uint16_t total);
+    void zerar();
+
+    bool recebido(uint16_t indice) const;
+    void marcar(uint16_t indice);
+    uint16_t proximo() const; // Primeiro indice que falta (total se completa)
+
+    bool ativa() const { return _total != 0; }
+    bool completa() const { return _total && _recebidos == _total; }
+    uint32_t transferencia() const { return _transferencia; }
+    uint16_t total() const { return _total; }
+    uint16_t recebidos() const { return _recebidos; }
+
+private:
+    uint32_t _transferencia = 0;
+    uint16_t _total = 0;
+    uint16_t _recebidos = 0;
+    uint8_t _mapa[MAX_MODELOS_TRANSFERENCIA / 8] = {};
+};
+
+// ------------------- MAPA DE POSICOES OCUPADAS -------------------
+// Bit i do mapa = posicao i do sensor (readIndexTable, 32 bytes por pagina de 256). Os
+// indices de uma exportacao sao as posicoes ocupadas em ordem crescente.
+
+uint16_t contarPosicoes(const uint8_t *mapa, uint16_t posicoes);
+// Posicao do indice-esimo bit ligado, ou `posicoes` se nao houver.
+uint16_t posicaoDoIndice(const uint8_t *mapa, uint16_t posicoes, uint16_t indice);
+
+// ------------------- STATUS -------------------
+
+enum OperacaoModelos : uint8_t
+{
+    MODELOS_EXPORTACAO,
+    MODELOS_IMPORTACAO
+};
+
+enum SituacaoModelos : uint8_t
+{
+    MODELOS_GRAVADO,     // Importacao: modelo gravado na posicao do pedaco
+    MODELOS_REPETIDO,    // Indice ja gravado: nada muda
+    MODELOS_RECUSADO,    // Pedaco (ResultadoPedaco em `detalhe`) ou pedido invalido
+    MODELOS_OCUPADO,     // Fila cheia: reenviar o mesmo pedaco
+    MODELOS_ERRO_SENSOR, // Codigo FINGERPRINT_* em `detalhe`
+    MODELOS_INICIADA,    // Exportacao aceita: `total` modelos a partir de `indice`
+    MODELOS_CONCLUIDA,   // Ultimo pedaco exportado ou gravado
+    MODELOS_CONEXAO,     // Progresso da importacao, republicado a cada conexao
+    NUM_SITUACOES_MODELOS
+};
+
+struct StatusModelos
+{
+    OperacaoModelos operacao;
+    SituacaoModelos situacao;
+    uint8_t detalhe;
+    uint32_t transferencia;
+    uint16_t indice;
+    uint16_t slot;
+    uint16_t total;
+};
+
+// Espaco para o JSON de serializarStatusModelos().
+const size_t TAMANHO_STATUS_MODELOS_JSON = 224;
+
+// JSON do status; com `progresso` (importacao) vao tambem recebidos e proximo, de onde o
+// envio deve continuar. Retorna o tamanho escrito (0 se nao couber).
+size_t serializarStatusModelos(char *buffer, size_t capacidade, const StatusModelos &status,
+                               const ProgressoTransferencia *progresso, long timestamp);
+
+const char *nomeSituacaoModelos(SituacaoModelos situacao);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef PARTICAO_QUENTE_H
+#define PARTICAO_QUENTE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ====================================================================================
+// PARTICAO QUENTE DA BIBLIOTECA DE DIGITAIS
+// ====================================================================================
+// A busca do modulo compara o modelo capturado com as posicoes da faixa pedida, uma a
+// uma, ate achar: com centenas de cadastros a espera na porta cresce com a biblioteca.
+// As ultimas posicoes do sensor ficam reservadas para copias dos modelos de quem mais
+// entra, e a verificacao procura primeiro nessa faixa curta e so sem acerto no resto da
+// biblioteca (dois comandos de busca com faixa, em vez de um sobre tudo).
+//
+// Os modelos sao copiados, nao movidos: cada pessoa continua na posicao de cadastro, que
+// e a chave da lista de acesso, dos eventos e da copia de modelos. Um acerto na particao
+// e traduzido para a posicao original. Uma copia so vale depois de confirmada; antes de
+// copiar (e antes de qualquer mudanca no modelo original) ela e invalidada, e um acerto
+// numa copia invalida conta como erro da particao e segue para a biblioteca.
+//
+// Quem entra: contagem de acertos por posicao original com decaimento (metade a cada 256
+// acertos), entao pesa quem entra muito e quem entrou por ultimo. Posicoes livres recebem
+// o candidato com mais pontos; cheia a particao, ele toma o lugar da copia mais fria
+// quando tem o dobro dos pontos dela mais um acerto.
+//
+// Como modelosDigitais.h, nao depende do Arduino. A tarefa de acesso (dona do sensor)
+// pede a proxima promocao, copia o modelo e confirma; o registro das copias vai para a NVS.
+
+const uint8_t MAX_PARTICAO_QUENTE = 32;
+const uint8_t MAX_CANDIDATOS_QUENTES = 4 * MAX_PARTICAO_QUENTE;
+
+enum CamadaBusca : uint8_t
+{
+    BUSCA_QUENTE,   // Faixa reservada
+    BUSCA_COMPLETA, // Resto da biblioteca
+    NUM_CAMADAS_BUSCA
+};
+
+struct EstatisticasCamada
+{
+    uint32_t buscas;
+    uint32_t acertos;
+};
+
+class ParticaoQuente
+{
+public:
+    // Reserva as `tamanho` ultimas posicoes de uma biblioteca de 0 a `capacidade` (0
+    // desliga; ate MAX_PARTICAO_QUENTE e no maximo um oitavo da biblioteca). Comeca sem
+    // copias nem contagem. Retorna false se o tamanho nao couber.
+    bool configurar(uint16_t capacidade, uint8_t tamanho);
+
+    bool ativa() const { return _tamanho != 0; }
+    uint16_t inicio() const { return _inicio; } // Primeira posicao reservada
+    uint8_t tamanho() const { return _tamanho; }
+    bool reservada(uint16_t posicao) const { return _tamanho && posicao >= _inicio && posicao < _inicio + _tamanho; }
+    // Posicao original da copia na posicao reservada `posicao` (0: sem copia valida).
+    uint16_t original(uint16_t posicao) const;
+
+    // Resultado de cada busca, pela camada; `original` do acerto para a contagem.
+    void registrarBusca(CamadaBusca camada, bool achou);
+    void registrarAcerto(uint16_t original);
+    const EstatisticasCamada &estatisticas(CamadaBusca camada) const { return _estatisticas[camada]; }
+    void zerarEstatisticas();
+
+    // Proxima copia a fazer: modelo de `original` para a posicao reservada `destino`.
+    bool proximaPromocao(uint16_t &original, uint16_t &destino) const;
+    void invalidar(uint16_t destino); // Antes de copiar
+    void confirmar(uint16_t destino, uint16_t original);
+    // O modelo de `original` mudou ou foi apagado: a copia deixa de valer e sai da
+    // contagem. Retorna a posicao da copia (0 se nao havia).
+    uint16_t esquecer(uint16_t original);
+
+    // Uma posicao original por posicao reservada (0: sem copia), para a NVS.
+    const uint16_t *copias() const { return _copias; }
+    void restaurar(const uint16_t *copias);
+
+private:
+    struct Candidato
+    {
+        uint16_t original;
+        uint16_t pontos;
+    };
+
+    uint16_t _inicio = 0;
+    uint8_t _tamanho = 0;
+    uint16_t _copias[MAX_PARTICAO_QUENTE] = {};
+    Candidato _candidatos[MAX_CANDIDATOS_QUENTES] = {};
+    uint16_t _acertosAteDecair = 0;
+    EstatisticasCamada _estatisticas[NUM_CAMADAS_BUSCA] = {};
+
+    uint16_t pontos(uint16_t original) const;
+    bool temCopia(uint16_t original) const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PARTIDA_H
+#define PARTIDA_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// PARTIDA (BOOT) EM FASES
+// ====================================================================================
+// O setup() so faz o que a porta precisa antes de tudo: trava e botao, e a configuracao
+// e a lista de acesso da NVS. O resto sobe na propria tarefa dona (tarefas.h), antes do
+// primeiro passo dela: o sensor de digitais na de acesso, os sensores de alarme na de
+// sensores, e a caixa de saida, o Wi-Fi, o MQTT e o relogio em segundo plano na de rede.
+// Com FreeRTOS as tarefas sobem em paralelo; no loop() cooperativo, na ordem da
+// prioridade. Nenhuma fase espera pela rede.
+//
+// Cada fase guarda o inicio e o fim em ms desde o reset (millis()); o relatorio vai
+// para o topico de boot quando o MQTT conecta (com o relogio, se ja sincronizou).
+
+enum FasePartida : uint8_t
+{
+    PARTIDA_TRAVA,        // GPIO da trava (fechada) e do botao
+    PARTIDA_CONFIGURACAO, // NVS: configuracao, lista de acesso e importacao de digitais
+    PARTIDA_DIGITAIS,     // Sensor de digitais e particao quente (tarefa de acesso)
+    PARTIDA_SENSORES,     // Balanca, distancia, luz e regras de alarme (tarefa de sensores)
+    PARTIDA_CAIXA,        // Caixa de saida na flash (tarefa de rede)
+    PARTIDA_WIFI,         // Do pedido de conexao ao primeiro IP
+    PARTIDA_MQTT,         // Do Wi-Fi ate o broker
+    PARTIDA_RELOGIO,      // Do Wi-Fi ate o fuso e o NTP
+    NUM_FASES_PARTIDA
+};
+
+// Zera todas as fases (inicio do setup()).
+void reiniciarPartida();
+
+// Cada fase e escrita por uma unica tarefa; qualquer uma le.
+void iniciarFase(FasePartida fase);
+void concluirFase(FasePartida fase, bool ok = true);
+bool faseIniciada(FasePartida fase);
+bool faseConcluida(FasePartida fase);
+
+// ms desde o reset em que o controle de acesso local ficou pronto (trava, NVS e
+// digitais), ou 0 se ainda nao.
+uint32_t acessoLocalProntoMs();
+
+const char *nomeFasePartida(FasePartida fase);
+
+// Espaco para o JSON de serializarPartida().
+const size_t TAMANHO_PARTIDA_JSON = 384;
+
+// {"fases":{"trava":[inicio,fim,ok],...,"relogio":null},"acesso_ms":N,"timestamp":T}
+// Fases que nao terminaram saem como null. Retorna o tamanho (0 se nao couber).
+size_t serializarPartida(char *buffer, size_t capacidade, time_t timestamp);
+
+#endif
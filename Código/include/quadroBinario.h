@@ -0,0 +1,119 @@
+#ifndef QUADRO_BINARIO_H
+#define QUADRO_BINARIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ====================================================================================
+// QUADRO BINARIO DAS MENSAGENS (ALTERNATIVA AO JSON)
+// ====================================================================================
+// Formato compacto, little-endian e sem alinhamento, escrito byte a byte para ser igual
+// em qualquer arquitetura. Este par de arquivos (quadroBinario.h/.cpp) nao depende do
+// Arduino e pode ser copiado para o Esp Subscriber ou para um consumidor no servidor.
+//
+// Cabecalho (14 bytes):
+//   0  'S' (0x53)            6  sequencia (uint32)
+//   1  versao                10 timestamp Unix (uint32)
+//   2  tipo (TipoQuadro)
+//   3  alarmes (bits ALARME_*)
+//   4  no (uint16)
+// Corpo por tipo:
+//   QUADRO_LEITURA (10): medida em gramas (int32), distanciaCM (uint16), leituraLDR (uint16), motivo (uint8),
+//                        causa do alarme fundido (uint8, ausente nos quadros antigos de 9 bytes)
+//   QUADRO_ACESSO (6):   liberado (uint8), dedo (uint16, fingerID), usuario (uint16), decisao (uint8,
+//                        DecisaoAcesso da lista de acesso); so liberado nos quadros antigos de 1 byte
+//   QUADRO_WIFI (9):     rssi (int8), conectado em s (uint32), reconexoes (uint16), quedas (uint16)
+//   QUADRO_AMOSTRAS (6 + 6 por amostra): sensor (uint8), quantidade (uint8), millis() da
+//                        primeira amostra (uint32) e, por amostra, ms desde a primeira
+//                        (uint16) e valor (int32). O timestamp do cabecalho e o da primeira.
+//                        Tamanho variavel: usa codificar/decodificarQuadroAmostras().
+//
+// Compatibilidade: versoes futuras so acrescentam campos ao fim do corpo. O decodificador
+// aceita a mesma versao principal com bytes a mais e os ignora.
+
+const uint8_t QUADRO_MARCA = 0x53;
+const uint8_t QUADRO_VERSAO = 1;
+const size_t QUADRO_TAMANHO_CABECALHO = 14;
+const size_t QUADRO_TAMANHO_MAXIMO = QUADRO_TAMANHO_CABECALHO + 10;
+const uint8_t QUADRO_MAX_AMOSTRAS = 32;
+const size_t QUADRO_TAMANHO_AMOSTRAS_MAXIMO = QUADRO_TAMANHO_CABECALHO + 6 + 6 * QUADRO_MAX_AMOSTRAS;
+const uint16_t QUADRO_FORA_DE_ALCANCE = 0xFFFF; // distanciaCM sem nada no alcance
+const uint8_t QUADRO_DECISAO_DESCONHECIDA = 0xFF; // decisao dos quadros de acesso antigos
+
+enum TipoQuadro
+{
+    QUADRO_LEITURA = 1,
+    QUADRO_ACESSO = 2,
+    QUADRO_WIFI = 3,
+    QUADRO_AMOSTRAS = 4
+};
+
+const uint8_t ALARME_PRESSAO = 1 << 0;
+const uint8_t ALARME_MOVIMENTO = 1 << 1;
+const uint8_t ALARME_LUZ = 1 << 2;
+const uint8_t ALARME_FUSAO = 1 << 3; // Alarme fundido (fusao.h)
+
+struct QuadroSafezone
+{
+    TipoQuadro tipo;
+    uint8_t alarmes;
+    uint16_t no;
+    uint32_t sequencia;
+    uint32_t timestamp;
+
+    // QUADRO_LEITURA
+    int32_t medidaGramas;
+    uint16_t distanciaCM;
+    uint16_t leituraLDR;
+    uint8_t motivo;      // MotivoTelemetria
+    uint8_t causaAlarme; // CausaAlarme
+
+    // QUADRO_ACESSO
+    bool liberado;
+    uint16_t dedo;
+    uint16_t usuario;
+    uint8_t decisao;
+
+    // QUADRO_WIFI
+    int8_t rssi;
+    uint32_t conectadoS;
+    uint16_t reconexoes;
+    uint16_t quedas;
+};
+
+struct AmostraQuadro
+{
+    uint16_t deslocamentoMs; // Desde a primeira amostra do quadro
+    int32_t valor;           // Unidade do sensor: g, mm ou contagem do ADC
+};
+
+struct QuadroAmostras
+{
+    uint8_t alarmes;
+    uint16_t no;
+    uint32_t sequencia;
+    uint32_t timestamp;
+
+    uint8_t sensor; // SensorAmostrado (amostragem.h)
+    uint8_t quantidade;
+    uint32_t instanteMs;
+    AmostraQuadro amostras[QUADRO_MAX_AMOSTRAS];
+};
+
+enum ResultadoQuadro
+{
+    QUADRO_OK,
+    QUADRO_CURTO,       // Menos bytes que o cabecalho + corpo do tipo
+    QUADRO_MARCA_ERRADA,
+    QUADRO_VERSAO_DESCONHECIDA,
+    QUADRO_TIPO_DESCONHECIDO
+};
+
+// Retorna o tamanho escrito, ou 0 se nao couber em `capacidade`.
+size_t codificarQuadro(const QuadroSafezone &quadro, uint8_t *buffer, size_t capacidade);
+ResultadoQuadro decodificarQuadro(const uint8_t *dados, size_t tamanho, QuadroSafezone &quadro);
+size_t codificarQuadroAmostras(const QuadroAmostras &quadro, uint8_t *buffer, size_t capacidade);
+ResultadoQuadro decodificarQuadroAmostras(const uint8_t *dados, size_t tamanho, QuadroAmostras &quadro);
+const char *descreverResultadoQuadro(ResultadoQuadro resultado);
+
+#endif
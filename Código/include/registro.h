@@ -0,0 +1,66 @@
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// REGISTRO (LOG) COM NIVEIS, ASSINCRONO
+// ====================================================================================
+// O monitor serial roda a 9600 baud: ~1 ms por caractere depois que a FIFO de
+// transmissao do UART (128 bytes) enche, e um Serial.println() nessa hora prende a
+// tarefa que chamou. Aqui a mensagem e formatada direto numa fila circular sem travas
+// (varios produtores, um consumidor) e so a tarefa de registro, de prioridade baixa,
+// escreve na serial, sem nunca esperar pela linha: cada passo escreve so o que cabe na
+// FIFO. Com a fila cheia a mensagem e descartada e contada; a contagem aparece no
+// proprio registro e no diagnostico.
+//
+// Uso (printf, sem "\n"):
+//     REGISTRAR_AVISO("Conexao MQTT perdida.");
+//     REGISTRAR_INFO("Lista de acesso v%lu: %u cadastros.", versao, cadastros);
+//
+// Com -D SAFEZONE_REGISTRO=N so os niveis ate N sao compilados (0 nada, 1 erro, 2 aviso,
+// 3 info, 4 depuracao; padrao 3): a chamada de um nivel acima some, argumentos e texto
+// inclusive. O menu interativo do sensor de digitais continua no Serial direto.
+
+#ifndef SAFEZONE_REGISTRO
+#define SAFEZONE_REGISTRO 3
+#endif
+
+enum NivelRegistro : uint8_t
+{
+    REGISTRO_ERRO = 1,
+    REGISTRO_AVISO,
+    REGISTRO_INFO,
+    REGISTRO_DEPURACAO
+};
+
+#define REGISTRAR(nivel, ...)                     \
+    do                                            \
+    {                                             \
+        if ((nivel) <= SAFEZONE_REGISTRO)         \
+            registrar((nivel), __VA_ARGS__);      \
+    } while (0)
+
+#define REGISTRAR_ERRO(...) REGISTRAR(REGISTRO_ERRO, __VA_ARGS__)
+#define REGISTRAR_AVISO(...) REGISTRAR(REGISTRO_AVISO, __VA_ARGS__)
+#define REGISTRAR_INFO(...) REGISTRAR(REGISTRO_INFO, __VA_ARGS__)
+#define REGISTRAR_DEPURACAO(...) REGISTRAR(REGISTRO_DEPURACAO, __VA_ARGS__)
+
+const uint8_t CAPACIDADE_REGISTRO = 32;    // Mensagens na fila (potencia de 2)
+const uint8_t TAMANHO_MENSAGEM_REGISTRO = 80; // Texto alem disso e cortado
+
+// Serial que recebe o registro (ja com begin()). Antes disso as mensagens esperam na fila.
+void iniciarRegistro(HardwareSerial &saida);
+
+// Qualquer tarefa (e o setup()). Nunca espera: retorna false se a fila estava cheia.
+bool registrar(NivelRegistro nivel, const char *formato, ...) __attribute__((format(printf, 2, 3)));
+
+// Tarefa de registro: escreve na serial o que cabe na FIFO de transmissao, sem esperar.
+void passoRegistro();
+
+// Mensagens descartadas (fila cheia) desde o boot, e as ainda na fila.
+uint32_t descartesRegistro();
+uint32_t pendentesRegistro();
+const char *nomeNivelRegistro(NivelRegistro nivel);
+
+#endif
@@ -3,6 +3,9 @@
 
 #include <Adafruit_Fingerprint.h>
 #include <HardwareSerial.h>
+#include "listaDeAcesso.h"
+#include "modelosDigitais.h"
+#include "particaoQuente.h"
 
 class FingerprintSensor
 {
@@ -16,16 +19,84 @@ public:
     void getFingerprintCount();
     bool isAccessGranted();
 
+    // --- Verificacao assincrona (nao bloqueia o loop) ---
+    void setCaptureTimeout(unsigned long timeoutMs);
+    void startVerification();
+    bool pollVerification(); // Retorna true na chamada em que a verificacao termina
+    bool isVerificationPending();
+    uint8_t verificationResult();
+    uint32_t decisionCycles(); // halCiclos() quando a verificacao terminou
+    // Resultado no registro (registro.h), fora de pollVerification(): a trava age antes.
+    void reportVerification();
+
+    // --- Decisao da lista de acesso (listaDeAcesso.h) na ultima verificacao ---
+    DecisaoAcesso accessDecision();
+    uint16_t matchedSlot(); // fingerID encontrado (0 sem digital)
+    uint16_t matchedUser(); // Usuario da lista (0 sem lista ou sem cadastro)
+
+    // --- Copia de modelos (modelosDigitais.h): bloqueantes, so fora de uma verificacao ---
+    uint16_t capacity();
+    uint8_t readIndexTable(uint8_t page, uint8_t *bitmap); // 32 bytes: bit i = posicao 256 * page + i
+    uint8_t readTemplate(uint16_t slot, uint8_t *model);   // TAMANHO_MODELO bytes
+    uint8_t writeTemplate(uint16_t slot, const uint8_t *model);
+    uint8_t copyTemplate(uint16_t from, uint16_t to);
+
+    // --- Particao quente (particaoQuente.h): busca nela antes da biblioteca ---
+    // Sem particao (ou inativa), uma busca so na biblioteca inteira. O aviso e chamado
+    // antes de qualquer mudanca num modelo (cadastro, exclusao, writeTemplate), para a
+    // copia dele deixar de valer antes; se retornar false, o modelo nao muda.
+    void useHotPartition(ParticaoQuente *partition);
+    void onTemplateChange(bool (*callback)(uint16_t slot));
+    uint16_t lastUserSlot(); // Ultima posicao fora da particao
+
 private:
+    // Etapas da verificacao: getImage -> image2Tz -> busca (particao, depois biblioteca)
+    enum VerificationState
+    {
+        VERIFY_IDLE,
+        VERIFY_CAPTURE,
+        VERIFY_CONVERT,
+        VERIFY_SEARCH,
+        VERIFY_DONE
+    };
+
+    static const unsigned long DEFAULT_CAPTURE_TIMEOUT = 10000;
+    static const unsigned long RESPONSE_TIMEOUT = 1000;
+    static const int MIN_ACK_SIZE = 12; // Cabecalho (9) + codigo (1) + checksum (2)
+    static const uint8_t INDEX_TABLE_SIZE = 32;
+
     Adafruit_Fingerprint _finger;
     HardwareSerial *_mySerial;
     bool _liberacaoAcesso;
+    DecisaoAcesso _decisao;
+    uint16_t _slot;
+    uint16_t _usuario;
     int _rxPin;
     int _txPin;
 
+    VerificationState _verifyState;
+    uint8_t _verifyResult;
+    bool _awaitingResponse;
+    unsigned long _captureTimeout;
+    unsigned long _verifyStart;
+    unsigned long _commandSentAt;
+    uint32_t _decisionCycles;
+    ParticaoQuente *_partition;
+    CamadaBusca _searchTier;
+    uint32_t _searchMark;
+    bool (*_templateChange)(uint16_t slot);
+
     uint8_t getFingerprintEnroll();
     uint8_t getFingerprintID();
-    uint8_t getFingerprintIDez();
+    bool sendStageCommand();
+    bool finishSearch(uint8_t result);
+    bool templateChanging(uint16_t slot);
+    void sendCommand(const uint8_t *data, uint8_t length);
+    bool finishVerification(uint8_t result);
+    uint8_t sendAndWait(const uint8_t *data, uint8_t length, Adafruit_Fingerprint_Packet &reply);
+    bool readDataPacket(uint8_t *data, uint16_t capacity, uint8_t &type, uint16_t &length);
+    void writeDataPacket(uint8_t type, const uint8_t *data, uint16_t length);
+    bool readBytes(uint8_t *data, uint16_t length);
 };
 
 #endif
\ No newline at end of file
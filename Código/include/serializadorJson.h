@@ -0,0 +1,209 @@
+#ifndef SERIALIZADOR_JSON_H
+#define SERIALIZADOR_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <type_traits>
+#include <utility>
+
+// ====================================================================================
+// SERIALIZADOR JSON SEM ALOCACAO
+// ====================================================================================
+// Cada mensagem tem um layout fixo (nome e tipo de cada campo, em ordem) declarado como
+// uma struct com `static constexpr CampoJson campos[]`. serializarJson<Layout>() escreve
+// o objeto num buffer do chamador e confere em compilacao:
+//   - o numero de valores e o tipo de cada um contra o layout;
+//   - que o buffer comporta o maior JSON possivel do layout.
+// Nenhuma alocacao no heap: o buffer pode ser estatico e publicado diretamente.
+
+enum TipoJson
+{
+    JSON_BOOL,
+    JSON_INTEIRO, // Ate 64 bits com sinal
+    JSON_DECIMAL, // Duas casas, limitado a +-1e9 (NaN vira null)
+    JSON_TEXTO    // Cortado em tamanhoTexto; aspas, barra e controles viram '_'
+};
+
+struct CampoJson
+{
+    const char *nome;
+    TipoJson tipo;
+    uint8_t tamanhoTexto; // So para JSON_TEXTO
+};
+
+namespace detalheJson
+{
+    constexpr size_t comprimento(const char *texto)
+    {
+        size_t n = 0;
+        while (texto[n])
+            n++;
+        return n;
+    }
+
+    constexpr size_t tamanhoValor(const CampoJson &campo)
+    {
+        switch (campo.tipo)
+        {
+        case JSON_BOOL:
+            return 5; // false
+        case JSON_INTEIRO:
+            return 20; // -9223372036854775808
+        case JSON_DECIMAL:
+            return 14; // -1000000000.00
+        default:
+            return campo.tamanhoTexto + 2u;
+        }
+    }
+
+    template <typename T>
+    constexpr TipoJson tipoDe()
+    {
+        typedef typename std::decay<T>::type U;
+        return std::is_same<U, bool>::value                            ? JSON_BOOL
+               : std::is_integral<U>::value || std::is_enum<U>::value ? JSON_INTEIRO
+               : std::is_floating_point<U>::value                      ? JSON_DECIMAL
+                                                                       : JSON_TEXTO;
+    }
+
+    template <typename T>
+    constexpr bool tipoValido()
+    {
+        typedef typename std::decay<T>::type U;
+        return std::is_arithmetic<U>::value || std::is_enum<U>::value ||
+               std::is_same<U, const char *>::value || std::is_same<U, char *>::value;
+    }
+
+    template <typename Layout, typename... Valores, size_t... I>
+    constexpr bool tiposConferem(std::index_sequence<I...>)
+    {
+        bool ok = true;
+        bool tipos[] = {true, (Layout::campos[I].tipo == tipoDe<Valores>() && tipoValido<Valores>())...};
+        for (bool tipo : tipos)
+            ok = ok && tipo;
+        return ok;
+    }
+
+    inline void escreverTexto(char *&p, const char *texto)
+    {
+        while (*texto)
+            *p++ = *texto++;
+    }
+
+    inline void escreverInteiro(char *&p, long long valor)
+    {
+        char digitos[20];
+        int n = 0;
+        unsigned long long absoluto = valor < 0 ? 0ULL - (unsigned long long)valor : (unsigned long long)valor;
+        do
+        {
+            digitos[n++] = '0' + absoluto % 10;
+            absoluto /= 10;
+        } while (absoluto);
+        if (valor < 0)
+            *p++ = '-';
+        while (n)
+            *p++ = digitos[--n];
+    }
+
+    inline void escreverValor(char *&p, const CampoJson &, bool valor)
+    {
+        escreverTexto(p, valor ? "true" : "false");
+    }
+
+    template <typename T>
+    inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+    escreverValor(char *&p, const CampoJson &, T valor)
+    {
+        escreverInteiro(p, (long long)valor);
+    }
+
+    inline void escreverValor(char *&p, const CampoJson &, double valor)
+    {
+        if (valor != valor) // NaN
+        {
+            escreverTexto(p, "null");
+            return;
+        }
+        if (valor > 1e9)
+            valor = 1e9;
+        if (valor < -1e9)
+            valor = -1e9;
+        long long centesimos = llround(valor * 100);
+        if (centesimos < 0)
+        {
+            *p++ = '-';
+            centesimos = -centesimos;
+        }
+        escreverInteiro(p, centesimos / 100);
+        *p++ = '.';
+        *p++ = '0' + (centesimos / 10) % 10;
+        *p++ = '0' + centesimos % 10;
+    }
+
+    inline void escreverValor(char *&p, const CampoJson &, float valor)
+    {
+        escreverValor(p, CampoJson(), (double)valor);
+    }
+
+    inline void escreverValor(char *&p, const CampoJson &campo, const char *texto)
+    {
+        *p++ = '"';
+        for (uint8_t i = 0; i < campo.tamanhoTexto && texto[i]; i++)
+        {
+            char c = texto[i];
+            *p++ = (c == '"' || c == '\\' || (uint8_t)c < 0x20) ? '_' : c;
+        }
+        *p++ = '"';
+    }
+
+    template <typename T>
+    inline void escreverCampo(char *&p, const CampoJson &campo, bool primeiro, const T &valor)
+    {
+        if (!primeiro)
+            *p++ = ',';
+        *p++ = '"';
+        escreverTexto(p, campo.nome);
+        *p++ = '"';
+        *p++ = ':';
+        escreverValor(p, campo, valor);
+    }
+
+    template <typename Layout, typename... Valores, size_t... I>
+    inline size_t escrever(char *buffer, std::index_sequence<I...>, const Valores &...valores)
+    {
+        char *p = buffer;
+        *p++ = '{';
+        int ordem[] = {0, (escreverCampo(p, Layout::campos[I], I == 0, valores), 0)...};
+        (void)ordem;
+        *p++ = '}';
+        *p = '\0';
+        return p - buffer;
+    }
+}
+
+// Maior JSON possivel de um layout (sem o terminador).
+template <size_t N>
+constexpr size_t tamanhoMaximoJson(const CampoJson (&campos)[N])
+{
+    size_t total = 2; // {}
+    for (size_t i = 0; i < N; i++)
+        total += (i ? 1 : 0) + detalheJson::comprimento(campos[i].nome) + 3 + detalheJson::tamanhoValor(campos[i]);
+    return total;
+}
+
+// Escreve o objeto e retorna o tamanho (sem o terminador '\0', sempre escrito).
+template <typename Layout, size_t Capacidade, typename... Valores>
+size_t serializarJson(char (&buffer)[Capacidade], const Valores &...valores)
+{
+    constexpr size_t N = sizeof(Layout::campos) / sizeof(Layout::campos[0]);
+    static_assert(sizeof...(Valores) == N, "Numero de valores diferente do layout");
+    static_assert(detalheJson::tiposConferem<Layout, Valores...>(std::index_sequence_for<Valores...>()),
+                  "Tipo de valor diferente do layout");
+    static_assert(Capacidade > tamanhoMaximoJson(Layout::campos), "Buffer menor que o maior JSON do layout");
+
+    return detalheJson::escrever<Layout>(buffer, std::index_sequence_for<Valores...>(), valores...);
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TAREFAS_H
+#define TAREFAS_H
+
+#include <Arduino.h>
+#include "agendador.h"
+
+// ====================================================================================
+// TAREFAS DO FIRMWARE
+// ====================================================================================
+// Cada subsistema expoe um "passo" que faz uma rodada de trabalho sem bloquear. Com
+// multitarefa (FreeRTOS no ESP32) cada passo roda na sua propria tarefa, fixada a um
+// nucleo; sem ela o loop() executa os passos em sequencia. Os dados entre tarefas
+// passam apenas por filas SPSC (filaSpsc.h).
+//
+// Os temporizadores de cada tarefa (porta, debounce, relatorios periodicos) ficam no
+// seu agendador (agendador.h), executado logo depois do passo. A tarefa dorme o
+// periodo ou, se for menos, ate o proximo prazo do agendador.
+//
+// O que cada subsistema precisa para subir (sensor, flash, rede) fica no `iniciar` da
+// tarefa dona, executado nela antes do primeiro passo: com multitarefa as tarefas
+// sobem em paralelo, e o setup() termina sem esperar por nenhuma (partida.h).
+
+struct Tarefa
+{
+    const char *nome;
+    void (*passo)(void);
+    uint16_t periodoMs; // Pausa entre dois passos (libera o nucleo)
+    uint8_t prioridade;
+    int8_t nucleo;
+    uint32_t pilha;     // Bytes
+    Agendador *agenda;  // Opcional
+    void (*iniciar)(void); // Opcional, uma vez antes do primeiro passo
+};
+
+struct EstatisticasTarefa
+{
+    const char *nome;
+    unsigned long passos;
+    unsigned long maiorPassoUs;
+    unsigned long tempoTotalUs;
+};
+
+const uint8_t MAX_TAREFAS = 4;
+
+// Cria uma tarefa por entrada da tabela (que deve permanecer valida). Tudo ou nada:
+// nenhuma tarefa comeca antes de todas existirem, e se uma falhar as ja criadas
+// terminam sem executar nada (retorna false, para o modo cooperativo).
+bool iniciarTarefas(const Tarefa *tabela, uint8_t quantidade);
+bool tarefasAtivas(void);
+
+// Modo cooperativo: o `iniciar` de cada tarefa, da maior prioridade para a menor (o
+// controle de acesso sobe antes da rede).
+void iniciarPassos(const Tarefa *tabela, uint8_t quantidade);
+// Modo cooperativo: um passo de cada tarefa, na ordem da tabela.
+void executarPassos(const Tarefa *tabela, uint8_t quantidade);
+
+uint8_t numeroTarefas(void);
+EstatisticasTarefa estatisticasTarefa(uint8_t indice);
+
+#endif
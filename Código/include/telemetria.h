@@ -0,0 +1,57 @@
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <Arduino.h>
+
+// ====================================================================================
+// TELEMETRIA POR ALTERACAO
+// ====================================================================================
+// Decide quando publicar o estado dos alarmes: imediatamente em qualquer borda (subida
+// ou descida), respeitando um intervalo minimo por sensor para absorver oscilacoes, e
+// um heartbeat de baixa taxa quando nada muda. Cada mensagem leva o estado completo.
+
+enum SensorAlarme
+{
+    SENSOR_PRESSAO,
+    SENSOR_MOVIMENTO,
+    SENSOR_LUZ,
+    SENSOR_FUSAO, // Alarme fundido (fusao.h): nao e um sensor, mas tem borda propria
+    NUM_SENSORES_ALARME
+};
+
+enum MotivoTelemetria
+{
+    TELEMETRIA_NENHUM,
+    TELEMETRIA_ALTERACAO, // Algum alarme mudou desde a ultima publicacao
+    TELEMETRIA_HEARTBEAT  // Nada mudou, mas o heartbeat venceu
+};
+
+struct ConfiguracaoTelemetria
+{
+    unsigned long intervaloMinimoMs[NUM_SENSORES_ALARME]; // Entre duas publicacoes de borda do sensor
+    unsigned long heartbeatMs;
+};
+
+class Telemetria
+{
+public:
+    explicit Telemetria(const ConfiguracaoTelemetria &configuracao) : _configuracao(configuracao) {}
+
+    void configurar(const ConfiguracaoTelemetria &configuracao) { _configuracao = configuracao; }
+
+    // Chamada a cada nova leitura. Nao altera o estado: so confirmar() registra o envio,
+    // para que uma publicacao que falhou seja repetida na proxima avaliacao.
+    MotivoTelemetria avaliar(const bool alarmes[NUM_SENSORES_ALARME], unsigned long agora) const;
+    void confirmar(const bool alarmes[NUM_SENSORES_ALARME], unsigned long agora);
+
+    static const char *nomeMotivo(MotivoTelemetria motivo);
+
+private:
+    ConfiguracaoTelemetria _configuracao;
+    bool _publicado[NUM_SENSORES_ALARME] = {};
+    unsigned long _ultimaBorda[NUM_SENSORES_ALARME] = {};
+    unsigned long _ultimoEnvio = 0;
+    bool _jaEnviou = false;
+};
+
+#endif
@@ -1,7 +1,13 @@
-#include "monitoramento.h"
-#include <HX711.h>
-#include <Wire.h>
-#include <Adafruit_VL53L0X.h>
+#include "Monitoramento.h"
+#include "hal.h"
+#include "amostragem.h"
+#include "balanca.h"
+#include "luz.h"
+#include "fusao.h"
+#include "configuracao.h"
+#include "diagnostico.h"
+#include "registro.h"
+#include <atomic>
 
 // ====================================================================================
 // VARIAVEIS E CONSTANTES DE MONITORAMENTO
@@ -10,126 +16,248 @@
 // ------------------- SENSOR DE PRESSAO -------------------
 const int LOADCELL_DOUT_PIN = 5;
 const int LOADCELL_SCK_PIN = 18;
-HX711 scale;
-float medida = 0.0;
-bool alarmeSensorPressao = false;
-const float LIMIAR_PESO = 5.0;
 unsigned long tempoAnteriorPressao = 0;
-const unsigned long INTERVALO_PRESSAO = 5000;
+uint32_t ultimaConversaoPressao = 0;
+const unsigned long ESPERA_TARA_MS = 2000; // 20 conversoes para o filtro assentar
+static unsigned long inicioBalanca = 0;
+static bool balancaTarada = false;
 
 // ------------------- SENSOR DE MOVIMENTO -------------------
-Adafruit_VL53L0X lox;
-bool alarmeSensorMovimento = false;
+const int VL53_GPIO1_PIN = 19; // Medida pronta
 unsigned long ultimoMillisMovimento = 0;
-const unsigned long INTERVALO_MOVIMENTO = 500;
-int distanciaCM = 0;
+static std::atomic<uint8_t> perfilPedido{DISTANCIA_PADRAO};
+static uint8_t perfilAtual = DISTANCIA_PADRAO; // Tarefa de sensores (dona do I2C)
 
 // ------------------- SENSOR DE LUZ -------------------
 const int pinSensorLuz = 33;
-bool alarmeSensorLuz = false;
-int leituraLDR = 0;
-const int LIMIAR_LUZ = 100;
 unsigned long ultimoMillisLuz = 0;
-const unsigned long INTERVALO_LUZ = 500;
+uint32_t ultimaAmostraLuz = 0;
+
+// Intervalos de leitura, limiares e calibracao: configuracao.h, em tempo de execucao.
+// As regras dos alarmes sao as tabelas de fusao.h, com os limiares da configuracao.
+
+// Acessadas apenas pela tarefa de sensores
+static LeituraSensores leitura = {};
+static int32_t entradas[NUM_ENTRADAS_FUSAO] = {0, FUSAO_SEM_MEDIDA, 0};
+static ConfiguracaoSafezone configuracao = CONFIGURACAO_PADRAO;
+static uint32_t geracaoConfiguracaoVista = 0;
 
 // ====================================================================================
 // FUNCOES DE MONITORAMENTO
 // ====================================================================================
 
+// Aplica uma configuracao nova aos sensores e ao modo da fusao e, se os limiares mudaram,
+// recompila as condicoes de peso e distancia da fusao (o que zera o estado dos alarmes).
+static void aplicarConfiguracaoSensores(const ConfiguracaoSafezone &nova, bool inicial)
+{
+    bool limiaresMudaram = inicial || nova.limiarPesoG != configuracao.limiarPesoG ||
+                           nova.histeresePesoG != configuracao.histeresePesoG ||
+                           nova.limiarDistanciaMM != configuracao.limiarDistanciaMM ||
+                           nova.histereseDistanciaMM != configuracao.histereseDistanciaMM;
+    configuracao = nova;
+
+    armarFusao(nova.armado != 0);
+    ajustarLimiaresLuz((uint16_t)nova.limiarLuz, (uint8_t)nova.limiarLuzPercentual);
+    calibrarBalanca(nova.contagensPorKg);
+    if (!limiaresMudaram)
+        return;
+
+    CondicaoFusao condicoes[NUM_CONDICOES_PADRAO];
+    for (uint8_t i = 0; i < NUM_CONDICOES_PADRAO; i++)
+    {
+        condicoes[i] = CONDICOES_PADRAO[i];
+        if (condicoes[i].entrada == ENTRADA_PESO)
+        {
+            condicoes[i].liga = nova.limiarPesoG;
+            condicoes[i].desliga = nova.limiarPesoG - nova.histeresePesoG;
+        }
+        else if (condicoes[i].entrada == ENTRADA_DISTANCIA)
+        {
+            condicoes[i].liga = nova.limiarDistanciaMM;
+            condicoes[i].desliga = nova.limiarDistanciaMM + nova.histereseDistanciaMM;
+        }
+    }
+    if (!compilarFusao(condicoes, NUM_CONDICOES_PADRAO, REGRAS_PADRAO, NUM_REGRAS_PADRAO))
+        REGISTRAR_AVISO("Limiares de alarme recusados pela fusao: seguem os anteriores.");
+}
+
 // ------------------- INICIALIZACAO -------------------
 void iniciarMonitoramento()
 {
-    // PRESSAO
-    scale.begin(LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN);
-    scale.set_scale(41795);
+    atualizarConfiguracao(configuracao, geracaoConfiguracaoVista);
+    aplicarConfiguracaoSensores(configuracao, true);
 
-    // Aguarda 2 segundos sem bloquear o sistema
-    unsigned long start = millis();
-    while (millis() - start < 2000)
+    // PRESSAO
+    if (!iniciarBalanca(LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN, configuracao.contagensPorKg))
     {
-        // Executa outras tarefas aqui se necessario
-        yield(); // para evitar watchdog reset
+        REGISTRAR_ERRO("Falha ao iniciar o sensor de pressão.");
     }
 
-    scale.tare();
-    scale.power_up();
-    Serial.println("Sensor de pressão iniciado");
+    // A tara sai em atualizarMonitoramento() quando o filtro assentar, sem segurar a partida
+    inicioBalanca = millis();
+    balancaTarada = false;
 
     // MOVIMENTO
-    Wire.begin();
-    if (!lox.begin())
+    perfilAtual = perfilPedido.load();
+    if (!halDistanciaIniciar(VL53_GPIO1_PIN, (PerfilDistancia)perfilAtual))
     {
-        Serial.println("Falha ao iniciar o sensor de movimento. Verifique a conexão.");
+        REGISTRAR_ERRO("Falha ao iniciar o sensor de movimento. Verifique a conexão.");
     }
 
     // LUZ
-    pinMode(pinSensorLuz, INPUT);
+    if (!iniciarLuz(pinSensorLuz))
+    {
+        REGISTRAR_ERRO("Falha ao iniciar a amostragem do sensor de luz.");
+    }
 }
 
 //* ------------------- LOOP DE MONITORAMENTO -------------------
-void atualizarMonitoramento()
+bool atualizarMonitoramento()
 {
+    // Uma leitura atomica quando nada mudou
+    ConfiguracaoSafezone nova;
+    if (atualizarConfiguracao(nova, geracaoConfiguracaoVista))
+        aplicarConfiguracaoSensores(nova, false);
     unsigned long agora = millis();
+    bool leu = false;
+    uint32_t marca = marcarEtapa();
 
     // --- SENSOR DE PRESSAO ---
-    if (agora - tempoAnteriorPressao >= INTERVALO_PRESSAO)
+    // O peso filtrado ja esta pronto (balanca.h): so e consultado, sem esperar o HX711,
+    // e so conta como leitura quando ha uma conversao nova.
+    LeituraBalanca balanca = leituraBalanca();
+    if (!balancaTarada)
+    {
+        if (agora - inicioBalanca >= ESPERA_TARA_MS)
+        {
+            tararBalanca();
+            balancaTarada = true;
+            ultimaConversaoPressao = leituraBalanca().conversoes; // So leituras depois da tara
+            REGISTRAR_INFO("Sensor de pressão iniciado");
+        }
+    }
+    else if (balanca.conversoes != ultimaConversaoPressao &&
+        agora - tempoAnteriorPressao >= (unsigned long)configuracao.intervaloMs[AMOSTRA_PRESSAO])
     {
         tempoAnteriorPressao = agora;
-        medida = scale.get_units(5);
-        if (medida < 0)
-            medida = 0;
+        ultimaConversaoPressao = balanca.conversoes;
+        int32_t gramas = balanca.gramas < 0 ? 0 : balanca.gramas;
 
-        alarmeSensorPressao = (medida >= LIMIAR_PESO);
+        leitura.medida = gramas / 1000.0f;
+        entradas[ENTRADA_PESO] = gramas;
+        registrarAmostra(AMOSTRA_PRESSAO, gramas, balanca.instante);
+        leu = true;
     }
+    marca = medirEtapa(ETAPA_PRESSAO, marca);
 
     // --- SENSOR DE MOVIMENTO ---
-    if (agora - ultimoMillisMovimento >= INTERVALO_MOVIMENTO)
+    // Medida continua: sem resultado novo do sensor a chamada nao faz I2C nenhum.
+    if (perfilPedido.load() != perfilAtual)
     {
-        ultimoMillisMovimento = agora;
-
-        VL53L0X_RangingMeasurementData_t measure;
-        lox.rangingTest(&measure, false);
-        distanciaCM = measure.RangeMilliMeter / 10;
-        if (distanciaCM < 40)
-        {
-            alarmeSensorMovimento = 1;
-        }
-        else
+        perfilAtual = perfilPedido.load();
+        halDistanciaPerfil((PerfilDistancia)perfilAtual);
+    }
+    if (agora - ultimoMillisMovimento >= (unsigned long)configuracao.intervaloMs[AMOSTRA_DISTANCIA])
+    {
+        uint16_t distanciaMM = 0;
+        MedidaDistancia medida = halDistanciaLer(distanciaMM);
+        if (medida != DISTANCIA_PENDENTE)
         {
-            alarmeSensorMovimento = 0;
+            ultimoMillisMovimento = agora;
+            if (medida == DISTANCIA_VALIDA)
+            {
+                leitura.distanciaCM = distanciaMM / 10;
+                entradas[ENTRADA_DISTANCIA] = distanciaMM;
+                registrarAmostra(AMOSTRA_DISTANCIA, distanciaMM, millis());
+            }
+            else
+            {
+                // Nada no alcance: nao vira uma distancia inventada nem dispara o alarme
+                leitura.distanciaCM = -1;
+                entradas[ENTRADA_DISTANCIA] = FUSAO_SEM_MEDIDA;
+                registrarAmostra(AMOSTRA_DISTANCIA, -1, millis());
+            }
+            leu = true;
         }
     }
+    marca = medirEtapa(ETAPA_DISTANCIA, marca);
 
     // --- SENSOR DE LUZ ---
-    if (agora - ultimoMillisLuz >= INTERVALO_LUZ)
+    // O detector roda a cada amostra do ADC (luz.h); aqui so se copia o resultado, na
+    // hora quando o alarme muda e, fora isso, no intervalo configurado.
+    LeituraLuz luz = leituraLuz();
+    if (luz.amostras != ultimaAmostraLuz &&
+        (luz.alarme != entradas[ENTRADA_LUZ] || agora - ultimoMillisLuz >= (unsigned long)configuracao.intervaloMs[AMOSTRA_LUZ]))
     {
         ultimoMillisLuz = agora;
+        ultimaAmostraLuz = luz.amostras;
 
-        leituraLDR = analogRead(pinSensorLuz);
-        alarmeSensorLuz = (leituraLDR > LIMIAR_LUZ);
+        leitura.leituraLDR = luz.nivel;
+        entradas[ENTRADA_LUZ] = luz.alarme;
+        registrarAmostra(AMOSTRA_LUZ, luz.nivel, luz.instante);
+        leu = true;
     }
+    marca = medirEtapa(ETAPA_LUZ, marca);
+
+    // --- FUSAO DOS ALARMES ---
+    // A cada chamada, mesmo sem leitura nova, para que as confirmacoes e retencoes
+    // vencam na hora. Uma mudanca de alarme conta como leitura.
+    ResultadoFusao fusao = avaliarFusao(entradas, agora);
+    bool pressao = fusao.entradas & (1 << ENTRADA_PESO);
+    bool movimento = fusao.entradas & (1 << ENTRADA_DISTANCIA);
+    bool luzAtiva = fusao.entradas & (1 << ENTRADA_LUZ);
+    if (pressao != leitura.alarmePressao || movimento != leitura.alarmeMovimento ||
+        luzAtiva != leitura.alarmeLuz || fusao.alarme != leitura.alarme || fusao.causa != leitura.causaAlarme)
+    {
+        leitura.alarmePressao = pressao;
+        leitura.alarmeMovimento = movimento;
+        leitura.alarmeLuz = luzAtiva;
+        leitura.alarme = fusao.alarme;
+        leitura.causaAlarme = fusao.causa;
+        leu = true;
+    }
+    medirEtapa(ETAPA_FUSAO, marca);
+
+    if (leu)
+        leitura.instante = millis();
 
     // --- RESUMO SERIAL PARA DEBUG ---
     /* Serial.println("===== RESUMO MONITORAMENTO =====");
     Serial.print("Alarme Pressão: ");
-    Serial.print(alarmeSensorPressao ? "ATIVO" : "inativo");
+    Serial.print(leitura.alarmePressao ? "ATIVO" : "inativo");
     Serial.print(" | Peso: ");
-    Serial.print(medida, 2);
+    Serial.print(leitura.medida, 2);
     Serial.println(" kg");
 
     Serial.print("Alarme Movimento: ");
-    Serial.print(alarmeSensorMovimento ? "ATIVO" : "inativo");
+    Serial.print(leitura.alarmeMovimento ? "ATIVO" : "inativo");
     Serial.print(" | Distância: ");
-    if (distanciaCM != -1)
-        Serial.print(distanciaCM);
+    if (leitura.distanciaCM != -1)
+        Serial.print(leitura.distanciaCM);
     else
         Serial.print("Fora de alcance");
     Serial.println(" cm");
 
     Serial.print("Alarme Luz: ");
-    Serial.print(alarmeSensorLuz ? "ATIVO" : "inativo");
+    Serial.print(leitura.alarmeLuz ? "ATIVO" : "inativo");
     Serial.print(" | Leitura LDR: ");
-    Serial.println(leituraLDR);
+    Serial.println(leitura.leituraLDR);
+
+    Serial.print("Alarme fundido: ");
+    Serial.println(leitura.alarme ? nomeCausaAlarme(leitura.causaAlarme) : "inativo");
 
     Serial.println("================================"); */
-}
\ No newline at end of file
+
+    return leu;
+}
+
+const LeituraSensores &leituraMonitoramento()
+{
+    return leitura;
+}
+
+void definirPerfilDistancia(PerfilDistancia perfil)
+{
+    if (perfil < NUM_PERFIS_DISTANCIA)
+        perfilPedido.store(perfil);
+}
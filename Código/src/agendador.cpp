@@ -0,0 +1,286 @@
+#include "agendador.h"
+
+enum EstadoTrabalho
+{
+    TRABALHO_LIVRE,
+    TRABALHO_PARADO,
+    TRABALHO_AGENDADO,
+    TRABALHO_EXECUTANDO, // Fora da roda; agendar() durante a execucao vale
+};
+
+static const uint8_t MASCARA_POSICAO = Agendador::POSICOES - 1;
+static const uint16_t VENCIDOS = Agendador::NIVEIS * Agendador::POSICOES; // Lista extra
+static const uint32_t ALCANCE_MS = 1UL << (Agendador::BITS_NIVEL * Agendador::NIVEIS);
+
+// Primeira posicao ocupada a partir de `indice`, dando a volta. Retorna a distancia
+// (0 a 63) ou -1 com o nivel vazio.
+static int distanciaOcupada(uint64_t ocupadas, uint8_t indice)
+{
+    if (!ocupadas)
+        return -1;
+    uint64_t girado = (ocupadas >> indice) | (indice ? ocupadas << (Agendador::POSICOES - indice) : 0);
+    return __builtin_ctzll(girado);
+}
+
+Agendador::Agendador(TrabalhoAgendado *trabalhos, uint16_t capacidade)
+    : _trabalhos(trabalhos), _capacidade(capacidade)
+{
+    for (uint16_t &lista : _listas)
+        lista = SEM_TRABALHO;
+    for (uint16_t i = 0; i < capacidade; i++)
+        _trabalhos[i].estado = TRABALHO_LIVRE;
+}
+
+uint16_t Agendador::registrar(const char *nome, FuncaoTrabalho funcao, void *contexto,
+                              uint32_t periodoMs, uint32_t orcamentoUs)
+{
+    if (!funcao || _quantidade >= _capacidade)
+        return SEM_TRABALHO;
+
+    uint16_t id = _quantidade++;
+    TrabalhoAgendado &t = _trabalhos[id];
+    t = {};
+    t.nome = nome;
+    t.funcao = funcao;
+    t.contexto = contexto;
+    t.periodoMs = periodoMs;
+    t.orcamentoUs = orcamentoUs;
+    t.estado = TRABALHO_PARADO;
+    t.estatisticas.nome = nome;
+    return id;
+}
+
+// ------------------- RODA -------------------
+
+// Coloca o trabalho na posicao do seu prazo: o menor nivel cujo alcance a partir de
+// _atual cobre o prazo. Prazos ja passados vao para _atual; alem do alcance, para a
+// ultima posicao do ultimo nivel (voltam a ser avaliados quando ela descer).
+void Agendador::inserir(uint16_t id)
+{
+    TrabalhoAgendado &t = _trabalhos[id];
+    uint32_t prazo = t.prazo;
+    uint32_t delta = prazo - _atual;
+    if ((int32_t)delta < 0)
+    {
+        prazo = _atual;
+        delta = 0;
+    }
+    else if (delta >= ALCANCE_MS)
+    {
+        prazo = _atual + ALCANCE_MS - 1;
+        delta = ALCANCE_MS - 1;
+    }
+
+    uint8_t nivel = 0;
+    while (delta >> (BITS_NIVEL * (nivel + 1)))
+        nivel++;
+    uint8_t indice = (prazo >> (BITS_NIVEL * nivel)) & MASCARA_POSICAO;
+    uint16_t posicao = nivel * POSICOES + indice;
+
+    t.posicao = posicao;
+    t.anterior = SEM_TRABALHO;
+    t.proximo = _listas[posicao];
+    if (t.proximo != SEM_TRABALHO)
+        _trabalhos[t.proximo].anterior = id;
+    _listas[posicao] = id;
+    _ocupadas[nivel] |= 1ULL << indice;
+    t.estado = TRABALHO_AGENDADO;
+}
+
+void Agendador::retirar(uint16_t id)
+{
+    TrabalhoAgendado &t = _trabalhos[id];
+    if (t.anterior != SEM_TRABALHO)
+        _trabalhos[t.anterior].proximo = t.proximo;
+    else
+        _listas[t.posicao] = t.proximo;
+    if (t.proximo != SEM_TRABALHO)
+        _trabalhos[t.proximo].anterior = t.anterior;
+    if (_listas[t.posicao] == SEM_TRABALHO && t.posicao != VENCIDOS)
+        _ocupadas[t.posicao / POSICOES] &= ~(1ULL << (t.posicao & MASCARA_POSICAO));
+    t.estado = TRABALHO_PARADO;
+}
+
+// A roda chegou a posicao `indice` do nivel: os trabalhos dela (prazo dentro das
+// proximas 64 posicoes do nivel de baixo) sao reinseridos mais abaixo.
+void Agendador::descer(uint8_t nivel, uint8_t indice)
+{
+    uint16_t posicao = nivel * POSICOES + indice;
+    uint16_t id = _listas[posicao];
+    _listas[posicao] = SEM_TRABALHO;
+    _ocupadas[nivel] &= ~(1ULL << indice);
+    while (id != SEM_TRABALHO)
+    {
+        uint16_t proximo = _trabalhos[id].proximo;
+        inserir(id);
+        id = proximo;
+    }
+}
+
+// ------------------- EXECUCAO -------------------
+
+bool Agendador::agendar(uint16_t id, uint32_t atrasoMs)
+{
+    if (id >= _quantidade)
+        return false;
+    uint32_t agora = millis();
+    if (!_iniciado)
+    {
+        _atual = agora;
+        _iniciado = true;
+    }
+
+    TrabalhoAgendado &t = _trabalhos[id];
+    if (t.estado == TRABALHO_AGENDADO)
+        retirar(id);
+    t.prazo = agora + atrasoMs;
+    inserir(id);
+    return true;
+}
+
+bool Agendador::parar(uint16_t id)
+{
+    if (id >= _quantidade)
+        return false;
+    if (_trabalhos[id].estado == TRABALHO_AGENDADO)
+        retirar(id);
+    _trabalhos[id].estado = TRABALHO_PARADO;
+    return true;
+}
+
+bool Agendador::agendado(uint16_t id) const
+{
+    return id < _quantidade && _trabalhos[id].estado == TRABALHO_AGENDADO;
+}
+
+void Agendador::rodar(uint16_t id, unsigned long agora)
+{
+    TrabalhoAgendado &t = _trabalhos[id];
+    EstatisticasTrabalho &e = t.estatisticas;
+    uint32_t atraso = (int32_t)(agora - t.prazo) > 0 ? agora - t.prazo : 0;
+
+    t.estado = TRABALHO_EXECUTANDO;
+    unsigned long inicio = micros();
+    t.funcao(t.contexto);
+    uint32_t duracao = micros() - inicio;
+
+    e.execucoes++;
+    e.atrasoTotalMs += atraso;
+    if (atraso > e.atrasoMaximoMs)
+        e.atrasoMaximoMs = atraso;
+    e.duracaoTotalUs += duracao;
+    if (duracao > e.duracaoMaximaUs)
+        e.duracaoMaximaUs = duracao;
+    if (t.orcamentoUs && duracao > t.orcamentoUs)
+        e.estouros++;
+
+    if (t.estado != TRABALHO_EXECUTANDO)
+        return; // O proprio trabalho se reagendou ou parou
+    if (!t.periodoMs)
+    {
+        t.estado = TRABALHO_PARADO;
+        return;
+    }
+
+    // Proximo prazo na grade do periodo; os que ja passaram sao pulados, nao acumulados
+    t.prazo += t.periodoMs;
+    if ((int32_t)(t.prazo - agora) <= 0)
+    {
+        uint32_t pulados = (agora - t.prazo) / t.periodoMs + 1;
+        e.perdidos += pulados;
+        t.prazo += pulados * t.periodoMs;
+    }
+    inserir(id);
+}
+
+// Distancia de _atual ate o proximo evento da roda: o prazo mais proximo do nivel 0 ou
+// a proxima descida de uma posicao ocupada dos niveis de cima. UINT32_MAX sem nenhum.
+uint32_t Agendador::distanciaProximo() const
+{
+    uint32_t proximo = UINT32_MAX;
+    int distancia = distanciaOcupada(_ocupadas[0], _atual & MASCARA_POSICAO);
+    if (distancia >= 0)
+        proximo = distancia;
+
+    for (uint8_t nivel = 1; nivel < NIVEIS; nivel++)
+    {
+        if (!_ocupadas[nivel])
+            continue;
+        uint8_t deslocamento = BITS_NIVEL * nivel;
+        uint32_t passo = 1UL << deslocamento;
+        uint32_t virada = (_atual + passo - 1) & ~(passo - 1);
+        distancia = distanciaOcupada(_ocupadas[nivel], (virada >> deslocamento) & MASCARA_POSICAO);
+        uint32_t ate = virada - _atual + (uint32_t)distancia * passo;
+        if (ate < proximo)
+            proximo = ate;
+    }
+    return proximo;
+}
+
+uint16_t Agendador::executar(unsigned long agora)
+{
+    if (!_iniciado)
+    {
+        _atual = agora;
+        _iniciado = true;
+    }
+
+    uint16_t executados = 0;
+    while ((int32_t)(agora - _atual) >= 0)
+    {
+        // Sem evento ate `agora`: as posicoes no caminho estao vazias e sao puladas
+        uint32_t distancia = distanciaProximo();
+        if (distancia > agora - _atual)
+        {
+            _atual = agora + 1;
+            break;
+        }
+        _atual += distancia;
+
+        // Descidas na virada de cada nivel
+        for (uint8_t nivel = 1; nivel < NIVEIS; nivel++)
+        {
+            if (_atual & ((1UL << (BITS_NIVEL * nivel)) - 1))
+                break;
+            descer(nivel, (_atual >> (BITS_NIVEL * nivel)) & MASCARA_POSICAO);
+        }
+
+        // Os vencidos vao para uma lista propria antes de rodar: um trabalho que se
+        // reagenda cai numa posicao da roda, nunca nesta mesma passada, e agendar() ou
+        // parar() de outro vencido continua valendo
+        uint8_t indice = _atual & MASCARA_POSICAO;
+        uint16_t id = _listas[indice];
+        _listas[indice] = SEM_TRABALHO;
+        _ocupadas[0] &= ~(1ULL << indice);
+        for (uint16_t i = id; i != SEM_TRABALHO; i = _trabalhos[i].proximo)
+            _trabalhos[i].posicao = VENCIDOS;
+        _listas[VENCIDOS] = id;
+        _atual++;
+
+        while ((id = _listas[VENCIDOS]) != SEM_TRABALHO)
+        {
+            retirar(id);
+            rodar(id, agora);
+            executados++;
+        }
+    }
+    return executados;
+}
+
+uint32_t Agendador::msAteProximo(unsigned long agora) const
+{
+    if (!_iniciado)
+        return UINT32_MAX;
+    uint32_t distancia = distanciaProximo();
+    if (distancia == UINT32_MAX)
+        return UINT32_MAX;
+    uint32_t prazo = _atual + distancia;
+    return (int32_t)(prazo - agora) > 0 ? prazo - agora : 0;
+}
+
+EstatisticasTrabalho Agendador::estatisticas(uint16_t id) const
+{
+    if (id >= _quantidade)
+        return EstatisticasTrabalho{"", 0, 0, 0, 0, 0, 0, 0};
+    return _trabalhos[id].estatisticas;
+}
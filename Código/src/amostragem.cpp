@@ -0,0 +1,104 @@
+#include "amostragem.h"
+#include "filaSpsc.h"
+
+struct Amostra
+{
+    unsigned long instante; // millis()
+    int32_t valor;
+};
+
+// Pelo menos dois quadros completos de folga por sensor.
+static FilaSpsc<Amostra, 2 * QUADRO_MAX_AMOSTRAS> aneis[NUM_SENSORES_AMOSTRADOS];
+static ConfiguracaoAmostragem configuracao = AMOSTRAGEM_PADRAO;
+
+// Acessados apenas pela tarefa de rede
+struct QuadroEmMontagem
+{
+    QuadroAmostras quadro;
+    Amostra sobra; // Recebida do anel mas longe demais da primeira (uint16 em ms)
+    bool temSobra;
+};
+static QuadroEmMontagem montagem[NUM_SENSORES_AMOSTRADOS];
+static unsigned long quadrosMontados = 0;
+
+void configurarAmostragem(const ConfiguracaoAmostragem &nova)
+{
+    configuracao = nova;
+    if (configuracao.amostrasPorQuadro < 1)
+        configuracao.amostrasPorQuadro = 1;
+    if (configuracao.amostrasPorQuadro > QUADRO_MAX_AMOSTRAS)
+        configuracao.amostrasPorQuadro = QUADRO_MAX_AMOSTRAS;
+}
+
+const ConfiguracaoAmostragem &configuracaoAmostragem()
+{
+    return configuracao;
+}
+
+void registrarAmostra(SensorAmostrado sensor, int32_t valor, unsigned long instante)
+{
+    if (!configuracao.ativa)
+        return;
+    Amostra amostra = {instante, valor};
+    aneis[sensor].enviar(amostra);
+}
+
+static void acrescentar(QuadroAmostras &quadro, const Amostra &amostra)
+{
+    if (quadro.quantidade == 0)
+        quadro.instanteMs = amostra.instante;
+    AmostraQuadro &destino = quadro.amostras[quadro.quantidade++];
+    destino.deslocamentoMs = (uint16_t)(amostra.instante - quadro.instanteMs);
+    destino.valor = amostra.valor;
+}
+
+bool montarQuadroAmostras(SensorAmostrado sensor, unsigned long agora, QuadroAmostras &quadro)
+{
+    QuadroEmMontagem &m = montagem[sensor];
+    uint8_t limite = configuracao.amostrasPorQuadro;
+    bool separar = false; // A proxima amostra nao cabe no deslocamento de 16 bits
+
+    if (m.temSobra && m.quadro.quantidade == 0)
+    {
+        acrescentar(m.quadro, m.sobra);
+        m.temSobra = false;
+    }
+
+    Amostra amostra;
+    while (!m.temSobra && m.quadro.quantidade < limite && aneis[sensor].receber(amostra))
+    {
+        if (m.quadro.quantidade && amostra.instante - m.quadro.instanteMs > 0xFFFF)
+        {
+            m.sobra = amostra;
+            m.temSobra = true;
+            separar = true;
+            break;
+        }
+        acrescentar(m.quadro, amostra);
+    }
+
+    if (m.quadro.quantidade == 0)
+        return false;
+    bool cheio = m.quadro.quantidade >= limite;
+    bool velho = agora - m.quadro.instanteMs >= configuracao.idadeMaximaMs;
+    if (!cheio && !velho && !separar)
+        return false;
+
+    quadro = m.quadro;
+    quadro.sensor = sensor;
+    m.quadro.quantidade = 0;
+    quadrosMontados++;
+    return true;
+}
+
+EstatisticasAmostragem estatisticasAmostragem()
+{
+    EstatisticasAmostragem estatisticas;
+    for (uint8_t i = 0; i < NUM_SENSORES_AMOSTRADOS; i++)
+    {
+        estatisticas.amostras[i] = aneis[i].enviados();
+        estatisticas.descartadas[i] = aneis[i].descartes();
+    }
+    estatisticas.quadros = quadrosMontados;
+    return estatisticas;
+}
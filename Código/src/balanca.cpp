@@ -0,0 +1,96 @@
+#include "balanca.h"
+#include "hal.h"
+#include <atomic>
+
+// ------------------- FILTRO -------------------
+// Escrito apenas pelo callback da HAL (uma conversao por vez). O estado do IIR guarda
+// 8 bits fracionarios em 64 bits: o valor bruto tem 24 bits com sinal.
+static const uint8_t JANELA_MEDIANA = 5;
+static const uint8_t IIR_DESLOCAMENTO = 2; // alfa = 1 / 2^2
+static const uint8_t IIR_FRACAO = 8;
+
+static int32_t janela[JANELA_MEDIANA];
+static uint8_t posicaoJanela = 0;
+static uint8_t preenchidas = 0;
+static int64_t estadoIir = 0;
+
+// ------------------- SAIDA -------------------
+static std::atomic<int32_t> filtradoBruto{0};
+static std::atomic<int32_t> tara{0};
+static std::atomic<int32_t> contagensKg{1};
+static std::atomic<int32_t> gramas{0};
+static std::atomic<uint32_t> conversoes{0};
+static std::atomic<unsigned long> instante{0};
+
+static int32_t medianaJanela()
+{
+    // Insercao numa copia de no maximo 5 valores: custo constante
+    int32_t ordenado[JANELA_MEDIANA];
+    for (uint8_t i = 0; i < preenchidas; i++)
+    {
+        int32_t valor = janela[i];
+        uint8_t j = i;
+        for (; j > 0 && ordenado[j - 1] > valor; j--)
+            ordenado[j] = ordenado[j - 1];
+        ordenado[j] = valor;
+    }
+    return ordenado[preenchidas / 2];
+}
+
+static int32_t paraGramas(int32_t bruto)
+{
+    return (int32_t)((int64_t)(bruto - tara.load()) * 1000 / contagensKg.load());
+}
+
+static void aoConverter(int32_t bruto)
+{
+    janela[posicaoJanela] = bruto;
+    posicaoJanela = (posicaoJanela + 1) % JANELA_MEDIANA;
+    if (preenchidas < JANELA_MEDIANA)
+        preenchidas++;
+
+    int64_t entrada = (int64_t)medianaJanela() << IIR_FRACAO;
+    if (conversoes.load() == 0)
+        estadoIir = entrada;
+    else
+        estadoIir += (entrada - estadoIir) >> IIR_DESLOCAMENTO;
+
+    int32_t filtrado = (int32_t)(estadoIir >> IIR_FRACAO);
+    filtradoBruto.store(filtrado);
+    gramas.store(paraGramas(filtrado));
+    instante.store(millis());
+    conversoes.fetch_add(1);
+}
+
+bool iniciarBalanca(int pinoDout, int pinoSck, int32_t contagensPorKg)
+{
+    calibrarBalanca(contagensPorKg);
+    halBalancaIniciar(pinoDout, pinoSck);
+    halBalancaLigar();
+    return halBalancaContinua(aoConverter);
+}
+
+bool calibrarBalanca(int32_t contagensPorKg)
+{
+    if (contagensPorKg <= 0)
+        return false;
+    contagensKg.store(contagensPorKg);
+    gramas.store(paraGramas(filtradoBruto.load()));
+    return true;
+}
+
+void tararBalanca()
+{
+    int32_t atual = filtradoBruto.load();
+    tara.store(atual);
+    gramas.store(paraGramas(atual));
+}
+
+LeituraBalanca leituraBalanca()
+{
+    LeituraBalanca leitura;
+    leitura.conversoes = conversoes.load();
+    leitura.gramas = gramas.load();
+    leitura.instante = instante.load();
+    return leitura;
+}
@@ -0,0 +1,216 @@
+#include <stddef.h>
+#include "caixaDeSaida.h"
+#include "modelosDigitais.h"
+
+static const uint8_t MARCA_REGISTRO = 0xC5;
+
+// CRC-32 (IEEE) do registro, o mesmo dos pedacos de modelos (modelosDigitais.h).
+static uint32_t crcRegistro(uint32_t sequencia, uint16_t tamanho, const uint8_t *dados)
+{
+    uint32_t crc = crc32Pedaco(0, (const uint8_t *)&sequencia, sizeof(sequencia));
+    crc = crc32Pedaco(crc, (const uint8_t *)&tamanho, sizeof(tamanho));
+    return crc32Pedaco(crc, dados, tamanho);
+}
+
+// ------------------- VARREDURA NA INICIALIZACAO -------------------
+
+bool CaixaDeSaida::iniciar()
+{
+    _setores = halFlashTamanho() / HAL_SETOR_FLASH;
+    if (_setores < 2)
+    {
+        _setores = 0;
+        return false;
+    }
+
+    // 1a passagem: o registro mais novo da a posicao de escrita e a marca de entrega
+    // mais nova diz ate onde o broker ja recebeu.
+    uint32_t maiorSequencia = 0;
+    uint32_t entregueAte = 0;
+    Cabecalho cabecalho;
+    _escrita = 0;
+    for (uint32_t setor = 0; setor < _setores; setor++)
+    {
+        uint32_t endereco = setor * HAL_SETOR_FLASH;
+        bool temMaior = false;
+        while (lerRegistro(endereco, cabecalho))
+        {
+            if (cabecalho.sequencia > maiorSequencia)
+            {
+                maiorSequencia = cabecalho.sequencia;
+                temMaior = true;
+            }
+            if (cabecalho.entregue == 0 && cabecalho.sequencia > entregueAte)
+                entregueAte = cabecalho.sequencia;
+            endereco += sizeof(Cabecalho) + cabecalho.tamanho;
+        }
+        if (!temMaior)
+            continue;
+
+        // Depois do ultimo registro o setor deve estar apagado. Se uma gravacao foi
+        // interrompida ali, o resto do setor e abandonado.
+        _escrita = endereco % capacidadeBytes();
+        uint32_t livre = HAL_SETOR_FLASH - endereco % HAL_SETOR_FLASH;
+        if (endereco % HAL_SETOR_FLASH && livre >= sizeof(Cabecalho))
+        {
+            uint8_t apos[sizeof(Cabecalho)];
+            halFlashLer(endereco, apos, sizeof(apos));
+            for (uint8_t byte : apos)
+                if (byte != 0xFF)
+                    _escrita = proximoSetor(endereco);
+        }
+    }
+    _proximaSequencia = maiorSequencia + 1;
+
+    // 2a passagem: o pendente mais antigo e o de menor sequencia apos a marca.
+    _leitura = _escrita;
+    _sequenciaLeitura = _proximaSequencia;
+    for (uint32_t setor = 0; setor < _setores; setor++)
+    {
+        uint32_t endereco = setor * HAL_SETOR_FLASH;
+        while (lerRegistro(endereco, cabecalho))
+        {
+            if (cabecalho.sequencia > entregueAte && cabecalho.sequencia < _sequenciaLeitura)
+            {
+                _leitura = endereco;
+                _sequenciaLeitura = cabecalho.sequencia;
+            }
+            endereco += sizeof(Cabecalho) + cabecalho.tamanho;
+        }
+    }
+    return true;
+}
+
+// ------------------- GRAVACAO -------------------
+
+uint32_t CaixaDeSaida::anexar(const uint8_t *dados, uint16_t tamanho)
+{
+    if (!_setores || tamanho == 0 || tamanho > CAIXA_TAMANHO_MAXIMO)
+        return 0;
+
+    uint32_t total = sizeof(Cabecalho) + tamanho;
+    if (_escrita % HAL_SETOR_FLASH + total > HAL_SETOR_FLASH)
+        _escrita = proximoSetor(_escrita);
+    if (pendentes() == 0)
+        _leitura = _escrita;
+    if (_escrita % HAL_SETOR_FLASH == 0)
+        liberarSetor(_escrita);
+
+    Cabecalho cabecalho = {MARCA_REGISTRO, 0xFF, tamanho, _proximaSequencia, crcRegistro(_proximaSequencia, tamanho, dados)};
+    memcpy(_registro, &cabecalho, sizeof(cabecalho));
+    memcpy(_registro + sizeof(cabecalho), dados, tamanho);
+    if (!halFlashEscrever(_escrita, _registro, total))
+    {
+        _estatisticas.falhasFlash++;
+        _escrita = proximoSetor(_escrita); // O trecho pode ter ficado meio escrito
+        return 0;
+    }
+
+    _escrita = (_escrita + total) % capacidadeBytes();
+    _estatisticas.anexados++;
+    return _proximaSequencia++;
+}
+
+// O setor vai ser reaproveitado: registros ainda pendentes nele sao perdidos.
+void CaixaDeSaida::liberarSetor(uint32_t endereco)
+{
+    if (pendentes() && _leitura / HAL_SETOR_FLASH == endereco / HAL_SETOR_FLASH)
+    {
+        Cabecalho cabecalho;
+        uint32_t perdido = _leitura;
+        while (perdido / HAL_SETOR_FLASH == endereco / HAL_SETOR_FLASH && lerRegistro(perdido, cabecalho))
+        {
+            _estatisticas.perdidos++;
+            perdido += sizeof(Cabecalho) + cabecalho.tamanho;
+        }
+
+        _leitura = proximoSetor(endereco);
+        if (lerRegistro(_leitura, cabecalho))
+        {
+            _sequenciaLeitura = cabecalho.sequencia;
+        }
+        else
+        {
+            _leitura = endereco;
+            _sequenciaLeitura = _proximaSequencia;
+        }
+    }
+
+    if (!halFlashApagarSetor(endereco))
+        _estatisticas.falhasFlash++;
+}
+
+// ------------------- ENTREGA -------------------
+
+unsigned CaixaDeSaida::drenar(unsigned long agora, PublicarRegistro publicar)
+{
+    if (!pendentes() || agora - _ultimoLote < _configuracao.intervaloLoteMs)
+        return 0;
+    _ultimoLote = agora;
+
+    unsigned enviados = 0;
+    uint32_t ultimo = 0;
+    Cabecalho cabecalho;
+    while (enviados < _configuracao.loteMaximo && proximoPendente(cabecalho))
+    {
+        if (!publicar(cabecalho.sequencia, _registro + sizeof(Cabecalho), cabecalho.tamanho))
+            break;
+        ultimo = _leitura;
+        _leitura = (_leitura + sizeof(Cabecalho) + cabecalho.tamanho) % capacidadeBytes();
+        _sequenciaLeitura = cabecalho.sequencia + 1;
+        enviados++;
+    }
+
+    if (enviados)
+    {
+        // Uma unica escrita de 1 byte por lote, sem apagar: 0xFF -> 0x00
+        uint8_t entregue = 0;
+        if (!halFlashEscrever(ultimo + offsetof(Cabecalho, entregue), &entregue, 1))
+            _estatisticas.falhasFlash++;
+        _estatisticas.entregues += enviados;
+        _estatisticas.lotes++;
+    }
+    return enviados;
+}
+
+// Posiciona a leitura no proximo registro valido, pulando o fim de setores.
+bool CaixaDeSaida::proximoPendente(Cabecalho &cabecalho)
+{
+    for (uint32_t saltos = 0; saltos <= _setores; saltos++)
+    {
+        if (_leitura == _escrita)
+            break;
+        if (lerRegistro(_leitura, cabecalho) && cabecalho.sequencia >= _sequenciaLeitura)
+        {
+            _sequenciaLeitura = cabecalho.sequencia; // Pula sequencias perdidas
+            return true;
+        }
+        _leitura = proximoSetor(_leitura);
+    }
+    _leitura = _escrita;
+    _sequenciaLeitura = _proximaSequencia;
+    return false;
+}
+
+// ------------------- AUXILIARES -------------------
+
+// Le cabecalho e dados para _registro e confere marca, limites e CRC.
+bool CaixaDeSaida::lerRegistro(uint32_t endereco, Cabecalho &cabecalho)
+{
+    uint32_t deslocamento = endereco % HAL_SETOR_FLASH;
+    if (deslocamento + sizeof(Cabecalho) > HAL_SETOR_FLASH ||
+        !halFlashLer(endereco, &cabecalho, sizeof(cabecalho)) || cabecalho.marca != MARCA_REGISTRO)
+        return false;
+    if (cabecalho.tamanho == 0 || cabecalho.tamanho > CAIXA_TAMANHO_MAXIMO ||
+        deslocamento + sizeof(Cabecalho) + cabecalho.tamanho > HAL_SETOR_FLASH)
+        return false;
+
+    uint8_t *dados = _registro + sizeof(Cabecalho);
+    return halFlashLer(endereco + sizeof(Cabecalho), dados, cabecalho.tamanho) &&
+           crcRegistro(cabecalho.sequencia, cabecalho.tamanho, dados) == cabecalho.crc;
+}
+
+uint32_t CaixaDeSaida::proximoSetor(uint32_t endereco) const
+{
+    return (endereco / HAL_SETOR_FLASH + 1) % _setores * HAL_SETOR_FLASH;
+}
@@ -0,0 +1,170 @@
+#include <Arduino.h>
+#include "conexaoMqtt.h"
+#include "backoff.h"
+#include "hal.h"
+#include "diagnostico.h"
+#include "registro.h"
+
+// ------- CONFIGURAÇÃO DA RECONEXÃO --------
+
+const unsigned long esperaMinimaMqtt = 1000;   // Primeira espera apos uma falha
+const unsigned long esperaMaximaMqtt = 60000;  // Limite do backoff exponencial
+const uint16_t timeoutTentativaMqtt = 1000;    // Tempo maximo de uma tentativa
+
+static const char *idMqtt = nullptr;
+static EstadoMqtt estado = MQTT_DESCONECTADO;
+static EstatisticasMqtt estatisticas = {0, 0, 0, 0, 0};
+
+struct Assinatura
+{
+    const char *topico;
+    void (*aoReceber)(const uint8_t *dados, unsigned int tamanho);
+};
+
+static Assinatura assinaturas[MAX_ASSINATURAS_MQTT];
+static uint8_t numAssinaturas = 0;
+
+static uint8_t falhasSeguidas = 0;
+static unsigned long proximaTentativa = 0;
+static unsigned long inicioQueda = 0;
+static bool jaConectou = false;
+
+unsigned long esperaReconexaoMqtt(uint8_t falhasSeguidas, uint32_t sorteio)
+{
+    return esperaBackoff(esperaMinimaMqtt, esperaMaximaMqtt, falhasSeguidas, sorteio);
+}
+
+static void receberMqtt(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    for (uint8_t i = 0; i < numAssinaturas; i++)
+        if (strcmp(topico, assinaturas[i].topico) == 0)
+            assinaturas[i].aoReceber(dados, tamanho);
+}
+
+void iniciarMqtt(const char *servidor, int porta, const char *id)
+{
+    idMqtt = id;
+    halMqttServidor(servidor, porta);
+    halMqttTimeoutConexao(timeoutTentativaMqtt);
+    halMqttAoReceber(receberMqtt);
+    estado = MQTT_DESCONECTADO;
+    proximaTentativa = millis();
+    inicioQueda = millis();
+}
+
+static void falharTentativa()
+{
+    estatisticas.falhas++;
+    unsigned long espera = esperaReconexaoMqtt(falhasSeguidas, halAleatorio());
+    if (falhasSeguidas < 255)
+        falhasSeguidas++;
+    proximaTentativa = millis() + espera;
+    estado = MQTT_AGUARDANDO;
+
+    REGISTRAR_AVISO("falha, rc=%d | nova tentativa em %lu ms", halMqttEstado(), espera);
+}
+
+// Chamada a cada passagem do loop. A tentativa de conexao anda uma etapa por chamada
+// (DNS, TCP, CONNACK), sem esperar pela rede; com podeConectar false ela nem comeca
+// nem avanca nesta passagem.
+void atualizarMqtt(bool podeConectar)
+{
+    unsigned long agora = millis();
+
+    if (estado == MQTT_CONECTADO)
+    {
+        if (halMqttConectado())
+        {
+            uint32_t marca = marcarEtapa();
+            halMqttLoop();
+            medirEtapa(ETAPA_MQTT_LOOP, marca);
+            return;
+        }
+        REGISTRAR_AVISO("Conexao MQTT perdida.");
+        inicioQueda = agora;
+        falhasSeguidas = 0;
+        proximaTentativa = agora + esperaReconexaoMqtt(0, halAleatorio());
+        estado = MQTT_AGUARDANDO;
+    }
+
+    if (!halWiFiConectado())
+    {
+        if (estado == MQTT_CONECTANDO)
+            halMqttCancelarConexao();
+        estado = MQTT_DESCONECTADO;
+        return;
+    }
+    if (estado == MQTT_DESCONECTADO)
+        estado = MQTT_AGUARDANDO;
+    if (!podeConectar)
+        return;
+
+    uint32_t marca = marcarEtapa();
+    if (estado == MQTT_AGUARDANDO)
+    {
+        if ((long)(agora - proximaTentativa) < 0)
+            return;
+
+        REGISTRAR_INFO("Conectando ao MQTT...");
+        estatisticas.tentativas++;
+        bool iniciou = halMqttIniciarConexao(idMqtt);
+        medirEtapa(ETAPA_MQTT_CONEXAO, marca);
+        if (!iniciou)
+        {
+            falharTentativa();
+            return;
+        }
+        estado = MQTT_CONECTANDO;
+        return;
+    }
+
+    AndamentoConexaoMqtt andamento = halMqttAndamentoConexao();
+    medirEtapa(ETAPA_MQTT_CONEXAO, marca);
+    if (andamento == CONEXAO_MQTT_PENDENTE)
+        return;
+    if (andamento == CONEXAO_MQTT_PRONTA)
+    {
+        unsigned long duracaoQueda = millis() - inicioQueda;
+        REGISTRAR_INFO("Conectado com sucesso apos %lu ms", duracaoQueda);
+
+        if (jaConectou)
+        {
+            estatisticas.reconexoes++;
+            estatisticas.ultimoTempoReconexao = duracaoQueda;
+            if (duracaoQueda > estatisticas.maiorTempoReconexao)
+                estatisticas.maiorTempoReconexao = duracaoQueda;
+        }
+        jaConectou = true;
+        falhasSeguidas = 0;
+        estado = MQTT_CONECTADO;
+        for (uint8_t i = 0; i < numAssinaturas; i++)
+            halMqttAssinar(assinaturas[i].topico);
+        return;
+    }
+    falharTentativa();
+}
+
+bool assinarMqtt(const char *topico, void (*aoReceber)(const uint8_t *dados, unsigned int tamanho))
+{
+    if (numAssinaturas >= MAX_ASSINATURAS_MQTT)
+        return false;
+    assinaturas[numAssinaturas++] = {topico, aoReceber};
+    if (estado == MQTT_CONECTADO)
+        halMqttAssinar(topico);
+    return true;
+}
+
+bool mqttConectado()
+{
+    return estado == MQTT_CONECTADO;
+}
+
+EstadoMqtt estadoMqtt()
+{
+    return estado;
+}
+
+const EstatisticasMqtt &estatisticasMqtt()
+{
+    return estatisticas;
+}
@@ -0,0 +1,233 @@
+#include "configuracao.h"
+#include "hal.h"
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+// ------------------- CAMPOS -------------------
+// Nome no JSON, posicao na estrutura e faixa aceita. Toda validacao, leitura e escrita
+// de JSON passa por esta tabela.
+struct CampoConfiguracao
+{
+    const char *nome;
+    size_t deslocamento;
+    int32_t minimo;
+    int32_t maximo;
+};
+
+#define CAMPO(nome, membro, minimo, maximo) {nome, offsetof(ConfiguracaoSafezone, membro), minimo, maximo}
+
+static const CampoConfiguracao CAMPOS[] = {
+    CAMPO("armado", armado, 0, 1),
+    CAMPO("limiar_peso_g", limiarPesoG, 100, 200000),
+    CAMPO("histerese_peso_g", histeresePesoG, 0, 50000),
+    CAMPO("limiar_distancia_mm", limiarDistanciaMM, 30, 2000), // Alcance do VL53L0X
+    CAMPO("histerese_distancia_mm", histereseDistanciaMM, 0, 1000),
+    CAMPO("limiar_luz", limiarLuz, 1, 4095),
+    CAMPO("limiar_luz_pct", limiarLuzPercentual, 1, 100),
+    CAMPO("intervalo_pressao_ms", intervaloMs[AMOSTRA_PRESSAO], 0, 60000),
+    CAMPO("intervalo_distancia_ms", intervaloMs[AMOSTRA_DISTANCIA], 0, 60000),
+    CAMPO("intervalo_luz_ms", intervaloMs[AMOSTRA_LUZ], 0, 60000),
+    CAMPO("intervalo_borda_ms", intervaloBordaMs, 0, 60000),
+    CAMPO("heartbeat_ms", heartbeatMs, 1000, 3600000),
+    CAMPO("destravamento_ms", destravamentoMs, 500, 30000),
+    CAMPO("desarme_ms", desarmeMs, 0, 600000),
+    CAMPO("contagens_kg", contagensPorKg, 1000, 10000000),
+};
+static const uint8_t NUM_CAMPOS = sizeof(CAMPOS) / sizeof(CAMPOS[0]);
+
+static int32_t &valorCampo(ConfiguracaoSafezone &configuracao, const CampoConfiguracao &campo)
+{
+    return *(int32_t *)((uint8_t *)&configuracao + campo.deslocamento);
+}
+
+static int32_t valorCampo(const ConfiguracaoSafezone &configuracao, const CampoConfiguracao &campo)
+{
+    return *(const int32_t *)((const uint8_t *)&configuracao + campo.deslocamento);
+}
+
+static const CampoConfiguracao *procurarCampo(const char *nome)
+{
+    for (const CampoConfiguracao &campo : CAMPOS)
+        if (strcmp(campo.nome, nome) == 0)
+            return &campo;
+    return nullptr;
+}
+
+// ------------------- SNAPSHOT -------------------
+// O buffer (geracao & 1) e o vigente; o escritor so toca no outro.
+static ConfiguracaoSafezone buffers[2] = {CONFIGURACAO_PADRAO, CONFIGURACAO_PADRAO};
+static std::atomic<uint32_t> geracao{0};
+
+static void publicar(const ConfiguracaoSafezone &nova)
+{
+    uint32_t g = geracao.load(std::memory_order_relaxed);
+    buffers[(g + 1) & 1] = nova;
+    geracao.store(g + 1, std::memory_order_release);
+}
+
+// Copia o buffer vigente, repetindo se o escritor publicou no meio. Retorna a geracao.
+static uint32_t copiar(ConfiguracaoSafezone &copia)
+{
+    uint32_t g;
+    do
+    {
+        g = geracao.load(std::memory_order_acquire);
+        copia = buffers[g & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (geracao.load(std::memory_order_relaxed) != g);
+    return g;
+}
+
+// ------------------- NVS -------------------
+// Registro da chave "config". Mudou a estrutura, muda a versao: o registro antigo e
+// ignorado e vale o padrao.
+static const char *CHAVE_NVS = "config";
+static const uint16_t VERSAO_NVS = 2; // 2: campo armado
+
+struct RegistroConfiguracao
+{
+    uint16_t versao;
+    ConfiguracaoSafezone valores;
+};
+
+static bool gravar(const ConfiguracaoSafezone &configuracao)
+{
+    RegistroConfiguracao registro;
+    memset(&registro, 0, sizeof(registro));
+    registro.versao = VERSAO_NVS;
+    registro.valores = configuracao;
+    return halNvsGravar(CHAVE_NVS, &registro, sizeof(registro));
+}
+
+// ====================================================================================
+// FUNCOES
+// ====================================================================================
+
+bool iniciarConfiguracao(const ConfiguracaoSafezone &padrao)
+{
+    RegistroConfiguracao registro;
+    bool gravada = halNvsLer(CHAVE_NVS, &registro, sizeof(registro)) &&
+                   registro.versao == VERSAO_NVS && !validarConfiguracao(registro.valores);
+    publicar(gravada ? registro.valores : padrao);
+    return gravada;
+}
+
+ConfiguracaoSafezone configuracaoAtual()
+{
+    ConfiguracaoSafezone copia;
+    copiar(copia);
+    return copia;
+}
+
+uint32_t geracaoConfiguracao()
+{
+    return geracao.load(std::memory_order_acquire);
+}
+
+bool atualizarConfiguracao(ConfiguracaoSafezone &copia, uint32_t &vista)
+{
+    if (geracao.load(std::memory_order_acquire) == vista)
+        return false;
+    vista = copiar(copia);
+    return true;
+}
+
+const char *validarConfiguracao(const ConfiguracaoSafezone &configuracao)
+{
+    for (const CampoConfiguracao &campo : CAMPOS)
+    {
+        int32_t valor = valorCampo(configuracao, campo);
+        if (valor < campo.minimo || valor > campo.maximo)
+            return campo.nome;
+    }
+
+    // Entre campos: o lado de desligar precisa continuar com sentido
+    if (configuracao.histeresePesoG >= configuracao.limiarPesoG)
+        return "histerese_peso_g";
+    return nullptr;
+}
+
+ResultadoConfiguracao aplicarConfiguracao(const ConfiguracaoSafezone &nova)
+{
+    if (validarConfiguracao(nova))
+        return CONFIGURACAO_INVALIDA;
+    if (memcmp(&nova, &buffers[geracao.load(std::memory_order_relaxed) & 1], sizeof(nova)) == 0)
+        return CONFIGURACAO_SEM_MUDANCA;
+
+    publicar(nova);
+    return gravar(nova) ? CONFIGURACAO_APLICADA : CONFIGURACAO_NAO_GRAVADA;
+}
+
+ResultadoConfiguracao aplicarConfiguracaoJson(const uint8_t *dados, size_t tamanho, const char *&erro)
+{
+    // Raro (uma mensagem por ajuste): o documento pode usar o heap
+    JsonDocument documento;
+    erro = "json";
+    if (deserializeJson(documento, dados, tamanho) || !documento.is<JsonObject>())
+        return CONFIGURACAO_INVALIDA;
+
+    ConfiguracaoSafezone nova = configuracaoAtual();
+    for (JsonPair par : documento.as<JsonObject>())
+    {
+        const CampoConfiguracao *campo = procurarCampo(par.key().c_str());
+        if (!campo)
+        {
+            erro = "campo desconhecido";
+            return CONFIGURACAO_INVALIDA;
+        }
+        if (!par.value().is<int32_t>())
+        {
+            erro = campo->nome;
+            return CONFIGURACAO_INVALIDA;
+        }
+        valorCampo(nova, *campo) = par.value().as<int32_t>();
+    }
+
+    erro = validarConfiguracao(nova);
+    if (erro)
+        return CONFIGURACAO_INVALIDA;
+    return aplicarConfiguracao(nova);
+}
+
+size_t serializarConfiguracao(char *buffer, size_t capacidade, const char *status, time_t timestamp)
+{
+    ConfiguracaoSafezone atual;
+    uint32_t g = copiar(atual);
+
+    size_t usado = 0;
+    int n = snprintf(buffer, capacidade, "{");
+    for (uint8_t i = 0; i < NUM_CAMPOS && n >= 0 && usado + n < capacidade; i++)
+    {
+        usado += n;
+        n = snprintf(buffer + usado, capacidade - usado, "\"%s\":%ld,", CAMPOS[i].nome,
+                     (long)valorCampo(atual, CAMPOS[i]));
+    }
+    if (n >= 0 && usado + n < capacidade)
+    {
+        usado += n;
+        n = snprintf(buffer + usado, capacidade - usado, "\"geracao\":%lu,\"status\":\"%s\",\"timestamp\":%ld}",
+                     (unsigned long)g, status, (long)timestamp);
+    }
+    if (n < 0 || usado + n >= capacidade)
+        return 0;
+    return usado + n;
+}
+
+const char *nomeResultadoConfiguracao(ResultadoConfiguracao resultado)
+{
+    switch (resultado)
+    {
+    case CONFIGURACAO_APLICADA:
+        return "aplicada";
+    case CONFIGURACAO_SEM_MUDANCA:
+        return "sem mudanca";
+    case CONFIGURACAO_INVALIDA:
+        return "invalida";
+    case CONFIGURACAO_NAO_GRAVADA:
+        return "nao gravada";
+    default:
+        return "?";
+    }
+}
@@ -0,0 +1,179 @@
+#include "diagnostico.h"
+#include "tarefas.h"
+#include "registro.h"
+
+// ------------------- HISTOGRAMA -------------------
+// Abaixo de 8 cada valor tem a sua faixa; a partir dai a faixa e o expoente (posicao
+// do bit mais alto) seguido dos 3 bits logo abaixo dele.
+
+uint16_t HistogramaLogLinear::faixa(uint32_t valor)
+{
+    if (valor < (1u << BITS_FAIXA))
+        return valor;
+    uint8_t expoente = 31 - __builtin_clz(valor);
+    uint8_t deslocamento = expoente - BITS_FAIXA;
+    return ((deslocamento + 1) << BITS_FAIXA) | ((valor >> deslocamento) & ((1u << BITS_FAIXA) - 1));
+}
+
+uint32_t HistogramaLogLinear::inicioFaixa(uint16_t faixa)
+{
+    if (faixa < (1u << BITS_FAIXA))
+        return faixa;
+    uint8_t deslocamento = (faixa >> BITS_FAIXA) - 1;
+    uint32_t mantissa = (1u << BITS_FAIXA) | (faixa & ((1u << BITS_FAIXA) - 1));
+    return mantissa << deslocamento;
+}
+
+uint32_t HistogramaLogLinear::larguraFaixa(uint16_t faixa)
+{
+    if (faixa < (1u << BITS_FAIXA))
+        return 1;
+    return 1u << ((faixa >> BITS_FAIXA) - 1);
+}
+
+void HistogramaLogLinear::registrar(uint32_t valor)
+{
+    // Escritor unico: load + store, sem operacoes atomicas de leitura-escrita
+    if (_zerar.load(std::memory_order_relaxed))
+    {
+        for (std::atomic<uint32_t> &contagem : _contagens)
+            contagem.store(0, std::memory_order_relaxed);
+        _amostras.store(0, std::memory_order_relaxed);
+        _maximo.store(0, std::memory_order_relaxed);
+        _zerar.store(false, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint32_t> &contagem = _contagens[faixa(valor)];
+    contagem.store(contagem.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _amostras.store(_amostras.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (valor > _maximo.load(std::memory_order_relaxed))
+        _maximo.store(valor, std::memory_order_relaxed);
+}
+
+uint32_t HistogramaLogLinear::amostras() const
+{
+    return _zerar.load(std::memory_order_relaxed) ? 0 : _amostras.load(std::memory_order_relaxed);
+}
+
+uint32_t HistogramaLogLinear::maximo() const
+{
+    return _zerar.load(std::memory_order_relaxed) ? 0 : _maximo.load(std::memory_order_relaxed);
+}
+
+uint32_t HistogramaLogLinear::percentil(double p) const
+{
+    // As contagens podem andar durante a leitura: o total e o da propria varredura
+    uint32_t contagens[NUM_FAIXAS];
+    uint32_t total = 0;
+    for (uint16_t i = 0; i < NUM_FAIXAS; i++)
+    {
+        contagens[i] = _contagens[i].load(std::memory_order_relaxed);
+        total += contagens[i];
+    }
+    if (!total || _zerar.load(std::memory_order_relaxed))
+        return 0;
+
+    uint32_t alvo = (uint32_t)(p / 100.0 * (total - 1)) + 1;
+    uint32_t acumulado = 0;
+    for (uint16_t i = 0; i < NUM_FAIXAS; i++)
+    {
+        acumulado += contagens[i];
+        if (acumulado >= alvo)
+        {
+            uint32_t meio = inicioFaixa(i) + larguraFaixa(i) / 2;
+            uint32_t maior = maximo();
+            return meio < maior ? meio : maior;
+        }
+    }
+    return maximo();
+}
+
+// ------------------- ETAPAS -------------------
+
+static const char *NOMES_ETAPAS[NUM_ETAPAS] = {
+    "wifi", "mqtt_conexao", "mqtt_loop", "envio_leituras", "pressao",
+    "distancia", "luz", "fusao", "botao_digital", "liberar_acesso", "espera_digital",
+    "busca_quente", "busca_completa", "destravar",
+};
+
+const char *nomeEtapa(EtapaPerfil etapa)
+{
+    return etapa < NUM_ETAPAS ? NOMES_ETAPAS[etapa] : "?";
+}
+
+#if SAFEZONE_PERFIL
+
+static HistogramaLogLinear histogramas[NUM_ETAPAS];
+
+// Apenas a tarefa de rede
+static unsigned long inicioJanela = 0;
+static unsigned long passosAnteriores[MAX_TAREFAS] = {};
+
+uint32_t medirEtapa(EtapaPerfil etapa, uint32_t marca)
+{
+    uint32_t agora = halCiclos();
+    histogramas[etapa].registrar(agora - marca);
+    return agora;
+}
+
+EstatisticasEtapa estatisticasEtapa(EtapaPerfil etapa)
+{
+    const HistogramaLogLinear &h = histogramas[etapa];
+    float porUs = halCiclosPorUs();
+    return {nomeEtapa(etapa), h.amostras(), h.percentil(50) / porUs, h.percentil(99) / porUs, h.maximo() / porUs};
+}
+
+size_t serializarDiagnostico(char *buffer, size_t capacidade, unsigned long agora, time_t timestamp)
+{
+    unsigned long janelaMs = agora - inicioJanela;
+    size_t usado = 0;
+    int n = snprintf(buffer, capacidade, "{\"janela_s\":%lu,\"etapas\":{", janelaMs / 1000);
+    for (uint8_t i = 0; i < NUM_ETAPAS && n >= 0 && usado + n < capacidade; i++)
+    {
+        usado += n;
+        EstatisticasEtapa e = estatisticasEtapa((EtapaPerfil)i);
+        n = snprintf(buffer + usado, capacidade - usado, "%s\"%s\":[%lu,%.1f,%.1f,%.1f]", i ? "," : "", e.nome,
+                     (unsigned long)e.amostras, e.p50Us, e.p99Us, e.maximoUs);
+    }
+    if (n >= 0 && usado + n < capacidade)
+    {
+        usado += n;
+        n = snprintf(buffer + usado, capacidade - usado,
+                     "},\"heap\":%lu,\"heap_min\":%lu,\"registro_descartes\":%lu,\"passos_s\":{",
+                     (unsigned long)halHeapLivre(), (unsigned long)halHeapMinimo(), (unsigned long)descartesRegistro());
+    }
+    for (uint8_t i = 0; i < numeroTarefas() && n >= 0 && usado + n < capacidade; i++)
+    {
+        usado += n;
+        EstatisticasTarefa t = estatisticasTarefa(i);
+        float porSegundo = janelaMs ? (t.passos - passosAnteriores[i]) * 1000.0f / janelaMs : 0;
+        passosAnteriores[i] = t.passos;
+        n = snprintf(buffer + usado, capacidade - usado, "%s\"%s\":%.1f", i ? "," : "", t.nome, porSegundo);
+    }
+    if (n >= 0 && usado + n < capacidade)
+    {
+        usado += n;
+        n = snprintf(buffer + usado, capacidade - usado, "},\"timestamp\":%ld}", (long)timestamp);
+    }
+
+    for (HistogramaLogLinear &h : histogramas)
+        h.zerar();
+    inicioJanela = agora;
+    if (n < 0 || usado + n >= capacidade)
+        return 0;
+    return usado + n;
+}
+
+#else
+
+EstatisticasEtapa estatisticasEtapa(EtapaPerfil etapa)
+{
+    return {nomeEtapa(etapa), 0, 0, 0, 0};
+}
+
+size_t serializarDiagnostico(char *, size_t, unsigned long, time_t)
+{
+    return 0;
+}
+
+#endif
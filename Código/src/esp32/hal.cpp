@@ -0,0 +1,744 @@
+#include "hal.h"
+#include <HX711.h>
+#include <Wire.h>
+#include <Adafruit_VL53L0X.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <ezTime.h>
+#include <esp_partition.h>
+#include <Preferences.h>
+#include <lwip/sockets.h>
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
+#include <atomic>
+
+// ====================================================================================
+// HAL DO ESP32 (BIBLIOTECAS REAIS)
+// ====================================================================================
+
+static HX711 scale;
+static Adafruit_VL53L0X lox;
+static WiFiClient espClient;
+static Timezone tempoLocal;
+
+// ------------------- SENSOR DE PRESSAO (HX711) -------------------
+// DOUT desce quando a conversao esta pronta. A interrupcao so acorda a tarefa
+// "balanca", que faz o shift dos 24 bits em HX711::read() (~50 us, com as interrupcoes
+// desligadas pela biblioteca) e entrega o valor. O shift tambem mexe em DOUT: a
+// notificacao extra e descartada por is_ready(), e o timeout cobre uma borda perdida.
+
+static const uint32_t BALANCA_PILHA = 2048;
+static const uint8_t BALANCA_PRIORIDADE = 4; // Acima das tarefas do firmware: a conversao
+                                             // deve ser lida antes da proxima (100 ms)
+static int pinoDoutBalanca = -1;
+static void (*aoConverterBalanca)(int32_t bruto) = NULL;
+static TaskHandle_t tarefaBalanca = NULL;
+
+static void IRAM_ATTR aoBalancaPronta()
+{
+    BaseType_t acordou = pdFALSE;
+    vTaskNotifyGiveFromISR(tarefaBalanca, &acordou);
+    if (acordou)
+        portYIELD_FROM_ISR();
+}
+
+static void lerBalancaContinua(void *parametro)
+{
+    (void)parametro;
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200));
+        if (scale.is_ready())
+            aoConverterBalanca((int32_t)scale.read());
+    }
+}
+
+void halBalancaIniciar(int pinoDout, int pinoSck)
+{
+    pinoDoutBalanca = pinoDout;
+    scale.begin(pinoDout, pinoSck);
+}
+
+void halBalancaLigar()
+{
+    scale.power_up();
+}
+
+bool halBalancaContinua(void (*aoConverter)(int32_t bruto))
+{
+    if (tarefaBalanca || pinoDoutBalanca < 0)
+        return false;
+    aoConverterBalanca = aoConverter;
+    if (xTaskCreatePinnedToCore(lerBalancaContinua, "balanca", BALANCA_PILHA, NULL, BALANCA_PRIORIDADE,
+                                &tarefaBalanca, 1) != pdPASS)
+        return false;
+    attachInterrupt(digitalPinToInterrupt(pinoDoutBalanca), aoBalancaPronta, FALLING);
+    return true;
+}
+
+// ------------------- SENSOR DE MOVIMENTO (VL53L0X) -------------------
+// A API da ST configura o GPIO1 como "medida nova pronta", ativo em nivel baixo (dreno
+// aberto). A interrupcao so marca a flag; o I2C fica com quem chama halDistanciaLer().
+// Se uma borda se perder, o registrador do sensor e consultado no maximo a cada 250 ms.
+
+static const uint32_t DISTANCIA_CONSULTA_MS = 250;
+static const Adafruit_VL53L0X::VL53L0X_Sense_config_t CONFIGURACAO_PERFIL[NUM_PERFIS_DISTANCIA] = {
+    Adafruit_VL53L0X::VL53L0X_SENSE_HIGH_SPEED,
+    Adafruit_VL53L0X::VL53L0X_SENSE_DEFAULT,
+    Adafruit_VL53L0X::VL53L0X_SENSE_LONG_RANGE,
+};
+static volatile bool distanciaPronta = false;
+static unsigned long ultimaConsultaDistancia = 0;
+
+static void IRAM_ATTR aoDistanciaPronta()
+{
+    distanciaPronta = true;
+}
+
+bool halDistanciaIniciar(int pinoPronto, PerfilDistancia perfil)
+{
+    Wire.begin();
+    Wire.setClock(400000); // Resultado lido em ~0,4 ms, contra ~1,5 ms a 100 kHz
+    if (!lox.begin())
+        return false;
+    pinMode(pinoPronto, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(pinoPronto), aoDistanciaPronta, FALLING);
+    return halDistanciaPerfil(perfil);
+}
+
+bool halDistanciaPerfil(PerfilDistancia perfil)
+{
+    if (perfil >= NUM_PERFIS_DISTANCIA)
+        return false;
+    lox.stopRangeContinuous();
+    bool ok = lox.configSensor(CONFIGURACAO_PERFIL[perfil]);
+    distanciaPronta = false;
+    ultimaConsultaDistancia = millis();
+    lox.startRangeContinuous(0); // 0: medidas uma atras da outra
+    return ok;
+}
+
+MedidaDistancia halDistanciaLer(uint16_t &mm)
+{
+    if (!distanciaPronta)
+    {
+        if (millis() - ultimaConsultaDistancia < DISTANCIA_CONSULTA_MS)
+            return DISTANCIA_PENDENTE;
+        ultimaConsultaDistancia = millis();
+        if (!lox.isRangeComplete())
+            return DISTANCIA_PENDENTE;
+    }
+    distanciaPronta = false;
+    ultimaConsultaDistancia = millis();
+
+    mm = lox.readRange(); // Tambem limpa a interrupcao no sensor
+    return lox.readRangeStatus() == 0 ? DISTANCIA_VALIDA : DISTANCIA_FORA_ALCANCE;
+}
+
+// ------------------- SENSOR DE LUZ (LDR NO ADC) -------------------
+// Tarefa periodica no tick de 1 ms do FreeRTOS; cada bloco sao 4 analogRead() do ADC1
+// (~40 us no total), que funciona com o Wi-Fi ligado.
+
+static const uint32_t ADC_PILHA = 2048;
+static const uint8_t ADC_PRIORIDADE = 4; // Como a balanca: curta e com periodo fixo
+static uint8_t pinoAdc = 0;
+static void (*aoAmostrarAdc)(const uint16_t *amostras, uint8_t quantidade) = NULL;
+
+static void amostrarAdcContinuo(void *parametro)
+{
+    (void)parametro;
+    uint16_t bloco[HAL_ADC_AMOSTRAS_POR_BLOCO];
+    TickType_t proximo = xTaskGetTickCount();
+    for (;;)
+    {
+        vTaskDelayUntil(&proximo, pdMS_TO_TICKS(HAL_ADC_BLOCO_US / 1000));
+        for (uint8_t i = 0; i < HAL_ADC_AMOSTRAS_POR_BLOCO; i++)
+            bloco[i] = analogRead(pinoAdc);
+        aoAmostrarAdc(bloco, HAL_ADC_AMOSTRAS_POR_BLOCO);
+    }
+}
+
+bool halAdcContinuo(uint8_t pino, void (*aoAmostrar)(const uint16_t *amostras, uint8_t quantidade))
+{
+    if (aoAmostrarAdc)
+        return false;
+    pinoAdc = pino;
+    aoAmostrarAdc = aoAmostrar;
+    pinMode(pino, INPUT);
+    return xTaskCreatePinnedToCore(amostrarAdcContinuo, "adc", ADC_PILHA, NULL, ADC_PRIORIDADE, NULL, 1) == pdPASS;
+}
+
+// ------------------- SENSOR DE DIGITAIS (SAIDA DE TOQUE) -------------------
+// A saida de toque do modulo e ativa em nivel alto enquanto ha dedo no vidro. A
+// interrupcao so copia o CCOUNT (getCycleCount() e inline) e marca a flag.
+
+static volatile bool toqueDigital = false;
+static volatile uint32_t ciclosToqueDigital = 0;
+
+static void IRAM_ATTR aoTocarDigital()
+{
+    ciclosToqueDigital = ESP.getCycleCount();
+    toqueDigital = true;
+}
+
+bool halToqueIniciar(int pino)
+{
+    pinMode(pino, INPUT_PULLDOWN); // Sem modulo ligado o pino fica baixo: nenhum toque falso
+    attachInterrupt(digitalPinToInterrupt(pino), aoTocarDigital, RISING);
+    return true;
+}
+
+bool halToqueLer(uint32_t &ciclos)
+{
+    if (!toqueDigital)
+        return false;
+    noInterrupts();
+    ciclos = ciclosToqueDigital;
+    toqueDigital = false;
+    interrupts();
+    return true;
+}
+
+// ------------------- WIFI -------------------
+
+static void (*callbackWiFi)(EventoWiFi evento) = nullptr;
+
+void halWiFiAoEvento(void (*callback)(EventoWiFi evento))
+{
+    callbackWiFi = callback;
+    WiFi.onEvent([](WiFiEvent_t evento, WiFiEventInfo_t info)
+                 {
+        if (!callbackWiFi)
+            return;
+        if (evento == ARDUINO_EVENT_WIFI_STA_GOT_IP)
+            callbackWiFi(WIFI_EVENTO_CONECTADO);
+        else if (evento == ARDUINO_EVENT_WIFI_STA_DISCONNECTED)
+            callbackWiFi(WIFI_EVENTO_DESCONECTADO); });
+}
+
+void halWiFiIniciar(const char *ssid, const char *senha)
+{
+    // A reconexao fica a cargo do firmware (internet.cpp), com backoff.
+    WiFi.setAutoReconnect(false);
+    WiFi.begin(ssid, senha);
+}
+
+bool halWiFiConectado()
+{
+    return WiFi.status() == WL_CONNECTED;
+}
+
+String halWiFiIP()
+{
+    return WiFi.localIP().toString();
+}
+
+int halWiFiRSSI()
+{
+    return WiFi.RSSI();
+}
+
+// ------------------- MQTT -------------------
+
+static void (*aoReceberMqtt)(const char *topico, const uint8_t *dados, unsigned int tamanho) = NULL;
+
+static void receberMqtt(char *topico, uint8_t *dados, unsigned int tamanho)
+{
+    if (aoReceberMqtt)
+        aoReceberMqtt(topico, dados, tamanho);
+}
+
+// A tentativa anda em etapas e cada chamada de halMqttAndamentoConexao() so consulta o
+// que ja chegou: o endereco do broker e resolvido pela pilha lwIP com callback, o TCP
+// abre num socket sem bloqueio, o CONNECT sai por ele e o CONNACK e lido aos poucos.
+// So com o CONNACK na mao o socket vai para o PubSubClient, cujo connect() mandaria
+// outro CONNECT e esperaria a resposta: o ClienteMqtt descarta o CONNECT e entrega o
+// CONNACK ja lido, e o connect() volta sem tocar na rede.
+class ClienteMqtt : public Client
+{
+public:
+    explicit ClienteMqtt(WiFiClient &rede) : _rede(rede) {}
+
+    void reproduzirConnack(const uint8_t *connack, uint8_t tamanho)
+    {
+        memcpy(_connack, connack, tamanho);
+        _tamanho = tamanho;
+        _lidos = 0;
+        _reproduzindo = true;
+    }
+
+    void encerrarReproducao()
+    {
+        _reproduzindo = false;
+    }
+
+    int connect(IPAddress ip, uint16_t porta) override { return _rede.connect(ip, porta); }
+    int connect(const char *host, uint16_t porta) override { return _rede.connect(host, porta); }
+    // Variantes com timeout do Client do arduino-esp32
+    int connect(IPAddress ip, uint16_t porta, int32_t timeout) { return _rede.connect(ip, porta, timeout); }
+    int connect(const char *host, uint16_t porta, int32_t timeout) { return _rede.connect(host, porta, timeout); }
+
+    size_t write(uint8_t byte) override { return _reproduzindo ? 1 : _rede.write(byte); }
+    size_t write(const uint8_t *dados, size_t tamanho) override
+    {
+        return _reproduzindo ? tamanho : _rede.write(dados, tamanho);
+    }
+
+    int available() override { return _reproduzindo ? _tamanho - _lidos : _rede.available(); }
+    int read() override
+    {
+        if (!_reproduzindo)
+            return _rede.read();
+        return _lidos < _tamanho ? _connack[_lidos++] : -1;
+    }
+    int read(uint8_t *dados, size_t tamanho) override
+    {
+        if (!_reproduzindo)
+            return _rede.read(dados, tamanho);
+        size_t n = 0;
+        while (n < tamanho && _lidos < _tamanho)
+            dados[n++] = _connack[_lidos++];
+        return n;
+    }
+    int peek() override
+    {
+        if (!_reproduzindo)
+            return _rede.peek();
+        return _lidos < _tamanho ? _connack[_lidos] : -1;
+    }
+
+    void flush() override
+    {
+        if (!_reproduzindo)
+            _rede.flush();
+    }
+    void stop() override
+    {
+        _reproduzindo = false;
+        _rede.stop();
+    }
+    uint8_t connected() override { return _rede.connected(); }
+    operator bool() override { return _rede; }
+
+private:
+    WiFiClient &_rede;
+    uint8_t _connack[4];
+    uint8_t _tamanho = 0;
+    uint8_t _lidos = 0;
+    bool _reproduzindo = false;
+};
+
+static ClienteMqtt clienteMqtt(espClient);
+static PubSubClient client(clienteMqtt);
+
+enum EtapaConexaoMqtt : uint8_t
+{
+    CONEXAO_PARADA,
+    CONEXAO_ENDERECO, // Esperando o DNS
+    CONEXAO_TCP,
+    CONEXAO_CONNACK
+};
+
+// Escrito pelo callback do DNS, na tarefa da lwIP.
+enum EstadoEnderecoBroker : uint8_t
+{
+    ENDERECO_A_RESOLVER,
+    ENDERECO_RESOLVENDO,
+    ENDERECO_PRONTO,
+    ENDERECO_FALHOU
+};
+
+// Depois de tantas tentativas seguidas falhando no TCP ou no CONNACK, o endereco e
+// resolvido de novo (o broker pode ter mudado de IP).
+static const uint8_t FALHAS_PARA_RESOLVER = 3;
+
+static const char *servidorMqtt = NULL;
+static uint16_t portaMqtt = 0;
+static uint32_t timeoutConexaoMs = 1000;
+static bool enderecoLiteral = false;
+static std::atomic<uint8_t> estadoEndereco{ENDERECO_A_RESOLVER};
+static std::atomic<uint32_t> enderecoBroker{0};
+static uint8_t falhasComEndereco = 0;
+
+static const char *idConexaoMqtt = NULL;
+static EtapaConexaoMqtt etapaConexao = CONEXAO_PARADA;
+static int socketConexao = -1;
+static unsigned long inicioConexao = 0;
+static uint8_t connack[4];
+static uint8_t connackLidos = 0;
+static int erroConexao = 0; // MQTT_* do PubSubClient da ultima tentativa que falhou
+
+static void aoResolverBroker(const char *, const ip_addr_t *ip, void *)
+{
+    if (ip && IP_IS_V4(ip))
+    {
+        enderecoBroker.store(ip_2_ip4(ip)->addr, std::memory_order_relaxed);
+        estadoEndereco.store(ENDERECO_PRONTO, std::memory_order_release);
+    }
+    else
+        estadoEndereco.store(ENDERECO_FALHOU, std::memory_order_release);
+}
+
+// Roda na tarefa da lwIP (tcpip_callback): dns_gethostbyname() so registra o pedido, e
+// a resposta chega em aoResolverBroker().
+static void resolverBroker(void *)
+{
+    ip_addr_t ip;
+    err_t erro = dns_gethostbyname(servidorMqtt, &ip, aoResolverBroker, NULL);
+    if (erro == ERR_OK)
+        aoResolverBroker(servidorMqtt, &ip, NULL); // Estava no cache
+    else if (erro != ERR_INPROGRESS)
+        aoResolverBroker(servidorMqtt, NULL, NULL);
+}
+
+static void pedirEndereco()
+{
+    estadoEndereco.store(ENDERECO_RESOLVENDO, std::memory_order_relaxed);
+    if (tcpip_callback(resolverBroker, NULL) != ERR_OK)
+        estadoEndereco.store(ENDERECO_FALHOU, std::memory_order_relaxed);
+}
+
+// CONNECT do MQTT 3.1.1 igual ao de PubSubClient::connect(id): sessao limpa, sem
+// usuario nem will, keepalive MQTT_KEEPALIVE. Retorna o tamanho, ou 0 se nao couber.
+static size_t montarConnect(uint8_t *pacote, size_t capacidade, const char *id)
+{
+    static const uint8_t CABECALHO[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02,
+                                        MQTT_KEEPALIVE >> 8, MQTT_KEEPALIVE & 0xFF};
+    size_t tamanhoId = strlen(id);
+    size_t restante = sizeof(CABECALHO) + 2 + tamanhoId;
+    if (restante > 127 || restante + 2 > capacidade) // Comprimento restante em um byte
+        return 0;
+
+    size_t n = 0;
+    pacote[n++] = MQTTCONNECT;
+    pacote[n++] = (uint8_t)restante;
+    memcpy(pacote + n, CABECALHO, sizeof(CABECALHO));
+    n += sizeof(CABECALHO);
+    pacote[n++] = (uint8_t)(tamanhoId >> 8);
+    pacote[n++] = (uint8_t)tamanhoId;
+    memcpy(pacote + n, id, tamanhoId);
+    return n + tamanhoId;
+}
+
+static bool abrirSocket()
+{
+    int s = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s < 0)
+        return false;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    struct sockaddr_in destino = {};
+    destino.sin_family = AF_INET;
+    destino.sin_port = htons(portaMqtt);
+    destino.sin_addr.s_addr = enderecoBroker.load(std::memory_order_relaxed);
+    if (lwip_connect(s, (struct sockaddr *)&destino, sizeof(destino)) < 0 && errno != EINPROGRESS)
+    {
+        lwip_close(s);
+        return false;
+    }
+    socketConexao = s;
+    etapaConexao = CONEXAO_TCP;
+    return true;
+}
+
+static AndamentoConexaoMqtt falharConexao(int erro)
+{
+    bool comEndereco = etapaConexao == CONEXAO_TCP || etapaConexao == CONEXAO_CONNACK;
+    erroConexao = erro;
+    halMqttCancelarConexao();
+    if (comEndereco && !enderecoLiteral && ++falhasComEndereco >= FALHAS_PARA_RESOLVER)
+    {
+        falhasComEndereco = 0;
+        estadoEndereco.store(ENDERECO_A_RESOLVER, std::memory_order_relaxed);
+    }
+    return CONEXAO_MQTT_FALHOU;
+}
+
+static AndamentoConexaoMqtt esperarOuVencer()
+{
+    if (millis() - inicioConexao < timeoutConexaoMs)
+        return CONEXAO_MQTT_PENDENTE;
+    return falharConexao(MQTT_CONNECTION_TIMEOUT);
+}
+
+void halMqttServidor(const char *servidor, uint16_t porta)
+{
+    IPAddress literal;
+    servidorMqtt = servidor;
+    portaMqtt = porta;
+    enderecoLiteral = literal.fromString(servidor);
+    enderecoBroker.store((uint32_t)literal, std::memory_order_relaxed);
+    estadoEndereco.store(enderecoLiteral ? ENDERECO_PRONTO : ENDERECO_A_RESOLVER, std::memory_order_relaxed);
+    client.setServer(servidor, porta);
+    client.setBufferSize(768); // Padrao de 256: pequeno para a configuracao efetiva em JSON
+    client.setCallback(receberMqtt);
+}
+
+void halMqttTimeoutConexao(uint16_t timeoutMs)
+{
+    // WiFiClient (arduino-esp32 2.x) e PubSubClient recebem o timeout em segundos; ele so
+    // vale para os pacotes depois da conexao, que tem o seu em milissegundos aqui.
+    uint16_t segundos = (timeoutMs + 999) / 1000;
+    timeoutConexaoMs = timeoutMs;
+    espClient.setTimeout(segundos);
+    client.setSocketTimeout(segundos);
+}
+
+// O prazo vale para a tentativa inteira. Um DNS mais lento que ele continua na lwIP, e a
+// proxima tentativa ja encontra o endereco.
+bool halMqttIniciarConexao(const char *id)
+{
+    halMqttCancelarConexao();
+    idConexaoMqtt = id;
+    inicioConexao = millis();
+    erroConexao = 0;
+
+    uint8_t endereco = estadoEndereco.load(std::memory_order_acquire);
+    if (endereco == ENDERECO_PRONTO)
+    {
+        if (abrirSocket())
+            return true;
+        erroConexao = MQTT_CONNECT_FAILED;
+        return false;
+    }
+    if (endereco != ENDERECO_RESOLVENDO)
+        pedirEndereco();
+    etapaConexao = CONEXAO_ENDERECO;
+    return true;
+}
+
+AndamentoConexaoMqtt halMqttAndamentoConexao()
+{
+    switch (etapaConexao)
+    {
+    case CONEXAO_ENDERECO:
+    {
+        uint8_t endereco = estadoEndereco.load(std::memory_order_acquire);
+        if (endereco == ENDERECO_PRONTO)
+            return abrirSocket() ? CONEXAO_MQTT_PENDENTE : falharConexao(MQTT_CONNECT_FAILED);
+        if (endereco == ENDERECO_FALHOU)
+            return falharConexao(MQTT_CONNECT_FAILED); // A proxima tentativa pede de novo
+        return esperarOuVencer();
+    }
+
+    case CONEXAO_TCP:
+    {
+        fd_set escrita;
+        FD_ZERO(&escrita);
+        FD_SET(socketConexao, &escrita);
+        struct timeval semEspera = {0, 0};
+        int pronto = lwip_select(socketConexao + 1, NULL, &escrita, NULL, &semEspera);
+        if (pronto == 0)
+            return esperarOuVencer();
+        int erro = 0;
+        socklen_t tamanho = sizeof(erro);
+        if (pronto < 0 || lwip_getsockopt(socketConexao, SOL_SOCKET, SO_ERROR, &erro, &tamanho) < 0 || erro)
+            return falharConexao(MQTT_CONNECT_FAILED); // Recusada ou sem rota
+
+        // Socket recem-conectado: o CONNECT (dezenas de bytes) cabe no buffer de envio
+        uint8_t pacote[64];
+        size_t n = montarConnect(pacote, sizeof(pacote), idConexaoMqtt);
+        if (!n || lwip_send(socketConexao, pacote, n, 0) != (int)n)
+            return falharConexao(MQTT_CONNECT_FAILED);
+        connackLidos = 0;
+        etapaConexao = CONEXAO_CONNACK;
+        return CONEXAO_MQTT_PENDENTE;
+    }
+
+    case CONEXAO_CONNACK:
+    {
+        int n = lwip_recv(socketConexao, connack + connackLidos, sizeof(connack) - connackLidos, 0);
+        if (n == 0 || (n < 0 && errno != EWOULDBLOCK && errno != EAGAIN))
+            return falharConexao(MQTT_CONNECTION_LOST); // O broker fechou sem responder
+        if (n > 0)
+            connackLidos += n;
+        if (connackLidos < sizeof(connack))
+            return esperarOuVencer();
+        if (connack[0] != MQTTCONNACK || connack[1] != 2)
+            return falharConexao(MQTT_CONNECT_FAILED);
+        if (connack[3] != 0)
+            return falharConexao(connack[3]); // MQTT_CONNECT_BAD_PROTOCOL ...
+
+        // Como o WiFiClient::connect(): o socket volta a bloquear depois de conectado
+        fcntl(socketConexao, F_SETFL, fcntl(socketConexao, F_GETFL, 0) & ~O_NONBLOCK);
+        espClient = WiFiClient(socketConexao);
+        espClient.setTimeout((timeoutConexaoMs + 999) / 1000);
+        socketConexao = -1;
+        etapaConexao = CONEXAO_PARADA;
+        falhasComEndereco = 0;
+
+        clienteMqtt.reproduzirConnack(connack, sizeof(connack));
+        bool conectado = client.connect(idConexaoMqtt);
+        clienteMqtt.encerrarReproducao();
+        return conectado ? CONEXAO_MQTT_PRONTA : CONEXAO_MQTT_FALHOU;
+    }
+
+    default:
+        return CONEXAO_MQTT_FALHOU;
+    }
+}
+
+void halMqttCancelarConexao()
+{
+    if (socketConexao >= 0)
+        lwip_close(socketConexao);
+    socketConexao = -1;
+    etapaConexao = CONEXAO_PARADA;
+}
+
+bool halMqttConectado()
+{
+    return client.connected();
+}
+
+int halMqttEstado()
+{
+    return erroConexao ? erroConexao : client.state();
+}
+
+void halMqttLoop()
+{
+    client.loop();
+}
+
+bool halMqttPublicar(const char *topico, const char *payload)
+{
+    return client.publish(topico, payload);
+}
+
+bool halMqttPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    return client.publish(topico, dados, tamanho);
+}
+
+void halMqttAoReceber(void (*callback)(const char *topico, const uint8_t *dados, unsigned int tamanho))
+{
+    aoReceberMqtt = callback;
+}
+
+bool halMqttAssinar(const char *topico)
+{
+    return client.subscribe(topico);
+}
+
+// ------------------- FLASH (PARTICAO "caixa") -------------------
+
+static const esp_partition_t *particaoCaixa()
+{
+    static const esp_partition_t *particao =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "caixa");
+    return particao;
+}
+
+uint32_t halFlashTamanho()
+{
+    return particaoCaixa() ? particaoCaixa()->size : 0;
+}
+
+bool halFlashLer(uint32_t endereco, void *dados, size_t tamanho)
+{
+    return particaoCaixa() && esp_partition_read(particaoCaixa(), endereco, dados, tamanho) == ESP_OK;
+}
+
+bool halFlashEscrever(uint32_t endereco, const void *dados, size_t tamanho)
+{
+    return particaoCaixa() && esp_partition_write(particaoCaixa(), endereco, dados, tamanho) == ESP_OK;
+}
+
+bool halFlashApagarSetor(uint32_t endereco)
+{
+    return particaoCaixa() && esp_partition_erase_range(particaoCaixa(), endereco, HAL_SETOR_FLASH) == ESP_OK;
+}
+
+// ------------------- NVS -------------------
+
+static Preferences preferencias;
+
+static bool abrirNvs()
+{
+    static bool aberta = false;
+    if (!aberta)
+        aberta = preferencias.begin("safezone", false);
+    return aberta;
+}
+
+bool halNvsLer(const char *chave, void *dados, size_t tamanho)
+{
+    if (!abrirNvs() || preferencias.getBytesLength(chave) != tamanho)
+        return false;
+    return preferencias.getBytes(chave, dados, tamanho) == tamanho;
+}
+
+bool halNvsGravar(const char *chave, const void *dados, size_t tamanho)
+{
+    return abrirNvs() && preferencias.putBytes(chave, dados, tamanho) == tamanho;
+}
+
+// ------------------- RELOGIO -------------------
+
+void halRelogioLocal(const char *local)
+{
+    tempoLocal.setLocation(local);
+}
+
+bool halRelogioSincronizado()
+{
+    events();
+    return timeStatus() != timeNotSet;
+}
+
+time_t halRelogioAgora()
+{
+    return tempoLocal.now();
+}
+
+// ------------------- TAREFAS -------------------
+
+// -D SAFEZONE_TAREFAS=0 volta ao loop() cooperativo unico.
+#ifndef SAFEZONE_TAREFAS
+#define SAFEZONE_TAREFAS 1
+#endif
+
+bool halMultitarefa()
+{
+    return SAFEZONE_TAREFAS;
+}
+
+bool halCriarTarefa(const char *nome, void (*funcao)(void *parametro), void *parametro,
+                    uint32_t pilha, uint8_t prioridade, int8_t nucleo)
+{
+    return xTaskCreatePinnedToCore(funcao, nome, pilha, parametro, prioridade, NULL, nucleo) == pdPASS;
+}
+
+void halEncerrarTarefa()
+{
+    vTaskDelete(NULL);
+}
+
+// ------------------- CPU E MEMORIA -------------------
+
+uint32_t halCiclos()
+{
+    return ESP.getCycleCount();
+}
+
+uint32_t halCiclosPorUs()
+{
+    return ESP.getCpuFreqMHz();
+}
+
+uint32_t halHeapLivre()
+{
+    return ESP.getFreeHeap();
+}
+
+uint32_t halHeapMinimo()
+{
+    return ESP.getMinFreeHeap();
+}
+
+// ------------------- ALEATORIO -------------------
+
+uint32_t halAleatorio()
+{
+    return esp_random();
+}
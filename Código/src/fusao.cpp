@@ -0,0 +1,244 @@
+#include "fusao.h"
+#include <string.h>
+#include <atomic>
+
+// ------------------- TABELA COMPILADA -------------------
+// As comparacoes "abaixo" viram "acima" com o sinal trocado, para que cada condicao seja
+// avaliada com as mesmas duas comparacoes.
+struct CondicaoCompilada
+{
+    uint8_t entrada;
+    int8_t sinal;
+    int32_t liga;
+    int32_t desliga;
+    uint16_t confirmacaoMs;
+    uint16_t retencaoMs;
+};
+
+struct RegraCompilada
+{
+    uint8_t mascara;
+    uint8_t modos;
+    uint8_t causa;
+    uint16_t janelaMs;
+    uint16_t retencaoMs;
+};
+
+struct EstadoCondicao
+{
+    bool ativa;
+    bool pendente;          // Do lado de ligar, esperando a confirmacao
+    bool jaAtivou;
+    unsigned long desde;    // Inicio da confirmacao
+    unsigned long ativacao; // Ultima ativacao
+};
+
+static CondicaoCompilada condicoes[MAX_CONDICOES_FUSAO];
+static RegraCompilada regras[MAX_REGRAS_FUSAO];
+static uint8_t numCondicoes = 0;
+static uint8_t numRegras = 0;
+
+// ------------------- ESTADO (TAREFA DE SENSORES) -------------------
+static EstadoCondicao estados[MAX_CONDICOES_FUSAO];
+static bool iniciada = false;
+static uint8_t modo = MODO_ARMADO;
+static unsigned long inicioModo = 0;
+static bool suspensa = false;
+static unsigned long fimSuspensao = 0;
+static uint32_t suspensoesVistas = 0;
+static bool alarme = false;
+static uint8_t regraAtual = 0;
+static unsigned long ultimaRegra = 0; // Ultima avaliacao com alguma regra satisfeita
+
+// ------------------- PEDIDOS DE OUTRAS TAREFAS -------------------
+static std::atomic<bool> armadoPedido{true};
+static std::atomic<unsigned long> fimPedido{0};
+static std::atomic<uint32_t> suspensoes{0}; // Publica fimPedido
+
+bool compilarFusao(const CondicaoFusao *novasCondicoes, uint8_t novasNum,
+                   const RegraFusao *novasRegras, uint8_t novasRegrasNum)
+{
+    if (novasNum > MAX_CONDICOES_FUSAO || novasRegrasNum > MAX_REGRAS_FUSAO)
+        return false;
+    for (uint8_t i = 0; i < novasNum; i++)
+    {
+        const CondicaoFusao &c = novasCondicoes[i];
+        bool acima = c.comparacao == FUSAO_ACIMA;
+        if (c.entrada >= NUM_ENTRADAS_FUSAO || (acima ? c.desliga > c.liga : c.desliga < c.liga) ||
+            c.liga == FUSAO_SEM_MEDIDA || c.desliga == FUSAO_SEM_MEDIDA)
+            return false;
+    }
+    uint8_t existentes = (uint8_t)((1u << novasNum) - 1);
+    for (uint8_t i = 0; i < novasRegrasNum; i++)
+    {
+        const RegraFusao &r = novasRegras[i];
+        if (!r.condicoes || (r.condicoes & ~existentes) || !r.modos ||
+            r.causa == CAUSA_NENHUMA || r.causa >= NUM_CAUSAS_ALARME)
+            return false;
+    }
+
+    for (uint8_t i = 0; i < novasNum; i++)
+    {
+        const CondicaoFusao &c = novasCondicoes[i];
+        int8_t sinal = c.comparacao == FUSAO_ACIMA ? 1 : -1;
+        condicoes[i] = {(uint8_t)c.entrada, sinal, sinal * c.liga, sinal * c.desliga, c.confirmacaoMs, c.retencaoMs};
+    }
+    for (uint8_t i = 0; i < novasRegrasNum; i++)
+    {
+        const RegraFusao &r = novasRegras[i];
+        regras[i] = {r.condicoes, r.modos, (uint8_t)r.causa, r.janelaMs, r.retencaoMs};
+    }
+    numCondicoes = novasNum;
+    numRegras = novasRegrasNum;
+
+    memset(estados, 0, sizeof(estados));
+    iniciada = false;
+    alarme = false;
+    return true;
+}
+
+// Modo atual a partir dos pedidos das outras tarefas.
+static uint8_t modoAtual(unsigned long agora)
+{
+    uint32_t n = suspensoes.load(std::memory_order_acquire);
+    if (n != suspensoesVistas)
+    {
+        suspensoesVistas = n;
+        fimSuspensao = fimPedido.load(std::memory_order_relaxed);
+        suspensa = true;
+    }
+    if (suspensa && (long)(agora - fimSuspensao) >= 0)
+        suspensa = false;
+    return armadoPedido.load(std::memory_order_relaxed) && !suspensa ? MODO_ARMADO : MODO_DESARMADO;
+}
+
+// Todas as condicoes da regra ativadas depois da mudanca de modo, ativas ou ha no maximo
+// janelaMs, e com as ativacoes a no maximo janelaMs uma da outra.
+static bool regraSatisfeita(const RegraCompilada &r, uint8_t ativas, unsigned long agora)
+{
+    if (!r.janelaMs)
+        return (ativas & r.mascara) == r.mascara;
+
+    unsigned long maisNova = ~0UL, maisAntiga = 0;
+    for (uint8_t bits = r.mascara; bits; bits &= bits - 1)
+    {
+        uint8_t i = __builtin_ctz(bits);
+        unsigned long idade = agora - estados[i].ativacao;
+        if (!(ativas & (1 << i)) && idade > r.janelaMs)
+            return false;
+        if (idade < maisNova)
+            maisNova = idade;
+        if (idade > maisAntiga)
+            maisAntiga = idade;
+    }
+    return maisAntiga - maisNova <= r.janelaMs;
+}
+
+ResultadoFusao avaliarFusao(const int32_t entradas[NUM_ENTRADAS_FUSAO], unsigned long agora)
+{
+    uint8_t novoModo = modoAtual(agora);
+    if (!iniciada || novoModo != modo)
+    {
+        iniciada = true;
+        modo = novoModo;
+        inicioModo = agora;
+        if (alarme && !(regras[regraAtual].modos & modo))
+            alarme = false; // Ex.: desarmado por um acesso autorizado
+    }
+
+    // --- Condicoes com histerese ---
+    ResultadoFusao resultado = {0, 0, false, CAUSA_NENHUMA};
+    uint8_t validas = 0; // Ja ativadas neste modo
+    unsigned long duracaoModo = agora - inicioModo;
+    for (uint8_t i = 0; i < numCondicoes; i++)
+    {
+        const CondicaoCompilada &c = condicoes[i];
+        EstadoCondicao &e = estados[i];
+        int32_t bruto = entradas[c.entrada];
+        bool semMedida = bruto == FUSAO_SEM_MEDIDA;
+        int32_t valor = semMedida ? 0 : bruto * c.sinal;
+
+        if (!e.ativa)
+        {
+            if (!semMedida && valor >= c.liga)
+            {
+                if (!e.pendente)
+                {
+                    e.pendente = true;
+                    e.desde = agora;
+                }
+                if (agora - e.desde >= c.confirmacaoMs)
+                {
+                    e.ativa = true;
+                    e.jaAtivou = true;
+                    e.ativacao = agora;
+                }
+            }
+            else
+                e.pendente = false;
+        }
+        else if ((semMedida || valor < c.desliga) && agora - e.ativacao >= c.retencaoMs)
+        {
+            e.ativa = false;
+            e.pendente = false;
+        }
+
+        if (e.ativa)
+        {
+            resultado.condicoes |= 1 << i;
+            resultado.entradas |= 1 << c.entrada;
+        }
+        if (e.jaAtivou && agora - e.ativacao <= duracaoModo)
+            validas |= 1 << i;
+    }
+
+    // --- Regras, em ordem de prioridade ---
+    uint8_t ativas = resultado.condicoes & validas;
+    bool satisfeita = false;
+    for (uint8_t i = 0; i < numRegras; i++)
+    {
+        const RegraCompilada &r = regras[i];
+        if (!(r.modos & modo) || (validas & r.mascara) != r.mascara || !regraSatisfeita(r, ativas, agora))
+            continue;
+        if (!alarme || i < regraAtual)
+            regraAtual = i; // A causa so muda para uma regra de prioridade maior
+        alarme = true;
+        satisfeita = true;
+        ultimaRegra = agora;
+        break;
+    }
+    if (alarme && !satisfeita && agora - ultimaRegra >= regras[regraAtual].retencaoMs)
+        alarme = false;
+
+    resultado.alarme = alarme;
+    resultado.causa = alarme ? (CausaAlarme)regras[regraAtual].causa : CAUSA_NENHUMA;
+    return resultado;
+}
+
+void armarFusao(bool armado)
+{
+    armadoPedido.store(armado, std::memory_order_relaxed);
+}
+
+void suspenderFusao(unsigned long duracaoMs)
+{
+    fimPedido.store(millis() + duracaoMs, std::memory_order_relaxed);
+    suspensoes.fetch_add(1, std::memory_order_release);
+}
+
+const char *nomeCausaAlarme(uint8_t causa)
+{
+    switch (causa)
+    {
+    case CAUSA_INTRUSAO:
+        return "intrusao";
+    case CAUSA_LANTERNA:
+        return "lanterna";
+    case CAUSA_PRESENCA:
+        return "presenca";
+    case CAUSA_LUZ:
+        return "luz";
+    default:
+        return "nenhuma";
+    }
+}
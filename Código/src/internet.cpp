@@ -1,51 +1,124 @@
 #include <Arduino.h>
-#include <WiFi.h>
+#include "hal.h"
+#include "backoff.h"
 #include "internet.h"
 #include "senhas.h"
+#include "registro.h"
 
 // ------- CONFIGURAÇÃO DO WIFI --------
 
-const unsigned long tempoEsperaConexao = 20000;
-const unsigned long tempoEsperaReconexao = 10000;
+const unsigned long tempoEsperaConexao = 20000;   // Sem nenhum evento apos WiFi.begin(): falhou
+const unsigned long esperaMinimaWiFi = 1000;      // Primeira espera apos uma falha
+const unsigned long esperaMaximaWiFi = 10000;     // Limite do backoff exponencial
 
-void conectaWiFi()
-{
-    Serial.printf("Conectando ao WiFi: %s", SSID);
-    WiFi.begin(SSID, SENHA);
+// Sinalizados pelo callback do driver (outra tarefa no ESP32) e tratados em checkWiFi()
+static volatile bool eventoConectado = false;
+static volatile bool eventoDesconectado = false;
 
-    unsigned long tempoInicialWiFi = millis();
+static bool conectado = false;
+static bool tentando = false;
+static bool jaConectou = false;
+static uint8_t falhasSeguidas = 0;
+static unsigned long inicioTentativa = 0;
+static unsigned long proximaTentativa = 0;
+static unsigned long inicioConexao = 0;
+static unsigned long reconexoes = 0;
+static unsigned long quedas = 0;
 
-    while (WiFi.status() != WL_CONNECTED && millis() - tempoInicialWiFi < tempoEsperaConexao)
-    {
-        Serial.print(".");
-        delay(500);
-    }
+static void aoEventoWiFi(EventoWiFi evento)
+{
+    if (evento == WIFI_EVENTO_CONECTADO)
+        eventoConectado = true;
+    else
+        eventoDesconectado = true;
+}
 
-    if (WiFi.status() == WL_CONNECTED)
-    {
-        Serial.println("\nWiFi Conectado com sucesso! ");
-        Serial.print("Endereço IP: ");
-        Serial.println(WiFi.localIP());
-    }
+static void agendarNovaTentativa()
+{
+    unsigned long espera = esperaBackoff(esperaMinimaWiFi, esperaMaximaWiFi, falhasSeguidas, halAleatorio());
+    if (falhasSeguidas < 255)
+        falhasSeguidas++;
+    proximaTentativa = millis() + espera;
+    tentando = false;
+}
 
-    else
+// Inicia a conexao e retorna imediatamente; o resultado chega por evento.
+void conectaWiFi()
+{
+    static bool callbackRegistrado = false;
+    if (!callbackRegistrado)
     {
-        Serial.println("\nFalha ao conectar no WiFi. Verifique o nome da rede e a senha");
+        halWiFiAoEvento(aoEventoWiFi);
+        callbackRegistrado = true;
     }
+
+    REGISTRAR_INFO("Conectando ao WiFi: %s", SSID);
+    halWiFiIniciar(SSID, SENHA);
+    tentando = true;
+    inicioTentativa = millis();
 }
 
+// Chamada a cada passagem do loop: trata os eventos do driver e, sem conexao, dispara
+// uma nova tentativa quando o backoff termina. Nunca espera pela rede.
 void checkWiFi()
 {
     unsigned long tempoAtual = millis();
-    static unsigned long tempoUltimaConexao = 0;
 
-    if (tempoAtual - tempoUltimaConexao > tempoEsperaReconexao)
+    if (eventoDesconectado)
     {
-        if (WiFi.status() != WL_CONNECTED)
+        eventoDesconectado = false;
+        if (conectado)
         {
-            Serial.println("\n Conexão Perdida! Tentando reconectar...");
-            conectaWiFi();
+            conectado = false;
+            quedas++;
+            falhasSeguidas = 0;
+            REGISTRAR_AVISO("Conexão Perdida! Tentando reconectar...");
+            agendarNovaTentativa();
+        }
+        else if (tentando)
+        {
+            REGISTRAR_AVISO("Falha ao conectar no WiFi. Verifique o nome da rede e a senha");
+            agendarNovaTentativa();
+        }
+    }
+
+    // Os dois eventos podem chegar entre duas passagens, e as flags nao guardam a ordem:
+    // so vale a conexao se o enlace ainda existe. Senao a queda ja tratada acima reagenda
+    // a tentativa (sem auto-reconexao, nenhum outro evento viria).
+    if (eventoConectado)
+    {
+        eventoConectado = false;
+        if (!conectado && halWiFiConectado())
+        {
+            conectado = true;
+            tentando = false;
+            falhasSeguidas = 0;
+            inicioConexao = tempoAtual;
+            if (jaConectou)
+                reconexoes++;
+            jaConectou = true;
+
+            REGISTRAR_INFO("WiFi Conectado com sucesso! Endereço IP: %s", halWiFiIP().c_str());
         }
-        tempoUltimaConexao = tempoAtual;
     }
-}
\ No newline at end of file
+
+    if (tentando && tempoAtual - inicioTentativa >= tempoEsperaConexao)
+    {
+        REGISTRAR_AVISO("Falha ao conectar no WiFi. Verifique o nome da rede e a senha");
+        agendarNovaTentativa();
+    }
+
+    if (!conectado && !tentando && (long)(tempoAtual - proximaTentativa) >= 0)
+        conectaWiFi();
+}
+
+QualidadeWiFi qualidadeWiFi()
+{
+    QualidadeWiFi qualidade;
+    qualidade.conectado = conectado;
+    qualidade.rssi = conectado ? halWiFiRSSI() : 0;
+    qualidade.conectadoHa = conectado ? millis() - inicioConexao : 0;
+    qualidade.reconexoes = reconexoes;
+    qualidade.quedas = quedas;
+    return qualidade;
+}
@@ -0,0 +1,347 @@
+#include "listaDeAcesso.h"
+#include "hal.h"
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+static_assert(sizeof(EntradaAcesso) == 16, "EntradaAcesso mudou de tamanho: rever o registro da NVS");
+
+// Antes disto o relogio ainda nao passou pelo NTP (o ezTime comeca em 1970).
+static const time_t RELOGIO_VALIDO = 1577836800; // 2020-01-01
+static const uint32_t SEGUNDOS_POR_DIA = 86400;
+
+// ------------------- LISTA -------------------
+// O contador de sequencia fica impar enquanto o escritor troca uma posicao.
+static EntradaAcesso entradas[MAX_SLOTS_ACESSO];
+static std::atomic<uint32_t> sequencia{0};
+static std::atomic<bool> ativa{false};
+static uint32_t versao = 0;    // Apenas o escritor
+static uint16_t cadastros = 0; // Apenas o escritor
+static uint16_t limiteSlots = MAX_SLOTS_ACESSO;
+
+static void trocar(uint16_t slot, const EntradaAcesso &entrada)
+{
+    uint32_t s = sequencia.load(std::memory_order_relaxed);
+    sequencia.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entradas[slot] = entrada;
+    sequencia.store(s + 2, std::memory_order_release);
+}
+
+// Copia uma posicao, repetindo se o escritor a trocou no meio.
+static EntradaAcesso copiar(uint16_t slot)
+{
+    EntradaAcesso copia;
+    uint32_t s;
+    do
+    {
+        s = sequencia.load(std::memory_order_acquire);
+        copia = entradas[slot];
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((s & 1) || sequencia.load(std::memory_order_relaxed) != s);
+    return copia;
+}
+
+static uint16_t contarCadastros()
+{
+    uint16_t total = 0;
+    for (const EntradaAcesso &entrada : entradas)
+        total += entrada.usuario != 0;
+    return total;
+}
+
+// ------------------- HORARIO -------------------
+
+static bool dentroDaJanela(uint8_t dias, uint16_t inicio, uint16_t fim, uint8_t dia, uint16_t minuto)
+{
+    uint8_t ontem = dia ? dia - 1 : 6;
+    if (inicio == fim)
+        return dias & (1 << dia);
+    if (inicio < fim)
+        return (dias & (1 << dia)) && minuto >= inicio && minuto < fim;
+    // Passa da meia-noite: o fim da janela de ontem tambem vale
+    return ((dias & (1 << dia)) && minuto >= inicio) || ((dias & (1 << ontem)) && minuto < fim);
+}
+
+static DecisaoAcesso avaliarHorario(const EntradaAcesso &entrada, time_t agoraLocal)
+{
+    bool restrita = false;
+    for (uint8_t i = 0; i < JANELAS_POR_SLOT; i++)
+        restrita = restrita || entrada.dias[i];
+    if (!restrita)
+        return ACESSO_LIBERADO;
+    if (agoraLocal < RELOGIO_VALIDO)
+        return ACESSO_SEM_RELOGIO;
+
+    // 1970-01-01 foi uma quinta-feira
+    uint32_t dias = (uint32_t)(agoraLocal / SEGUNDOS_POR_DIA);
+    uint8_t dia = (dias + 4) % 7;
+    uint16_t minuto = (uint16_t)((agoraLocal % SEGUNDOS_POR_DIA) / 60);
+    for (uint8_t i = 0; i < JANELAS_POR_SLOT; i++)
+        if (entrada.dias[i] && dentroDaJanela(entrada.dias[i], entrada.inicioMin[i], entrada.fimMin[i], dia, minuto))
+            return ACESSO_LIBERADO;
+    return ACESSO_FORA_DO_HORARIO;
+}
+
+// ------------------- CAMPOS DO PATCH -------------------
+// Nome no JSON, posicao na entrada, tamanho e faixa aceita.
+struct CampoPatch
+{
+    const char *nome;
+    size_t deslocamento;
+    uint8_t tamanho;
+    int32_t minimo;
+    int32_t maximo;
+};
+
+#define CAMPO(nome, membro, minimo, maximo) \
+    {nome, offsetof(EntradaAcesso, membro), sizeof(EntradaAcesso::membro), minimo, maximo}
+
+static const CampoPatch CAMPOS[] = {
+    CAMPO("usuario", usuario, 0, 65535),
+    CAMPO("confianca", confiancaMinima, 0, 65535),
+    CAMPO("revogado", revogado, 0, 1),
+    CAMPO("dias", dias[0], 0, TODOS_OS_DIAS),
+    CAMPO("inicio", inicioMin[0], 0, MINUTOS_POR_DIA - 1),
+    CAMPO("fim", fimMin[0], 0, MINUTOS_POR_DIA),
+    CAMPO("dias2", dias[1], 0, TODOS_OS_DIAS),
+    CAMPO("inicio2", inicioMin[1], 0, MINUTOS_POR_DIA - 1),
+    CAMPO("fim2", fimMin[1], 0, MINUTOS_POR_DIA),
+};
+
+// Do patch, fora da entrada: versao nova, versao em que se baseia e posicao.
+static const char *const CABECALHO[] = {"versao", "base", "slot"};
+static const uint8_t NUM_CABECALHO = sizeof(CABECALHO) / sizeof(CABECALHO[0]);
+
+static const CampoPatch *procurarCampo(const char *nome)
+{
+    for (const CampoPatch &campo : CAMPOS)
+        if (strcmp(campo.nome, nome) == 0)
+            return &campo;
+    return nullptr;
+}
+
+static void escreverCampo(EntradaAcesso &entrada, const CampoPatch &campo, int32_t valor)
+{
+    uint8_t *destino = (uint8_t *)&entrada + campo.deslocamento;
+    if (campo.tamanho == 1)
+        *destino = (uint8_t)valor;
+    else
+        *(uint16_t *)destino = (uint16_t)valor;
+}
+
+static int32_t lerCampo(const EntradaAcesso &entrada, const CampoPatch &campo)
+{
+    const uint8_t *origem = (const uint8_t *)&entrada + campo.deslocamento;
+    return campo.tamanho == 1 ? *origem : *(const uint16_t *)origem;
+}
+
+// Nome do primeiro campo invalido, ou nullptr.
+static const char *validarEntrada(const EntradaAcesso &entrada)
+{
+    for (const CampoPatch &campo : CAMPOS)
+    {
+        int32_t valor = lerCampo(entrada, campo);
+        if (valor < campo.minimo || valor > campo.maximo)
+            return campo.nome;
+    }
+    return entrada.reservado ? "reservado" : nullptr;
+}
+
+// ------------------- NVS -------------------
+// Registro da chave "acl": a lista inteira. Mudou a estrutura, muda a versao do
+// registro: o antigo e ignorado e o no fica sem lista ate o servidor reenviar.
+static const char *CHAVE_NVS = "acl";
+static const uint16_t VERSAO_NVS = 1;
+
+struct RegistroListaDeAcesso
+{
+    uint16_t versaoRegistro;
+    uint16_t reservado;
+    uint32_t versao;
+    EntradaAcesso entradas[MAX_SLOTS_ACESSO];
+};
+
+static bool gravar()
+{
+    static RegistroListaDeAcesso registro; // ~3 KB: fora da pilha da tarefa de rede
+    memset(&registro, 0, sizeof(registro));
+    registro.versaoRegistro = VERSAO_NVS;
+    registro.versao = versao;
+    memcpy(registro.entradas, entradas, sizeof(entradas));
+    return halNvsGravar(CHAVE_NVS, &registro, sizeof(registro));
+}
+
+// ====================================================================================
+// FUNCOES
+// ====================================================================================
+
+bool iniciarListaDeAcesso()
+{
+    static RegistroListaDeAcesso registro;
+    bool gravada = halNvsLer(CHAVE_NVS, &registro, sizeof(registro)) && registro.versaoRegistro == VERSAO_NVS;
+    for (uint16_t slot = 0; gravada && slot < MAX_SLOTS_ACESSO; slot++)
+        gravada = !validarEntrada(registro.entradas[slot]);
+
+    EntradaAcesso vazia = {};
+    for (uint16_t slot = 0; slot < MAX_SLOTS_ACESSO; slot++)
+        trocar(slot, gravada ? registro.entradas[slot] : vazia);
+    versao = gravada ? registro.versao : 0;
+    cadastros = contarCadastros();
+    ativa.store(gravada, std::memory_order_release);
+    return gravada;
+}
+
+void limitarSlotsAcesso(uint16_t capacidade)
+{
+    limiteSlots = capacidade < MAX_SLOTS_ACESSO ? capacidade + 1 : MAX_SLOTS_ACESSO;
+}
+
+ResultadoAcesso avaliarAcesso(uint16_t slot, uint16_t confianca, time_t agoraLocal)
+{
+    if (!ativa.load(std::memory_order_acquire))
+        return {ACESSO_LIBERADO, 0}; // Sem lista: comportamento antigo
+    if (slot >= MAX_SLOTS_ACESSO)
+        return {ACESSO_SEM_CADASTRO, 0};
+
+    EntradaAcesso entrada = copiar(slot);
+    if (!entrada.usuario)
+        return {ACESSO_SEM_CADASTRO, 0};
+    if (entrada.revogado)
+        return {ACESSO_REVOGADO, entrada.usuario};
+    if (confianca < entrada.confiancaMinima)
+        return {ACESSO_CONFIANCA_BAIXA, entrada.usuario};
+    return {avaliarHorario(entrada, agoraLocal), entrada.usuario};
+}
+
+ResultadoPatchAcesso aplicarPatchAcesso(uint32_t base, uint32_t nova, uint16_t slot, const EntradaAcesso &entrada)
+{
+    if (nova <= base || slot >= limiteSlots || validarEntrada(entrada))
+        return PATCH_INVALIDO;
+    if (nova == versao)
+        return PATCH_REPETIDO;
+    if (base != versao)
+        return PATCH_FORA_DE_ORDEM;
+
+    // Apagar: a posicao inteira volta a zero
+    EntradaAcesso copia = {};
+    if (entrada.usuario)
+        copia = entrada;
+    cadastros += (copia.usuario != 0) - (entradas[slot].usuario != 0);
+    trocar(slot, copia);
+    versao = nova;
+    ativa.store(true, std::memory_order_release);
+    return gravar() ? PATCH_APLICADO : PATCH_NAO_GRAVADO;
+}
+
+ResultadoPatchAcesso aplicarPatchAcessoJson(const uint8_t *dados, size_t tamanho, const char *&erro)
+{
+    // Raro (uma mensagem por mudanca de cadastro): o documento pode usar o heap
+    JsonDocument documento;
+    erro = "json";
+    if (deserializeJson(documento, dados, tamanho) || !documento.is<JsonObject>())
+        return PATCH_INVALIDO;
+
+    // O patch troca a posicao inteira: campo ausente e zero
+    EntradaAcesso entrada = {};
+    int32_t cabecalho[NUM_CABECALHO] = {-1, -1, -1};
+    bool temUsuario = false;
+    for (JsonPair par : documento.as<JsonObject>())
+    {
+        const char *nome = par.key().c_str();
+        int8_t indice = -1;
+        for (uint8_t i = 0; i < NUM_CABECALHO; i++)
+            if (strcmp(nome, CABECALHO[i]) == 0)
+                indice = i;
+        const CampoPatch *campo = indice < 0 ? procurarCampo(nome) : nullptr;
+        if (indice < 0 && !campo)
+        {
+            erro = "campo desconhecido";
+            return PATCH_INVALIDO;
+        }
+        // `erro` precisa sobreviver ao documento: o nome vem das tabelas, nao do JSON
+        erro = campo ? campo->nome : CABECALHO[indice];
+        if (!par.value().is<int32_t>())
+            return PATCH_INVALIDO;
+        int32_t valor = par.value().as<int32_t>();
+
+        if (!campo)
+        {
+            cabecalho[indice] = valor;
+            continue;
+        }
+        if (valor < campo->minimo || valor > campo->maximo)
+            return PATCH_INVALIDO;
+        escreverCampo(entrada, *campo, valor);
+        temUsuario = temUsuario || campo->deslocamento == offsetof(EntradaAcesso, usuario);
+    }
+
+    int32_t nova = cabecalho[0], base = cabecalho[1], slot = cabecalho[2];
+    // Sem "usuario" o patch e recusado: um campo esquecido nao apaga um cadastro
+    if (nova < 1)
+        erro = "versao";
+    else if (base < 0 || base >= nova)
+        erro = "base";
+    else if (slot < 0 || slot >= limiteSlots)
+        erro = "slot";
+    else if (!temUsuario)
+        erro = "usuario";
+    else
+        erro = nullptr;
+    if (erro)
+        return PATCH_INVALIDO;
+    return aplicarPatchAcesso((uint32_t)base, (uint32_t)nova, (uint16_t)slot, entrada);
+}
+
+bool listaDeAcessoAtiva()
+{
+    return ativa.load(std::memory_order_acquire);
+}
+
+uint32_t versaoListaDeAcesso()
+{
+    return versao;
+}
+
+uint16_t cadastrosListaDeAcesso()
+{
+    return cadastros;
+}
+
+size_t serializarListaDeAcesso(char *buffer, size_t capacidade, const char *status, time_t timestamp)
+{
+    int n = snprintf(buffer, capacidade, "{\"versao\":%lu,\"cadastros\":%u,\"ativa\":%s,\"status\":\"%s\",\"timestamp\":%ld}",
+                     (unsigned long)versao, (unsigned)cadastros, listaDeAcessoAtiva() ? "true" : "false", status,
+                     (long)timestamp);
+    if (n < 0 || (size_t)n >= capacidade)
+        return 0;
+    return n;
+}
+
+const char *nomeDecisaoAcesso(DecisaoAcesso decisao)
+{
+    static const char *NOMES[NUM_DECISOES_ACESSO] = {
+        "liberado", "nao encontrado", "sem cadastro", "revogado", "confianca baixa", "fora do horario", "sem relogio",
+    };
+    return decisao < NUM_DECISOES_ACESSO ? NOMES[decisao] : "?";
+}
+
+const char *nomeResultadoPatchAcesso(ResultadoPatchAcesso resultado)
+{
+    switch (resultado)
+    {
+    case PATCH_APLICADO:
+        return "aplicado";
+    case PATCH_REPETIDO:
+        return "repetido";
+    case PATCH_FORA_DE_ORDEM:
+        return "fora de ordem";
+    case PATCH_INVALIDO:
+        return "invalido";
+    case PATCH_NAO_GRAVADO:
+        return "nao gravado";
+    default:
+        return "?";
+    }
+}
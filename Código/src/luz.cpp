@@ -0,0 +1,136 @@
+#include "luz.h"
+#include "hal.h"
+#include <atomic>
+
+// ------------------- DETECTOR -------------------
+// Escrito apenas pelo callback da HAL. Os filtros guardam 12 bits fracionarios sobre a
+// amostra de 14 bits (cabe em int32).
+static const uint8_t SOBREAMOSTRAGEM = 16; // Conversoes por amostra (+2 bits)
+static const uint8_t MS_POR_AMOSTRA = 4;   // 16 conversoes a 4 kHz
+static const uint8_t RAPIDO_DESLOCAMENTO = 3;  // alfa 1/8: ~8 amostras (32 ms)
+static const uint8_t BASE_DESLOCAMENTO = 10;   // alfa 1/1024: ~1024 amostras (4 s)
+static const uint8_t FRACAO = 12;
+static const uint8_t MAX_JANELA = 64; // Amostras da janela de variacao (256 ms)
+
+static ConfiguracaoLuz configuracao = LUZ_PADRAO;
+static std::atomic<uint16_t> limiarMinimo{LUZ_PADRAO.limiarMinimo}; // Ajustaveis em uso
+static std::atomic<uint8_t> limiarPercentual{LUZ_PADRAO.limiarPercentual};
+static uint32_t somaConversoes = 0;
+static uint8_t conversoesSomadas = 0;
+static bool primeira = true;
+static int32_t rapido = 0; // Q12 de 14 bits
+static int32_t base = 0;
+static int32_t historico[MAX_JANELA]; // rapido das ultimas amostras, em 14 bits
+static uint8_t posicaoHistorico = 0;
+static uint8_t tamanhoJanela = 1;
+static bool alarme = false;
+static uint32_t inicioAlarme = 0; // Em amostras
+
+// ------------------- SAIDA -------------------
+static std::atomic<uint16_t> nivelPublicado{0};
+static std::atomic<uint16_t> basePublicada{0};
+static std::atomic<bool> alarmePublicado{false};
+static std::atomic<uint32_t> amostras{0};
+static std::atomic<unsigned long> instante{0};
+
+void configurarLuz(const ConfiguracaoLuz &nova)
+{
+    configuracao = nova;
+    ajustarLimiaresLuz(nova.limiarMinimo, nova.limiarPercentual);
+    uint16_t janela = configuracao.janelaMs / MS_POR_AMOSTRA;
+    tamanhoJanela = janela < 1 ? 1 : janela > MAX_JANELA ? MAX_JANELA : janela;
+    somaConversoes = 0;
+    conversoesSomadas = 0;
+    primeira = true;
+    alarme = false;
+    alarmePublicado.store(false);
+}
+
+void ajustarLimiaresLuz(uint16_t minimo, uint8_t percentual)
+{
+    limiarMinimo.store(minimo, std::memory_order_relaxed);
+    limiarPercentual.store(percentual, std::memory_order_relaxed);
+}
+
+static void processarAmostra(int32_t x)
+{
+    uint32_t n = amostras.load();
+    if (primeira)
+    {
+        rapido = base = x << FRACAO;
+        for (uint8_t i = 0; i < MAX_JANELA; i++)
+            historico[i] = x;
+        primeira = false;
+    }
+    rapido += ((x << FRACAO) - rapido) >> RAPIDO_DESLOCAMENTO;
+    base += (rapido - base) >> BASE_DESLOCAMENTO;
+
+    int32_t atual = rapido >> FRACAO;
+    int32_t linha = base >> FRACAO;
+    // historico e circular: a posicao atual guarda a amostra de `tamanhoJanela` atras
+    uint8_t antiga = (posicaoHistorico + MAX_JANELA - tamanhoJanela) % MAX_JANELA;
+    int32_t variacao = atual - historico[antiga];
+    historico[posicaoHistorico] = atual;
+    posicaoHistorico = (posicaoHistorico + 1) % MAX_JANELA;
+
+    int32_t desvio = atual - linha;
+    int32_t limiar = (int32_t)limiarMinimo.load(std::memory_order_relaxed) << 2; // 12 -> 14 bits
+    int32_t relativo = linha * limiarPercentual.load(std::memory_order_relaxed) / 100;
+    if (relativo > limiar)
+        limiar = relativo;
+
+    if (!alarme)
+    {
+        bool brusca = (desvio >= limiar && variacao >= limiar / 2) ||
+                      (desvio <= -limiar && variacao <= -limiar / 2);
+        if (brusca)
+        {
+            alarme = true;
+            inicioAlarme = n;
+        }
+    }
+    else if ((n - inicioAlarme) * MS_POR_AMOSTRA >= configuracao.retencaoMs && abs(desvio) < limiar / 2 &&
+             abs(variacao) < limiar / 2)
+    {
+        // So encerra com o sinal estavel: no meio de outra transicao o desvio passa por
+        // zero (ex.: lanterna desligando) e o alarme nao deve piscar
+        alarme = false;
+    }
+
+    nivelPublicado.store((uint16_t)(atual >> 2));
+    basePublicada.store((uint16_t)(linha >> 2));
+    alarmePublicado.store(alarme);
+    instante.store(millis());
+    amostras.fetch_add(1);
+}
+
+void alimentarLuz(const uint16_t *conversoes, uint8_t quantidade)
+{
+    for (uint8_t i = 0; i < quantidade; i++)
+    {
+        somaConversoes += conversoes[i];
+        if (++conversoesSomadas == SOBREAMOSTRAGEM)
+        {
+            processarAmostra((int32_t)(somaConversoes >> 2)); // Soma de 16 x 12 bits -> 14 bits
+            somaConversoes = 0;
+            conversoesSomadas = 0;
+        }
+    }
+}
+
+bool iniciarLuz(uint8_t pino)
+{
+    configurarLuz(configuracao);
+    return halAdcContinuo(pino, alimentarLuz);
+}
+
+LeituraLuz leituraLuz()
+{
+    LeituraLuz leitura;
+    leitura.amostras = amostras.load();
+    leitura.nivel = nivelPublicado.load();
+    leitura.linhaDeBase = basePublicada.load();
+    leitura.alarme = alarmePublicado.load();
+    leitura.instante = instante.load();
+    return leitura;
+}
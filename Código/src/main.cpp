@@ -1,12 +1,28 @@
 #include <Arduino.h>
-#include "monitoramento.h"
+#include "Monitoramento.h"
 #include "sensorDeDigitais.h"
 #include "internet.h"
+#include "conexaoMqtt.h"
 #include "senhas.h"
-#include <WiFi.h>
-#include <PubSubClient.h>
+#include "hal.h"
+#include "tarefas.h"
+#include "agendador.h"
+#include "filaSpsc.h"
+#include "eventos.h"
+#include "telemetria.h"
+#include "mensagens.h"
+#include "quadroBinario.h"
+#include "caixaDeSaida.h"
+#include "amostragem.h"
+#include "fusao.h"
+#include "configuracao.h"
+#include "diagnostico.h"
+#include "listaDeAcesso.h"
+#include "modelosDigitais.h"
+#include "particaoQuente.h"
+#include "registro.h"
+#include "partida.h"
 #include <ArduinoJson.h>
-#include <ezTime.h>
 
 // --- Configuracoes de Hardware e Rede ---
 
@@ -15,13 +31,11 @@
 #define PASSWORD 0x00000000
 #define pinButton 12
 #define pinoTrava 25
+#define pinoToque 4 // Saida de toque do modulo de digitais (com SAFEZONE_TOQUE)
 
 // --- Instanciacao de Objetos ---
 
 FingerprintSensor sensorDigital(&Serial2, PASSWORD, RX_FINGERPRINT, TX_FINGERPRINT);
-WiFiClient espClient;
-PubSubClient client(espClient);
-Timezone tempoLocal;
 
 // --- Configuracoes de Rede (MQTT)
 
@@ -29,18 +43,241 @@ const char *mqtt_server = "broker.hivemq.com";
 const int mqtt_port = 1883;
 const char *mqtt_id = "senai134-safezone-publisher";
 const char *mqtt_topic_pub = "safezone-events";
+const char *mqtt_topic_wifi = "safezone-wifi";
+const char *mqtt_topic_amostras = "safezone-amostras";
+const char *mqtt_topic_config = "safezone-config/134";                 // Ajustes deste no
+const char *mqtt_topic_config_todos = "safezone-config/todos";         // Ajustes de toda a frota
+const char *mqtt_topic_config_efetiva = "safezone-config/134/efetiva"; // Configuracao vigente
+const char *mqtt_topic_diag = "safezone/134/diag";                     // Perfil das etapas e heap
+const char *mqtt_topic_boot = "safezone/134/boot";                     // Duracao das fases da partida
+const char *mqtt_topic_acl = "safezone-acl/134";                       // Patches da lista de acesso
+const char *mqtt_topic_acl_efetiva = "safezone-acl/134/efetiva";       // Versao vigente da lista
+const char *mqtt_topic_modelos_exportar = "safezone-digitais/134/exportar";        // Pedido de copia das digitais
+const char *mqtt_topic_modelos_arquivo = "safezone-digitais/134/arquivo";          // Pedacos da copia
+const char *mqtt_topic_modelos_importar = "safezone-digitais/134/importar";        // Pedacos a gravar neste no
+const char *mqtt_topic_modelos_importar_todos = "safezone-digitais/todos/importar"; // Pedacos para toda a frota
+const char *mqtt_topic_modelos_status = "safezone-digitais/134/status";            // Progresso da copia
+const uint16_t mqtt_no = 134; // Identificador do no nos quadros binarios
+
+// --- Formato das mensagens ---
+// JSON (padrao) ou quadro binario compacto (quadroBinario.h), escolhido por implantacao
+// com -D SAFEZONE_MENSAGENS_BINARIAS=1. Os assinantes precisam usar o mesmo formato.
+
+#ifndef SAFEZONE_MENSAGENS_BINARIAS
+#define SAFEZONE_MENSAGENS_BINARIAS 0
+#endif
+
+// --- Amostragem de alta taxa ---
+// -D SAFEZONE_AMOSTRAGEM=1 le a luz a 50 Hz, a distancia a 50 Hz (perfil rapido do
+// VL53L0X) e o peso a 10 Hz (cada conversao do HX711, filtrada) e publica as amostras em quadros binarios de 32 no topico de
+// amostras, para a analise de assinaturas de intrusao no servidor. Os alarmes seguem
+// derivados das mesmas leituras.
+
+#ifndef SAFEZONE_AMOSTRAGEM
+#define SAFEZONE_AMOSTRAGEM 0
+#endif
+
+// --- Captura pelo toque ---
+// -D SAFEZONE_TOQUE=1 usa a saida de toque do modulo (TOUCH do R503, WAK do R307) ligada
+// ao pinoToque: a verificacao comeca quando o dedo encosta no vidro, sem apertar o botao
+// nem esperar o debounce. O botao continua funcionando.
+
+#ifndef SAFEZONE_TOQUE
+#define SAFEZONE_TOQUE 0
+#endif
+
+// --- Particao quente das digitais ---
+// -D SAFEZONE_PARTICAO_QUENTE=N reserva as N ultimas posicoes do sensor (ate 32) para
+// copias dos modelos de quem mais entra (particaoQuente.h): a verificacao procura nelas
+// antes do resto da biblioteca. Na primeira vez as posicoes precisam estar livres; depois
+// o cadastro e a importacao nao as aceitam e a exportacao as pula.
+
+#ifndef SAFEZONE_PARTICAO_QUENTE
+#define SAFEZONE_PARTICAO_QUENTE 0
+#endif
+
+const ConfiguracaoAmostragem amostragemAltaTaxa = {true, 32, 2000};
+const int32_t intervaloLuzAltaTaxa = 20; // Padrao da configuracao neste modo
 
 // --- Variaveis de Estado ---
 
-bool portaDestravada = false;
-unsigned long tempoInicioDestravamento = 0;
-const unsigned long duracaoDestravamento = 3000; // Tempo que a porta fica aberta
+// Espera na porta: do aperto do botao (ou do toque no sensor) ate a decisao, medida em
+// ETAPA_ESPERA_DIGITAL e publicada no diagnostico. Apenas a tarefa de acesso.
+bool apertoPendente = false; // Borda do aperto vista, debounce ainda nao confirmou
+uint32_t inicioAperto = 0;   // halCiclos() na primeira borda do aperto
+uint32_t inicioEspera = 0;   // Da verificacao em andamento
+
+// --- Configuracao em tempo de execucao ---
+// Limiares, intervalos, tempos da porta e calibracao (configuracao.h), ajustados pelo
+// topico de configuracao e gravados na NVS. Cada tarefa guarda a sua copia e so a
+// atualiza quando a geracao muda.
+
+ConfiguracaoSafezone configuracaoAcesso = CONFIGURACAO_PADRAO; // Tarefa de acesso
+uint32_t geracaoAcesso = 0;
+ConfiguracaoSafezone configuracaoRede = CONFIGURACAO_PADRAO; // Tarefa de rede
+uint32_t geracaoRede = 0;
+char statusConfiguracao[48] = ""; // Resultado a publicar no topico da configuracao vigente
+char mensagemConfiguracao[TAMANHO_CONFIGURACAO_JSON];
+
+// --- Lista de acesso ---
+// Quem pode entrar e em que horario, por posicao de digital no sensor (listaDeAcesso.h).
+// A decisao e local; os patches chegam pelo topico da lista e a versao vigente volta
+// no topico da lista efetiva, para o servidor saber de onde continuar.
+
+char statusListaDeAcesso[48] = ""; // Resultado a publicar no topico da lista vigente
+char mensagemListaDeAcesso[TAMANHO_LISTA_ACESSO_JSON];
+
+// --- Copia das digitais ---
+// Os modelos do sensor saem e entram em pedacos de 528 bytes (modelosDigitais.h), um
+// modelo por passo da tarefa de acesso e so sem verificacao em andamento. A exportacao
+// comeca por um pedido no topico de exportacao e sai no topico do arquivo; a importacao
+// chega pelos topicos de importacao (deste no ou da frota), grava cada modelo na mesma
+// posicao de origem (a lista de acesso vale igual em toda a frota) e responde no topico
+// de status com o proximo indice que falta. O progresso da importacao fica na NVS: depois
+// de uma queda ou de um reinicio o envio continua de onde parou.
+
+struct PedidoExportacao
+{
+  uint32_t transferencia;
+  uint16_t inicio;
+};
+
+const uint8_t VERSAO_PROGRESSO_NVS = 1;
+struct RegistroProgressoImportacao
+{
+  uint8_t versaoRegistro;
+  ProgressoTransferencia progresso;
+};
+
+ProgressoTransferencia progressoImportacao; // Apenas a tarefa de rede
+uint8_t pedacoMqtt[TAMANHO_PEDACO];
+char mensagemModelos[TAMANHO_STATUS_MODELOS_JSON];
+
+// --- Particao quente ---
+// As copias validas ficam na NVS, gravadas com a copia invalidada antes de copiar e de
+// novo depois de confirmada: depois de uma queda no meio, a posicao reservada nao aponta
+// para o modelo errado. Apenas a tarefa de acesso.
+
+const uint8_t VERSAO_PARTICAO_NVS = 1;
+struct RegistroParticaoQuente
+{
+  uint8_t versaoRegistro;
+  uint8_t tamanho;
+  uint16_t capacidade;
+  uint16_t copias[MAX_PARTICAO_QUENTE];
+};
+
+ParticaoQuente particaoQuente;
+
+// --- Telemetria dos alarmes ---
+// Publica em cada borda de alarme (no maximo uma por intervalo por sensor, 1 s por
+// padrao, o fundido na hora) e, sem alteracoes, um heartbeat com o estado completo.
+// Os intervalos vem da configuracao, aplicada pela tarefa de rede.
+
+Telemetria telemetria({{0, 0, 0, 0}, 0});
+
+// --- Caixa de saida ---
+// Eventos de acesso e leituras dos sensores vao primeiro para a flash, como quadro
+// binario, e saem em lotes de ate 10 a cada 50 ms (200 mensagens/s) enquanto o broker
+// estiver conectado. A sequencia da caixa vai em cada mensagem do topico de eventos.
+
+const ConfiguracaoCaixaDeSaida configuracaoCaixa = {10, 50};
+CaixaDeSaida caixaDeSaida(configuracaoCaixa);
+
+// --- Buffer de publicacao ---
+// Estatico e usado apenas pela tarefa de rede: nenhuma mensagem aloca memoria no heap.
+
+char mensagemMqtt[TAMANHO_MENSAGEM_MQTT];
+uint8_t quadroMqtt[QUADRO_TAMANHO_MAXIMO];
+uint32_t sequenciaWiFi = 0;         // Quadros do topico de Wi-Fi, que nao passam pela caixa
+uint32_t sequenciaAmostras = 0;     // Quadros do topico de amostras: lacunas sao quadros perdidos
+QuadroAmostras quadroAmostras;
+uint8_t bufferAmostras[QUADRO_TAMANHO_AMOSTRAS_MAXIMO];
+LeituraSensores ultimaLeitura = {}; // Ultima leitura recebida pela tarefa de rede
+char mensagemDiagnostico[SAFEZONE_PERFIL ? TAMANHO_DIAGNOSTICO_JSON : 1];
+char mensagemPartida[TAMANHO_PARTIDA_JSON];
+bool relatorioPartidaEnviado = false;
+const uint32_t esperaRelogioPartidaMs = 10000; // Depois do MQTT, o relatorio espera o NTP ate isto
+
+// --- Temporizadores ---
+// Cada tarefa tem o seu agendador (agendador.h), executado depois do seu passo: a
+// tarefa de acesso trava a porta e confirma o botao, a de rede envia a qualidade do
+// Wi-Fi e o diagnostico (diagnostico.h) a cada minuto.
+
+const unsigned long debounceTime = 50;
+const uint32_t intervaloWiFiMs = 60000;
+const uint32_t intervaloDiagnosticoMs = 60000;
+
+AgendadorFixo<4> agendaAcesso;
+AgendadorFixo<4> agendaRede;
+uint16_t idTrava = SEM_TRABALHO;
+uint16_t idBotao = SEM_TRABALHO;
+uint16_t idWiFi = SEM_TRABALHO;
+uint16_t idDiagnostico = SEM_TRABALHO;
+
+// --- Comunicacao entre tarefas ---
+
+FilaSpsc<LeituraSensores, 16> filaLeituras; // sensores -> rede
+FilaSpsc<EventoAcesso, 8> filaAcessos;      // acesso -> rede
+FilaSpsc<PedidoExportacao, 2> filaPedidosExportacao; // rede -> acesso
+FilaSpsc<PedacoModelo, 2> filaImportacao;            // rede -> acesso
+FilaSpsc<PedacoModelo, 2> filaExportacao;            // acesso -> rede
+FilaSpsc<StatusModelos, 8> filaStatusModelos;        // acesso -> rede
+FilaSpsc<StatusModelos, 4> respostasModelos;         // rede -> rede: respostas dadas no callback MQTT
 
 // --- Prototipacao das Funcoes ---
 
-void liberarAcesso(PubSubClient &client, Timezone &tempo, const char *topico);
-void enviarLeituraSensores(PubSubClient &client, Timezone &tempoLocal, const char *topico);
-void mqttConnect(void);
+void passoRede();
+void passoSensores();
+void passoAcesso();
+void iniciarRede();
+void iniciarSensores();
+void iniciarAcesso();
+void acompanharPartida();
+void liberarAcesso();
+void travarPorta(void *contexto);
+void confirmarBotao(void *contexto);
+void trabalhoWiFi(void *contexto);
+void trabalhoDiagnostico(void *contexto);
+void enviarLeituraSensores();
+void enviarEventoAcesso(const EventoAcesso &evento);
+void enviarQualidadeWiFi(const char *topico);
+void enviarDiagnostico(const char *topico);
+void enviarAmostras(const char *topico);
+void enviarConfiguracao(const char *topico);
+void receberConfiguracao(const uint8_t *dados, unsigned int tamanho);
+void enviarListaDeAcesso(const char *topico);
+void receberListaDeAcesso(const uint8_t *dados, unsigned int tamanho);
+void passoModelos();
+uint8_t lerMapaDigitais(uint8_t *mapa, uint16_t &posicoes);
+void enviarModelos(const char *topicoArquivo, const char *topicoStatus);
+void publicarStatusModelos(const char *topico, const StatusModelos &status);
+void receberPedidoExportacao(const uint8_t *dados, unsigned int tamanho);
+void receberPedacoModelo(const uint8_t *dados, unsigned int tamanho);
+bool carregarProgressoImportacao();
+bool gravarProgressoImportacao();
+bool iniciarParticaoQuente(uint8_t tamanho);
+void passoParticaoQuente();
+bool esquecerCopiaDigital(uint16_t slot);
+bool gravarParticaoQuente();
+uint8_t alarmesAtuais();
+void completarQuadro(QuadroSafezone &quadro);
+bool guardarEvento(QuadroSafezone &quadro);
+bool publicarRegistro(uint32_t sequencia, const uint8_t *dados, uint16_t tamanho);
+
+// --- Tarefas ---
+// O nucleo 0 e dividido com a pilha Wi-Fi; acesso e sensores ficam no nucleo 1, com o
+// controle de acesso na maior prioridade. O registro (registro.h) escreve na serial com a
+// menor prioridade, no nucleo 0. Sem multitarefa, loop() roda os passos nesta ordem.
+// Cada tarefa sobe o seu hardware no `iniciar` (partida.h): o acesso nao espera a rede.
+
+const Tarefa tarefas[] = {
+    {"rede", passoRede, 10, 1, 0, 8192, &agendaRede, iniciarRede},
+    {"sensores", passoSensores, 10, 2, 1, 4096, nullptr, iniciarSensores},
+    {"acesso", passoAcesso, 5, 3, 1, 4096, &agendaAcesso, iniciarAcesso},
+    {"registro", passoRegistro, 10, 0, 0, 3072, nullptr, nullptr},
+};
+const uint8_t NUM_TAREFAS = sizeof(tarefas) / sizeof(tarefas[0]);
 
 // ====================================================================================
 // SETUP
@@ -48,25 +285,68 @@ void mqttConnect(void);
 
 void setup()
 {
-  Serial.begin(9600);
-  Serial2.begin(57600, SERIAL_8N1, RX_FINGERPRINT, TX_FINGERPRINT);
-
+  // Porta fechada antes de qualquer outra coisa
+  reiniciarPartida();
+  iniciarFase(PARTIDA_TRAVA);
   pinMode(pinoTrava, OUTPUT);
   digitalWrite(pinoTrava, LOW);
   pinMode(pinButton, INPUT_PULLUP);
+  if (SAFEZONE_TOQUE)
+    halToqueIniciar(pinoToque);
+  concluirFase(PARTIDA_TRAVA);
 
-  conectaWiFi();
-  client.setServer(mqtt_server, mqtt_port);
-  tempoLocal.setLocation("America/Sao_Paulo");
+  Serial.begin(9600);
+  iniciarRegistro(Serial);
+  Serial2.begin(57600, SERIAL_8N1, RX_FINGERPRINT, TX_FINGERPRINT);
 
-  iniciarMonitoramento();
+  idTrava = agendaAcesso.registrar("trava", travarPorta, nullptr);
+  idBotao = agendaAcesso.registrar("botao", confirmarBotao, nullptr);
+  idWiFi = agendaRede.registrar("wifi", trabalhoWiFi, (void *)mqtt_topic_wifi, intervaloWiFiMs);
+  agendaRede.agendar(idWiFi, intervaloWiFiMs);
+  if (SAFEZONE_PERFIL)
+  {
+    idDiagnostico = agendaRede.registrar("diag", trabalhoDiagnostico, (void *)mqtt_topic_diag, intervaloDiagnosticoMs);
+    agendaRede.agendar(idDiagnostico, intervaloDiagnosticoMs);
+  }
 
-  if (!sensorDigital.begin(57600))
+  // So a NVS: a lista de acesso decide sem rede
+  iniciarFase(PARTIDA_CONFIGURACAO);
+  ConfiguracaoSafezone configuracaoPadrao = CONFIGURACAO_PADRAO;
+  if (SAFEZONE_AMOSTRAGEM)
   {
-    Serial.println("Falha ao inicializar o sensor de digitais.");
+    configurarAmostragem(amostragemAltaTaxa);
+    configuracaoPadrao.intervaloMs[AMOSTRA_LUZ] = intervaloLuzAltaTaxa;
+    definirPerfilDistancia(DISTANCIA_RAPIDO);
   }
+  if (iniciarConfiguracao(configuracaoPadrao))
+    REGISTRAR_INFO("Configuracao carregada da NVS.");
+  if (iniciarListaDeAcesso())
+    REGISTRAR_INFO("Lista de acesso v%lu: %u cadastros.", (unsigned long)versaoListaDeAcesso(),
+                   (unsigned)cadastrosListaDeAcesso());
+  if (carregarProgressoImportacao())
+    REGISTRAR_INFO("Importacao de digitais %lu: %u de %u modelos.", (unsigned long)progressoImportacao.transferencia(),
+                   (unsigned)progressoImportacao.recebidos(), (unsigned)progressoImportacao.total());
+  concluirFase(PARTIDA_CONFIGURACAO);
+
+  // O cliente e as assinaturas so ficam registrados: a conexao e da tarefa de rede
+  iniciarMqtt(mqtt_server, mqtt_port, mqtt_id);
+  assinarMqtt(mqtt_topic_config, receberConfiguracao);
+  assinarMqtt(mqtt_topic_config_todos, receberConfiguracao);
+  assinarMqtt(mqtt_topic_acl, receberListaDeAcesso);
+  assinarMqtt(mqtt_topic_modelos_exportar, receberPedidoExportacao);
+  assinarMqtt(mqtt_topic_modelos_importar, receberPedacoModelo);
+  assinarMqtt(mqtt_topic_modelos_importar_todos, receberPedacoModelo);
 
-  Serial.println("Sistema de seguranca iniciado.");
+  // Sensor de digitais, sensores de alarme e rede sobem cada um na sua tarefa. Se uma
+  // tarefa nao puder ser criada nenhuma roda (tarefas.h), e tudo segue no loop().
+  relatorioPartidaEnviado = false;
+  if (halMultitarefa() && iniciarTarefas(tarefas, NUM_TAREFAS))
+    REGISTRAR_INFO("Sistema de seguranca iniciado (tarefas).");
+  else
+  {
+    iniciarPassos(tarefas, NUM_TAREFAS);
+    REGISTRAR_INFO("Sistema de seguranca iniciado.");
+  }
 }
 
 // ====================================================================================
@@ -75,16 +355,123 @@ void setup()
 
 void loop()
 {
+  if (tarefasAtivas())
+  {
+    delay(1000); // O trabalho esta nas tarefas
+    return;
+  }
+
+  executarPassos(tarefas, NUM_TAREFAS);
+}
+
+// ====================================================================================
+// INICIALIZACAO DAS TAREFAS
+// ====================================================================================
+// Cada uma roda na propria tarefa antes do primeiro passo (em paralelo com as outras, ou
+// da maior prioridade para a menor no loop() cooperativo).
+
+// --- Acesso: sensor de digitais; com ele pronto a porta ja abre sem rede ---
+void iniciarAcesso()
+{
+  iniciarFase(PARTIDA_DIGITAIS);
+  bool sensor = sensorDigital.begin(57600);
+  if (!sensor)
+    REGISTRAR_ERRO("Falha ao inicializar o sensor de digitais.");
+  if (SAFEZONE_PARTICAO_QUENTE && iniciarParticaoQuente(SAFEZONE_PARTICAO_QUENTE))
+    REGISTRAR_INFO("Particao quente: posicoes %u a %u.", (unsigned)particaoQuente.inicio(),
+                   (unsigned)(particaoQuente.inicio() + particaoQuente.tamanho() - 1));
+  concluirFase(PARTIDA_DIGITAIS, sensor);
+  REGISTRAR_INFO("Acesso local pronto em %lu ms.", (unsigned long)acessoLocalProntoMs());
+}
+
+// --- Sensores: compila as regras de alarme com os limiares da configuracao ---
+void iniciarSensores()
+{
+  iniciarFase(PARTIDA_SENSORES);
+  iniciarMonitoramento(); // A tara da balanca fica para quando o filtro assentar
+  concluirFase(PARTIDA_SENSORES);
+}
+
+// --- Rede: caixa de saida e o pedido de conexao; o resto em acompanharPartida() ---
+void iniciarRede()
+{
+  iniciarFase(PARTIDA_CAIXA);
+  bool caixa = caixaDeSaida.iniciar();
+  if (caixa)
+    REGISTRAR_INFO("Caixa de saida: %lu eventos pendentes.", (unsigned long)caixaDeSaida.pendentes());
+  else
+    REGISTRAR_AVISO("Sem particao da caixa de saida: eventos so com o broker conectado.");
+  concluirFase(PARTIDA_CAIXA, caixa);
+
+  iniciarFase(PARTIDA_WIFI);
+  conectaWiFi();
+}
+
+// ====================================================================================
+// PASSOS DAS TAREFAS
+// ====================================================================================
+
+// --- Rede: unica dona do Wi-Fi, do MQTT e do relogio NTP ---
+void passoRede()
+{
+  uint32_t marca = marcarEtapa();
   checkWiFi();
-  if (!client.connected())
-    mqttConnect();
+  medirEtapa(ETAPA_WIFI, marca);
+  // Nunca espera pela rede: durante uma queda o controle de acesso segue local. No loop()
+  // cooperativo a conexao tambem fica para depois de um acesso em andamento (o CONNACK
+  // no ESP32 ainda e lido com espera).
+  atualizarMqtt(tarefasAtivas() || !(apertoPendente || sensorDigital.isVerificationPending()));
 
-  client.loop();
+  if (atualizarConfiguracao(configuracaoRede, geracaoRede))
+  {
+    unsigned long intervalo = configuracaoRede.intervaloBordaMs;
+    telemetria.configurar({{intervalo, intervalo, intervalo, 0}, (unsigned long)configuracaoRede.heartbeatMs});
+  }
+  enviarConfiguracao(mqtt_topic_config_efetiva);
+  enviarListaDeAcesso(mqtt_topic_acl_efetiva);
+  enviarModelos(mqtt_topic_modelos_arquivo, mqtt_topic_modelos_status);
 
-  atualizarMonitoramento();
+  marca = marcarEtapa();
+  enviarLeituraSensores();
+  medirEtapa(ETAPA_ENVIO_LEITURAS, marca);
 
-  enviarLeituraSensores(client, tempoLocal, mqtt_topic_pub);
+  EventoAcesso evento;
+  while (filaAcessos.receber(evento))
+    enviarEventoAcesso(evento);
 
+  if (mqttConectado())
+    caixaDeSaida.drenar(millis(), publicarRegistro);
+
+  enviarAmostras(mqtt_topic_amostras);
+  acompanharPartida();
+}
+
+// --- Sensores de alarme ---
+void passoSensores()
+{
+  static LeituraSensores enviada = {};
+
+  if (!atualizarMonitoramento())
+    return;
+  const LeituraSensores &leitura = leituraMonitoramento();
+
+  // O peso chega a cada conversao do HX711 e, na amostragem de alta taxa, os valores
+  // seguem pelos aneis de amostras; a fila de leituras so recebe mudancas de alarme e,
+  // fora isso, uma leitura a cada 500 ms.
+  bool mudou = leitura.alarmePressao != enviada.alarmePressao ||
+               leitura.alarmeMovimento != enviada.alarmeMovimento ||
+               leitura.alarmeLuz != enviada.alarmeLuz ||
+               leitura.alarme != enviada.alarme || leitura.causaAlarme != enviada.causaAlarme;
+  if (!mudou && leitura.instante - enviada.instante < 500)
+    return;
+
+  if (filaLeituras.enviar(leitura))
+    enviada = leitura;
+}
+
+// --- Controle de acesso: botao, sensor de digitais e trava ---
+void passoAcesso()
+{
   // --- Sessao para gerenciamento de impressoes digitais ---
   // --- Desativado durante o funcionamento, que apenas verifica ao apertar o botao ---
   /*if (Serial.available())
@@ -115,122 +502,682 @@ void loop()
     }
   }*/
 
+  atualizarConfiguracao(configuracaoAcesso, geracaoAcesso);
+
   // --- Verificacao de impressoes digitais pelo botao (com tecnica de debounce) ---
+  // Cada mudanca remarca a confirmacao: ela so roda com o botao parado por debounceTime
   static bool novaTentativaDeAcesso = false;
-
-  unsigned long currentTime = millis();
-
-  bool stateButton = digitalRead(pinButton);
   static bool previousStateButton = 1;
-  static bool lastAction = 1;
-
-  const unsigned long debounceTime = 50;
-  static unsigned long previousTime = 0;
 
+  uint32_t marca = marcarEtapa();
+  bool stateButton = digitalRead(pinButton);
   if (stateButton != previousStateButton)
   {
-    previousTime = currentTime;
+    previousStateButton = stateButton;
+    agendaAcesso.agendar(idBotao, debounceTime);
+    if (!stateButton && !apertoPendente)
+    {
+      apertoPendente = true;
+      inicioAperto = halCiclos();
+    }
   }
 
-  if ((currentTime - previousTime) > debounceTime)
+  // Toque no sensor: a captura sai ainda nesta passagem, no pollVerification() abaixo
+  uint32_t ciclosToque;
+  if (halToqueLer(ciclosToque) && !sensorDigital.isVerificationPending())
   {
-    if (stateButton != lastAction)
-    {
-      lastAction = stateButton;
-      if (!stateButton) // O botão foi pressionado
-      {
-        sensorDigital.verifyFingerprint();
-        novaTentativaDeAcesso = true;
-      }
-      else
-      {
-        // O botao foi solto
-      }
-    }
+    inicioEspera = ciclosToque;
+    sensorDigital.startVerification();
   }
 
+  // A verificacao avanca uma etapa por passagem e termina sem bloquear
+  if (sensorDigital.pollVerification())
+    novaTentativaDeAcesso = true;
+  medirEtapa(ETAPA_BOTAO_DIGITAL, marca);
+
   if (novaTentativaDeAcesso)
   {
-    liberarAcesso(client, tempoLocal, mqtt_topic_pub);
+    liberarAcesso();
+    if (sensorDigital.verificationResult() != FINGERPRINT_NOFINGER) // Ninguem encostou o dedo
+      medirEtapa(ETAPA_ESPERA_DIGITAL, inicioEspera);
+    sensorDigital.reportVerification(); // Log so depois da trava
     novaTentativaDeAcesso = false;
   }
 
-  if (portaDestravada && (millis() - tempoInicioDestravamento >= duracaoDestravamento))
+  passoModelos();        // Copia das digitais, entre as verificacoes
+  passoParticaoQuente(); // Idem
+}
+
+// --- Trabalhos agendados ---
+
+void travarPorta(void *)
+{
+  digitalWrite(pinoTrava, LOW); // Trava a porta
+}
+
+// O botao ficou parado por debounceTime: age na mudanca do estado estavel.
+void confirmarBotao(void *)
+{
+  static bool lastAction = 1;
+
+  bool stateButton = digitalRead(pinButton);
+  apertoPendente = false; // Um aperto mais curto que o debounce e descartado aqui
+  if (stateButton == lastAction)
+    return;
+  lastAction = stateButton;
+  if (!stateButton && !sensorDigital.isVerificationPending()) // O botão foi pressionado
   {
-    portaDestravada = false;
-    digitalWrite(pinoTrava, LOW); // Trava a porta
+    uint32_t marca = marcarEtapa();
+    inicioEspera = inicioAperto;
+    sensorDigital.startVerification();
+    medirEtapa(ETAPA_BOTAO_DIGITAL, marca);
   }
+  else
+  {
+    // O botao foi solto
+  }
+}
+
+void trabalhoWiFi(void *contexto)
+{
+  enviarQualidadeWiFi((const char *)contexto);
+}
+
+void trabalhoDiagnostico(void *contexto)
+{
+  enviarDiagnostico((const char *)contexto);
 }
 
 // ====================================================================================
 // FUNCOES
 // ====================================================================================
 
-void liberarAcesso(PubSubClient &client, Timezone &tempo, const char *topico)
+// A trava vem primeiro: o evento de auditoria, a fusao e o log ficam para depois da
+// borda do pino. ETAPA_DESTRAVAR mede da resposta da busca lida ate essa borda.
+void liberarAcesso()
+{
+  uint32_t marca = marcarEtapa();
+
+  if (sensorDigital.isAccessGranted())
+  {
+    digitalWrite(pinoTrava, HIGH); // Destrava a porta
+    medirEtapa(ETAPA_DESTRAVAR, sensorDigital.decisionCycles());
+    agendaAcesso.agendar(idTrava, configuracaoAcesso.destravamentoMs); // Remarca se ja aberta
+    suspenderFusao(configuracaoAcesso.desarmeMs);
+  }
+
+  // A publicacao fica com a tarefa de rede (caixa de saida); aqui so entra na fila
+  EventoAcesso evento;
+  evento.liberado = sensorDigital.isAccessGranted(); // Tentativas bem ou nao sucedidas
+  evento.instante = millis();
+  evento.dedo = sensorDigital.matchedSlot();
+  evento.usuario = sensorDigital.matchedUser();
+  evento.decisao = sensorDigital.accessDecision();
+  if (!filaAcessos.enviar(evento))
+    REGISTRAR_ERRO("Evento de acesso perdido: fila para a rede cheia.");
+  medirEtapa(ETAPA_LIBERAR_ACESSO, marca);
+}
+
+void enviarLeituraSensores()
+{
+  LeituraSensores &leitura = ultimaLeitura;
+
+  // Cada leitura entregue pela tarefa de sensores e avaliada, para nao perder uma borda
+  // curta quando varias se acumulam na fila. Sem leitura nova o heartbeat ainda vence.
+  LeituraSensores recebida;
+  bool nova = filaLeituras.receber(recebida);
+  do
+  {
+    if (nova)
+      leitura = recebida;
+
+    bool alarmes[NUM_SENSORES_ALARME];
+    alarmes[SENSOR_PRESSAO] = leitura.alarmePressao;
+    alarmes[SENSOR_MOVIMENTO] = leitura.alarmeMovimento;
+    alarmes[SENSOR_LUZ] = leitura.alarmeLuz;
+    alarmes[SENSOR_FUSAO] = leitura.alarme;
+
+    unsigned long agora = millis();
+    MotivoTelemetria motivo = telemetria.avaliar(alarmes, agora);
+    if (motivo == TELEMETRIA_NENHUM)
+      continue;
+
+    // Mesmo sem broker a leitura vai para a caixa de saida e sai quando a conexao voltar
+    QuadroSafezone quadro = {};
+    quadro.tipo = QUADRO_LEITURA;
+    quadro.timestamp = halRelogioAgora();
+    quadro.medidaGramas = (int32_t)(leitura.medida * 1000);
+    quadro.distanciaCM = leitura.distanciaCM < 0 ? QUADRO_FORA_DE_ALCANCE : leitura.distanciaCM;
+    quadro.leituraLDR = leitura.leituraLDR;
+    quadro.motivo = motivo;
+    quadro.causaAlarme = leitura.causaAlarme;
+    if (guardarEvento(quadro))
+      telemetria.confirmar(alarmes, agora);
+  } while ((nova = filaLeituras.receber(recebida)));
+}
+
+void enviarEventoAcesso(const EventoAcesso &evento)
 {
-  unsigned long agora = millis();
+  // O evento pode ter esperado na fila: o timestamp e o da decisao
+  QuadroSafezone quadro = {};
+  quadro.tipo = QUADRO_ACESSO;
+  quadro.timestamp = halRelogioAgora() - (time_t)((millis() - evento.instante) / 1000);
+  quadro.liberado = evento.liberado;
+  quadro.dedo = evento.dedo;
+  quadro.usuario = evento.usuario;
+  quadro.decisao = evento.decisao;
+
+  REGISTRAR_INFO("[MQTT] Acesso %s (%s)", evento.liberado ? "liberado" : "negado", nomeDecisaoAcesso(evento.decisao));
+  if (!guardarEvento(quadro))
+    REGISTRAR_ERRO("[MQTT] Evento de acesso perdido (sem flash e sem broker).");
+}
+
+// Trabalho periodico da tarefa de rede (intervaloWiFiMs).
+void enviarQualidadeWiFi(const char *topico)
+{
+  QualidadeWiFi qualidade = qualidadeWiFi();
+  if (!qualidade.conectado)
+    return;
+
+  // --- Envia a qualidade da conexao Wi-Fi a cada minuto ---
+  if (SAFEZONE_MENSAGENS_BINARIAS)
   {
-    JsonDocument doc;
-    String mensagem;
+    QuadroSafezone quadro = {};
+    quadro.tipo = QUADRO_WIFI;
+    quadro.timestamp = halRelogioAgora();
+    quadro.rssi = qualidade.rssi;
+    quadro.conectadoS = qualidade.conectadoHa / 1000;
+    quadro.reconexoes = qualidade.reconexoes;
+    quadro.quedas = qualidade.quedas;
+    quadro.sequencia = ++sequenciaWiFi;
+    completarQuadro(quadro);
+    size_t tamanho = codificarQuadro(quadro, quadroMqtt, sizeof(quadroMqtt));
+    halMqttPublicar(topico, quadroMqtt, tamanho);
+    return;
+  }
+
+  serializarJson<LayoutQualidadeWiFi>(mensagemMqtt, qualidade.rssi, qualidade.conectadoHa / 1000,
+                                      qualidade.reconexoes, qualidade.quedas, halRelogioAgora());
+  halMqttPublicar(topico, mensagemMqtt);
+}
 
-    doc["liberar_Acesso"] = sensorDigital.isAccessGranted(); // Envia as tentativas de acesso (bem ou nao sucedidas)
-    doc["timestamp"] = tempo.now();
+// Fases da partida que dependem da rede e o relatorio, ate ele sair. O fuso (e o NTP)
+// so e pedido com o Wi-Fi conectado; no ESP32 a consulta bloqueia a tarefa de rede,
+// nunca a de acesso.
+void acompanharPartida()
+{
+  static uint32_t mqttConectouEm = 0;
+  if (relatorioPartidaEnviado)
+    return;
 
-    serializeJson(doc, mensagem);
-    Serial.println("[MQTT] Enviando leitura sensores:");
-    Serial.println(mensagem);
-    client.publish(topico, mensagem.c_str());
+  if (!faseConcluida(PARTIDA_WIFI) && halWiFiConectado())
+  {
+    concluirFase(PARTIDA_WIFI);
+    iniciarFase(PARTIDA_MQTT);
+    iniciarFase(PARTIDA_RELOGIO);
+    halRelogioLocal("America/Sao_Paulo");
+  }
+  if (faseIniciada(PARTIDA_MQTT) && !faseConcluida(PARTIDA_MQTT) && mqttConectado())
+  {
+    concluirFase(PARTIDA_MQTT);
+    mqttConectouEm = millis();
   }
+  if (faseIniciada(PARTIDA_RELOGIO) && !faseConcluida(PARTIDA_RELOGIO) && halRelogioSincronizado())
+    concluirFase(PARTIDA_RELOGIO);
 
-  if (sensorDigital.isAccessGranted())
+  if (!faseConcluida(PARTIDA_MQTT) || !mqttConectado() ||
+      (!faseConcluida(PARTIDA_RELOGIO) && millis() - mqttConectouEm < esperaRelogioPartidaMs))
+    return;
+  if (serializarPartida(mensagemPartida, sizeof(mensagemPartida), halRelogioAgora()) &&
+      halMqttPublicar(mqtt_topic_boot, mensagemPartida))
   {
-    portaDestravada = true;
-    tempoInicioDestravamento = millis();
-    digitalWrite(pinoTrava, HIGH); // Destrava a porta
+    relatorioPartidaEnviado = true;
+    REGISTRAR_INFO("[MQTT] Relatorio da partida: acesso local em %lu ms.", (unsigned long)acessoLocalProntoMs());
   }
 }
 
-void enviarLeituraSensores(PubSubClient &client, Timezone &tempo, const char *topico)
+// Trabalho periodico da tarefa de rede (intervaloDiagnosticoMs). Sem broker a janela
+// e descartada: o diagnostico e do momento, nao passa pela caixa de saida.
+void enviarDiagnostico(const char *topico)
 {
-  static unsigned long ultimaLeitura = 0;
-  const unsigned long intervaloLeitura = 3000;
+  size_t tamanho = serializarDiagnostico(mensagemDiagnostico, sizeof(mensagemDiagnostico), millis(), halRelogioAgora());
+  if (tamanho && mqttConectado())
+    halMqttPublicar(topico, mensagemDiagnostico);
+}
 
-  unsigned long agora = millis();
-  if (agora - ultimaLeitura >= intervaloLeitura)
+void enviarAmostras(const char *topico)
+{
+  for (uint8_t sensor = 0; sensor < NUM_SENSORES_AMOSTRADOS; sensor++)
   {
-    ultimaLeitura = agora;
+    while (montarQuadroAmostras((SensorAmostrado)sensor, millis(), quadroAmostras))
+    {
+      quadroAmostras.sequencia = ++sequenciaAmostras;
+      if (!mqttConectado())
+        continue; // Sem broker o quadro e descartado; a sequencia mostra a lacuna
 
-    JsonDocument doc;
-    String mensagem;
+      quadroAmostras.no = mqtt_no;
+      quadroAmostras.timestamp = halRelogioAgora() - (time_t)((millis() - quadroAmostras.instanteMs) / 1000);
+      quadroAmostras.alarmes = alarmesAtuais();
+      size_t tamanho = codificarQuadroAmostras(quadroAmostras, bufferAmostras, sizeof(bufferAmostras));
+      halMqttPublicar(topico, bufferAmostras, tamanho);
+    }
+  }
+}
+
+// Publica a configuracao vigente depois de cada mensagem de configuracao e a cada
+// conexao ao broker, com o resultado da ultima mensagem ou "conexao".
+void enviarConfiguracao(const char *topico)
+{
+  static bool estavaConectado = false;
+  bool conectado = mqttConectado();
+  if (conectado && !estavaConectado && !statusConfiguracao[0])
+    strcpy(statusConfiguracao, "conexao");
+  estavaConectado = conectado;
+  if (!conectado || !statusConfiguracao[0])
+    return;
 
-    // --- Envia as leituras do sistema de alarme a cada 3 segundos ---
-    doc["sensor_luz"] = alarmeSensorLuz;
-    doc["sensor_movimento"] = alarmeSensorMovimento;
-    doc["sensor_pressao"] = alarmeSensorPressao;
-    doc["timestamp"] = tempo.now();
+  if (serializarConfiguracao(mensagemConfiguracao, sizeof(mensagemConfiguracao), statusConfiguracao,
+                             halRelogioAgora()) &&
+      halMqttPublicar(topico, mensagemConfiguracao))
+    statusConfiguracao[0] = '\0';
+}
+
+// Mensagem dos topicos de configuracao, dentro de atualizarMqtt(). Aplica na hora; a
+// resposta sai em enviarConfiguracao(), fora do callback do cliente MQTT.
+void receberConfiguracao(const uint8_t *dados, unsigned int tamanho)
+{
+  const char *erro = nullptr;
+  ResultadoConfiguracao resultado = aplicarConfiguracaoJson(dados, tamanho, erro);
+  if (resultado == CONFIGURACAO_INVALIDA)
+    snprintf(statusConfiguracao, sizeof(statusConfiguracao), "invalida: %s", erro);
+  else
+    snprintf(statusConfiguracao, sizeof(statusConfiguracao), "%s", nomeResultadoConfiguracao(resultado));
+  REGISTRAR_INFO("[MQTT] Configuracao %s", statusConfiguracao);
+}
 
-    serializeJson(doc, mensagem);
-    client.publish(topico, mensagem.c_str());
+// Publica a versao vigente da lista de acesso depois de cada patch e a cada conexao ao
+// broker, como a configuracao.
+void enviarListaDeAcesso(const char *topico)
+{
+  static bool estavaConectado = false;
+  bool conectado = mqttConectado();
+  if (conectado && !estavaConectado && !statusListaDeAcesso[0])
+    strcpy(statusListaDeAcesso, "conexao");
+  estavaConectado = conectado;
+  if (!conectado || !statusListaDeAcesso[0])
+    return;
+
+  if (serializarListaDeAcesso(mensagemListaDeAcesso, sizeof(mensagemListaDeAcesso), statusListaDeAcesso,
+                              halRelogioAgora()) &&
+      halMqttPublicar(topico, mensagemListaDeAcesso))
+    statusListaDeAcesso[0] = '\0';
+}
+
+// Patch do topico da lista de acesso, dentro de atualizarMqtt(). A tarefa de acesso ve
+// a posicao nova na proxima digital.
+void receberListaDeAcesso(const uint8_t *dados, unsigned int tamanho)
+{
+  const char *erro = nullptr;
+  ResultadoPatchAcesso resultado = aplicarPatchAcessoJson(dados, tamanho, erro);
+  if (resultado == PATCH_INVALIDO)
+    snprintf(statusListaDeAcesso, sizeof(statusListaDeAcesso), "invalido: %s", erro);
+  else
+    snprintf(statusListaDeAcesso, sizeof(statusListaDeAcesso), "%s", nomeResultadoPatchAcesso(resultado));
+  REGISTRAR_INFO("[MQTT] Lista de acesso v%lu: patch %s", (unsigned long)versaoListaDeAcesso(), statusListaDeAcesso);
+}
+
+// --- Copia das digitais: tarefa de acesso ---
+// Um modelo por chamada (~0,1 s de serial a 57600 baud), so com o sensor livre: um dedo
+// no botao espera no maximo a transferencia de um modelo. Os pedidos de exportacao tem
+// prioridade, depois a importacao; a exportacao para enquanto a fila de saida esta cheia.
+void passoModelos()
+{
+  static PedacoModelo pedaco; // 522 bytes: fora da pilha
+  static uint8_t mapa[MAX_MODELOS_TRANSFERENCIA / 8];
+  static uint16_t posicoes = 0;
+  static uint32_t exportacao = 0; // Transferencia em andamento (0: nenhuma)
+  static uint16_t totalExportacao = 0;
+  static uint16_t proximoExportar = 0;
+
+  if (sensorDigital.isVerificationPending())
+    return;
+
+  PedidoExportacao pedido;
+  if (filaPedidosExportacao.receber(pedido))
+  {
+    StatusModelos status = {MODELOS_EXPORTACAO, MODELOS_INICIADA, 0, pedido.transferencia, pedido.inicio, 0, 0};
+    uint8_t p = lerMapaDigitais(mapa, posicoes);
+    if (particaoQuente.ativa() && posicoes > particaoQuente.inicio())
+      posicoes = particaoQuente.inicio(); // As copias da particao quente nao saem
+    exportacao = p == FINGERPRINT_OK ? pedido.transferencia : 0;
+    totalExportacao = p == FINGERPRINT_OK ? contarPosicoes(mapa, posicoes) : 0;
+    proximoExportar = pedido.inicio;
+    if (p != FINGERPRINT_OK)
+    {
+      status.situacao = MODELOS_ERRO_SENSOR;
+      status.detalhe = p;
+    }
+    status.total = totalExportacao;
+    filaStatusModelos.enviar(status);
   }
+  else if (filaImportacao.receber(pedaco))
+  {
+    uint8_t p = particaoQuente.reservada(pedaco.slot) ? FINGERPRINT_BADLOCATION
+                                                      : sensorDigital.writeTemplate(pedaco.slot, pedaco.modelo);
+    StatusModelos status = {MODELOS_IMPORTACAO, p == FINGERPRINT_OK ? MODELOS_GRAVADO : MODELOS_ERRO_SENSOR, p,
+                            pedaco.transferencia, pedaco.indice, pedaco.slot, pedaco.total};
+    filaStatusModelos.enviar(status);
+    return;
+  }
+
+  if (!exportacao || filaExportacao.tamanho() >= filaExportacao.capacidade())
+    return;
+  StatusModelos status = {MODELOS_EXPORTACAO, MODELOS_CONCLUIDA, 0, exportacao, proximoExportar, 0, totalExportacao};
+  if (proximoExportar < totalExportacao)
+  {
+    pedaco.transferencia = exportacao;
+    pedaco.indice = proximoExportar;
+    pedaco.total = totalExportacao;
+    pedaco.slot = posicaoDoIndice(mapa, posicoes, proximoExportar);
+    uint8_t p = sensorDigital.readTemplate(pedaco.slot, pedaco.modelo);
+    if (p == FINGERPRINT_OK)
+    {
+      filaExportacao.enviar(pedaco);
+      if (++proximoExportar < totalExportacao)
+        return;
+    }
+    else
+    {
+      status.situacao = MODELOS_ERRO_SENSOR;
+      status.detalhe = p;
+      status.slot = pedaco.slot;
+    }
+  }
+  exportacao = 0;
+  filaStatusModelos.enviar(status);
 }
 
-void mqttConnect()
+// Mapa das posicoes ocupadas do sensor, pagina por pagina (0 a capacidade).
+uint8_t lerMapaDigitais(uint8_t *mapa, uint16_t &posicoes)
 {
-  while (!client.connected())
+  uint16_t capacidade = sensorDigital.capacity();
+  posicoes = capacidade < MAX_MODELOS_TRANSFERENCIA ? capacidade + 1 : MAX_MODELOS_TRANSFERENCIA;
+  for (uint8_t pagina = 0; pagina * 256 < posicoes; pagina++)
   {
-    Serial.println("Conectando ao MQTT...");
+    uint8_t p = sensorDigital.readIndexTable(pagina, mapa + pagina * 32);
+    if (p != FINGERPRINT_OK)
+      return p;
+  }
+  return FINGERPRINT_OK;
+}
 
-    if (client.connect(mqtt_id))
+// --- Copia das digitais: tarefa de rede ---
+// Publica os pedacos exportados e as respostas. Um pedaco que nao sai (queda do broker
+// no meio da publicacao) se perde: quem monta o arquivo pede de novo a partir do indice
+// que falta. O progresso da importacao tambem e republicado a cada conexao, para quem
+// envia saber de onde continuar.
+void enviarModelos(const char *topicoArquivo, const char *topicoStatus)
+{
+  static PedacoModelo pedaco;
+  static bool estavaConectado = false;
+  bool conectado = mqttConectado();
+  if (conectado && !estavaConectado && progressoImportacao.ativa() && !progressoImportacao.completa())
+  {
+    StatusModelos status = {MODELOS_IMPORTACAO, MODELOS_CONEXAO, 0, progressoImportacao.transferencia(),
+                            progressoImportacao.proximo(), 0, progressoImportacao.total()};
+    respostasModelos.enviar(status);
+  }
+  estavaConectado = conectado;
+
+  // Resultados da tarefa de acesso: a importacao so avanca com o modelo gravado
+  StatusModelos status;
+  while (filaStatusModelos.receber(status))
+  {
+    if (status.operacao == MODELOS_IMPORTACAO && status.situacao == MODELOS_GRAVADO &&
+        status.transferencia == progressoImportacao.transferencia())
     {
-      Serial.println("Conectado com sucesso");
+      progressoImportacao.marcar(status.indice);
+      if (!gravarProgressoImportacao())
+        REGISTRAR_ERRO("[NVS] Falha ao gravar o progresso da importacao de digitais.");
+      if (progressoImportacao.completa())
+        status.situacao = MODELOS_CONCLUIDA;
     }
+    respostasModelos.enviar(status);
+  }
 
-    else
+  if (!conectado)
+    return;
+  while (filaExportacao.receber(pedaco))
+  {
+    size_t tamanho = codificarPedaco(pedaco, pedacoMqtt, sizeof(pedacoMqtt));
+    halMqttPublicar(topicoArquivo, pedacoMqtt, tamanho);
+  }
+  while (respostasModelos.receber(status))
+    publicarStatusModelos(topicoStatus, status);
+}
+
+void publicarStatusModelos(const char *topico, const StatusModelos &status)
+{
+  const ProgressoTransferencia *progresso = status.operacao == MODELOS_IMPORTACAO ? &progressoImportacao : nullptr;
+  if (serializarStatusModelos(mensagemModelos, sizeof(mensagemModelos), status, progresso, halRelogioAgora()))
+    halMqttPublicar(topico, mensagemModelos);
+}
+
+// Pedido de exportacao, dentro de atualizarMqtt(): {"transferencia": id, "inicio": indice}.
+// "inicio" (padrao 0) retoma uma copia interrompida sem repetir o que ja chegou.
+void receberPedidoExportacao(const uint8_t *dados, unsigned int tamanho)
+{
+  JsonDocument documento;
+  int32_t campos[2] = {0, 0};
+  const char *NOMES[2] = {"transferencia", "inicio"};
+  bool valido = !deserializeJson(documento, dados, tamanho) && documento.is<JsonObject>();
+  for (JsonPair par : documento.as<JsonObject>())
+  {
+    bool conhecido = false;
+    for (uint8_t i = 0; i < 2; i++)
     {
-      Serial.print("falha, rc=");
-      Serial.println(client.state());
-      Serial.println("tentando novamente em 5 segundos");
-      delay(5000);
+      if (strcmp(par.key().c_str(), NOMES[i]) == 0 && par.value().is<int32_t>())
+      {
+        campos[i] = par.value().as<int32_t>();
+        conhecido = true;
+      }
+    }
+    valido = valido && conhecido;
+  }
+  valido = valido && campos[0] > 0 && campos[1] >= 0 && campos[1] < MAX_MODELOS_TRANSFERENCIA;
+
+  StatusModelos status = {MODELOS_EXPORTACAO, MODELOS_RECUSADO, 0, (uint32_t)campos[0],
+                          (uint16_t)campos[1], 0, 0};
+  if (!valido)
+    respostasModelos.enviar(status);
+  else if (!filaPedidosExportacao.enviar({(uint32_t)campos[0], (uint16_t)campos[1]}))
+  {
+    status.situacao = MODELOS_OCUPADO;
+    respostasModelos.enviar(status);
+  }
+  REGISTRAR_INFO("[MQTT] Exportacao de digitais %ld a partir de %ld%s", (long)campos[0], (long)campos[1],
+                 valido ? "" : ": pedido invalido");
+}
+
+// Pedaco dos topicos de importacao, dentro de atualizarMqtt(). Recusado, repetido ou
+// com a fila cheia responde na hora; gravado, responde quando a tarefa de acesso
+// termina.
+void receberPedacoModelo(const uint8_t *dados, unsigned int tamanho)
+{
+  static PedacoModelo pedaco;
+  ResultadoPedaco resultado = decodificarPedaco(dados, tamanho, pedaco);
+  StatusModelos status = {MODELOS_IMPORTACAO, MODELOS_RECUSADO, (uint8_t)resultado, progressoImportacao.transferencia(),
+                          0, 0, progressoImportacao.total()};
+  if (resultado == PEDACO_OK)
+  {
+    // Outra transferencia recomeca o progresso (uma por vez)
+    if (pedaco.transferencia != progressoImportacao.transferencia() || pedaco.total != progressoImportacao.total())
+    {
+      progressoImportacao.comecar(pedaco.transferencia, pedaco.total);
+      gravarProgressoImportacao();
+    }
+    status = {MODELOS_IMPORTACAO, MODELOS_REPETIDO, 0, pedaco.transferencia, pedaco.indice, pedaco.slot, pedaco.total};
+    if (!progressoImportacao.recebido(pedaco.indice))
+    {
+      if (filaImportacao.enviar(pedaco))
+        return;
+      status.situacao = MODELOS_OCUPADO;
+    }
+  }
+  respostasModelos.enviar(status);
+}
+
+bool carregarProgressoImportacao()
+{
+  static RegistroProgressoImportacao registro; // ~140 bytes: fora da pilha
+  if (!halNvsLer("modelos", &registro, sizeof(registro)) || registro.versaoRegistro != VERSAO_PROGRESSO_NVS)
+    return false;
+  progressoImportacao = registro.progresso;
+  return progressoImportacao.ativa();
+}
+
+bool gravarProgressoImportacao()
+{
+  static RegistroProgressoImportacao registro;
+  registro.versaoRegistro = VERSAO_PROGRESSO_NVS;
+  registro.progresso = progressoImportacao;
+  return halNvsGravar("modelos", &registro, sizeof(registro));
+}
+
+// ====================================================================================
+// PARTICAO QUENTE DAS DIGITAIS
+// ====================================================================================
+
+// Reserva as `tamanho` ultimas posicoes e recupera as copias da NVS. Sem registro (a
+// primeira vez com esta particao), as posicoes reservadas precisam estar livres: um
+// modelo cadastrado nelas ficaria de fora da busca. Senao a particao fica desligada.
+bool iniciarParticaoQuente(uint8_t tamanho)
+{
+  static uint8_t mapa[MAX_MODELOS_TRANSFERENCIA / 8];
+  static RegistroParticaoQuente registro;
+  uint16_t capacidade = sensorDigital.capacity();
+  sensorDigital.useHotPartition(nullptr);
+  if (!particaoQuente.configurar(capacidade, tamanho) || !particaoQuente.ativa())
+  {
+    REGISTRAR_AVISO("Particao quente nao cabe na biblioteca do sensor: desligada.");
+    return false;
+  }
+
+  if (halNvsLer("quente", &registro, sizeof(registro)) && registro.versaoRegistro == VERSAO_PARTICAO_NVS &&
+      registro.tamanho == tamanho && registro.capacidade == capacidade)
+  {
+    particaoQuente.restaurar(registro.copias);
+  }
+  else
+  {
+    uint16_t posicoes;
+    uint8_t p = lerMapaDigitais(mapa, posicoes);
+    uint16_t fim = particaoQuente.inicio() + tamanho;
+    bool livres = p == FINGERPRINT_OK && fim <= posicoes;
+    for (uint16_t posicao = particaoQuente.inicio(); livres && posicao < fim; posicao++)
+      livres = !((mapa[posicao / 8] >> (posicao % 8)) & 1);
+    if (!livres || !gravarParticaoQuente())
+    {
+      REGISTRAR_AVISO("Posicoes da particao quente ocupadas ou sem NVS: particao desligada.");
+      particaoQuente.configurar(capacidade, 0);
+      return false;
     }
   }
-}
\ No newline at end of file
+  sensorDigital.onTemplateChange(esquecerCopiaDigital);
+  sensorDigital.useHotPartition(&particaoQuente);
+  return true;
+}
+
+// Uma copia por chamada (~0,1 s no sensor), so com o sensor livre e sem aperto pendente.
+void passoParticaoQuente()
+{
+  uint16_t original, destino;
+  if (!particaoQuente.ativa() || sensorDigital.isVerificationPending() || apertoPendente ||
+      !particaoQuente.proximaPromocao(original, destino))
+    return;
+
+  particaoQuente.invalidar(destino);
+  if (!gravarParticaoQuente())
+    return;
+  if (sensorDigital.copyTemplate(original, destino) == FINGERPRINT_OK)
+    particaoQuente.confirmar(destino, original);
+  else
+    particaoQuente.esquecer(original); // Posicao vazia ou erro: sai da contagem
+  gravarParticaoQuente();
+}
+
+// Chamada pelo sensor antes de um modelo mudar: a copia dele deixa de valer antes. Sem
+// gravar na NVS o modelo nao muda, senao a copia antiga voltaria a valer no reinicio.
+bool esquecerCopiaDigital(uint16_t slot)
+{
+  return !particaoQuente.esquecer(slot) || gravarParticaoQuente();
+}
+
+bool gravarParticaoQuente()
+{
+  static RegistroParticaoQuente registro;
+  registro.versaoRegistro = VERSAO_PARTICAO_NVS;
+  registro.tamanho = particaoQuente.tamanho();
+  registro.capacidade = sensorDigital.capacity();
+  memcpy(registro.copias, particaoQuente.copias(), sizeof(registro.copias));
+  return halNvsGravar("quente", &registro, sizeof(registro));
+}
+
+// Bits ALARME_* da ultima leitura recebida pela tarefa de rede.
+uint8_t alarmesAtuais()
+{
+  return (ultimaLeitura.alarmePressao ? ALARME_PRESSAO : 0) |
+         (ultimaLeitura.alarmeMovimento ? ALARME_MOVIMENTO : 0) |
+         (ultimaLeitura.alarmeLuz ? ALARME_LUZ : 0) |
+         (ultimaLeitura.alarme ? ALARME_FUSAO : 0);
+}
+
+// Completa o cabecalho comum do quadro: no e alarmes atuais.
+void completarQuadro(QuadroSafezone &quadro)
+{
+  quadro.no = mqtt_no;
+  quadro.alarmes = alarmesAtuais();
+}
+
+// Grava o evento na caixa de saida. Sem a particao, tenta publicar na hora.
+bool guardarEvento(QuadroSafezone &quadro)
+{
+  completarQuadro(quadro);
+  size_t tamanho = codificarQuadro(quadro, quadroMqtt, sizeof(quadroMqtt));
+  if (!tamanho)
+    return false;
+  if (caixaDeSaida.anexar(quadroMqtt, tamanho))
+    return true;
+  return publicarRegistro(0, quadroMqtt, tamanho);
+}
+
+// Publica um registro da caixa de saida no formato configurado, com a sua sequencia.
+bool publicarRegistro(uint32_t sequencia, const uint8_t *dados, uint16_t tamanho)
+{
+  QuadroSafezone quadro;
+  if (decodificarQuadro(dados, tamanho, quadro) != QUADRO_OK)
+    return true; // Registro ilegivel: descartado para nao travar a fila
+
+  quadro.sequencia = sequencia;
+  if (SAFEZONE_MENSAGENS_BINARIAS)
+  {
+    size_t n = codificarQuadro(quadro, quadroMqtt, sizeof(quadroMqtt));
+    return halMqttPublicar(mqtt_topic_pub, quadroMqtt, n);
+  }
+
+  if (quadro.tipo == QUADRO_ACESSO)
+  {
+    serializarJson<LayoutEventoAcesso>(mensagemMqtt, quadro.liberado, quadro.timestamp, sequencia, quadro.dedo,
+                                       quadro.usuario, nomeDecisaoAcesso((DecisaoAcesso)quadro.decisao));
+  }
+  else
+  {
+    serializarJson<LayoutLeituraSensores>(mensagemMqtt, (bool)(quadro.alarmes & ALARME_LUZ),
+                                          (bool)(quadro.alarmes & ALARME_MOVIMENTO),
+                                          (bool)(quadro.alarmes & ALARME_PRESSAO),
+                                          Telemetria::nomeMotivo((MotivoTelemetria)quadro.motivo),
+                                          quadro.timestamp, sequencia, (bool)(quadro.alarmes & ALARME_FUSAO),
+                                          nomeCausaAlarme(quadro.causaAlarme));
+  }
+  return halMqttPublicar(mqtt_topic_pub, mensagemMqtt);
+}
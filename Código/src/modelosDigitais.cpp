@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <string.h>
+#include "modelosDigitais.h"
+
+// ------------------- ESCRITA E LEITURA LITTLE-ENDIAN -------------------
+
+static uint8_t *escrever16(uint8_t *p, uint16_t valor)
+{
+    p[0] = valor & 0xFF;
+    p[1] = valor >> 8;
+    return p + 2;
+}
+
+static uint8_t *escrever32(uint8_t *p, uint32_t valor)
+{
+    p[0] = valor & 0xFF;
+    p[1] = (valor >> 8) & 0xFF;
+    p[2] = (valor >> 16) & 0xFF;
+    p[3] = valor >> 24;
+    return p + 4;
+}
+
+static uint16_t ler16(const uint8_t *p)
+{
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t ler32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ------------------- CRC-32 -------------------
+// Tabela de 16 entradas (um nibble por vez): 64 bytes de flash e um quarto dos passos da
+// versao bit a bit. Tambem protege os registros da caixa de saida.
+
+static const uint32_t TABELA_CRC[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t crc32Pedaco(uint32_t crc, const uint8_t *dados, size_t tamanho)
+{
+    crc = ~crc;
+    while (tamanho--)
+    {
+        crc ^= *dados++;
+        crc = (crc >> 4) ^ TABELA_CRC[crc & 0x0F];
+        crc = (crc >> 4) ^ TABELA_CRC[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+// ------------------- PEDACOS -------------------
+
+size_t codificarPedaco(const PedacoModelo &pedaco, uint8_t *buffer, size_t capacidade)
+{
+    if (capacidade < TAMANHO_PEDACO)
+        return 0;
+    uint8_t *p = buffer;
+    *p++ = PEDACO_MARCA;
+    *p++ = PEDACO_VERSAO;
+    p = escrever32(p, pedaco.transferencia);
+    p = escrever16(p, pedaco.indice);
+    p = escrever16(p, pedaco.total);
+    p = escrever16(p, pedaco.slot);
+    memcpy(p, pedaco.modelo, TAMANHO_MODELO);
+    p += TAMANHO_MODELO;
+    escrever32(p, crc32Pedaco(0, buffer, p - buffer));
+    return TAMANHO_PEDACO;
+}
+
+ResultadoPedaco decodificarPedaco(const uint8_t *dados, size_t tamanho, PedacoModelo &pedaco)
+{
+    // Ao contrario dos quadros, o pedaco tem tamanho fixo: bytes a mais sao um erro
+    if (tamanho != TAMANHO_PEDACO)
+        return PEDACO_CURTO;
+    if (dados[0] != PEDACO_MARCA)
+        return PEDACO_MARCA_ERRADA;
+    if (dados[1] != PEDACO_VERSAO)
+        return PEDACO_VERSAO_DESCONHECIDA;
+    if (crc32Pedaco(0, dados, TAMANHO_PEDACO - 4) != ler32(dados + TAMANHO_PEDACO - 4))
+        return PEDACO_CRC_ERRADO;
+
+    pedaco.transferencia = ler32(dados + 2);
+    pedaco.indice = ler16(dados + 6);
+    pedaco.total = ler16(dados + 8);
+    pedaco.slot = ler16(dados + 10);
+    if (pedaco.total > MAX_MODELOS_TRANSFERENCIA || pedaco.indice >= pedaco.total)
+        return PEDACO_FORA_DO_LIMITE;
+    memcpy(pedaco.modelo, dados + 12, TAMANHO_MODELO);
+    return PEDACO_OK;
+}
+
+const char *descreverResultadoPedaco(ResultadoPedaco resultado)
+{
+    switch (resultado)
+    {
+    case PEDACO_OK:
+        return "ok";
+    case PEDACO_CURTO:
+        return "tamanho errado";
+    case PEDACO_MARCA_ERRADA:
+        return "marca errada";
+    case PEDACO_VERSAO_DESCONHECIDA:
+        return "versao desconhecida";
+    case PEDACO_CRC_ERRADO:
+        return "crc errado";
+    case PEDACO_FORA_DO_LIMITE:
+        return "indice fora do limite";
+    }
+    return "?";
+}
+
+// ------------------- PROGRESSO -------------------
+
+void ProgressoTransferencia::comecar(uint32_t transferencia, uint16_t total)
+{
+    if (transferencia == _transferencia && total == _total)
+        return;
+    zerar();
+    _transferencia = transferencia;
+    _total = total <= MAX_MODELOS_TRANSFERENCIA ? total : MAX_MODELOS_TRANSFERENCIA;
+}
+
+void ProgressoTransferencia::zerar()
+{
+    _transferencia = 0;
+    _total = 0;
+    _recebidos = 0;
+    memset(_mapa, 0, sizeof(_mapa));
+}
+
+bool ProgressoTransferencia::recebido(uint16_t indice) const
+{
+    return indice < _total && (_mapa[indice / 8] & (1 << (indice % 8)));
+}
+
+void ProgressoTransferencia::marcar(uint16_t indice)
+{
+    if (indice >= _total || recebido(indice))
+        return;
+    _mapa[indice / 8] |= 1 << (indice % 8);
+    _recebidos++;
+}
+
+uint16_t ProgressoTransferencia::proximo() const
+{
+    // Pula bytes completos: no meio de uma transferencia grande quase todos estao cheios
+    for (uint16_t byte = 0; byte * 8 < _total; byte++)
+    {
+        if (_mapa[byte] == 0xFF)
+            continue;
+        for (uint16_t indice = byte * 8; indice < _total && indice < byte * 8 + 8; indice++)
+            if (!recebido(indice))
+                return indice;
+    }
+    return _total;
+}
+
+// ------------------- MAPA DE POSICOES -------------------
+
+uint16_t contarPosicoes(const uint8_t *mapa, uint16_t posicoes)
+{
+    uint16_t total = 0;
+    for (uint16_t posicao = 0; posicao < posicoes; posicao++)
+        total += (mapa[posicao / 8] >> (posicao % 8)) & 1;
+    return total;
+}
+
+uint16_t posicaoDoIndice(const uint8_t *mapa, uint16_t posicoes, uint16_t indice)
+{
+    for (uint16_t posicao = 0; posicao < posicoes; posicao++)
+        if (((mapa[posicao / 8] >> (posicao % 8)) & 1) && indice-- == 0)
+            return posicao;
+    return posicoes;
+}
+
+// ------------------- STATUS -------------------
+
+static const char *NOMES_OPERACOES[] = {"exportacao", "importacao"};
+
+static const char *NOMES_SITUACOES[NUM_SITUACOES_MODELOS] = {
+    "gravado", "repetido", "recusado", "ocupado", "erro do sensor", "iniciada", "concluida", "conexao",
+};
+
+const char *nomeSituacaoModelos(SituacaoModelos situacao)
+{
+    return situacao < NUM_SITUACOES_MODELOS ? NOMES_SITUACOES[situacao] : "?";
+}
+
+size_t serializarStatusModelos(char *buffer, size_t capacidade, const StatusModelos &status,
+                               const ProgressoTransferencia *progresso, long timestamp)
+{
+    const char *detalhe = "";
+    char codigo[8];
+    if (status.situacao == MODELOS_RECUSADO)
+        detalhe = status.operacao == MODELOS_IMPORTACAO ? descreverResultadoPedaco((ResultadoPedaco)status.detalhe)
+                                                        : "pedido invalido";
+    else if (status.situacao == MODELOS_ERRO_SENSOR)
+    {
+        snprintf(codigo, sizeof(codigo), "0x%02X", status.detalhe);
+        detalhe = codigo;
+    }
+
+    int n = snprintf(buffer, capacidade,
+                     "{\"operacao\":\"%s\",\"transferencia\":%lu,\"status\":\"%s\",\"detalhe\":\"%s\","
+                     "\"indice\":%u,\"slot\":%u,\"total\":%u",
+                     NOMES_OPERACOES[status.operacao == MODELOS_IMPORTACAO], (unsigned long)status.transferencia,
+                     nomeSituacaoModelos(status.situacao), detalhe, (unsigned)status.indice, (unsigned)status.slot,
+                     (unsigned)status.total);
+    if (n < 0 || (size_t)n >= capacidade)
+        return 0;
+    size_t usado = n;
+
+    if (progresso)
+        n = snprintf(buffer + usado, capacidade - usado, ",\"recebidos\":%u,\"proximo\":%u,\"timestamp\":%ld}",
+                     (unsigned)progresso->recebidos(), (unsigned)progresso->proximo(), timestamp);
+    else
+        n = snprintf(buffer + usado, capacidade - usado, ",\"timestamp\":%ld}", timestamp);
+    if (n < 0 || usado + n >= capacidade)
+        return 0;
+    return usado + n;
+}
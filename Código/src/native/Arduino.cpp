@@ -0,0 +1,433 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include <chrono>
+#include <map>
+#include <thread>
+#include "simulador.h"
+
+// ====================================================================================
+// RELOGIO SIMULADO
+// ====================================================================================
+
+static std::recursive_mutex travaEstado;
+static std::chrono::steady_clock::time_point inicioHost = std::chrono::steady_clock::now();
+static uint64_t deslocamentoUs = 0;
+static double fatorTempoReal = 0; // 0: relogio que salta (uma unica thread)
+static bool hostCongelado = false;  // Relogio = deslocamentoUs
+static std::multimap<uint64_t, std::function<void()>> eventos;
+static bool processandoEventos = false;
+
+std::recursive_mutex &sim::estado()
+{
+    return travaEstado;
+}
+
+static void processarEventos(uint64_t agora)
+{
+    if (processandoEventos)
+        return;
+    processandoEventos = true;
+    while (!eventos.empty() && eventos.begin()->first <= agora)
+    {
+        std::function<void()> acao = eventos.begin()->second;
+        eventos.erase(eventos.begin());
+        acao();
+    }
+    processandoEventos = false;
+}
+
+static uint64_t lerRelogioNs()
+{
+    if (hostCongelado)
+        return deslocamentoUs * 1000;
+    uint64_t host = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - inicioHost)
+                        .count();
+    if (fatorTempoReal > 0)
+        host = (uint64_t)(host * fatorTempoReal);
+    return host + deslocamentoUs * 1000;
+}
+
+static uint64_t lerRelogio()
+{
+    return lerRelogioNs() / 1000;
+}
+
+uint64_t sim::agoraUs()
+{
+    sim::Trava trava;
+    uint64_t agora = lerRelogio();
+    processarEventos(agora);
+    return agora;
+}
+
+uint64_t sim::agoraNs()
+{
+    sim::Trava trava;
+    return lerRelogioNs();
+}
+
+void sim::avancarUs(uint64_t us)
+{
+    double fator;
+    {
+        sim::Trava trava;
+        fator = fatorTempoReal;
+        if (fator <= 0)
+            deslocamentoUs += us;
+    }
+    if (fator > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)(us / fator)));
+    sim::agoraUs();
+}
+
+void sim::agendar(uint64_t instanteUs, std::function<void()> acao)
+{
+    sim::Trava trava;
+    eventos.emplace(instanteUs, acao);
+}
+
+void sim::reiniciar()
+{
+    sim::Trava trava;
+    eventos.clear();
+    deslocamentoUs = 0;
+    fatorTempoReal = 0;
+    hostCongelado = false;
+    inicioHost = std::chrono::steady_clock::now();
+}
+
+void sim::tempoReal(double fator)
+{
+    // O relogio continua de onde estava; so muda o ritmo.
+    sim::Trava trava;
+    uint64_t agora = lerRelogio();
+    inicioHost = std::chrono::steady_clock::now();
+    deslocamentoUs = agora;
+    fatorTempoReal = fator;
+}
+
+void sim::congelarHost(bool congelar)
+{
+    // Como em tempoReal(): o relogio continua de onde estava
+    sim::Trava trava;
+    uint64_t agora = lerRelogio();
+    inicioHost = std::chrono::steady_clock::now();
+    deslocamentoUs = agora;
+    hostCongelado = congelar;
+}
+
+unsigned long millis() { return (unsigned long)(sim::agoraUs() / 1000); }
+unsigned long micros() { return (unsigned long)sim::agoraUs(); }
+void delay(uint32_t ms) { sim::avancarUs((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { sim::avancarUs(us); }
+void yield() { sim::avancarUs(100); } // Uma fatia do escalonador do FreeRTOS
+
+// ====================================================================================
+// GPIO E ADC
+// ====================================================================================
+
+static const int NUM_PINOS = 40;
+static uint8_t modoPino[NUM_PINOS];
+static uint8_t nivelEntrada[NUM_PINOS];
+static uint8_t nivelSaidaPino[NUM_PINOS];
+static uint16_t valorAnalogico[NUM_PINOS];
+static std::function<void(uint64_t, uint8_t, uint8_t)> observadorPinos;
+
+void pinMode(uint8_t pino, uint8_t modo)
+{
+    sim::Trava trava;
+    if (pino >= NUM_PINOS)
+        return;
+    modoPino[pino] = modo;
+    if (modo == INPUT_PULLUP)
+        nivelEntrada[pino] = HIGH;
+}
+
+int digitalRead(uint8_t pino)
+{
+    sim::Trava trava;
+    if (pino >= NUM_PINOS)
+        return LOW;
+    return modoPino[pino] == OUTPUT ? nivelSaidaPino[pino] : nivelEntrada[pino];
+}
+
+void digitalWrite(uint8_t pino, uint8_t valor)
+{
+    sim::Trava trava;
+    if (pino >= NUM_PINOS)
+        return;
+    nivelSaidaPino[pino] = valor ? HIGH : LOW;
+    if (observadorPinos)
+        observadorPinos(sim::agoraUs(), pino, nivelSaidaPino[pino]);
+}
+
+uint16_t analogRead(uint8_t pino)
+{
+    sim::avancarUs(10); // Conversao do ADC do ESP32 (~10 us)
+    sim::Trava trava;
+    return pino < NUM_PINOS ? valorAnalogico[pino] : 0;
+}
+
+uint16_t sim::nivelAnalogico(uint8_t pino)
+{
+    sim::Trava trava;
+    return pino < NUM_PINOS ? valorAnalogico[pino] : 0;
+}
+
+void sim::definirEntrada(uint8_t pino, int nivel)
+{
+    sim::Trava trava;
+    if (pino < NUM_PINOS)
+        nivelEntrada[pino] = nivel ? HIGH : LOW;
+}
+
+int sim::nivelSaida(uint8_t pino)
+{
+    sim::Trava trava;
+    return pino < NUM_PINOS ? nivelSaidaPino[pino] : LOW;
+}
+
+void sim::definirAnalogico(uint8_t pino, uint16_t valor)
+{
+    sim::Trava trava;
+    if (pino < NUM_PINOS)
+        valorAnalogico[pino] = valor;
+}
+
+void sim::aoEscreverPino(std::function<void(uint64_t, uint8_t, uint8_t)> observador)
+{
+    sim::Trava trava;
+    observadorPinos = observador;
+}
+
+// ====================================================================================
+// PRINT E STREAM
+// ====================================================================================
+
+size_t Print::write(const uint8_t *buffer, size_t tamanho)
+{
+    size_t n = 0;
+    while (tamanho--)
+        n += write(*buffer++);
+    return n;
+}
+
+size_t Print::printf(const char *formato, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, formato);
+    int n = vsnprintf(buffer, sizeof(buffer), formato, args);
+    va_end(args);
+    if (n < 0)
+        return 0;
+    return write((const uint8_t *)buffer, (size_t)n < sizeof(buffer) ? n : sizeof(buffer) - 1);
+}
+
+size_t Print::print(long n, int base)
+{
+    char buffer[24];
+    if (base == HEX)
+        snprintf(buffer, sizeof(buffer), "%lX", n);
+    else
+        snprintf(buffer, sizeof(buffer), "%ld", n);
+    return write(buffer);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%lu", n);
+    return write(buffer);
+}
+
+size_t Print::print(double n, int casas)
+{
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", casas, n);
+    return write(buffer);
+}
+
+int Stream::timedRead()
+{
+    unsigned long inicio = millis();
+    do
+    {
+        int c = read();
+        if (c >= 0)
+            return c;
+        yield();
+    } while (millis() - inicio < _timeout);
+    return -1;
+}
+
+int Stream::timedPeek()
+{
+    unsigned long inicio = millis();
+    do
+    {
+        int c = peek();
+        if (c >= 0)
+            return c;
+        yield();
+    } while (millis() - inicio < _timeout);
+    return -1;
+}
+
+long Stream::parseInt()
+{
+    int c = timedPeek();
+    while (c >= 0 && c != '-' && (c < '0' || c > '9'))
+    {
+        read();
+        c = timedPeek();
+    }
+
+    bool negativo = false;
+    long valor = 0;
+    if (c == '-')
+    {
+        negativo = true;
+        read();
+        c = timedPeek();
+    }
+    while (c >= '0' && c <= '9')
+    {
+        valor = valor * 10 + (c - '0');
+        read();
+        c = timedPeek();
+    }
+    return negativo ? -valor : valor;
+}
+
+String Stream::readStringUntil(char terminador)
+{
+    String texto;
+    int c = timedRead();
+    while (c >= 0 && c != terminador)
+    {
+        texto += (char)c;
+        c = timedRead();
+    }
+    return texto;
+}
+
+// ====================================================================================
+// PORTAS SERIAIS
+// ====================================================================================
+
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin)
+{
+    (void)config;
+    (void)rxPin;
+    (void)txPin;
+    _baud = baud;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    // Modela a FIFO de transmissao do UART: escrever e instantaneo ate a FIFO encher;
+    // a partir dai cada byte espera o anterior sair pela linha na baud configurada.
+    uint64_t espera = 0;
+    uint32_t tempoByte = tempoByteUs();
+    if (tempoByte)
+    {
+        sim::Trava trava;
+        uint64_t agora = sim::agoraUs();
+        if (_txLivreEm < agora)
+            _txLivreEm = agora;
+        uint64_t limiteFifo = (uint64_t)tempoByte * FIFO_TX;
+        if (_txLivreEm - agora > limiteFifo)
+            espera = _txLivreEm - agora - limiteFifo;
+        _txLivreEm += tempoByte;
+    }
+    if (espera)
+        sim::avancarUs(espera);
+
+    sim::Trava trava;
+    _bytesTx++;
+    if (_eco)
+        fputc(c, stdout);
+    if (_dispositivo)
+        _dispositivo->receber(c);
+    return 1;
+}
+
+void HardwareSerial::injetar(const uint8_t *dados, size_t tamanho, uint64_t disponivelEmUs)
+{
+    sim::Trava trava;
+    for (size_t i = 0; i < tamanho && _rxQuantidade < CAPACIDADE_RX; i++)
+    {
+        size_t fim = (_rxInicio + _rxQuantidade) % CAPACIDADE_RX;
+        _rx[fim] = dados[i];
+        _rxDisponivelEm[fim] = disponivelEmUs;
+        _rxQuantidade++;
+    }
+}
+
+int HardwareSerial::available()
+{
+    sim::Trava trava;
+    uint64_t agora = sim::agoraUs();
+    int n = 0;
+    for (size_t i = 0; i < _rxQuantidade; i++)
+    {
+        if (_rxDisponivelEm[(_rxInicio + i) % CAPACIDADE_RX] > agora)
+            break;
+        n++;
+    }
+    return n;
+}
+
+int HardwareSerial::peek()
+{
+    sim::Trava trava;
+    if (_rxQuantidade == 0 || _rxDisponivelEm[_rxInicio] > sim::agoraUs())
+        return -1;
+    return _rx[_rxInicio];
+}
+
+int HardwareSerial::read()
+{
+    sim::Trava trava;
+    int c = peek();
+    if (c < 0)
+        return -1;
+    _rxInicio = (_rxInicio + 1) % CAPACIDADE_RX;
+    _rxQuantidade--;
+    return c;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    uint32_t tempoByte = tempoByteUs();
+    if (!tempoByte)
+        return FIFO_TX;
+    sim::Trava trava;
+    uint64_t agora = sim::agoraUs();
+    uint64_t naFifo = _txLivreEm > agora ? (_txLivreEm - agora + tempoByte - 1) / tempoByte : 0;
+    return naFifo < FIFO_TX ? (int)(FIFO_TX - naFifo) : 0;
+}
+
+void HardwareSerial::flush()
+{
+    uint64_t espera = 0;
+    {
+        sim::Trava trava;
+        uint64_t agora = sim::agoraUs();
+        if (_txLivreEm > agora)
+            espera = _txLivreEm - agora;
+    }
+    if (espera)
+        sim::avancarUs(espera);
+}
+
+void sim::ecoarConsole(bool ecoar)
+{
+    sim::Trava trava;
+    Serial.ecoarNoConsole(ecoar);
+}
@@ -0,0 +1,162 @@
+#ifndef ARDUINO_NATIVE_H
+#define ARDUINO_NATIVE_H
+
+// ====================================================================================
+// NUCLEO ARDUINO SIMULADO (BUILD NATIVO)
+// ====================================================================================
+// Substitui o <Arduino.h> do ESP32 no [env:native]. Implementa apenas o subconjunto
+// usado pelo firmware e pela biblioteca Adafruit_Fingerprint: relogio simulado,
+// GPIO/ADC, Print/Stream e as portas seriais.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef std::string String;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define SERIAL_8N1 0x800001c
+
+#define DEC 10
+#define HEX 16
+
+// --- Tempo (relogio simulado, ver simulador.h) ---
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// --- GPIO e ADC ---
+void pinMode(uint8_t pino, uint8_t modo);
+int digitalRead(uint8_t pino);
+void digitalWrite(uint8_t pino, uint8_t valor);
+uint16_t analogRead(uint8_t pino);
+
+// --- Saida formatada ---
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t tamanho);
+    size_t write(const char *texto) { return write((const uint8_t *)texto, strlen(texto)); }
+
+    size_t printf(const char *formato, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char *texto) { return write(texto); }
+    size_t print(const String &texto) { return write((const uint8_t *)texto.c_str(), texto.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int casas = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &valor) { return print(valor) + println(); }
+    template <typename T>
+    size_t println(const T &valor, int formato) { return print(valor, formato) + println(); }
+};
+
+// --- Entrada com timeout (Stream) ---
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    long parseInt();
+    String readStringUntil(char terminador);
+
+protected:
+    unsigned long _timeout = 1000;
+    int timedRead();
+    int timedPeek();
+};
+
+// --- Dispositivo ligado a uma porta serial simulada (ex.: modulo de digitais) ---
+class DispositivoSerial
+{
+public:
+    virtual ~DispositivoSerial() {}
+    // Chamado a cada byte que o firmware escreve na porta.
+    virtual void receber(uint8_t byte) = 0;
+};
+
+// --- Porta UART simulada ---
+class HardwareSerial : public Stream
+{
+public:
+    // constexpr: a porta existe antes dos construtores estaticos dos dispositivos simulados.
+    constexpr explicit HardwareSerial(int numero) : _numero(numero) {}
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    void end() { _baud = 0; }
+    operator bool() const { return true; }
+    unsigned long baudRate() const { return _baud; }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    // Bytes que cabem na FIFO de transmissao sem esperar pela linha.
+    int availableForWrite();
+
+    // Lado do simulador: conecta um dispositivo e injeta bytes recebidos.
+    void conectar(DispositivoSerial *dispositivo) { _dispositivo = dispositivo; }
+    void injetar(const uint8_t *dados, size_t tamanho, uint64_t disponivelEmUs = 0);
+    void injetar(const char *texto) { injetar((const uint8_t *)texto, strlen(texto)); }
+    void ecoarNoConsole(bool ecoar) { _eco = ecoar; }
+    unsigned long bytesTransmitidos() const { return _bytesTx; }
+
+    // Tempo de transmissao de um byte (start + 8 dados + stop) na baud atual.
+    uint32_t tempoByteUs() const { return _baud ? (uint32_t)(10000000UL / _baud) : 0; }
+    // Instante (us simulados) em que o ultimo byte escrito termina de sair pela linha.
+    uint64_t txLivreEmUs() const { return _txLivreEm; }
+
+private:
+    static const size_t CAPACIDADE_RX = 1024;
+    static const size_t FIFO_TX = 128;
+
+    int _numero;
+    unsigned long _baud = 0;
+    DispositivoSerial *_dispositivo = nullptr;
+    bool _eco = false;
+    unsigned long _bytesTx = 0;
+
+    uint8_t _rx[CAPACIDADE_RX] = {};
+    uint64_t _rxDisponivelEm[CAPACIDADE_RX] = {};
+    size_t _rxInicio = 0;
+    size_t _rxQuantidade = 0;
+
+    uint64_t _txLivreEm = 0; // Instante em que a FIFO de transmissao esvazia
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+void setup();
+void loop();
+
+#endif
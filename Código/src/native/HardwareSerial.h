@@ -0,0 +1,7 @@
+#ifndef HARDWARE_SERIAL_NATIVE_H
+#define HARDWARE_SERIAL_NATIVE_H
+
+// A porta UART simulada e declarada junto com o restante do nucleo Arduino nativo.
+#include <Arduino.h>
+
+#endif
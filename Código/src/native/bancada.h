@@ -0,0 +1,134 @@
+#ifndef BANCADA_H
+#define BANCADA_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// ====================================================================================
+// BANCADA DE MEDICAO (BUILD NATIVO)
+// ====================================================================================
+// Utilitarios compartilhados pelos benchmarks: opcoes de linha de comando, relogio do
+// host e estatisticas de latencia. Cada benchmark e uma funcao registrada em main.cpp.
+
+typedef int (*Benchmark)(int argc, char **argv);
+
+int benchLoop(int argc, char **argv);
+int benchDigitais(int argc, char **argv);
+int benchReconexao(int argc, char **argv);
+int benchWiFi(int argc, char **argv);
+int benchTarefas(int argc, char **argv);
+int benchTelemetria(int argc, char **argv);
+int benchJson(int argc, char **argv);
+int benchBinario(int argc, char **argv);
+int benchCaixa(int argc, char **argv);
+int benchAmostragem(int argc, char **argv);
+int benchBalanca(int argc, char **argv);
+int benchDistancia(int argc, char **argv);
+int benchLuz(int argc, char **argv);
+int benchFusao(int argc, char **argv);
+int benchConfiguracao(int argc, char **argv);
+int benchAgendador(int argc, char **argv);
+int benchDiagnostico(int argc, char **argv);
+int benchAcesso(int argc, char **argv);
+int benchModelos(int argc, char **argv);
+int benchEspera(int argc, char **argv);
+int benchToque(int argc, char **argv);
+int benchParticao(int argc, char **argv);
+int benchTrava(int argc, char **argv);
+int benchRegistro(int argc, char **argv);
+int benchPartida(int argc, char **argv);
+
+// Cenario padrao (benchLoop.cpp): acessos, sensores e quedas de rede agendados a partir
+// de `inicio` (us simulados). Retorna quantos acessos autorizados o cenario contem.
+unsigned montarCenario(uint64_t inicio, uint64_t duracao);
+
+// --- Opcoes "--nome valor" ---
+inline double opcaoNumero(int argc, char **argv, const char *nome, double padrao)
+{
+    for (int i = 0; i + 1 < argc; i++)
+        if (strcmp(argv[i], nome) == 0)
+            return atof(argv[i + 1]);
+    return padrao;
+}
+
+inline bool opcaoPresente(int argc, char **argv, const char *nome)
+{
+    for (int i = 0; i < argc; i++)
+        if (strcmp(argv[i], nome) == 0)
+            return true;
+    return false;
+}
+
+// --- Relogio de parede do host, para custo real de CPU ---
+inline uint64_t relogioHostNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// --- Distribuicao de latencias ---
+class Amostras
+{
+public:
+    void reservar(size_t n) { _valores.reserve(n); }
+    void registrar(uint64_t valor)
+    {
+        _valores.push_back(valor);
+        _ordenado = false;
+    }
+    size_t quantidade() const { return _valores.size(); }
+
+    uint64_t percentil(double p)
+    {
+        if (_valores.empty())
+            return 0;
+        ordenar();
+        size_t i = (size_t)(p / 100.0 * (_valores.size() - 1) + 0.5);
+        return _valores[i];
+    }
+
+    uint64_t maximo()
+    {
+        if (_valores.empty())
+            return 0;
+        ordenar();
+        return _valores.back();
+    }
+
+    double media() const
+    {
+        if (_valores.empty())
+            return 0;
+        double soma = 0;
+        for (uint64_t v : _valores)
+            soma += v;
+        return soma / _valores.size();
+    }
+
+    void imprimir(const char *nome, const char *unidade)
+    {
+        printf("%-28s p50 %8llu | p99 %8llu | max %8llu %s (n=%zu)\n", nome,
+               (unsigned long long)percentil(50), (unsigned long long)percentil(99),
+               (unsigned long long)maximo(), unidade, quantidade());
+    }
+
+private:
+    std::vector<uint64_t> _valores;
+    bool _ordenado = false;
+
+    void ordenar()
+    {
+        if (_ordenado)
+            return;
+        std::sort(_valores.begin(), _valores.end());
+        _ordenado = true;
+    }
+};
+
+#endif
@@ -0,0 +1,381 @@
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "bancada.h"
+#include "simulador.h"
+#include "hal.h"
+#include "listaDeAcesso.h"
+#include "sensorDeDigitais.h"
+
+// ====================================================================================
+// BENCHMARK DA LISTA DE ACESSO LOCAL
+// ====================================================================================
+// 1) Custo de uma decisao (avaliarAcesso) com a lista cheia: posicoes sorteadas, duas
+//    janelas de horario, e o pior caso (nenhuma janela vale).
+// 2) Janelas de horario, revogacao, confianca e relogio invalido contra uma tabela de
+//    casos com a resposta esperada.
+// 3) Firmware (loop() cooperativo) recebendo patches pelo broker: cadastro, janela fora
+//    do horario, revogacao; cada dedo no sensor precisa terminar na decisao esperada, com
+//    e sem rede. Patches fora de ordem, repetidos e invalidos sao recusados sem mudar a
+//    versao, e a lista volta da NVS num reinicio.
+// 4) Um escritor trocando uma posicao sem parar contra leitores em outras threads:
+//    nenhuma decisao pode misturar duas versoes da posicao.
+// Opcoes:
+//   --decisoes N   decisoes por medida de custo (padrao 10000000)
+//   --trocas N     trocas do escritor no teste entre threads (padrao 200000)
+//   --leitores N   threads leitoras (padrao 2)
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const uint8_t PINO_BOTAO = 12;
+static const uint8_t PINO_TRAVA = 25;
+static const char *TOPICO = "safezone-acl/134";
+static const char *TOPICO_EFETIVA = "safezone-acl/134/efetiva";
+static const char *TOPICO_EVENTOS = "safezone-events";
+static const time_t QUARTA_10H = 1760522400; // 2025-10-15, 10h (o relogio simulado e UTC)
+static const uint16_t CAPACIDADE_EMULADOR = 162;
+
+extern FingerprintSensor sensorDigital;
+
+static volatile uint32_t sumidouro;
+static std::string efetiva;
+static std::string ultimoEvento;
+static bool travaAberta = false;
+
+static EntradaAcesso entrada(uint16_t usuario, uint16_t confianca, uint8_t dias = 0, uint16_t inicio = 0,
+                             uint16_t fim = 0, uint8_t dias2 = 0, uint16_t inicio2 = 0, uint16_t fim2 = 0)
+{
+    EntradaAcesso e = {};
+    e.usuario = usuario;
+    e.confiancaMinima = confianca;
+    e.dias[0] = dias;
+    e.inicioMin[0] = inicio;
+    e.fimMin[0] = fim;
+    e.dias[1] = dias2;
+    e.inicioMin[1] = inicio2;
+    e.fimMin[1] = fim2;
+    return e;
+}
+
+static uint32_t sortear(uint32_t &semente)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+// ------------------- CUSTO -------------------
+
+static void medirCusto(uint64_t decisoes)
+{
+    // Lista cheia: dias uteis de 8h a 18h e sabado de 22h a 2h, confianca minima 50
+    uint32_t versao = versaoListaDeAcesso();
+    for (uint16_t slot = 1; slot <= CAPACIDADE_EMULADOR; slot++, versao++)
+        aplicarPatchAcesso(versao, versao + 1, slot, entrada(1000 + slot, 50, 0x3E, 480, 1080, 0x40, 1320, 120));
+
+    std::vector<uint16_t> slots(4096), confiancas(4096);
+    std::vector<time_t> instantes(4096);
+    uint32_t semente = 134;
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        slots[i] = sortear(semente) % MAX_SLOTS_ACESSO;
+        confiancas[i] = sortear(semente) % 200;
+        instantes[i] = QUARTA_10H + sortear(semente) % (7 * 86400);
+    }
+
+    uint64_t t0 = relogioHostNs();
+    for (uint64_t i = 0; i < decisoes; i++)
+        sumidouro += avaliarAcesso(slots[i & 4095], confiancas[i & 4095], instantes[i & 4095]).decisao;
+    double sorteada = (double)(relogioHostNs() - t0) / decisoes;
+
+    // Pior caso: passa por tudo e as duas janelas sao conferidas (domingo, 12h)
+    t0 = relogioHostNs();
+    for (uint64_t i = 0; i < decisoes; i++)
+        sumidouro += avaliarAcesso(1 + (i & 127), 120, QUARTA_10H + 4 * 86400 + 2 * 3600).decisao;
+    double piorCaso = (double)(relogioHostNs() - t0) / decisoes;
+
+    printf("decisao: %.1f ns sorteada, %.1f ns no pior caso (%u posicoes, %zu bytes cada, %zu no total)\n", sorteada,
+           piorCaso, (unsigned)cadastrosListaDeAcesso(), sizeof(EntradaAcesso), sizeof(EntradaAcesso) * MAX_SLOTS_ACESSO);
+}
+
+// ------------------- CASOS -------------------
+
+struct Caso
+{
+    const char *nome;
+    uint16_t slot;
+    uint16_t confianca;
+    time_t agora;
+    DecisaoAcesso esperada;
+};
+
+static bool conferirCasos()
+{
+    uint32_t v = versaoListaDeAcesso();
+    aplicarPatchAcesso(v, v + 1, 1, entrada(11, 0)); // Qualquer horario
+    aplicarPatchAcesso(v + 1, v + 2, 2, entrada(12, 100)); // Confianca minima 100
+    aplicarPatchAcesso(v + 2, v + 3, 3, entrada(13, 0, 0x3E, 480, 1080)); // Seg a sex, 8h as 18h
+    aplicarPatchAcesso(v + 3, v + 4, 4, entrada(14, 0, 0x20, 1320, 360)); // Sexta 22h ate sabado 6h
+    aplicarPatchAcesso(v + 4, v + 5, 5, entrada(15, 0, 0x01, 600, 600, 0x3E, 1200, 1260)); // Domingo todo, uteis 20h
+    EntradaAcesso revogada = entrada(16, 0);
+    revogada.revogado = 1;
+    aplicarPatchAcesso(v + 5, v + 6, 6, revogada);
+    aplicarPatchAcesso(v + 6, v + 7, 7, entrada(0, 0)); // Apagada
+
+    const time_t quarta = QUARTA_10H - 10 * 3600; // Quarta, 0h
+    const time_t sexta = quarta + 2 * 86400, sabado = quarta + 3 * 86400, domingo = quarta + 4 * 86400;
+    const Caso casos[] = {
+        {"sem restricao", 1, 10, quarta + 3 * 3600, ACESSO_LIBERADO},
+        {"confianca 99 < 100", 2, 99, quarta, ACESSO_CONFIANCA_BAIXA},
+        {"confianca 100", 2, 100, quarta, ACESSO_LIBERADO},
+        {"quarta 7h59", 3, 50, quarta + 479 * 60, ACESSO_FORA_DO_HORARIO},
+        {"quarta 8h00", 3, 50, quarta + 480 * 60, ACESSO_LIBERADO},
+        {"quarta 17h59", 3, 50, quarta + 1079 * 60, ACESSO_LIBERADO},
+        {"quarta 18h00", 3, 50, quarta + 1080 * 60, ACESSO_FORA_DO_HORARIO},
+        {"sabado 10h (uteis)", 3, 50, sabado + 600 * 60, ACESSO_FORA_DO_HORARIO},
+        {"sexta 21h59", 4, 50, sexta + 1319 * 60, ACESSO_FORA_DO_HORARIO},
+        {"sexta 23h", 4, 50, sexta + 1380 * 60, ACESSO_LIBERADO},
+        {"sabado 5h59", 4, 50, sabado + 359 * 60, ACESSO_LIBERADO},
+        {"sabado 6h00", 4, 50, sabado + 360 * 60, ACESSO_FORA_DO_HORARIO},
+        {"sabado 23h", 4, 50, sabado + 1380 * 60, ACESSO_FORA_DO_HORARIO},
+        {"domingo 3h", 5, 50, domingo + 180 * 60, ACESSO_LIBERADO},
+        {"quarta 20h30", 5, 50, quarta + 1230 * 60, ACESSO_LIBERADO},
+        {"quarta 21h", 5, 50, quarta + 1260 * 60, ACESSO_FORA_DO_HORARIO},
+        {"relogio sem NTP", 3, 50, 8 * 3600, ACESSO_SEM_RELOGIO},
+        {"relogio sem NTP, sem janela", 1, 50, 8 * 3600, ACESSO_LIBERADO},
+        {"revogado", 6, 200, quarta + 600 * 60, ACESSO_REVOGADO},
+        {"apagado", 7, 200, quarta + 600 * 60, ACESSO_SEM_CADASTRO},
+        {"fora da lista", 8, 200, quarta + 600 * 60, ACESSO_SEM_CADASTRO},
+        {"alem da capacidade", 500, 200, quarta + 600 * 60, ACESSO_SEM_CADASTRO},
+    };
+
+    bool ok = true;
+    for (const Caso &caso : casos)
+    {
+        DecisaoAcesso decisao = avaliarAcesso(caso.slot, caso.confianca, caso.agora).decisao;
+        bool certo = decisao == caso.esperada;
+        ok = ok && certo;
+        if (!certo)
+            printf("  %-28s -> %s, esperado %s: ERRO\n", caso.nome, nomeDecisaoAcesso(decisao),
+                   nomeDecisaoAcesso(caso.esperada));
+    }
+    printf("casos: %zu decisoes de horario, confianca, revogacao e relogio: %s\n", sizeof(casos) / sizeof(casos[0]),
+           ok ? "ok" : "ERRO");
+    return ok;
+}
+
+// ------------------- FIRMWARE -------------------
+
+static void aoPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    if (strcmp(topico, TOPICO_EFETIVA) == 0)
+        efetiva.assign((const char *)dados, tamanho);
+    else if (strcmp(topico, TOPICO_EVENTOS) == 0)
+        ultimoEvento.assign((const char *)dados, tamanho);
+}
+
+static void rodar(uint64_t duracao)
+{
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+}
+
+static bool contem(const std::string &texto, const char *trecho)
+{
+    return texto.find(trecho) != std::string::npos;
+}
+
+// Publica um patch e roda ate a versao vigente voltar (ou 2 s).
+static bool enviarPatch(const char *payload, const char *statusEsperado)
+{
+    efetiva.clear();
+    uint64_t inicio = sim::agoraUs();
+    sim::publicarNoBroker(TOPICO, payload, false);
+    while (efetiva.empty() && sim::agoraUs() - inicio < 2 * S)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+    char status[64];
+    snprintf(status, sizeof(status), "\"status\":\"%s", statusEsperado);
+    bool certo = contem(efetiva, status);
+    printf("  patch %-78s -> %s %s\n", payload, efetiva.empty() ? "(sem resposta)" : efetiva.c_str(), certo ? "ok" : "ERRO");
+    return certo;
+}
+
+// Botao, dedo e o tempo da verificacao; confere a decisao do sensor e a trava.
+static bool tentar(uint16_t dedo, DecisaoAcesso esperada, bool conectado)
+{
+    travaAberta = false;
+    ultimoEvento.clear();
+    uint64_t t = sim::agoraUs();
+    sim::agendar(t, []
+                 { sim::definirEntrada(PINO_BOTAO, LOW); });
+    sim::agendar(t + 300 * MS, []
+                 { sim::definirEntrada(PINO_BOTAO, HIGH); });
+    sim::agendar(t + 500 * MS, [dedo]
+                 { sim::definirDedo(true, dedo); });
+    sim::agendar(t + 1500 * MS, []
+                 { sim::definirDedo(false); });
+    rodar(3 * S);
+
+    DecisaoAcesso decisao = sensorDigital.accessDecision();
+    bool liberado = esperada == ACESSO_LIBERADO;
+    char trecho[48];
+    snprintf(trecho, sizeof(trecho), "\"decisao\":\"%s\"", nomeDecisaoAcesso(esperada));
+    bool publicado = !conectado || contem(ultimoEvento, trecho);
+    bool certo = decisao == esperada && travaAberta == liberado && publicado;
+    printf("  dedo %u %s: %-16s usuario %-5u trava %-8s evento %s\n", (unsigned)dedo,
+           conectado ? "com rede" : "sem rede", nomeDecisaoAcesso(decisao), (unsigned)sensorDigital.matchedUser(),
+           travaAberta ? "aberta" : "fechada", conectado ? (publicado ? "ok" : "ERRO") : "na caixa de saida");
+    return certo;
+}
+
+static bool executarFirmware()
+{
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::aoPublicar(aoPublicar);
+    sim::aoEscreverPino([](uint64_t, uint8_t pino, uint8_t nivel)
+                        {
+        if (pino == PINO_TRAVA && nivel == HIGH)
+            travaAberta = true; });
+    setup();
+    for (uint16_t id = 1; id <= 4; id++)
+        sim::cadastrarDigital(id);
+    rodar(5 * S);
+
+    bool ok = true;
+    printf("firmware:\n");
+    // Sem lista: qualquer digital encontrada libera, como antes
+    ok = tentar(1, ACESSO_LIBERADO, true) && ok;
+    ok = tentar(0, ACESSO_NAO_ENCONTRADO, true) && ok;
+
+    // Janela que acabou de passar: das 0h ate o minuto atual, todos os dias
+    time_t agora = halRelogioAgora();
+    unsigned minuto = (unsigned)((agora % 86400) / 60);
+    char janela[160];
+    snprintf(janela, sizeof(janela),
+             "{\"versao\":3,\"base\":2,\"slot\":3,\"usuario\":1003,\"dias\":127,\"inicio\":0,\"fim\":%u}", minuto);
+
+    ok = enviarPatch("{\"versao\":1,\"base\":0,\"slot\":1,\"usuario\":1001,\"confianca\":50}", "aplicado") && ok;
+    ok = enviarPatch("{\"versao\":2,\"base\":1,\"slot\":2,\"usuario\":1002,\"confianca\":200}", "aplicado") && ok;
+    ok = enviarPatch(janela, "aplicado") && ok;
+    ok = enviarPatch("{\"versao\":4,\"base\":3,\"slot\":4,\"usuario\":1004,\"revogado\":1}", "aplicado") && ok;
+    ok = enviarPatch("{\"versao\":6,\"base\":5,\"slot\":1,\"usuario\":9}", "fora de ordem") && ok;
+    ok = enviarPatch("{\"versao\":4,\"base\":3,\"slot\":4,\"usuario\":1004,\"revogado\":1}", "repetido") && ok;
+    ok = enviarPatch("{\"versao\":5,\"base\":4,\"slot\":500,\"usuario\":1}", "invalido: slot") && ok;
+    ok = enviarPatch("{\"versao\":5,\"base\":4,\"slot\":1,\"confianca\":10}", "invalido: usuario") && ok;
+    ok = enviarPatch("{\"versao\":5,\"base\":4,\"slot\":1,\"usuario\":1,\"fim\":2000}", "invalido: fim") && ok;
+    bool versao = versaoListaDeAcesso() == 4 && cadastrosListaDeAcesso() == 4;
+    ok = ok && versao;
+    printf("  versao %lu com %u cadastros depois dos recusados: %s\n", (unsigned long)versaoListaDeAcesso(),
+           (unsigned)cadastrosListaDeAcesso(), versao ? "ok" : "ERRO");
+
+    // O emulador responde com confianca 120
+    ok = tentar(1, ACESSO_LIBERADO, true) && ok;
+    ok = tentar(2, ACESSO_CONFIANCA_BAIXA, true) && ok;
+    ok = tentar(3, ACESSO_FORA_DO_HORARIO, true) && ok;
+    ok = tentar(4, ACESSO_REVOGADO, true) && ok;
+    ok = tentar(0, ACESSO_NAO_ENCONTRADO, true) && ok;
+
+    // Sem rede a decisao e a mesma
+    sim::definirWiFi(false);
+    rodar(2 * S);
+    ok = tentar(1, ACESSO_LIBERADO, false) && ok;
+    ok = tentar(4, ACESSO_REVOGADO, false) && ok;
+    sim::definirWiFi(true);
+    rodar(10 * S);
+
+    // Reinicio: a lista volta da NVS
+    uint64_t t0 = relogioHostNs();
+    bool daNvs = iniciarListaDeAcesso();
+    double recarga = (relogioHostNs() - t0) / 1e3;
+    agora = halRelogioAgora();
+    bool certo = daNvs && versaoListaDeAcesso() == 4 && cadastrosListaDeAcesso() == 4 &&
+                 avaliarAcesso(1, 120, agora).decisao == ACESSO_LIBERADO &&
+                 avaliarAcesso(2, 120, agora).decisao == ACESSO_CONFIANCA_BAIXA &&
+                 avaliarAcesso(3, 120, agora).decisao == ACESSO_FORA_DO_HORARIO &&
+                 avaliarAcesso(4, 120, agora).decisao == ACESSO_REVOGADO;
+    ok = ok && certo;
+    printf("  reinicio: lista v%lu lida da NVS em %.1f us (host): %s\n", (unsigned long)versaoListaDeAcesso(), recarga,
+           certo ? "ok" : "ERRO");
+
+    sim::aoPublicar(nullptr);
+    sim::aoEscreverPino(nullptr);
+    return ok;
+}
+
+// ------------------- ESCRITOR X LEITORES -------------------
+// As duas versoes da posicao diferem em usuario e decisao: uma copia rasgada da um par
+// que nao existe em nenhuma delas.
+static bool testarThreads(unsigned long trocas, unsigned leitores)
+{
+    const uint16_t SLOT = 9;
+    EntradaAcesso a = entrada(2001, 0), b = entrada(2002, 0);
+    b.revogado = 1;
+    time_t agora = halRelogioAgora();
+
+    // Sem NVS: so a troca na RAM compete com os leitores
+    sim::bloquearFlash(true);
+    uint32_t versao = versaoListaDeAcesso();
+    aplicarPatchAcesso(versao, versao + 1, SLOT, a);
+    versao++;
+
+    std::atomic<bool> parar{false};
+    std::atomic<unsigned long> leituras{0}, rasgadas{0};
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < leitores; i++)
+        threads.emplace_back([&]
+                             {
+            unsigned long n = 0, r = 0;
+            while (!parar.load(std::memory_order_relaxed))
+            {
+                ResultadoAcesso resultado = avaliarAcesso(SLOT, 100, agora);
+                bool deA = resultado.usuario == 2001 && resultado.decisao == ACESSO_LIBERADO;
+                bool deB = resultado.usuario == 2002 && resultado.decisao == ACESSO_REVOGADO;
+                r += !deA && !deB;
+                n++;
+            }
+            leituras += n;
+            rasgadas += r; });
+
+    uint64_t t0 = relogioHostNs();
+    unsigned long aplicadas = 0;
+    for (unsigned long i = 0; i < trocas; i++, versao++)
+        aplicadas += aplicarPatchAcesso(versao, versao + 1, SLOT, i % 2 ? a : b) == PATCH_NAO_GRAVADO;
+    parar = true;
+    for (std::thread &t : threads)
+        t.join();
+    double segundos = (relogioHostNs() - t0) / 1e9;
+    sim::bloquearFlash(false);
+
+    printf("threads: %lu trocas em %.2f s contra %u leitores: %lu decisoes, %lu rasgadas\n", trocas, segundos, leitores,
+           leituras.load(), rasgadas.load());
+    return rasgadas == 0 && aplicadas == trocas;
+}
+
+int benchAcesso(int argc, char **argv)
+{
+    uint64_t decisoes = (uint64_t)opcaoNumero(argc, argv, "--decisoes", 10000000);
+    unsigned long trocas = (unsigned long)opcaoNumero(argc, argv, "--trocas", 200000);
+    unsigned leitores = (unsigned)opcaoNumero(argc, argv, "--leitores", 2);
+    bool ok = true;
+
+    printf("\n=== benchmark acesso ===\n");
+    ok = executarFirmware() && ok;
+    ok = conferirCasos() && ok;
+    medirCusto(decisoes);
+    ok = testarThreads(trocas, leitores) && ok;
+
+    printf("%s\n", ok ? "ok: decisoes locais corretas com e sem rede, patches em ordem, NVS e copias consistentes" : "FALHA");
+    remove("bench_caixa.bin");
+    remove("bench_nvs.bin");
+    return ok ? 0 : 1;
+}
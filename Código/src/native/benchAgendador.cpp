@@ -0,0 +1,305 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "agendador.h"
+
+// ====================================================================================
+// BENCHMARK DO AGENDADOR (RODA DE TEMPORIZADORES)
+// ====================================================================================
+// Algumas centenas de trabalhos (periodos de 1 ms a 1 min e trabalhos de uma vez so
+// que se remarcam com atraso pseudoaleatorio) contra o relogio simulado, parado entre
+// os passos (sim::congelarHost) para que os prazos sejam exatos:
+//   1) passo de 1 ms: custo de executar() por passo e por trabalho despachado, contra
+//      a verificacao ad hoc `millis() - ultimo >= periodo` de cada trabalho a cada
+//      passo. Confere as execucoes esperadas e atraso zero;
+//   2) dormindo msAteProximo(), so com os trabalhos de 1 s ou mais e os de uma vez so:
+//      quantas vezes a tarefa acorda, contra o prazo mais proximo calculado a parte
+//      (nunca pode acordar depois dele), e a CPU total contra a verificacao ad hoc;
+//   3) atraso e periodos perdidos de um trabalho de 10 ms com passos de 7 ms e um
+//      passo travado de 35 ms, e estouro de orcamento de um trabalho lento.
+// Opcoes:
+//   --trabalhos N   trabalhos (padrao 300, maximo 1024)
+//   --duracao-s N   tempo simulado por cenario (padrao 600)
+
+static const uint16_t CAPACIDADE = 1024;
+static const uint32_t PERIODOS[] = {1, 5, 10, 20, 50, 100, 250, 1000, 5000, 60000};
+static const uint8_t NUM_PERIODOS = sizeof(PERIODOS) / sizeof(PERIODOS[0]);
+
+static AgendadorFixo<CAPACIDADE> agenda;
+
+struct Carga
+{
+    uint16_t id;
+    uint32_t periodo;  // 0: uma vez so, remarcado pelo proprio trabalho
+    uint32_t proximo;  // Prazo segundo a bancada (ms)
+    uint32_t semente;
+    bool ativo;
+    unsigned long execucoes;
+    unsigned long esperadas;
+};
+
+static Carga cargas[CAPACIDADE];
+static uint16_t quantidade = 0;
+static volatile uint32_t sumidouro;
+
+static uint32_t sortear(uint32_t &semente)
+{
+    semente = semente * 1664525u + 1013904223u;
+    return semente >> 8;
+}
+
+// O mesmo trabalho, sem remarcar: o que a verificacao ad hoc chama.
+static void trabalhoReferencia(void *contexto)
+{
+    Carga &c = *(Carga *)contexto;
+    sumidouro += ++c.esperadas;
+}
+
+static void trabalhoCarga(void *contexto)
+{
+    Carga &c = *(Carga *)contexto;
+    c.execucoes++;
+    sumidouro += c.execucoes;
+    if (c.periodo)
+    {
+        c.proximo += c.periodo;
+        return;
+    }
+    uint32_t atraso = 1 + sortear(c.semente) % 2000;
+    c.proximo = millis() + atraso;
+    c.esperadas++;
+    agenda.agendar(c.id, atraso);
+}
+
+// Um de cada 10 trabalhos e de uma vez so; os outros percorrem a lista de periodos.
+// Os periodicos abaixo de periodoMinimo ficam parados.
+static void montar(uint16_t n, uint32_t periodoMinimo = 0)
+{
+    static bool registrados = false;
+    if (!registrados)
+    {
+        for (uint16_t i = 0; i < n; i++)
+        {
+            Carga &c = cargas[i];
+            c.periodo = i % 10 == 9 ? 0 : PERIODOS[i % NUM_PERIODOS];
+            c.id = agenda.registrar("carga", trabalhoCarga, &c, c.periodo);
+        }
+        quantidade = n;
+        registrados = true;
+    }
+
+    uint32_t agora = millis();
+    for (uint16_t i = 0; i < quantidade; i++)
+    {
+        Carga &c = cargas[i];
+        c.semente = 0x9E3779B9u * (i + 1);
+        c.execucoes = 0;
+        c.esperadas = 0;
+        c.ativo = !c.periodo || c.periodo >= periodoMinimo;
+        if (!c.ativo)
+            continue;
+        uint32_t atraso = c.periodo ? c.periodo : 1 + sortear(c.semente) % 2000;
+        c.proximo = agora + atraso;
+        agenda.agendar(c.id, atraso);
+    }
+}
+
+static void pararTodos()
+{
+    for (uint16_t i = 0; i < quantidade; i++)
+        agenda.parar(cargas[i].id);
+}
+
+// Execucoes esperadas em `duracao` ms: periodicos pelo periodo, os de uma vez so pelas
+// remarcacoes que eles mesmos contaram (mais a primeira, se o prazo passou).
+static bool conferirExecucoes(uint32_t inicio, uint32_t duracao, unsigned long &total)
+{
+    bool certo = true;
+    total = 0;
+    for (uint16_t i = 0; i < quantidade; i++)
+    {
+        Carga &c = cargas[i];
+        unsigned long esperadas = !c.ativo ? 0 : c.periodo ? duracao / c.periodo : c.esperadas;
+        if (!c.periodo && (int32_t)(inicio + duracao - c.proximo) >= 0)
+            esperadas++; // Ultimo prazo vencido ainda nao executado: nao deveria existir
+        certo = certo && c.execucoes == esperadas;
+        total += c.execucoes;
+    }
+    return certo;
+}
+
+// Referencia: a cada passo de 1 ms cada trabalho ativo confere o proprio periodo (os
+// de uma vez so como periodicos de 1 s) e mede a propria duracao, como o agendador.
+// Retorna o tempo de host gasto.
+static uint64_t verificarAdHoc(uint32_t duracao, unsigned long &chamados)
+{
+    static uint32_t ultimo[CAPACIDADE];
+    for (uint16_t i = 0; i < quantidade; i++)
+        ultimo[i] = millis();
+    uint64_t hostNs = 0;
+    chamados = 0;
+    for (uint32_t ms = 0; ms < duracao; ms++)
+    {
+        sim::avancarUs(1000);
+        uint64_t t0 = relogioHostNs();
+        unsigned long agora = millis();
+        for (uint16_t i = 0; i < quantidade; i++)
+        {
+            if (!cargas[i].ativo)
+                continue;
+            uint32_t periodo = cargas[i].periodo ? cargas[i].periodo : 1000;
+            if (agora - ultimo[i] >= periodo)
+            {
+                ultimo[i] = agora;
+                unsigned long inicio = micros();
+                trabalhoReferencia(&cargas[i]);
+                sumidouro += micros() - inicio;
+                chamados++;
+            }
+        }
+        hostNs += relogioHostNs() - t0;
+    }
+    return hostNs;
+}
+
+// ------------------- PASSO DE 1 MS -------------------
+static bool medirPassoFixo(uint32_t duracao)
+{
+    montar(quantidade);
+    uint32_t inicio = millis();
+    uint64_t hostNs = 0;
+    unsigned long despachados = 0;
+    for (uint32_t ms = 0; ms < duracao; ms++)
+    {
+        sim::avancarUs(1000);
+        uint64_t t0 = relogioHostNs();
+        despachados += agenda.executar(millis());
+        hostNs += relogioHostNs() - t0;
+    }
+    pararTodos();
+
+    unsigned long total = 0;
+    bool certo = conferirExecucoes(inicio, duracao, total) && total == despachados;
+    uint32_t atrasoMaximo = 0;
+    for (uint16_t i = 0; i < quantidade; i++)
+        atrasoMaximo = std::max(atrasoMaximo, agenda.estatisticas(cargas[i].id).atrasoMaximoMs);
+    certo = certo && atrasoMaximo == 0;
+
+    unsigned long chamados = 0;
+    uint64_t adHocNs = verificarAdHoc(duracao, chamados);
+
+    printf("passo de 1 ms: %lu execucoes (%.1f por passo), atraso maximo %lu ms: %s\n",
+           total, (double)total / duracao, (unsigned long)atrasoMaximo, certo ? "ok" : "ERRO");
+    printf("  agendador: %.0f ns por passo, %.1f ns por trabalho despachado\n",
+           (double)hostNs / duracao, despachados ? (double)hostNs / despachados : 0.0);
+    printf("  ad hoc (millis() - ultimo >= periodo): %.0f ns por passo (%u verificacoes), %.1f ns por trabalho chamado\n",
+           (double)adHocNs / duracao, quantidade, chamados ? (double)adHocNs / chamados : 0.0);
+    return certo;
+}
+
+// ------------------- DORMINDO ATE O PROXIMO PRAZO -------------------
+static bool medirOcioso(uint32_t duracao)
+{
+    montar(quantidade, 1000);
+    uint32_t inicio = millis();
+    unsigned long despertares = 0, vazios = 0, adiantados = 0, atrasados = 0;
+    uint64_t hostNs = 0;
+
+    while (millis() - inicio < duracao)
+    {
+        uint32_t agora = millis();
+        uint32_t espera = agenda.msAteProximo(agora);
+
+        // Prazo mais proximo pela bancada
+        uint32_t menor = UINT32_MAX;
+        for (uint16_t i = 0; i < quantidade; i++)
+            if (cargas[i].ativo)
+                menor = std::min(menor, (int32_t)(cargas[i].proximo - agora) > 0 ? cargas[i].proximo - agora : 0);
+        if (espera > menor)
+            atrasados++;
+        else if (espera < menor)
+            adiantados++;
+
+        uint32_t restante = duracao - (agora - inicio);
+        sim::avancarUs((uint64_t)std::max<uint32_t>(1, std::min(espera, restante)) * 1000);
+        if (millis() - inicio > duracao)
+            break;
+        despertares++;
+        uint64_t t0 = relogioHostNs();
+        vazios += agenda.executar(millis()) == 0;
+        hostNs += relogioHostNs() - t0;
+    }
+    pararTodos();
+
+    unsigned long total = 0;
+    bool certo = conferirExecucoes(inicio, duracao, total) && atrasados == 0;
+    unsigned long chamados = 0;
+    uint64_t adHocNs = verificarAdHoc(duracao, chamados);
+
+    printf("dormindo msAteProximo(): %lu despertares em %lu ms (%lu sem trabalho, %lu antes do prazo, %lu depois), "
+           "%lu execucoes: %s\n",
+           despertares, (unsigned long)duracao, vazios, adiantados, atrasados, total, certo ? "ok" : "ERRO");
+    printf("  agendador: %.0f ns por despertar, %.1f ms de CPU no total\n",
+           despertares ? (double)hostNs / despertares : 0.0, hostNs / 1e6);
+    printf("  ad hoc acordando a cada 1 ms: %.1f ms de CPU no total (%lu trabalhos chamados)\n", adHocNs / 1e6, chamados);
+    return certo;
+}
+
+// ------------------- ATRASO, PERDIDOS E ESTOURO -------------------
+static void trabalhoRapido(void *)
+{
+    sumidouro++;
+}
+
+static void trabalhoLento(void *)
+{
+    sim::avancarUs(2000); // 2 ms de CPU contra um orcamento de 500 us
+}
+
+static bool medirAtraso()
+{
+    AgendadorFixo<2> pequena;
+    uint16_t rapido = pequena.registrar("rapido", trabalhoRapido, nullptr, 10);
+    uint16_t lento = pequena.registrar("lento", trabalhoLento, nullptr, 100, 500);
+    pequena.agendar(rapido, 10);
+    pequena.agendar(lento, 100);
+
+    for (int i = 0; i < 140; i++) // ~1 s em passos de 7 ms
+    {
+        sim::avancarUs(7000);
+        pequena.executar(millis());
+    }
+    sim::avancarUs(35000); // Passo travado: 3 periodos do rapido vencem juntos
+    pequena.executar(millis());
+
+    EstatisticasTrabalho r = pequena.estatisticas(rapido);
+    EstatisticasTrabalho l = pequena.estatisticas(lento);
+    bool certo = r.atrasoMaximoMs >= 6 && r.perdidos >= 3 && r.estouros == 0 &&
+                 l.estouros == l.execucoes && l.execucoes > 0 && l.duracaoMaximaUs >= 2000;
+    printf("%-7s %4lu execucoes, atraso medio %.1f ms, maximo %lu ms, %lu perdidos\n", r.nome, r.execucoes,
+           r.execucoes ? (double)r.atrasoTotalMs / r.execucoes : 0.0, (unsigned long)r.atrasoMaximoMs, r.perdidos);
+    printf("%-7s %4lu execucoes, duracao maxima %lu us, %lu estouros do orcamento de 500 us\n", l.nome, l.execucoes,
+           (unsigned long)l.duracaoMaximaUs, l.estouros);
+    printf("atraso, perdidos e estouro: %s\n", certo ? "ok" : "ERRO");
+    return certo;
+}
+
+int benchAgendador(int argc, char **argv)
+{
+    uint16_t trabalhos = (uint16_t)std::min<double>(opcaoNumero(argc, argv, "--trabalhos", 300), CAPACIDADE);
+    uint32_t duracao = (uint32_t)(opcaoNumero(argc, argv, "--duracao-s", 600) * 1000);
+    bool ok = true;
+
+    printf("\n=== benchmark agendador: %u trabalhos, %lu s simulados ===\n", trabalhos, (unsigned long)duracao / 1000);
+    sim::congelarHost(true);
+    montar(trabalhos);
+    pararTodos();
+
+    ok = medirPassoFixo(duracao) && ok;
+    ok = medirOcioso(duracao) && ok;
+    ok = medirAtraso() && ok;
+    sim::congelarHost(false);
+
+    printf("%s\n", ok ? "ok: execucoes no prazo, nenhum despertar atrasado, atraso e estouro medidos" : "FALHA");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include <math.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "amostragem.h"
+#include "configuracao.h"
+#include "quadroBinario.h"
+#include "Monitoramento.h"
+
+// ====================================================================================
+// BENCHMARK DA AMOSTRAGEM DE ALTA TAXA
+// ====================================================================================
+// Executa o firmware (loop() cooperativo) com a amostragem ligada e mede, no broker
+// simulado, quantas amostras por segundo chegam de ponta a ponta, com que atraso e a
+// que custo em mensagens. Roda primeiro com uma amostra por mensagem e depois com os
+// quadros de N amostras, nas mesmas taxas.
+// Opcoes:
+//   --duracao-s N     tempo simulado de cada fase (padrao 60)
+//   --luz-ms N        intervalo de amostragem do LDR (padrao 20)
+//   --distancia-ms N  intervalo do VL53L0X (padrao 0: cada medida, perfil rapido)
+//   --pressao-ms N    intervalo do peso filtrado (padrao 0: cada conversao do HX711)
+//   --por-quadro N    amostras por quadro na segunda fase (padrao 32)
+
+static const uint8_t PINO_LDR = 33;
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const char *NOMES_SENSORES[] = {"pressao", "distancia", "luz"};
+
+struct MedidaFase
+{
+    unsigned long mensagens;    // Todos os topicos
+    unsigned long quadros;      // Topico de amostras
+    unsigned long bytesQuadros;
+    unsigned long amostras[NUM_SENSORES_AMOSTRADOS];
+    unsigned long invalidos;
+    uint32_t ultimaSequencia;
+    unsigned long lacunas;
+    Amostras atrasoMs; // Instante da amostra -> chegada ao broker
+};
+
+static MedidaFase *fase = nullptr;
+
+static void aoPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    if (!fase)
+        return;
+    fase->mensagens++;
+    if (strcmp(topico, "safezone-amostras") != 0)
+        return;
+
+    static QuadroAmostras quadro;
+    if (decodificarQuadroAmostras(dados, tamanho, quadro) != QUADRO_OK || quadro.sensor >= NUM_SENSORES_AMOSTRADOS)
+    {
+        fase->invalidos++;
+        return;
+    }
+    if (fase->ultimaSequencia && quadro.sequencia != fase->ultimaSequencia + 1)
+        fase->lacunas++;
+    fase->ultimaSequencia = quadro.sequencia;
+    fase->quadros++;
+    fase->bytesQuadros += tamanho;
+    fase->amostras[quadro.sensor] += quadro.quantidade;
+
+    unsigned long agoraMs = (unsigned long)(sim::agoraUs() / 1000);
+    for (uint8_t i = 0; i < quadro.quantidade; i++)
+        fase->atrasoMs.registrar(agoraMs - (quadro.instanteMs + quadro.amostras[i].deslocamentoMs));
+}
+
+// Luz oscilando e um vulto se aproximando e se afastando, para as amostras variarem.
+static void agendarSinais(uint64_t inicio, uint64_t duracao)
+{
+    for (uint64_t t = 0; t < duracao; t += 50 * MS)
+    {
+        uint16_t ldr = (uint16_t)(60 + 40 * sin(t / 1e6 * 2 * M_PI * 0.5));
+        sim::agendar(inicio + t, [ldr]
+                     { sim::definirAnalogico(PINO_LDR, ldr); });
+    }
+    for (uint64_t t = 0; t < duracao; t += 200 * MS)
+    {
+        uint16_t mm = (uint16_t)(800 + 600 * cos(t / 1e6 * 2 * M_PI / 20));
+        sim::agendar(inicio + t, [mm]
+                     { sim::definirDistanciaMM(mm); });
+    }
+}
+
+static void executarFase(const char *nome, const ConfiguracaoAmostragem &configuracao, uint64_t duracao)
+{
+    configurarAmostragem(configuracao);
+    MedidaFase medida = {};
+    EstatisticasAmostragem antes = estatisticasAmostragem();
+    Amostras latenciaLoop;
+
+    uint64_t inicio = sim::agoraUs();
+    agendarSinais(inicio, duracao);
+    fase = &medida;
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        uint64_t t0 = sim::agoraUs();
+        loop();
+        latenciaLoop.registrar(sim::agoraUs() - t0);
+        sim::avancarUs(200);
+    }
+    fase = nullptr;
+    EstatisticasAmostragem depois = estatisticasAmostragem();
+
+    double segundos = (sim::agoraUs() - inicio) / 1e6;
+    unsigned long total = 0, geradas = 0, descartadas = 0;
+    for (uint8_t i = 0; i < NUM_SENSORES_AMOSTRADOS; i++)
+    {
+        total += medida.amostras[i];
+        geradas += depois.amostras[i] - antes.amostras[i];
+        descartadas += depois.descartadas[i] - antes.descartadas[i];
+    }
+
+    printf("%s (%u por quadro):\n", nome, configuracao.amostrasPorQuadro);
+    printf("  amostras no broker: %.1f/s (", total / segundos);
+    for (uint8_t i = 0; i < NUM_SENSORES_AMOSTRADOS; i++)
+        printf("%s%s %.1f", i ? ", " : "", NOMES_SENSORES[i], medida.amostras[i] / segundos);
+    printf(") de %lu geradas, %lu descartadas no anel\n", geradas, descartadas);
+    printf("  mensagens no broker: %.1f/s (%.1f/s de amostras), %.0f bytes/s de amostras, %.1f amostras/mensagem\n",
+           medida.mensagens / segundos, medida.quadros / segundos, medida.bytesQuadros / segundos,
+           medida.quadros ? (double)total / medida.quadros : 0.0);
+    printf("  quadros: %lu lacunas de sequencia, %lu invalidos\n", medida.lacunas, medida.invalidos);
+    medida.atrasoMs.imprimir("  atraso amostra->broker:", "ms");
+    latenciaLoop.imprimir("  latencia loop():", "us");
+}
+
+int benchAmostragem(int argc, char **argv)
+{
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 60) * S);
+    ConfiguracaoAmostragem configuracao = {true, 32, 2000};
+    ConfiguracaoSafezone intervalos = CONFIGURACAO_PADRAO;
+    intervalos.intervaloMs[AMOSTRA_LUZ] = (int32_t)opcaoNumero(argc, argv, "--luz-ms", 20);
+    intervalos.intervaloMs[AMOSTRA_DISTANCIA] = (int32_t)opcaoNumero(argc, argv, "--distancia-ms", 0);
+    intervalos.intervaloMs[AMOSTRA_PRESSAO] = (int32_t)opcaoNumero(argc, argv, "--pressao-ms", 0);
+    uint8_t porQuadro = (uint8_t)opcaoNumero(argc, argv, "--por-quadro", 32);
+
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+
+    sim::aoPublicar(aoPublicar);
+    definirPerfilDistancia(DISTANCIA_RAPIDO); // Como no firmware com SAFEZONE_AMOSTRAGEM
+    setup();
+    if (aplicarConfiguracao(intervalos) == CONFIGURACAO_INVALIDA)
+    {
+        printf("Intervalos fora da faixa da configuracao.\n");
+        return 1;
+    }
+    uint64_t aquecimento = sim::agoraUs();
+    while (sim::agoraUs() - aquecimento < 5 * S) // Wi-Fi e MQTT conectados antes de medir
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+
+    printf("\n=== benchmark amostragem (luz %ld ms, distancia %ld ms, pressao %ld ms) ===\n",
+           (long)intervalos.intervaloMs[AMOSTRA_LUZ], (long)intervalos.intervaloMs[AMOSTRA_DISTANCIA],
+           (long)intervalos.intervaloMs[AMOSTRA_PRESSAO]);
+
+    configuracao.amostrasPorQuadro = 1;
+    executarFase("uma amostra por mensagem", configuracao, duracao);
+    configuracao.amostrasPorQuadro = porQuadro;
+    executarFase("quadros", configuracao, duracao);
+
+    remove("bench_caixa.bin");
+    remove("bench_nvs.bin");
+    return 0;
+}
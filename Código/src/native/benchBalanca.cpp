@@ -0,0 +1,142 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "Monitoramento.h"
+#include "amostragem.h"
+#include "configuracao.h"
+#include "balanca.h"
+
+// ====================================================================================
+// BENCHMARK DA BALANCA (HX711 CONTINUO + FILTRO)
+// ====================================================================================
+// Mede o custo do caminho da pressao em atualizarMonitoramento() (so ele ligado), em
+// tempo de CPU do host por chamada, e a qualidade do filtro contra a celula simulada
+// com ruido e picos: taxa de atualizacao do peso, tempo ate o alarme e ate assentar
+// num degrau de carga, erro em regime e alarmes falsos causados pelos picos.
+// Opcoes:
+//   --duracao-s N      tempo simulado de cada fase (padrao 60)
+//   --ruido N          ruido do HX711 em contagens (padrao 20)
+//   --picos-por-mil N  conversoes com pico a cada mil (padrao 20)
+//   --carga-kg N       degrau de carga (padrao 8)
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const int32_t INTERVALO_LONGO_MS = 60000; // Movimento e luz quase parados
+
+struct Degrau
+{
+    uint64_t inicio;
+    float kg;
+    uint64_t alarme;   // Instante em que o alarme acompanhou o degrau (0: ainda nao)
+    uint64_t assentou; // Instante em que o peso chegou a 1% do degrau (0: ainda nao)
+};
+
+int benchBalanca(int argc, char **argv)
+{
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 60) * S);
+    uint32_t ruido = (uint32_t)opcaoNumero(argc, argv, "--ruido", 20);
+    uint32_t picos = (uint32_t)opcaoNumero(argc, argv, "--picos-por-mil", 20);
+    float cargaKg = (float)opcaoNumero(argc, argv, "--carga-kg", 8);
+    bool ok = true;
+
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::definirRuidoBalanca(ruido, 0);
+    setup();
+    loop();
+    ConfiguracaoSafezone configuracao = configuracaoAtual();
+    configuracao.intervaloMs[AMOSTRA_DISTANCIA] = INTERVALO_LONGO_MS;
+    configuracao.intervaloMs[AMOSTRA_LUZ] = INTERVALO_LONGO_MS;
+    aplicarConfiguracao(configuracao);
+
+    printf("\n=== benchmark balanca (ruido %u contagens, %u picos por mil) ===\n", ruido, picos);
+
+    // ------------------- CUSTO POR CHAMADA -------------------
+    Amostras custoSemConversao, custoComConversao;
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        uint64_t t0 = relogioHostNs();
+        bool leu = atualizarMonitoramento();
+        uint64_t ns = relogioHostNs() - t0;
+        (leu ? custoComConversao : custoSemConversao).registrar(ns);
+        sim::avancarUs(200);
+    }
+    double segundos = (sim::agoraUs() - inicio) / 1e6;
+    printf("caminho da pressao em atualizarMonitoramento():\n");
+    custoSemConversao.imprimir("  sem conversao nova:", "ns");
+    custoComConversao.imprimir("  com conversao nova:", "ns");
+    printf("  peso atualizado %.1f vezes/s\n", custoComConversao.quantidade() / segundos);
+    if (custoComConversao.quantidade() / segundos < 9.5)
+        ok = false;
+
+    // ------------------- DEGRAUS COM RUIDO E PICOS -------------------
+    sim::definirRuidoBalanca(ruido, picos);
+    inicio = sim::agoraUs();
+    std::vector<Degrau> degraus;
+    for (uint64_t t = 5 * S; t + 5 * S < duracao; t += 10 * S)
+        degraus.push_back({inicio + t, degraus.size() % 2 ? 0.0f : cargaKg, 0, 0});
+    for (const Degrau &degrau : degraus)
+    {
+        float kg = degrau.kg;
+        sim::agendar(degrau.inicio, [kg]
+                     { sim::definirPeso(kg); });
+    }
+
+    size_t atual = 0;
+    bool alarmeAnterior = leituraMonitoramento().alarmePressao;
+    unsigned long transicoes = 0, falsos = 0;
+    int32_t maiorErroRegime = 0;
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        sim::avancarUs(200);
+        uint64_t agora = sim::agoraUs();
+        if (!atualizarMonitoramento())
+            continue;
+        while (atual + 1 < degraus.size() && agora >= degraus[atual + 1].inicio)
+            atual++;
+        const LeituraSensores &leitura = leituraMonitoramento();
+        bool carregado = !degraus.empty() && agora >= degraus[atual].inicio && degraus[atual].kg >= 5.0f;
+        int32_t esperado = agora >= degraus[0].inicio ? (int32_t)(degraus[atual].kg * 1000) : 0;
+        int32_t erro = abs((int32_t)(leitura.medida * 1000) - esperado);
+
+        if (leitura.alarmePressao != alarmeAnterior)
+        {
+            transicoes++;
+            if (leitura.alarmePressao != carregado)
+                falsos++;
+            alarmeAnterior = leitura.alarmePressao;
+        }
+        if (agora >= degraus[0].inicio)
+        {
+            Degrau &degrau = degraus[atual];
+            if (!degrau.alarme && leitura.alarmePressao == carregado)
+                degrau.alarme = agora;
+            if (!degrau.assentou && erro <= (int32_t)(cargaKg * 10))
+                degrau.assentou = agora;
+            if (degrau.assentou && agora - degrau.assentou > 1 * S)
+                maiorErroRegime = std::max(maiorErroRegime, erro);
+        }
+    }
+
+    Amostras tempoAlarme, tempoAssentar;
+    for (const Degrau &degrau : degraus)
+    {
+        if (!degrau.alarme || !degrau.assentou)
+            ok = false;
+        tempoAlarme.registrar((degrau.alarme - degrau.inicio) / MS);
+        tempoAssentar.registrar((degrau.assentou - degrau.inicio) / MS);
+    }
+    printf("degraus de %.1f kg (%zu):\n", cargaKg, degraus.size());
+    tempoAlarme.imprimir("  ate o alarme:", "ms");
+    tempoAssentar.imprimir("  ate 1% do degrau:", "ms");
+    printf("  erro em regime: max %d g; %lu transicoes de alarme, %lu falsas\n", maiorErroRegime, transicoes, falsos);
+    if (falsos || transicoes != degraus.size())
+        ok = false;
+
+    sim::definirRuidoBalanca(20, 0);
+    remove("bench_caixa.bin");
+    remove("bench_nvs.bin");
+    printf("%s\n", ok ? "ok: peso a cada conversao, sem alarmes falsos pelos picos" : "FALHA");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "mensagens.h"
+#include "quadroBinario.h"
+#include "fusao.h"
+#include "listaDeAcesso.h"
+
+// ====================================================================================
+// BENCHMARK DO QUADRO BINARIO
+// ====================================================================================
+// Tamanho e tempo de codificacao de cada mensagem em JSON (serializarJson) e no quadro
+// binario, tempo de decodificacao do quadro e verificacao de ida e volta.
+// Opcoes:
+//   --mensagens N   mensagens por medida (padrao 1000000)
+
+static char json[TAMANHO_MENSAGEM_MQTT];
+static uint8_t quadroBytes[QUADRO_TAMANHO_MAXIMO];
+static volatile uint32_t sumidouro;
+
+static const char *MOTIVOS[] = {"nenhum", "alteracao", "heartbeat"};
+
+static QuadroSafezone quadroDaMensagem(TipoQuadro tipo, uint32_t i)
+{
+    QuadroSafezone q = {};
+    q.tipo = tipo;
+    q.alarmes = i & 15;
+    q.no = 134;
+    q.sequencia = i;
+    q.timestamp = 1760000000 + i;
+    q.medidaGramas = (int32_t)(i % 20000);
+    q.distanciaCM = 20 + i % 800;
+    q.leituraLDR = i % 4096;
+    q.motivo = 1 + i % 2;
+    q.causaAlarme = q.alarmes & ALARME_FUSAO ? (uint8_t)(1 + i % (NUM_CAUSAS_ALARME - 1)) : (uint8_t)CAUSA_NENHUMA;
+    q.liberado = i & 8;
+    q.dedo = 1 + i % 162;
+    q.usuario = q.liberado ? 1000 + q.dedo : 0;
+    q.decisao = q.liberado ? 0 : (uint8_t)(1 + i % 6);
+    q.rssi = -40 - (int8_t)(i % 50);
+    q.conectadoS = 3600 + i;
+    q.reconexoes = i % 7;
+    q.quedas = i % 3;
+    return q;
+}
+
+static size_t codificarJson(const QuadroSafezone &q)
+{
+    switch (q.tipo)
+    {
+    case QUADRO_LEITURA:
+        return serializarJson<LayoutLeituraSensores>(json, (bool)(q.alarmes & ALARME_LUZ), (bool)(q.alarmes & ALARME_MOVIMENTO),
+                                                     (bool)(q.alarmes & ALARME_PRESSAO), MOTIVOS[q.motivo], q.timestamp, q.sequencia,
+                                                     (bool)(q.alarmes & ALARME_FUSAO), nomeCausaAlarme(q.causaAlarme));
+    case QUADRO_ACESSO:
+        return serializarJson<LayoutEventoAcesso>(json, q.liberado, q.timestamp, q.sequencia, q.dedo, q.usuario,
+                                                  nomeDecisaoAcesso((DecisaoAcesso)q.decisao));
+    default:
+        return serializarJson<LayoutQualidadeWiFi>(json, q.rssi, q.conectadoS, q.reconexoes, q.quedas, q.timestamp);
+    }
+}
+
+static bool iguais(const QuadroSafezone &a, const QuadroSafezone &b)
+{
+    bool cabecalho = a.tipo == b.tipo && a.alarmes == b.alarmes && a.no == b.no &&
+                     a.sequencia == b.sequencia && a.timestamp == b.timestamp;
+    switch (a.tipo)
+    {
+    case QUADRO_LEITURA:
+        return cabecalho && a.medidaGramas == b.medidaGramas && a.distanciaCM == b.distanciaCM &&
+               a.leituraLDR == b.leituraLDR && a.motivo == b.motivo && a.causaAlarme == b.causaAlarme;
+    case QUADRO_ACESSO:
+        return cabecalho && a.liberado == b.liberado && a.dedo == b.dedo && a.usuario == b.usuario &&
+               a.decisao == b.decisao;
+    default:
+        return cabecalho && a.rssi == b.rssi && a.conectadoS == b.conectadoS &&
+               a.reconexoes == b.reconexoes && a.quedas == b.quedas;
+    }
+}
+
+int benchBinario(int argc, char **argv)
+{
+    uint32_t mensagens = (uint32_t)opcaoNumero(argc, argv, "--mensagens", 1000000);
+    const TipoQuadro tipos[] = {QUADRO_LEITURA, QUADRO_ACESSO, QUADRO_WIFI};
+    const char *nomes[] = {"leitura sensores", "evento acesso", "qualidade wifi"};
+    bool idaEVolta = true;
+
+    printf("\n=== benchmark binario (%u mensagens por medida) ===\n", mensagens);
+    printf("%-17s %20s | %32s | %s\n", "", "JSON", "quadro binario", "decodificar");
+    for (int t = 0; t < 3; t++)
+    {
+        // Ida e volta, incluindo quadros truncados, leituras de 9 bytes e acessos de 1 byte
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            QuadroSafezone original = quadroDaMensagem(tipos[t], i * 7919);
+            QuadroSafezone lido;
+            size_t n = codificarQuadro(original, quadroBytes, sizeof(quadroBytes));
+            if (n == 0 || decodificarQuadro(quadroBytes, n, lido) != QUADRO_OK || !iguais(original, lido))
+                idaEVolta = false;
+            size_t curto = n - 1;
+            if (tipos[t] == QUADRO_LEITURA)
+            {
+                // Leitura antiga, sem a causa do alarme: continua valida
+                original.causaAlarme = CAUSA_NENHUMA;
+                if (decodificarQuadro(quadroBytes, curto, lido) != QUADRO_OK || !iguais(original, lido))
+                    idaEVolta = false;
+                curto--;
+            }
+            else if (tipos[t] == QUADRO_ACESSO)
+            {
+                // Acesso antigo, so com `liberado`: continua valido
+                original.dedo = original.usuario = 0;
+                original.decisao = QUADRO_DECISAO_DESCONHECIDA;
+                curto = QUADRO_TAMANHO_CABECALHO + 1;
+                if (decodificarQuadro(quadroBytes, curto, lido) != QUADRO_OK || !iguais(original, lido))
+                    idaEVolta = false;
+                curto--;
+            }
+            if (decodificarQuadro(quadroBytes, curto, lido) != QUADRO_CURTO)
+                idaEVolta = false;
+        }
+
+        uint64_t bytesJson = 0, bytesQuadro = 0;
+        uint64_t inicio = relogioHostNs();
+        for (uint32_t i = 0; i < mensagens; i++)
+        {
+            size_t n = codificarJson(quadroDaMensagem(tipos[t], i));
+            bytesJson += n;
+            sumidouro = sumidouro + (uint8_t)json[n / 2];
+        }
+        double nsJson = (double)(relogioHostNs() - inicio) / mensagens;
+
+        inicio = relogioHostNs();
+        for (uint32_t i = 0; i < mensagens; i++)
+        {
+            size_t n = codificarQuadro(quadroDaMensagem(tipos[t], i), quadroBytes, sizeof(quadroBytes));
+            bytesQuadro += n;
+            sumidouro = sumidouro + quadroBytes[n / 2];
+        }
+        double nsQuadro = (double)(relogioHostNs() - inicio) / mensagens;
+
+        QuadroSafezone lido;
+        size_t n = codificarQuadro(quadroDaMensagem(tipos[t], 134), quadroBytes, sizeof(quadroBytes));
+        inicio = relogioHostNs();
+        for (uint32_t i = 0; i < mensagens; i++)
+        {
+            quadroBytes[6] = (uint8_t)i; // Sequencia muda a cada volta
+            decodificarQuadro(quadroBytes, n, lido);
+            sumidouro = sumidouro + lido.sequencia;
+        }
+        double nsDecodificar = (double)(relogioHostNs() - inicio) / mensagens;
+
+        double mediaJson = (double)bytesJson / mensagens;
+        double mediaQuadro = (double)bytesQuadro / mensagens;
+        printf("%-17s %5.1f B %7.1f ns/msg | %5.1f B (%4.1fx menor) %7.1f ns/msg | %6.1f ns/msg\n",
+               nomes[t], mediaJson, nsJson, mediaQuadro, mediaJson / mediaQuadro, nsQuadro, nsDecodificar);
+    }
+
+    printf("ida e volta (quadros truncados e leituras antigas): %s\n", idaEVolta ? "ok" : "ERRO");
+    return idaEVolta ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "caixaDeSaida.h"
+#include "quadroBinario.h"
+
+// ====================================================================================
+// BENCHMARK DA CAIXA DE SAIDA
+// ====================================================================================
+// Um no fica offline por um tempo gerando eventos, perde a energia no meio de um lote
+// da recuperacao e, depois de reiniciar, termina de esvaziar a caixa no ritmo da tarefa
+// de rede (um passo a cada 10 ms). Mede a amplificacao de escrita e os apagamentos da
+// flash, o tempo para alcancar o broker e confere que nenhum evento se perdeu alem dos
+// que nao couberam no anel. Depois enche o anel alem da capacidade
+// para conferir o descarte dos mais antigos.
+// Opcoes:
+//   --offline-min N          tempo sem broker (padrao 60)
+//   --eventos-hora N         eventos gerados por hora (padrao 600)
+//   --lote N                 registros por lote (padrao 10, como no firmware)
+//   --intervalo-ms N         espera entre lotes (padrao 50, como no firmware)
+//   --custo-publicacao-ms N  tempo de cada publicacao (padrao 0.3)
+
+static const uint64_t S = 1000000;
+static const uint32_t PASSO_REDE_MS = 10;
+static const unsigned long CICLOS_SETOR = 100000; // Resistencia tipica da NOR flash
+
+static uint32_t custoPublicacaoUs = 300;
+static std::vector<uint32_t> recebidas;
+static size_t quedaDeEnergia = 0; // Publicacoes ate a queda (0: sem queda)
+
+static bool publicar(uint32_t sequencia, const uint8_t *dados, uint16_t tamanho)
+{
+    (void)dados;
+    (void)tamanho;
+    sim::avancarUs(custoPublicacaoUs);
+    recebidas.push_back(sequencia);
+    if (recebidas.size() == quedaDeEnergia)
+        sim::bloquearFlash(true); // A marca de entrega deste lote nao chega a ser gravada
+    return true;
+}
+
+// Mistura de eventos do firmware: leituras de sensores e tentativas de acesso.
+static size_t eventoDoCenario(uint32_t i, uint8_t *quadro)
+{
+    QuadroSafezone q = {};
+    q.tipo = i % 3 == 2 ? QUADRO_ACESSO : QUADRO_LEITURA;
+    q.alarmes = i & 7;
+    q.no = 134;
+    q.timestamp = 1760000000 + i;
+    q.medidaGramas = (int32_t)(i % 9000);
+    q.distanciaCM = 120;
+    q.leituraLDR = 50;
+    q.motivo = 1 + i % 2;
+    q.liberado = i & 1;
+    return codificarQuadro(q, quadro, QUADRO_TAMANHO_MAXIMO);
+}
+
+// Esvazia a caixa no ritmo da tarefa de rede, ate `limite` registros (0: todos).
+static uint64_t drenarNoRitmo(CaixaDeSaida &caixa, size_t limite, uint64_t &ocupadoUs)
+{
+    uint64_t inicio = sim::agoraUs();
+    while (caixa.pendentes() && (!limite || recebidas.size() < limite))
+    {
+        uint64_t antes = sim::agoraUs();
+        caixa.drenar(millis(), publicar);
+        ocupadoUs += sim::agoraUs() - antes;
+        delay(PASSO_REDE_MS);
+    }
+    return sim::agoraUs() - inicio;
+}
+
+int benchCaixa(int argc, char **argv)
+{
+    double offlineMin = opcaoNumero(argc, argv, "--offline-min", 60);
+    double eventosHora = opcaoNumero(argc, argv, "--eventos-hora", 600);
+    ConfiguracaoCaixaDeSaida configuracao;
+    configuracao.loteMaximo = (uint8_t)opcaoNumero(argc, argv, "--lote", 10);
+    configuracao.intervaloLoteMs = (uint16_t)opcaoNumero(argc, argv, "--intervalo-ms", 50);
+    custoPublicacaoUs = (uint32_t)(opcaoNumero(argc, argv, "--custo-publicacao-ms", 0.3) * 1000);
+
+    uint32_t eventos = (uint32_t)(offlineMin / 60 * eventosHora);
+    uint64_t espacamento = (uint64_t)(3600 * S / eventosHora);
+    uint8_t quadro[QUADRO_TAMANHO_MAXIMO];
+    bool ok = true;
+
+    printf("\n=== benchmark caixa de saida ===\n");
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+
+    // ------------------- OFFLINE: SO GRAVACAO -------------------
+    CaixaDeSaida caixa(configuracao);
+    caixa.iniciar();
+    sim::EstatisticasFlash antes = sim::flash();
+    unsigned long bytesEventos = 0;
+    uint64_t tempoAnexar = 0;
+    for (uint32_t i = 0; i < eventos; i++)
+    {
+        size_t n = eventoDoCenario(i, quadro);
+        bytesEventos += n;
+        uint64_t t0 = sim::agoraUs();
+        if (!caixa.anexar(quadro, n))
+            ok = false;
+        tempoAnexar += sim::agoraUs() - t0;
+        sim::avancarUs(espacamento);
+    }
+    sim::EstatisticasFlash depois = sim::flash();
+    unsigned long escritos = depois.bytesEscritos - antes.bytesEscritos;
+    unsigned long apagados = depois.setoresApagados - antes.setoresApagados;
+    printf("offline %.0f min: %u eventos (%lu bytes), anel de %lu KB\n", offlineMin, eventos, bytesEventos,
+           (unsigned long)caixa.capacidadeBytes() / 1024);
+    printf("  flash: %lu bytes escritos (%.2fx os eventos), %lu setores apagados, %.2f ms por evento\n",
+           escritos, (double)escritos / bytesEventos, apagados, eventos ? tempoAnexar / 1000.0 / eventos : 0.0);
+    if (caixa.estatisticas().perdidos)
+        printf("  anel cheio: %lu eventos mais antigos descartados\n", caixa.estatisticas().perdidos);
+
+    // ------------------- RECONEXAO COM QUEDA DE ENERGIA NO MEIO -------------------
+    recebidas.clear();
+    uint64_t ocupadoUs = 0;
+    CaixaDeSaida antesDoReinicio(configuracao);
+    antesDoReinicio.iniciar();
+    if (antesDoReinicio.pendentes() != eventos - caixa.estatisticas().perdidos)
+        ok = false;
+    quedaDeEnergia = eventos / 3 + configuracao.loteMaximo / 2;
+    uint64_t recuperacao = drenarNoRitmo(antesDoReinicio, quedaDeEnergia, ocupadoUs);
+    size_t entreguesAntes = recebidas.size();
+    quedaDeEnergia = 0;
+    sim::bloquearFlash(false);
+
+    CaixaDeSaida aposReinicio(configuracao);
+    aposReinicio.iniciar();
+    uint32_t pendentesAposReinicio = aposReinicio.pendentes();
+    antes = sim::flash();
+    recuperacao += drenarNoRitmo(aposReinicio, 0, ocupadoUs);
+    depois = sim::flash();
+
+    std::vector<bool> vistas(eventos + 1, false);
+    size_t repetidas = 0;
+    for (uint32_t sequencia : recebidas)
+    {
+        if (sequencia == 0 || sequencia > eventos)
+            ok = false;
+        else if (vistas[sequencia])
+            repetidas++;
+        else
+            vistas[sequencia] = true;
+    }
+    size_t faltando = std::count(vistas.begin() + 1, vistas.end(), false);
+    if (faltando != caixa.estatisticas().perdidos || repetidas > configuracao.loteMaximo)
+        ok = false;
+
+    double recuperacaoS = recuperacao / 1e6;
+    printf("reconexao: queda de energia apos %zu entregas, %u pendentes na volta\n", entreguesAntes, pendentesAposReinicio);
+    printf("  %zu publicacoes (%zu repetidas, %zu faltando) em %.2f s simulados: %.0f msg/s\n",
+           recebidas.size(), repetidas, faltando, recuperacaoS, recebidas.size() / recuperacaoS);
+    printf("  tarefa de rede ocupada %.1f%% do tempo; %lu marcas de entrega (1 byte cada)\n",
+           100.0 * ocupadoUs / recuperacao, depois.escritas - antes.escritas);
+
+    // ------------------- DESGASTE -------------------
+    double bytesHora = eventos ? (double)escritos / eventos * eventosHora : 0;
+    double voltasAno = bytesHora * 24 * 365 / caixa.capacidadeBytes();
+    printf("desgaste a %.0f eventos/h: %.1f KB/h, %.0f apagamentos/ano por setor (%.0f anos ate %lu ciclos)\n",
+           eventosHora, bytesHora / 1024, voltasAno, voltasAno > 0 ? CICLOS_SETOR / voltasAno : 0.0, CICLOS_SETOR);
+
+    // ------------------- ANEL CHEIO -------------------
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    CaixaDeSaida cheia(configuracao);
+    cheia.iniciar();
+    uint32_t excesso = cheia.capacidadeBytes() / 16; // Bem mais registros que o anel comporta
+    for (uint32_t i = 0; i < excesso; i++)
+        cheia.anexar(quadro, eventoDoCenario(i, quadro));
+
+    CaixaDeSaida cheiaAposReinicio(configuracao);
+    cheiaAposReinicio.iniciar();
+    uint32_t sobreviventes = cheiaAposReinicio.pendentes();
+    recebidas.clear();
+    drenarNoRitmo(cheiaAposReinicio, 0, ocupadoUs);
+    bool contiguas = !recebidas.empty() && recebidas.back() == excesso;
+    for (size_t i = 1; i < recebidas.size(); i++)
+        contiguas = contiguas && recebidas[i] == recebidas[i - 1] + 1;
+    if (!contiguas || cheia.estatisticas().perdidos + recebidas.size() != excesso)
+        ok = false;
+    printf("anel cheio: %u eventos, %lu mais antigos descartados, %u entregues apos reinicio (%s)\n",
+           excesso, cheia.estatisticas().perdidos, sobreviventes, contiguas ? "contiguos ate o mais novo" : "ERRO");
+
+    remove("bench_caixa.bin");
+    printf("%s\n", ok ? "ok: nenhum evento perdido fora do anel cheio, repetidos so do lote interrompido" : "FALHA");
+    return ok ? 0 : 1;
+}
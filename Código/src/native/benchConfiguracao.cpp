@@ -0,0 +1,265 @@
+#include <Arduino.h>
+#include <atomic>
+#include <thread>
+#include "bancada.h"
+#include "simulador.h"
+#include "configuracao.h"
+#include "Monitoramento.h"
+
+// ====================================================================================
+// BENCHMARK DA CONFIGURACAO EM TEMPO DE EXECUCAO
+// ====================================================================================
+// Mede o custo da leitura da configuracao no caminho quente (sem mudanca e com a copia
+// inteira) e executa o firmware (loop() cooperativo) recebendo ajustes pelo broker:
+//   - com 4 kg na balanca, baixa o limiar de peso para 3 kg e mede o tempo ate a
+//     configuracao vigente ser publicada e ate o alarme de pressao ligar, sem reiniciar;
+//   - mensagens invalidas (campo fora da faixa, campo desconhecido, JSON quebrado) sao
+//     recusadas inteiras, sem mudar a geracao;
+//   - desarmado ({"armado":0}) alguem parado na frente do sensor nao dispara o alarme
+//     fundido; armado de novo, dispara;
+//   - a configuracao volta da NVS num reinicio, e uma gravacao que falha (queda de
+//     energia) nao muda o que volta;
+//   - um escritor trocando a configuracao sem parar contra leitores em outras threads:
+//     nenhuma copia pode misturar campos de duas configuracoes.
+// Opcoes:
+//   --leituras N   leituras por medida de custo (padrao 10000000)
+//   --trocas N     trocas do escritor no teste entre threads (padrao 20000)
+//   --leitores N   threads leitoras (padrao 2)
+
+static const uint64_t S = 1000000;
+static const char *TOPICO = "safezone-config/134";
+static const char *TOPICO_EFETIVA = "safezone-config/134/efetiva";
+
+static volatile int32_t sumidouro;
+static uint64_t instanteEfetiva = 0;
+static char statusEfetiva[64] = "";
+
+static void aoPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    if (strcmp(topico, TOPICO_EFETIVA) != 0)
+        return;
+    instanteEfetiva = sim::agoraUs();
+    statusEfetiva[0] = '\0';
+    std::string payload((const char *)dados, tamanho);
+    size_t inicio = payload.find("\"status\":\"");
+    if (inicio == std::string::npos)
+        return;
+    inicio += 10;
+    size_t fim = payload.find('"', inicio);
+    snprintf(statusEfetiva, sizeof(statusEfetiva), "%s", payload.substr(inicio, fim - inicio).c_str());
+}
+
+static void rodar(uint64_t duracao)
+{
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+}
+
+// Publica no topico do no e roda o firmware ate a resposta (ou 2 s).
+static uint64_t enviar(const char *payload)
+{
+    instanteEfetiva = 0;
+    uint64_t inicio = sim::agoraUs();
+    sim::publicarNoBroker(TOPICO, payload, false);
+    while (!instanteEfetiva && sim::agoraUs() - inicio < 2 * S)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+    return instanteEfetiva ? instanteEfetiva - inicio : 0;
+}
+
+// ------------------- CUSTO DA LEITURA -------------------
+static void medirLeitura(uint64_t leituras)
+{
+    ConfiguracaoSafezone copia;
+    uint32_t geracao = 0;
+    atualizarConfiguracao(copia, geracao);
+
+    uint64_t t0 = relogioHostNs();
+    for (uint64_t i = 0; i < leituras; i++)
+    {
+        atualizarConfiguracao(copia, geracao);
+        sumidouro = copia.limiarPesoG;
+    }
+    double semMudanca = (double)(relogioHostNs() - t0) / leituras;
+
+    t0 = relogioHostNs();
+    for (uint64_t i = 0; i < leituras; i++)
+        sumidouro = configuracaoAtual().limiarPesoG;
+    double copiaInteira = (double)(relogioHostNs() - t0) / leituras;
+
+    printf("leitura: %.1f ns sem mudanca (atualizarConfiguracao), %.1f ns copiando %zu bytes (configuracaoAtual)\n",
+           semMudanca, copiaInteira, sizeof(ConfiguracaoSafezone));
+}
+
+// ------------------- ESCRITOR X LEITORES -------------------
+// Duas configuracoes que diferem em todos os campos: uma copia rasgada nao e igual a
+// nenhuma das duas.
+static bool testarThreads(unsigned long trocas, unsigned leitores)
+{
+    ConfiguracaoSafezone a = CONFIGURACAO_PADRAO, b = CONFIGURACAO_PADRAO;
+    aplicarConfiguracao(a);
+    b.limiarPesoG = 6000;
+    b.histeresePesoG = 700;
+    b.limiarDistanciaMM = 350;
+    b.histereseDistanciaMM = 80;
+    b.limiarLuz = 60;
+    b.limiarLuzPercentual = 30;
+    b.intervaloMs[0] = 10;
+    b.intervaloMs[1] = 15;
+    b.intervaloMs[2] = 250;
+    b.intervaloBordaMs = 2000;
+    b.heartbeatMs = 30000;
+    b.destravamentoMs = 5000;
+    b.desarmeMs = 20000;
+    b.contagensPorKg = 42000;
+
+    std::atomic<bool> parar{false};
+    std::atomic<unsigned long> leituras{0}, rasgadas{0}, mudancas{0};
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < leitores; i++)
+        threads.emplace_back([&]
+                             {
+            ConfiguracaoSafezone copia;
+            uint32_t geracao = 0;
+            unsigned long n = 0, r = 0, m = 0;
+            while (!parar.load(std::memory_order_relaxed))
+            {
+                if (atualizarConfiguracao(copia, geracao))
+                {
+                    m++;
+                    if (memcmp(&copia, &a, sizeof(a)) != 0 && memcmp(&copia, &b, sizeof(b)) != 0)
+                        r++;
+                }
+                ConfiguracaoSafezone atual = configuracaoAtual();
+                if (memcmp(&atual, &a, sizeof(a)) != 0 && memcmp(&atual, &b, sizeof(b)) != 0)
+                    r++;
+                n++;
+            }
+            leituras += n;
+            rasgadas += r;
+            mudancas += m; });
+
+    uint64_t t0 = relogioHostNs();
+    unsigned long aplicadas = 0;
+    for (unsigned long i = 0; i < trocas; i++)
+        aplicadas += aplicarConfiguracao(i % 2 ? a : b) == CONFIGURACAO_APLICADA;
+    parar = true;
+    for (std::thread &t : threads)
+        t.join();
+    double segundos = (relogioHostNs() - t0) / 1e9;
+
+    printf("threads: %lu trocas (%lu gravadas) em %.2f s contra %u leitores: %lu leituras, %lu mudancas vistas, %lu copias rasgadas\n",
+           trocas, aplicadas, segundos, leitores, leituras.load(), mudancas.load(), rasgadas.load());
+    return rasgadas == 0 && aplicadas == trocas;
+}
+
+int benchConfiguracao(int argc, char **argv)
+{
+    uint64_t leituras = (uint64_t)opcaoNumero(argc, argv, "--leituras", 10000000);
+    unsigned long trocas = (unsigned long)opcaoNumero(argc, argv, "--trocas", 20000);
+    unsigned leitores = (unsigned)opcaoNumero(argc, argv, "--leitores", 2);
+    bool ok = true;
+
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::aoPublicar(aoPublicar);
+    setup();
+    rodar(5 * S); // Wi-Fi e MQTT conectados, assinaturas feitas, filtro da balanca assentado
+
+    printf("\n=== benchmark configuracao ===\n");
+    medirLeitura(leituras);
+
+    // ------------------- AJUSTE PELO BROKER -------------------
+    sim::definirPeso(4.0f);
+    rodar(2 * S);
+    bool antes = leituraMonitoramento().alarmePressao;
+    uint32_t geracao = geracaoConfiguracao();
+
+    uint64_t inicio = sim::agoraUs();
+    uint64_t efetiva = enviar("{\"limiar_peso_g\":3000,\"histerese_peso_g\":300}");
+    bool aplicada = strcmp(statusEfetiva, "aplicada") == 0;
+    while (!leituraMonitoramento().alarmePressao && sim::agoraUs() - inicio < 5 * S)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+    uint64_t alarme = leituraMonitoramento().alarmePressao ? sim::agoraUs() - inicio : 0;
+    bool certo = !antes && aplicada && alarme && geracaoConfiguracao() == geracao + 1;
+    ok = ok && certo;
+    printf("4 kg, limiar 5 kg -> 3 kg: configuracao vigente publicada em %.1f ms (%s), alarme de pressao em %.1f ms: %s\n",
+           efetiva / 1e3, statusEfetiva, alarme / 1e3, certo ? "ok" : "ERRO");
+
+    // ------------------- MENSAGENS INVALIDAS -------------------
+    const char *invalidas[] = {
+        "{\"limiar_peso_g\":4000,\"heartbeat_ms\":10}",
+        "{\"limiar_peso_g\":4000,\"limiar_fantasma\":1}",
+        "{\"limiar_peso_g\":4000,\"histerese_peso_g\":5000}",
+        "{\"limiar_peso_g\":4000.5}",
+        "{\"limiar_peso_g\":",
+    };
+    for (const char *payload : invalidas)
+    {
+        geracao = geracaoConfiguracao();
+        enviar(payload);
+        certo = strncmp(statusEfetiva, "invalida", 8) == 0 && geracaoConfiguracao() == geracao &&
+                configuracaoAtual().limiarPesoG == 3000;
+        ok = ok && certo;
+        printf("invalida %-50s -> %-28s %s\n", payload, statusEfetiva, certo ? "ok" : "ERRO");
+    }
+    enviar("{\"limiar_peso_g\":3000}");
+    certo = strcmp(statusEfetiva, "sem mudanca") == 0;
+    ok = ok && certo;
+    printf("repetida: %s %s\n", statusEfetiva, certo ? "ok" : "ERRO");
+
+    // ------------------- ARMAR E DESARMAR -------------------
+    enviar("{\"armado\":0}");
+    certo = strcmp(statusEfetiva, "aplicada") == 0 && configuracaoAtual().armado == 0;
+    sim::definirDistanciaMM(300); // Presenca: parado a 30 cm
+    rodar(7 * S);
+    bool desarmado = !leituraMonitoramento().alarme;
+    enviar("{\"armado\":1}");
+    sim::definirDistanciaMM(1000); // Armada, a regra so conta uma presenca nova
+    rodar(1 * S);
+    sim::definirDistanciaMM(300);
+    rodar(7 * S);
+    bool armado = leituraMonitoramento().alarme;
+    sim::definirDistanciaMM(1000);
+    certo = certo && desarmado && armado && configuracaoAtual().armado == 1;
+    ok = ok && certo;
+    printf("presenca desarmado: %s, armado: %s %s\n", desarmado ? "sem alarme" : "alarme",
+           armado ? "alarme" : "sem alarme", certo ? "ok" : "ERRO");
+
+    // ------------------- NVS -------------------
+    ConfiguracaoSafezone gravada = configuracaoAtual();
+    bool daNvs = iniciarConfiguracao(CONFIGURACAO_PADRAO);
+    ConfiguracaoSafezone lida = configuracaoAtual();
+    certo = daNvs && memcmp(&gravada, &lida, sizeof(gravada)) == 0;
+    ok = ok && certo;
+    printf("reinicio: configuracao %s: %s\n", daNvs ? "lida da NVS" : "padrao", certo ? "ok" : "ERRO");
+
+    sim::bloquearFlash(true);
+    ConfiguracaoSafezone nova = gravada;
+    nova.destravamentoMs = 4000;
+    ResultadoConfiguracao resultado = aplicarConfiguracao(nova);
+    sim::bloquearFlash(false);
+    iniciarConfiguracao(CONFIGURACAO_PADRAO);
+    certo = resultado == CONFIGURACAO_NAO_GRAVADA && configuracaoAtual().destravamentoMs == gravada.destravamentoMs;
+    ok = ok && certo;
+    printf("queda de energia na gravacao: %s, depois do reinicio destravamento %ld ms: %s\n",
+           nomeResultadoConfiguracao(resultado), (long)configuracaoAtual().destravamentoMs, certo ? "ok" : "ERRO");
+
+    // ------------------- ESCRITOR X LEITORES -------------------
+    sim::aoPublicar(nullptr);
+    ok = testarThreads(trocas, leitores) && ok;
+
+    printf("%s\n", ok ? "ok: ajuste aplicado sem reiniciar, invalidas recusadas, NVS e copias consistentes" : "FALHA");
+    remove("bench_caixa.bin");
+    remove("bench_nvs.bin");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include <Arduino.h>
+#include <math.h>
+#include <string>
+#include "bancada.h"
+#include "simulador.h"
+#include "diagnostico.h"
+#include "particaoQuente.h"
+
+// ====================================================================================
+// BENCHMARK DO PERFIL DAS ETAPAS E DO DIAGNOSTICO
+// ====================================================================================
+// 1) Precisao do histograma log-linear: p50, p99 e maximo contra os valores exatos
+//    (Amostras ordenadas) em distribuicoes sinteticas de duracoes em ciclos.
+// 2) Firmware (loop() cooperativo) contra o cenario do benchmark "loop": confere as
+//    mensagens do topico de diagnostico (todas as etapas medidas em alguma janela, menos
+//    a busca na particao quente se ela estiver desligada; heap e passos por segundo das
+//    tarefas) e mostra a ultima.
+// 3) Custo de registrar uma medida e de um par marcarEtapa()/medirEtapa() no host
+//    (no ESP32 o contador de ciclos e um registrador; aqui passa pelo relogio simulado).
+// Opcoes:
+//   --amostras N    amostras por distribuicao (padrao 1000000)
+//   --duracao-s N   tempo simulado do firmware (padrao 180)
+// Com -D SAFEZONE_PERFIL=0 so a parte 1 roda: o firmware nao mede nem publica nada.
+
+static const uint64_t S = 1000000;
+static const char *TOPICO_DIAGNOSTICO = "safezone/134/diag";
+
+extern ParticaoQuente particaoQuente;
+
+static volatile uint32_t sumidouro;
+static std::vector<std::string> mensagens;
+
+// ------------------- PRECISAO -------------------
+
+static uint32_t sortear(uint32_t &semente)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+static double uniforme(uint32_t &semente)
+{
+    return (sortear(semente) + 0.5) / 4294967296.0;
+}
+
+// Normal padrao (Box-Muller)
+static double normal(uint32_t &semente)
+{
+    return sqrt(-2 * log(uniforme(semente))) * cos(2 * M_PI * uniforme(semente));
+}
+
+enum Distribuicao
+{
+    UNIFORME,    // 100 a 10000 ciclos
+    LOG_NORMAL,  // Mediana de 2400 ciclos (10 us), cauda longa
+    BIMODAL,     // 98% rapidas (~500 ciclos), 2% lentas (~2 ms, uma publicacao)
+    NUM_DISTRIBUICOES
+};
+
+static const char *NOMES_DISTRIBUICOES[NUM_DISTRIBUICOES] = {"uniforme", "log-normal", "bimodal"};
+
+static uint32_t gerar(Distribuicao d, uint32_t &semente)
+{
+    switch (d)
+    {
+    case UNIFORME:
+        return 100 + sortear(semente) % 9901;
+    case LOG_NORMAL:
+        return (uint32_t)(2400 * exp(1.2 * normal(semente)));
+    default:
+        if (sortear(semente) % 100 < 98)
+            return 400 + sortear(semente) % 200;
+        return 480000 + sortear(semente) % 20000;
+    }
+}
+
+static double erroRelativo(uint64_t medido, uint64_t exato)
+{
+    return exato ? fabs((double)medido - (double)exato) / exato : 0;
+}
+
+static bool medirPrecisao(uint32_t amostras)
+{
+    static HistogramaLogLinear histograma; // ~1 KB: fora da pilha
+    bool ok = true;
+    printf("%-12s %10s %10s %8s %10s %10s %8s %10s\n", "ciclos", "p50", "exato", "erro", "p99", "exato", "erro", "max");
+    for (uint8_t d = 0; d < NUM_DISTRIBUICOES; d++)
+    {
+        histograma.zerar();
+        Amostras exatas;
+        exatas.reservar(amostras);
+        uint32_t semente = 134 + d;
+        for (uint32_t i = 0; i < amostras; i++)
+        {
+            uint32_t valor = gerar((Distribuicao)d, semente);
+            histograma.registrar(valor);
+            exatas.registrar(valor);
+        }
+
+        uint32_t p50 = histograma.percentil(50), p99 = histograma.percentil(99);
+        uint64_t e50 = exatas.percentil(50), e99 = exatas.percentil(99);
+        double erro50 = erroRelativo(p50, e50), erro99 = erroRelativo(p99, e99);
+        // Ponto medio de uma faixa de 1/8 da potencia de 2: no maximo 1/16 de erro
+        bool certo = erro50 <= 1.0 / 16 && erro99 <= 1.0 / 16 && histograma.maximo() == exatas.maximo() &&
+                     histograma.amostras() == amostras;
+        ok = ok && certo;
+        printf("%-12s %10lu %10llu %7.2f%% %10lu %10llu %7.2f%% %10lu %s\n", NOMES_DISTRIBUICOES[d],
+               (unsigned long)p50, (unsigned long long)e50, erro50 * 100, (unsigned long)p99,
+               (unsigned long long)e99, erro99 * 100, (unsigned long)histograma.maximo(), certo ? "ok" : "ERRO");
+    }
+    printf("memoria: %zu bytes por etapa, %zu no total (%u etapas)\n", sizeof(HistogramaLogLinear),
+           sizeof(HistogramaLogLinear) * NUM_ETAPAS, (unsigned)NUM_ETAPAS);
+    return ok;
+}
+
+// ------------------- CUSTO -------------------
+
+static void medirCusto(uint32_t amostras)
+{
+    static HistogramaLogLinear histograma;
+    uint32_t semente = 7;
+    std::vector<uint32_t> valores(4096);
+    for (uint32_t &valor : valores)
+        valor = gerar(LOG_NORMAL, semente);
+
+    uint64_t t0 = relogioHostNs();
+    for (uint32_t i = 0; i < amostras; i++)
+        histograma.registrar(valores[i & 4095]);
+    double registrar = (double)(relogioHostNs() - t0) / amostras;
+
+    // O par completo, como no firmware: aqui inclui duas leituras do relogio simulado
+    uint32_t pares = amostras / 10;
+    t0 = relogioHostNs();
+    for (uint32_t i = 0; i < pares; i++)
+    {
+        uint32_t marca = marcarEtapa();
+        sumidouro += i;
+        medirEtapa(ETAPA_FUSAO, marca);
+    }
+    double par = (double)(relogioHostNs() - t0) / pares;
+    printf("custo: %.1f ns por registro no histograma, %.1f ns por par marcarEtapa()/medirEtapa() (relogio simulado)\n",
+           registrar, par);
+}
+
+// ------------------- FIRMWARE -------------------
+
+static void aoPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    if (strcmp(topico, TOPICO_DIAGNOSTICO) == 0)
+        mensagens.emplace_back((const char *)dados, tamanho);
+}
+
+// [amostras, p50, p99, max] da etapa na mensagem; false se nao estiver la.
+static bool lerEtapa(const std::string &mensagem, const char *nome, unsigned long &amostras, float valores[3])
+{
+    std::string chave = std::string("\"") + nome + "\":[";
+    size_t posicao = mensagem.find(chave);
+    if (posicao == std::string::npos)
+        return false;
+    return sscanf(mensagem.c_str() + posicao + chave.size(), "%lu,%f,%f,%f", &amostras, &valores[0], &valores[1],
+                  &valores[2]) == 4;
+}
+
+static bool lerNumero(const std::string &mensagem, const char *nome, double &valor)
+{
+    std::string chave = std::string("\"") + nome + "\":";
+    size_t posicao = mensagem.find(chave);
+    return posicao != std::string::npos && sscanf(mensagem.c_str() + posicao + chave.size(), "%lf", &valor) == 1;
+}
+
+static bool executarFirmware(uint64_t duracao)
+{
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::aoPublicar(aoPublicar);
+    setup();
+    uint64_t inicio = sim::agoraUs();
+    montarCenario(inicio, duracao);
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+    sim::aoPublicar(nullptr);
+
+    // Cada etapa precisa aparecer com medidas em alguma janela
+    unsigned long totais[NUM_ETAPAS] = {};
+    bool formato = !mensagens.empty();
+    for (const std::string &mensagem : mensagens)
+    {
+        for (uint8_t i = 0; i < NUM_ETAPAS; i++)
+        {
+            unsigned long n = 0;
+            float valores[3];
+            formato = formato && lerEtapa(mensagem, nomeEtapa((EtapaPerfil)i), n, valores);
+            totais[i] += n;
+        }
+        double heap = 0, heapMinimo = 0, rede = 0, sensores = 0, acesso = 0;
+        formato = formato && lerNumero(mensagem, "heap", heap) && lerNumero(mensagem, "heap_min", heapMinimo) &&
+                  heap > 0 && heapMinimo > 0 && lerNumero(mensagem, "rede", rede) && rede > 0 &&
+                  lerNumero(mensagem, "sensores", sensores) && sensores > 0 &&
+                  lerNumero(mensagem, "acesso", acesso) && acesso > 0;
+    }
+    // A busca na particao quente so acontece com -D SAFEZONE_PARTICAO_QUENTE
+    bool todas = true;
+    for (uint8_t i = 0; i < NUM_ETAPAS; i++)
+        todas = todas && (totais[i] > 0 || (i == ETAPA_BUSCA_QUENTE && !particaoQuente.ativa()));
+
+    printf("firmware: %zu mensagens de diagnostico em %.0f s (%zu a %zu bytes), formato %s, todas as etapas medidas: %s\n",
+           mensagens.size(), duracao / 1e6,
+           mensagens.empty() ? 0 : std::min_element(mensagens.begin(), mensagens.end(), [](const std::string &a, const std::string &b)
+                                                     { return a.size() < b.size(); })->size(),
+           mensagens.empty() ? 0 : std::max_element(mensagens.begin(), mensagens.end(), [](const std::string &a, const std::string &b)
+                                                     { return a.size() < b.size(); })->size(),
+           formato ? "ok" : "ERRO", todas ? "ok" : "ERRO");
+
+    if (!mensagens.empty())
+    {
+        const std::string &ultima = mensagens.back();
+        printf("ultima janela:\n  %-16s %9s %10s %10s %10s\n", "etapa", "medidas", "p50 us", "p99 us", "max us");
+        for (uint8_t i = 0; i < NUM_ETAPAS; i++)
+        {
+            unsigned long n = 0;
+            float valores[3] = {};
+            lerEtapa(ultima, nomeEtapa((EtapaPerfil)i), n, valores);
+            printf("  %-16s %9lu %10.1f %10.1f %10.1f\n", nomeEtapa((EtapaPerfil)i), n, valores[0], valores[1], valores[2]);
+        }
+        printf("  %s\n", ultima.substr(ultima.find("\"heap\"")).c_str());
+    }
+
+    remove("bench_caixa.bin");
+    remove("bench_nvs.bin");
+    return formato && todas;
+}
+
+int benchDiagnostico(int argc, char **argv)
+{
+    uint32_t amostras = (uint32_t)opcaoNumero(argc, argv, "--amostras", 1000000);
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 180) * S);
+    bool ok = true;
+
+    printf("\n=== benchmark diagnostico (SAFEZONE_PERFIL=%d) ===\n", SAFEZONE_PERFIL);
+    ok = medirPrecisao(amostras) && ok;
+    if (SAFEZONE_PERFIL)
+    {
+        ok = executarFirmware(duracao) && ok;
+        medirCusto(amostras); // Depois: os pares caem no histograma de uma etapa
+    }
+
+    if (!ok)
+        printf("FALHA\n");
+    else
+        printf("ok: percentis dentro de 1/16%s\n", SAFEZONE_PERFIL ? ", diagnostico publicado com todas as etapas" : "");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "sensorDeDigitais.h"
+
+// ====================================================================================
+// BENCHMARK DA VERIFICACAO DE DIGITAIS
+// ====================================================================================
+// Dirige a verificacao assincrona do FingerprintSensor contra o modulo simulado, sem o
+// restante do loop(), e mede o custo de cada chamada de pollVerification() e o tempo
+// do inicio da verificacao ate a decisao.
+// Opcoes:
+//   --tentativas N     numero de verificacoes (padrao 200)
+//   --timeout-ms N     timeout de captura (padrao 2000)
+//   --limite-poll-ms N falha (codigo 1) se alguma chamada passar de N ms (padrao 10)
+
+extern FingerprintSensor sensorDigital;
+
+int benchDigitais(int argc, char **argv)
+{
+    int tentativas = (int)opcaoNumero(argc, argv, "--tentativas", 200);
+    unsigned long timeoutMs = (unsigned long)opcaoNumero(argc, argv, "--timeout-ms", 2000);
+    double limitePollMs = opcaoNumero(argc, argv, "--limite-poll-ms", 10);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    Serial.begin(9600);
+    if (!sensorDigital.begin(57600))
+    {
+        printf("Sensor de digitais simulado nao respondeu.\n");
+        return 1;
+    }
+    sensorDigital.setCaptureTimeout(timeoutMs);
+    for (uint16_t id = 1; id <= 20; id++)
+        sim::cadastrarDigital(id);
+
+    Amostras poll;
+    Amostras decisao;
+    int liberados = 0, negados = 0, semDedo = 0;
+    srand(134);
+
+    for (int i = 0; i < tentativas; i++)
+    {
+        // Dedo cadastrado, nao cadastrado ou ausente, colocado de 0 a 1 s depois.
+        int tipo = rand() % 10;
+        uint64_t inicio = sim::agoraUs();
+        if (tipo < 8)
+        {
+            uint16_t dedo = tipo < 6 ? (uint16_t)(rand() % 20 + 1) : 0;
+            sim::agendar(inicio + (uint64_t)(rand() % 1000) * 1000, [dedo]
+                         { sim::definirDedo(true, dedo); });
+        }
+
+        sensorDigital.startVerification();
+        bool terminou = false;
+        while (!terminou)
+        {
+            uint64_t antes = sim::agoraUs();
+            terminou = sensorDigital.pollVerification();
+            poll.registrar(sim::agoraUs() - antes);
+            sim::avancarUs(200); // Restante de uma passagem do loop()
+        }
+        decisao.registrar((sim::agoraUs() - inicio) / 1000);
+
+        if (sensorDigital.isAccessGranted())
+            liberados++;
+        else if (sensorDigital.verificationResult() == FINGERPRINT_NOFINGER)
+            semDedo++;
+        else
+            negados++;
+
+        sim::definirDedo(false);
+        sim::avancarUs(100000);
+    }
+
+    printf("\n=== benchmark digitais ===\n");
+    printf("verificacoes: %d (%d liberadas, %d negadas, %d sem dedo)\n",
+           tentativas, liberados, negados, semDedo);
+    poll.imprimir("pollVerification():", "us");
+    decisao.imprimir("inicio ate decisao:", "ms");
+
+    if (limitePollMs > 0 && poll.maximo() > limitePollMs * 1000)
+    {
+        printf("FALHA: pollVerification() acima de %.1f ms\n", limitePollMs);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "Monitoramento.h"
+#include "amostragem.h"
+#include "configuracao.h"
+
+// ====================================================================================
+// BENCHMARK DO SENSOR DE MOVIMENTO (VL53L0X CONTINUO)
+// ====================================================================================
+// Com so o caminho do movimento ligado em atualizarMonitoramento(), um vulto entra e
+// sai do alcance repetidamente e, para cada perfil de tempo, mede: custo por chamada
+// (sem medida nova e com medida nova, em tempo simulado: inclui o I2C modelado),
+// medidas lidas por segundo, atraso ate o alarme e o tratamento das medidas fora de
+// alcance (nenhuma pode virar distancia nem alarme).
+// Opcoes:
+//   --duracao-s N   tempo simulado por perfil (padrao 60)
+//   --passo-us N    tempo ocioso entre chamadas (padrao 200)
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const int32_t INTERVALO_LONGO_MS = 60000; // Pressao e luz quase paradas
+static const char *NOMES_PERFIS[NUM_PERFIS_DISTANCIA] = {"rapido", "padrao", "longo"};
+
+// Ciclo de 4 s: longe (fora de alcance), se aproximando, perto (alarme), se afastando.
+struct Trecho
+{
+    uint64_t inicio;
+    uint16_t mm;
+};
+static const Trecho CICLO[] = {{0, 3000}, {1000 * MS, 900}, {2000 * MS, 300}, {3000 * MS, 900}};
+static const uint64_t DURACAO_CICLO = 4 * S;
+
+int benchDistancia(int argc, char **argv)
+{
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 60) * S);
+    uint64_t passo = (uint64_t)opcaoNumero(argc, argv, "--passo-us", 200);
+    bool ok = true;
+
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    setup();
+    loop();
+    ConfiguracaoSafezone configuracao = configuracaoAtual();
+    configuracao.intervaloMs[AMOSTRA_PRESSAO] = INTERVALO_LONGO_MS;
+    configuracao.intervaloMs[AMOSTRA_LUZ] = INTERVALO_LONGO_MS;
+    aplicarConfiguracao(configuracao);
+
+    printf("\n=== benchmark distancia (VL53L0X continuo) ===\n");
+    for (uint8_t perfil = 0; perfil < NUM_PERFIS_DISTANCIA; perfil++)
+    {
+        definirPerfilDistancia((PerfilDistancia)perfil);
+        atualizarMonitoramento(); // Aplica o perfil fora da medicao
+
+        uint64_t inicio = sim::agoraUs();
+        for (uint64_t t = 0; t < duracao; t += DURACAO_CICLO)
+            for (const Trecho &trecho : CICLO)
+            {
+                uint16_t mm = trecho.mm;
+                sim::agendar(inicio + t + trecho.inicio, [mm]
+                             { sim::definirDistanciaMM(mm); });
+            }
+
+        Amostras custoPendente, custoNova, atrasoAlarme;
+        unsigned long foraDeAlcance = 0, inventadas = 0, alarmesFalsos = 0;
+        uint64_t cicloAlarmado = UINT64_MAX;
+        bool alarmeAnterior = leituraMonitoramento().alarmeMovimento;
+        while (sim::agoraUs() - inicio < duracao)
+        {
+            sim::avancarUs(passo);
+            uint64_t t0 = sim::agoraUs();
+            bool leu = atualizarMonitoramento();
+            uint64_t custo = sim::agoraUs() - t0;
+            (leu ? custoNova : custoPendente).registrar(custo);
+            if (!leu)
+                continue;
+
+            uint64_t noCiclo = (t0 - inicio) % DURACAO_CICLO;
+            const LeituraSensores &leitura = leituraMonitoramento();
+            bool longe = noCiclo < CICLO[1].inicio;
+            bool dentroDoPerto = noCiclo >= CICLO[2].inicio && noCiclo < CICLO[3].inicio;
+            if (leitura.distanciaCM < 0)
+                foraDeAlcance++;
+            else if (longe && noCiclo > 50 * MS) // Medida ja iniciada com o alvo longe
+                inventadas++;
+            // O alarme tem duracao minima (fusao.h): so a subida fora do trecho perto e falsa
+            if (leitura.alarmeMovimento && !alarmeAnterior && !dentroDoPerto)
+                alarmesFalsos++;
+            alarmeAnterior = leitura.alarmeMovimento;
+
+            uint64_t ciclo = (t0 - inicio) / DURACAO_CICLO;
+            if (dentroDoPerto && leitura.alarmeMovimento && ciclo != cicloAlarmado)
+            {
+                atrasoAlarme.registrar(noCiclo - CICLO[2].inicio);
+                cicloAlarmado = ciclo;
+            }
+        }
+
+        double segundos = (sim::agoraUs() - inicio) / 1e6;
+        printf("perfil %s:\n", NOMES_PERFIS[perfil]);
+        custoPendente.imprimir("  sem medida nova:", "us");
+        custoNova.imprimir("  com medida nova:", "us");
+        printf("  %.1f medidas/s, %lu fora de alcance, %lu distancias inventadas, %lu alarmes falsos\n",
+               custoNova.quantidade() / segundos, foraDeAlcance, inventadas, alarmesFalsos);
+        atrasoAlarme.imprimir("  alvo perto -> alarme:", "us");
+        if (inventadas || alarmesFalsos || atrasoAlarme.quantidade() != duracao / DURACAO_CICLO ||
+            custoPendente.percentil(99) > 50)
+            ok = false;
+    }
+
+    remove("bench_caixa.bin");
+    remove("bench_nvs.bin");
+    printf("%s\n", ok ? "ok: sem espera pela medida e sem distancias fora de alcance" : "FALHA");
+    return ok ? 0 : 1;
+}
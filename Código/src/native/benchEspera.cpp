@@ -0,0 +1,219 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "sensorDeDigitais.h"
+
+// ====================================================================================
+// BENCHMARK DA ESPERA NA PORTA (BOTAO ATE A DECISAO)
+// ====================================================================================
+// Firmware inteiro (loop() cooperativo) contra o modulo emulado com os tempos de
+// processamento de um AS608: o dedo ja esta no vidro quando o botao e apertado e a
+// espera vai do aperto ate o fim da verificacao (debounce, captura, conversao, busca e
+// as idas e vindas pela UART).
+// 1) Baud (o firmware usa 57600 fixo) x tamanho da biblioteca, ate 1000 modelos em
+//    posicoes sorteadas; uma em cada dez tentativas e um dedo sem cadastro, que faz a
+//    busca percorrer a biblioteca toda. Cada tentativa precisa terminar na posicao certa.
+// 2) A mesma biblioteca com o modulo ideal (sem tempo de processamento): o que sobra e
+//    linha e firmware.
+// 3) Respostas perdidas, com um bit trocado e capturas falhas a 57600: as falhas custam
+//    tempo, mas nenhuma decisao pode sair errada.
+// A divisao da espera vem das estatisticas do emulador: modulo = processamento dos
+// comandos, linha = bytes nos dois sentidos na baud da tentativa, firmware = o resto
+// (debounce de 50 ms e o intervalo entre as passagens do loop()).
+// Opcoes:
+//   --tentativas N   tentativas por linha da tabela (padrao 60)
+//   --verbose        ecoa o console do firmware
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const uint8_t PINO_BOTAO = 12;
+static const uint16_t CAPACIDADE = 1000;
+
+extern FingerprintSensor sensorDigital;
+
+static uint32_t sortear(uint32_t &semente)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+static void rodar(uint64_t duracao)
+{
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+}
+
+// Biblioteca com `modelos` posicoes sorteadas; o dedo de cada posicao e o proprio numero.
+static std::vector<uint16_t> preencher(uint16_t modelos, uint32_t &semente)
+{
+    std::vector<uint16_t> slots;
+    for (uint16_t slot = 1; slot <= CAPACIDADE; slot++)
+        slots.push_back(slot);
+    for (size_t i = slots.size() - 1; i > 0; i--)
+        std::swap(slots[i], slots[sortear(semente) % (i + 1)]);
+    slots.resize(modelos);
+
+    sim::apagarDigitais();
+    for (uint16_t slot : slots)
+        sim::cadastrarDigital(slot);
+    return slots;
+}
+
+struct Resultado
+{
+    Amostras espera;    // us, so as tentativas que terminaram com uma decisao
+    double moduloUs = 0; // Medias por tentativa decidida
+    double linhaUs = 0;
+    unsigned falhas = 0;  // Terminaram com erro do sensor ou sem terminar
+    unsigned erradas = 0; // Decisao com a posicao errada
+};
+
+// Uma tentativa: dedo no vidro, botao apertado por 300 ms.
+static void tentar(uint16_t dedo, Resultado &resultado)
+{
+    sim::definirDedo(true, dedo);
+    sim::EstatisticasDigitais antes = sim::digitais();
+    uint64_t aperto = sim::agoraUs();
+    sim::agendar(aperto, []
+                 { sim::definirEntrada(PINO_BOTAO, LOW); });
+    sim::agendar(aperto + 300 * MS, []
+                 { sim::definirEntrada(PINO_BOTAO, HIGH); });
+
+    bool comecou = false;
+    uint64_t decisao = 0;
+    while (!decisao && sim::agoraUs() - aperto < 5 * S)
+    {
+        loop();
+        bool pendente = sensorDigital.isVerificationPending();
+        if (pendente)
+            comecou = true;
+        else if (comecou)
+            decisao = sim::agoraUs();
+        sim::avancarUs(200);
+    }
+    sim::definirDedo(false);
+    while (sim::agoraUs() - aperto < 400 * MS) // Botao solto e parado antes da proxima
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+
+    uint8_t codigo = sensorDigital.verificationResult();
+    if (!decisao || (codigo != FINGERPRINT_OK && codigo != FINGERPRINT_NOTFOUND))
+    {
+        resultado.falhas++;
+        return;
+    }
+    uint16_t esperado = dedo;
+    if ((codigo == FINGERPRINT_OK ? sensorDigital.matchedSlot() : 0) != esperado)
+    {
+        resultado.erradas++;
+        return;
+    }
+
+    const sim::EstatisticasDigitais &depois = sim::digitais();
+    uint64_t bytes = (depois.bytesRecebidos - antes.bytesRecebidos) + (depois.bytesEnviados - antes.bytesEnviados);
+    uint32_t n = resultado.espera.quantidade();
+    resultado.moduloUs += ((double)(depois.processamentoUs - antes.processamentoUs) - resultado.moduloUs) / (n + 1);
+    resultado.linhaUs += ((double)bytes * Serial2.tempoByteUs() - resultado.linhaUs) / (n + 1);
+    resultado.espera.registrar(decisao - aperto);
+}
+
+static Resultado medir(const std::vector<uint16_t> &slots, int tentativas, uint32_t &semente)
+{
+    Resultado resultado;
+    resultado.espera.reservar(tentativas);
+    for (int i = 0; i < tentativas; i++)
+    {
+        // Dedo 0: a imagem nao bate com nenhum modelo
+        uint16_t dedo = sortear(semente) % 10 == 0 ? 0 : slots[sortear(semente) % slots.size()];
+        tentar(dedo, resultado);
+    }
+    return resultado;
+}
+
+static void imprimir(unsigned long baud, uint16_t modelos, const char *perfil, Resultado &r)
+{
+    double media = r.espera.media();
+    printf("%6lu | %7u | %-6s | %7.1f | %7.1f | %9.1f | %8.1f | %11.1f | %s\n", baud, (unsigned)modelos, perfil,
+           r.espera.percentil(50) / 1e3, r.espera.percentil(99) / 1e3, r.moduloUs / 1e3, r.linhaUs / 1e3,
+           (media - r.moduloUs - r.linhaUs) / 1e3, r.falhas || r.erradas ? "ERRO" : "ok");
+}
+
+int benchEspera(int argc, char **argv)
+{
+    int tentativas = (int)opcaoNumero(argc, argv, "--tentativas", 60);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::definirCapacidadeDigitais(CAPACIDADE); // Lida pelo firmware no setup()
+    setup();
+    rodar(5 * S);
+    if (sensorDigital.capacity() != CAPACIDADE)
+    {
+        printf("Sensor de digitais simulado nao respondeu.\n");
+        return 1;
+    }
+
+    static const unsigned long BAUDS[] = {9600, 19200, 38400, 57600, 115200};
+    static const uint16_t MODELOS[] = {10, 100, 500, 1000};
+    const sim::LatenciasDigitais IDEAL = {};
+    uint32_t semente = 134;
+    bool ok = true;
+
+    printf("espera do aperto do botao ate a decisao (ms), %d tentativas por linha:\n", tentativas);
+    printf("%6s | %7s | %-6s | %7s | %7s | %9s | %8s | %11s |\n", "baud", "modelos", "perfil", "p50", "p99", "modulo",
+           "linha", "firmware");
+    for (unsigned long baud : BAUDS)
+    {
+        // O emulador responde na baud da porta: os dois lados mudam juntos
+        Serial2.begin(baud);
+        for (uint16_t modelos : MODELOS)
+        {
+            std::vector<uint16_t> slots = preencher(modelos, semente);
+            sim::definirLatenciasDigitais(sim::LATENCIAS_AS608);
+            Resultado as608 = medir(slots, tentativas, semente);
+            imprimir(baud, modelos, "AS608", as608);
+            ok = ok && !as608.falhas && !as608.erradas;
+
+            if (modelos != 100)
+                continue;
+            sim::definirLatenciasDigitais(IDEAL);
+            Resultado ideal = medir(slots, tentativas, semente);
+            imprimir(baud, modelos, "ideal", ideal);
+            ok = ok && !ideal.falhas && !ideal.erradas;
+        }
+    }
+
+    // Erros na linha e no vidro, na baud do firmware
+    Serial2.begin(57600);
+    std::vector<uint16_t> slots = preencher(100, semente);
+    sim::definirLatenciasDigitais(sim::LATENCIAS_AS608);
+    printf("erros a 57600 com 100 modelos (perdidas, corrompidas e capturas falhas na mesma taxa):\n");
+    static const uint32_t TAXAS_POR_MIL[] = {0, 10, 50};
+    for (uint32_t taxa : TAXAS_POR_MIL)
+    {
+        sim::ErrosDigitais erros = {taxa, taxa, taxa};
+        sim::injetarErrosDigitais(erros);
+        sim::EstatisticasDigitais antes = sim::digitais();
+        Resultado r = medir(slots, tentativas * 4, semente);
+        const sim::EstatisticasDigitais &depois = sim::digitais();
+        bool certo = !r.erradas && (taxa || !r.falhas);
+        ok = ok && certo;
+        printf("  %4.1f%%: %3u falhas e %u erradas em %d (%lu perdidas, %lu corrompidas, %lu capturas falhas), "
+               "espera p50 %.1f ms p99 %.1f ms: %s\n",
+               taxa / 10.0, r.falhas, r.erradas, tentativas * 4, (unsigned long)(depois.perdidas - antes.perdidas),
+               (unsigned long)(depois.corrompidas - antes.corrompidas),
+               (unsigned long)(depois.falhasCaptura - antes.falhasCaptura), r.espera.percentil(50) / 1e3,
+               r.espera.percentil(99) / 1e3, certo ? "ok" : "ERRO");
+    }
+    sim::injetarErrosDigitais(sim::ErrosDigitais{});
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "fusao.h"
+#include "telemetria.h"
+
+// ====================================================================================
+// BENCHMARK DA FUSAO DOS ALARMES
+// ====================================================================================
+// Mede o custo de avaliarFusao() com as tabelas do firmware e com uma tabela cheia, e
+// reproduz cenarios deterministicos no ritmo da tarefa de sensores (10 ms; peso a cada
+// 100 ms, distancia a cada 20 ms), comparando com as regras antigas (peso >= 5 kg,
+// distancia < 40 cm, luz, sem histerese, cada uma um alarme para o assinante):
+//   - valores parados no limiar, com ruido: nenhum alarme e poucas bordas;
+//   - intrusao, lanterna e presenca: um alarme fundido logo depois do gatilho, com a
+//     causa certa (a lanterna comeca como luz e sobe de prioridade com o movimento);
+//   - entrada com acesso autorizado: nenhum alarme durante a janela da porta.
+// As mensagens contam as publicacoes da Telemetria com a configuracao do firmware.
+// Opcoes:
+//   --avaliacoes N        avaliacoes por medida de custo (padrao 1000000)
+//   --ruido-peso-g N      +- g no peso filtrado (padrao 60)
+//   --ruido-distancia-mm N +- mm na distancia (padrao 25)
+
+static const unsigned long PASSO_MS = 10;
+static const unsigned long JANELA_ACESSO_MS = 15000; // desarmeMs de CONFIGURACAO_PADRAO
+static const double LATENCIA_MAXIMA_S = 1.0;
+static const ConfiguracaoTelemetria TELEMETRIA_FIRMWARE = {{1000, 1000, 1000, 0}, 60000};
+
+static double ruidoPesoG = 60;
+static double ruidoDistanciaMM = 25;
+static volatile uint32_t sumidouro;
+
+static uint32_t sortear(uint32_t &estado)
+{
+    estado ^= estado << 13;
+    estado ^= estado >> 17;
+    estado ^= estado << 5;
+    return estado;
+}
+
+static double ruido(uint32_t &semente, double amplitude)
+{
+    return amplitude * ((sortear(semente) % 2001) / 1000.0 - 1.0);
+}
+
+// ------------------- CENARIOS -------------------
+
+struct Cenario
+{
+    const char *nome;
+    double duracaoS;
+    double (*pesoG)(double s);
+    double (*distanciaMM)(double s); // < 0: nada no alcance
+    bool (*luz)(double s);           // Detector de mudanca brusca
+    double acessoS;                  // Acesso autorizado (< 0: nenhum)
+    CausaAlarme esperada;
+    double gatilhoS; // A partir de quando o alarme e esperado
+};
+
+static double vazio(double) { return 0; }
+static double longe(double) { return -1; }
+static bool escuro(double) { return false; }
+
+static const Cenario CENARIOS[] = {
+    {"peso-no-limiar", 600, [](double)
+     { return 5000.0; }, longe, escuro, -1, CAUSA_NENHUMA, 0},
+    {"vulto-no-limiar", 600, vazio, [](double)
+     { return 400.0; }, escuro, -1, CAUSA_NENHUMA, 0},
+    {"objeto-e-passagem", 120, [](double s)
+     { return s >= 10 ? 8000.0 : 0.0; }, [](double s)
+     { return s >= 60 && s < 62 ? 300.0 : -1.0; }, escuro, -1, CAUSA_NENHUMA, 0},
+    {"intrusao", 60, [](double s)
+     { return s >= 11 && s < 30 ? 8000.0 : 0.0; }, [](double s)
+     { return s >= 10 && s < 30 ? 250.0 : -1.0; }, escuro, -1, CAUSA_INTRUSAO, 11},
+    {"lanterna", 60, vazio, [](double s)
+     { return s >= 11 && s < 13 ? 300.0 : -1.0; }, [](double s)
+     { return s >= 10 && s < 12; }, -1, CAUSA_LANTERNA, 10},
+    {"presenca", 60, vazio, [](double s)
+     { return s >= 10 && s < 20 ? 300.0 : -1.0; }, escuro, -1, CAUSA_PRESENCA, 15},
+    {"acesso-autorizado", 60, [](double s)
+     { return s >= 8 && s < 14 ? 8000.0 : 0.0; }, [](double s)
+     { return s >= 6 && s < 16 ? 250.0 : -1.0; }, escuro, 5, CAUSA_NENHUMA, 0},
+};
+
+struct Contagem
+{
+    unsigned long bordas = 0;    // Alarmes por sensor
+    unsigned long alarmes = 0;   // Subidas que o assinante trata como alarme
+    unsigned long mensagens = 0; // Publicacoes da Telemetria
+};
+
+struct ResultadoCenario
+{
+    Contagem antiga, nova;
+    CausaAlarme causa = CAUSA_NENHUMA; // A ultima, se a regra mudar durante o alarme
+    double primeiroAlarmeS = -1;
+};
+
+static void contarMensagem(Telemetria &telemetria, const bool alarmes[NUM_SENSORES_ALARME], unsigned long agora, Contagem &c)
+{
+    if (telemetria.avaliar(alarmes, agora) == TELEMETRIA_NENHUM)
+        return;
+    telemetria.confirmar(alarmes, agora);
+    c.mensagens++;
+}
+
+static ResultadoCenario executarCenario(const Cenario &cenario, uint32_t semente)
+{
+    ResultadoCenario r;
+    compilarFusao(CONDICOES_PADRAO, NUM_CONDICOES_PADRAO, REGRAS_PADRAO, NUM_REGRAS_PADRAO);
+    armarFusao(true);
+    Telemetria antiga(TELEMETRIA_FIRMWARE), nova(TELEMETRIA_FIRMWARE);
+
+    int32_t entradas[NUM_ENTRADAS_FUSAO] = {0, FUSAO_SEM_MEDIDA, 0};
+    bool anteriorAntiga[NUM_SENSORES_ALARME] = {}, anteriorNova[NUM_SENSORES_ALARME] = {};
+    bool acessou = false;
+    unsigned long inicio = millis();
+    for (unsigned long t = 0; t < cenario.duracaoS * 1000; t += PASSO_MS)
+    {
+        double s = t / 1000.0;
+        if (t % 100 == 0)
+            entradas[ENTRADA_PESO] = (int32_t)(cenario.pesoG(s) + ruido(semente, ruidoPesoG));
+        if (t % 20 == 0)
+        {
+            double mm = cenario.distanciaMM(s);
+            entradas[ENTRADA_DISTANCIA] = mm < 0 ? FUSAO_SEM_MEDIDA : (int32_t)(mm + ruido(semente, ruidoDistanciaMM));
+        }
+        entradas[ENTRADA_LUZ] = cenario.luz(s);
+        if (cenario.acessoS >= 0 && !acessou && s >= cenario.acessoS)
+        {
+            suspenderFusao(JANELA_ACESSO_MS);
+            acessou = true;
+        }
+
+        // --- Regras antigas ---
+        bool alarmesAntigos[NUM_SENSORES_ALARME] = {};
+        alarmesAntigos[SENSOR_PRESSAO] = entradas[ENTRADA_PESO] >= 5000;
+        alarmesAntigos[SENSOR_MOVIMENTO] = entradas[ENTRADA_DISTANCIA] != FUSAO_SEM_MEDIDA &&
+                                           entradas[ENTRADA_DISTANCIA] / 10 < 40;
+        alarmesAntigos[SENSOR_LUZ] = entradas[ENTRADA_LUZ];
+
+        // --- Fusao ---
+        ResultadoFusao fusao = avaliarFusao(entradas, millis());
+        bool alarmesNovos[NUM_SENSORES_ALARME];
+        alarmesNovos[SENSOR_PRESSAO] = fusao.entradas & (1 << ENTRADA_PESO);
+        alarmesNovos[SENSOR_MOVIMENTO] = fusao.entradas & (1 << ENTRADA_DISTANCIA);
+        alarmesNovos[SENSOR_LUZ] = fusao.entradas & (1 << ENTRADA_LUZ);
+        alarmesNovos[SENSOR_FUSAO] = fusao.alarme;
+
+        for (uint8_t i = 0; i < NUM_SENSORES_ALARME; i++)
+        {
+            if (alarmesAntigos[i] != anteriorAntiga[i] && i != SENSOR_FUSAO)
+            {
+                r.antiga.bordas++;
+                r.antiga.alarmes += alarmesAntigos[i];
+            }
+            if (alarmesNovos[i] != anteriorNova[i])
+            {
+                if (i == SENSOR_FUSAO)
+                    r.nova.alarmes += alarmesNovos[i];
+                else
+                    r.nova.bordas++;
+            }
+            anteriorAntiga[i] = alarmesAntigos[i];
+            anteriorNova[i] = alarmesNovos[i];
+        }
+        if (fusao.alarme && r.primeiroAlarmeS < 0)
+            r.primeiroAlarmeS = s;
+        if (fusao.alarme)
+            r.causa = fusao.causa;
+        contarMensagem(antiga, alarmesAntigos, millis() - inicio, r.antiga);
+        contarMensagem(nova, alarmesNovos, millis() - inicio, r.nova);
+
+        sim::avancarUs(PASSO_MS * 1000);
+    }
+    return r;
+}
+
+// ------------------- CUSTO -------------------
+
+static double medirCusto(uint32_t avaliacoes)
+{
+    int32_t entradas[NUM_ENTRADAS_FUSAO];
+    uint32_t semente = 134;
+    unsigned long agora = 0;
+    uint64_t inicio = relogioHostNs();
+    for (uint32_t i = 0; i < avaliacoes; i++)
+    {
+        // Perto dos limiares, para que condicoes e regras mudem de estado
+        entradas[ENTRADA_PESO] = 4000 + sortear(semente) % 2000;
+        entradas[ENTRADA_DISTANCIA] = i & 64 ? FUSAO_SEM_MEDIDA : 300 + (int32_t)(sortear(semente) % 300);
+        entradas[ENTRADA_LUZ] = (i >> 9) & 1;
+        agora += PASSO_MS;
+        ResultadoFusao r = avaliarFusao(entradas, agora);
+        sumidouro = sumidouro + r.condicoes + r.causa;
+    }
+    return (double)(relogioHostNs() - inicio) / avaliacoes;
+}
+
+static bool compilarTabelaCheia()
+{
+    CondicaoFusao condicoes[MAX_CONDICOES_FUSAO];
+    RegraFusao regras[MAX_REGRAS_FUSAO];
+    for (uint8_t i = 0; i < MAX_CONDICOES_FUSAO; i++)
+    {
+        EntradaFusao entrada = (EntradaFusao)(i % NUM_ENTRADAS_FUSAO);
+        if (entrada == ENTRADA_DISTANCIA)
+            condicoes[i] = {entrada, FUSAO_ABAIXO, 350 + 20 * i, 450 + 20 * i, (uint16_t)(40 * i), 500};
+        else if (entrada == ENTRADA_PESO)
+            condicoes[i] = {entrada, FUSAO_ACIMA, 4500 + 100 * i, 4000 + 100 * i, (uint16_t)(100 * i), 500};
+        else
+            condicoes[i] = {entrada, FUSAO_ACIMA, 1, 1, 0, 0};
+    }
+    for (uint8_t i = 0; i < MAX_REGRAS_FUSAO; i++)
+    {
+        uint8_t mascara = (uint8_t)((0x7 << i) | (0x7 >> (8 - i))); // 3 condicoes por regra
+        regras[i] = {mascara, (uint16_t)(500 * (i + 1)), MODO_ARMADO, (CausaAlarme)(1 + i % (NUM_CAUSAS_ALARME - 1)), 1000};
+    }
+    return compilarFusao(condicoes, MAX_CONDICOES_FUSAO, regras, MAX_REGRAS_FUSAO);
+}
+
+int benchFusao(int argc, char **argv)
+{
+    uint32_t avaliacoes = (uint32_t)opcaoNumero(argc, argv, "--avaliacoes", 1000000);
+    ruidoPesoG = opcaoNumero(argc, argv, "--ruido-peso-g", 60);
+    ruidoDistanciaMM = opcaoNumero(argc, argv, "--ruido-distancia-mm", 25);
+    bool ok = true;
+
+    printf("\n=== benchmark fusao (ruido +-%.0f g, +-%.0f mm) ===\n", ruidoPesoG, ruidoDistanciaMM);
+
+    compilarFusao(CONDICOES_PADRAO, NUM_CONDICOES_PADRAO, REGRAS_PADRAO, NUM_REGRAS_PADRAO);
+    double padrao = medirCusto(avaliacoes);
+    if (!compilarTabelaCheia())
+        ok = false;
+    double cheia = medirCusto(avaliacoes);
+    printf("custo por avaliacao: %.0f ns (tabelas do firmware: %u condicoes, %u regras), %.0f ns (cheia: %u, %u)\n",
+           padrao, NUM_CONDICOES_PADRAO, NUM_REGRAS_PADRAO, cheia, MAX_CONDICOES_FUSAO, MAX_REGRAS_FUSAO);
+
+    printf("%-19s | %24s | %24s | %s\n", "", "regras antigas", "fusao", "alarme fundido");
+    printf("%-19s | %7s %7s %8s | %7s %7s %8s |\n", "cenario", "bordas", "alarmes", "mensagens",
+           "bordas", "alarmes", "mensagens");
+    for (const Cenario &cenario : CENARIOS)
+    {
+        ResultadoCenario r = executarCenario(cenario, 2024);
+        bool certo;
+        if (cenario.esperada == CAUSA_NENHUMA)
+            certo = r.nova.alarmes == 0;
+        else
+            certo = r.nova.alarmes == 1 && r.causa == cenario.esperada &&
+                    r.primeiroAlarmeS >= cenario.gatilhoS && r.primeiroAlarmeS - cenario.gatilhoS <= LATENCIA_MAXIMA_S;
+        ok = ok && certo;
+
+        char alarme[48];
+        if (r.primeiroAlarmeS < 0)
+            snprintf(alarme, sizeof(alarme), "nenhum");
+        else
+            snprintf(alarme, sizeof(alarme), "%s +%.0f ms", nomeCausaAlarme(r.causa),
+                     (r.primeiroAlarmeS - cenario.gatilhoS) * 1000);
+        printf("%-19s | %7lu %7lu %8lu | %7lu %7lu %8lu | %-20s esperado %s: %s\n", cenario.nome,
+               r.antiga.bordas, r.antiga.alarmes, r.antiga.mensagens, r.nova.bordas, r.nova.alarmes, r.nova.mensagens,
+               alarme, nomeCausaAlarme(cenario.esperada), certo ? "ok" : "ERRO");
+    }
+
+    compilarFusao(CONDICOES_PADRAO, NUM_CONDICOES_PADRAO, REGRAS_PADRAO, NUM_REGRAS_PADRAO);
+    printf("%s\n", ok ? "ok: sem alarme falso nos limiares e no acesso, causa certa nas intrusoes" : "FALHA");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <new>
+#include "bancada.h"
+#include "mensagens.h"
+
+// ====================================================================================
+// BENCHMARK DA SERIALIZACAO DAS MENSAGENS
+// ====================================================================================
+// Compara o caminho antigo (JsonDocument + String a cada mensagem) com serializarJson()
+// num buffer estatico, para as tres mensagens publicadas. Conta as alocacoes feitas
+// pelo ArduinoJson (via Allocator) e por new (String) e confere que o JSON e identico.
+// Opcoes:
+//   --mensagens N   mensagens por medida (padrao 1000000)
+
+// Contador de alocacoes do programa inteiro (String/std::string usam new).
+static std::atomic<unsigned long> alocacoesNew{0};
+
+void *operator new(size_t tamanho)
+{
+    alocacoesNew.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(tamanho ? tamanho : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+class AlocadorContador : public ArduinoJson::Allocator
+{
+public:
+    unsigned long alocacoes = 0;
+
+    void *allocate(size_t tamanho) override
+    {
+        alocacoes++;
+        return malloc(tamanho);
+    }
+    void deallocate(void *p) override { free(p); }
+    void *reallocate(void *p, size_t tamanho) override
+    {
+        alocacoes++;
+        return realloc(p, tamanho);
+    }
+};
+
+static AlocadorContador alocadorJson;
+static char mensagem[TAMANHO_MENSAGEM_MQTT];
+static volatile uint32_t sumidouro; // Impede que o compilador descarte a mensagem
+
+static void consumir(const char *texto, size_t tamanho)
+{
+    sumidouro = sumidouro + tamanho + (uint8_t)texto[tamanho / 2];
+}
+
+struct Valores
+{
+    bool luz, movimento, pressao;
+    const char *motivo;
+    bool alarme;
+    const char *causa;
+    bool liberado;
+    uint16_t dedo, usuario;
+    const char *decisao;
+    int rssi;
+    unsigned long conectadoS, reconexoes, quedas;
+    time_t timestamp;
+    uint32_t seq;
+};
+
+static Valores valoresDaMensagem(uint32_t i)
+{
+    Valores v;
+    v.luz = i & 1;
+    v.movimento = i & 2;
+    v.pressao = i & 4;
+    v.motivo = i & 8 ? "alteracao" : "heartbeat";
+    v.alarme = i & 32;
+    v.causa = v.alarme ? "intrusao" : "nenhuma";
+    v.liberado = i & 16;
+    v.dedo = 1 + i % 162;
+    v.usuario = v.liberado ? 1000 + v.dedo : 0;
+    v.decisao = v.liberado ? "liberado" : "sem cadastro";
+    v.rssi = -40 - (int)(i % 50);
+    v.conectadoS = 3600 + i;
+    v.reconexoes = i % 7;
+    v.quedas = i % 3;
+    v.timestamp = 1760000000 + i;
+    v.seq = i;
+    return v;
+}
+
+// --- Caminho antigo ---
+static String antigo(int tipo, const Valores &v)
+{
+    JsonDocument doc(&alocadorJson);
+    String texto;
+    if (tipo == 0)
+    {
+        doc["sensor_luz"] = v.luz;
+        doc["sensor_movimento"] = v.movimento;
+        doc["sensor_pressao"] = v.pressao;
+        doc["motivo"] = v.motivo;
+        doc["timestamp"] = v.timestamp;
+        doc["seq"] = v.seq;
+        doc["alarme"] = v.alarme;
+        doc["causa"] = v.causa;
+    }
+    else if (tipo == 1)
+    {
+        doc["liberar_Acesso"] = v.liberado;
+        doc["timestamp"] = v.timestamp;
+        doc["seq"] = v.seq;
+        doc["dedo"] = v.dedo;
+        doc["usuario"] = v.usuario;
+        doc["decisao"] = v.decisao;
+    }
+    else
+    {
+        doc["wifi_rssi"] = v.rssi;
+        doc["wifi_conectado_s"] = v.conectadoS;
+        doc["wifi_reconexoes"] = v.reconexoes;
+        doc["wifi_quedas"] = v.quedas;
+        doc["timestamp"] = v.timestamp;
+    }
+    serializeJson(doc, texto);
+    return texto;
+}
+
+// --- Serializador de layout fixo ---
+static size_t novo(int tipo, const Valores &v)
+{
+    if (tipo == 0)
+        return serializarJson<LayoutLeituraSensores>(mensagem, v.luz, v.movimento, v.pressao, v.motivo, v.timestamp, v.seq,
+                                                     v.alarme, v.causa);
+    if (tipo == 1)
+        return serializarJson<LayoutEventoAcesso>(mensagem, v.liberado, v.timestamp, v.seq, v.dedo, v.usuario,
+                                                  v.decisao);
+    return serializarJson<LayoutQualidadeWiFi>(mensagem, v.rssi, v.conectadoS, v.reconexoes, v.quedas, v.timestamp);
+}
+
+int benchJson(int argc, char **argv)
+{
+    uint32_t mensagens = (uint32_t)opcaoNumero(argc, argv, "--mensagens", 1000000);
+    const char *nomes[] = {"leitura sensores", "evento acesso", "qualidade wifi"};
+    bool identicos = true;
+
+    printf("\n=== benchmark json (%u mensagens por medida, buffer de %zu bytes) ===\n",
+           mensagens, TAMANHO_MENSAGEM_MQTT);
+    for (int tipo = 0; tipo < 3; tipo++)
+    {
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            Valores v = valoresDaMensagem(i);
+            size_t n = novo(tipo, v);
+            if (antigo(tipo, v) != String(mensagem, n))
+                identicos = false;
+        }
+
+        unsigned long newAntes = alocacoesNew.load();
+        alocadorJson.alocacoes = 0;
+        uint64_t inicio = relogioHostNs();
+        for (uint32_t i = 0; i < mensagens; i++)
+        {
+            String texto = antigo(tipo, valoresDaMensagem(i));
+            consumir(texto.c_str(), texto.length());
+        }
+        double nsAntigo = (double)(relogioHostNs() - inicio) / mensagens;
+        double alocAntigo = (double)(alocacoesNew.load() - newAntes + alocadorJson.alocacoes) / mensagens;
+
+        newAntes = alocacoesNew.load();
+        inicio = relogioHostNs();
+        for (uint32_t i = 0; i < mensagens; i++)
+        {
+            size_t n = novo(tipo, valoresDaMensagem(i));
+            consumir(mensagem, n);
+        }
+        double nsNovo = (double)(relogioHostNs() - inicio) / mensagens;
+        double alocNovo = (double)(alocacoesNew.load() - newAntes) / mensagens;
+
+        printf("%-17s JsonDocument+String %7.1f ns %5.2f aloc/msg | serializarJson %6.1f ns %4.2f aloc/msg | %.1fx\n",
+               nomes[tipo], nsAntigo, alocAntigo, nsNovo, alocNovo, nsAntigo / nsNovo);
+    }
+
+    printf("saida identica ao ArduinoJson: %s\n", identicos ? "sim" : "NAO");
+    return identicos ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "sensorDeDigitais.h"
+#include "caixaDeSaida.h"
+
+// ====================================================================================
+// BENCHMARK DO LOOP PRINCIPAL
+// ====================================================================================
+// Executa setup() e depois loop() por um tempo simulado, contra um cenario com
+// tentativas de acesso, variacoes dos sensores e quedas do broker e do Wi-Fi. Falha se
+// algum acesso autorizado nao abrir a trava. Os limites valem para a espera modelada
+// de cada iteracao (delay(), UART, rede, flash: o tempo simulado menos o do host), que
+// nao depende de pausas do host; a latencia com o custo de CPU sai a parte.
+// Opcoes:
+//   --duracao-s N     tempo simulado apos o setup (padrao 180)
+//   --passo-us N      tempo ocioso simulado entre iteracoes (padrao 200)
+//   --limite-max-ms N falha (codigo 1) se alguma iteracao passar de N ms (padrao 50:
+//                     o apagamento de um setor da caixa de saida leva 45 ms; 0 desliga)
+//   --limite-digitais-ms N  idem, so para iteracoes com verificacao de digital pendente
+//                     (padrao 9: a verificacao nao pode segurar o loop() por 10 ms)
+//   --verbose         ecoa o Serial do firmware no terminal
+
+static const uint8_t PINO_BOTAO = 12;
+static const uint8_t PINO_TRAVA = 25;
+static const uint8_t PINO_LDR = 33;
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+
+extern FingerprintSensor sensorDigital;
+extern CaixaDeSaida caixaDeSaida;
+
+static unsigned long aberturasTrava = 0;
+
+unsigned montarCenario(uint64_t inicio, uint64_t duracao)
+{
+    unsigned autorizadas = 0;
+    for (uint16_t id = 1; id <= 5; id++)
+        sim::cadastrarDigital(id);
+
+    sim::definirDistanciaMM(1200);
+    sim::definirAnalogico(PINO_LDR, 50);
+
+    // Tentativas de acesso a cada 15 s: botao por 300 ms e dedo 500 ms depois.
+    // Uma em cada quatro usa um dedo nao cadastrado e uma em cada seis nao tem dedo
+    // (a verificacao termina pelo timeout de captura).
+    unsigned tentativa = 0;
+    for (uint64_t t = inicio + 10 * S; t + 2 * S < inicio + duracao; t += 15 * S, tentativa++)
+    {
+        uint16_t dedo = (tentativa % 4 == 3) ? 0 : (uint16_t)(tentativa % 5 + 1);
+        sim::agendar(t, []
+                     { sim::definirEntrada(PINO_BOTAO, LOW); });
+        sim::agendar(t + 300 * MS, []
+                     { sim::definirEntrada(PINO_BOTAO, HIGH); });
+        if (tentativa % 6 == 5)
+            continue;
+        if (dedo)
+            autorizadas++;
+        sim::agendar(t + 500 * MS, [dedo]
+                     { sim::definirDedo(true, dedo); });
+        sim::agendar(t + 1500 * MS, []
+                     { sim::definirDedo(false); });
+    }
+
+    // Sensores de alarme
+    sim::agendar(inicio + 30 * S, []
+                 { sim::definirPeso(8.0); });
+    sim::agendar(inicio + 40 * S, []
+                 { sim::definirPeso(0.0); });
+    sim::agendar(inicio + 45 * S, []
+                 { sim::definirDistanciaMM(250); });
+    sim::agendar(inicio + 47 * S, []
+                 { sim::definirDistanciaMM(1200); });
+    sim::agendar(inicio + 50 * S, []
+                 { sim::definirAnalogico(PINO_LDR, 400); });
+    sim::agendar(inicio + 55 * S, []
+                 { sim::definirAnalogico(PINO_LDR, 50); });
+
+    // Quedas de rede
+    sim::agendar(inicio + 60 * S, []
+                 { sim::definirBroker(false); });
+    sim::agendar(inicio + 90 * S, []
+                 { sim::definirBroker(true); });
+    sim::agendar(inicio + 120 * S, []
+                 { sim::definirWiFi(false); });
+    sim::agendar(inicio + 135 * S, []
+                 { sim::definirWiFi(true); });
+
+    return autorizadas;
+}
+
+int benchLoop(int argc, char **argv)
+{
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 180) * S);
+    uint64_t passo = (uint64_t)opcaoNumero(argc, argv, "--passo-us", 200);
+    double limiteMaxMs = opcaoNumero(argc, argv, "--limite-max-ms", 50);
+    double limiteDigitaisMs = opcaoNumero(argc, argv, "--limite-digitais-ms", 9);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    sim::aoEscreverPino([](uint64_t, uint8_t pino, uint8_t nivel)
+                        {
+        if (pino == PINO_TRAVA && nivel == HIGH)
+            aberturasTrava++; });
+
+    sim::usarArquivoFlash("bench_caixa.bin", true); // Caixa de saida vazia a cada execucao
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+
+    uint64_t inicioSetup = sim::agoraUs();
+    setup();
+    uint64_t inicio = sim::agoraUs();
+    unsigned autorizadas = montarCenario(inicio, duracao);
+
+    Amostras latencias;
+    Amostras latenciasDigitais;
+    Amostras esperas; // Modeladas, sem o host
+    Amostras esperasDigitais;
+    latencias.reservar(duracao / (passo + 1) + 1);
+    esperas.reservar(duracao / (passo + 1) + 1);
+    uint64_t tempoEmLoop = 0;
+    uint64_t hostInicio = relogioHostNs();
+
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        bool verificando = sensorDigital.isVerificationPending();
+        uint64_t antesHost = relogioHostNs();
+        uint64_t antes = sim::agoraUs();
+        loop();
+        uint64_t depois = sim::agoraUs();
+        uint64_t host = (relogioHostNs() - antesHost) / 1000;
+        uint64_t espera = depois - antes > host ? depois - antes - host : 0;
+        latencias.registrar(depois - antes);
+        esperas.registrar(espera);
+        if (verificando || sensorDigital.isVerificationPending())
+        {
+            latenciasDigitais.registrar(depois - antes);
+            esperasDigitais.registrar(espera);
+        }
+        tempoEmLoop += depois - antes;
+        sim::avancarUs(passo);
+    }
+
+    double hostS = (relogioHostNs() - hostInicio) / 1e9;
+    double simuladoS = (sim::agoraUs() - inicio) / 1e6;
+    const sim::EstatisticasBroker &broker = sim::broker();
+
+    printf("\n=== benchmark loop ===\n");
+    printf("setup():                     %.3f s simulados\n", (inicio - inicioSetup) / 1e6);
+    printf("tempo simulado:              %.1f s (%zu iteracoes, host %.2f s)\n",
+           simuladoS, latencias.quantidade(), hostS);
+    printf("iteracoes/s (simulado):      %.1f\n", latencias.quantidade() / simuladoS);
+    printf("iteracoes/s (so loop()):     %.1f\n", latencias.quantidade() / (tempoEmLoop / 1e6));
+    latencias.imprimir("latencia loop():", "us");
+    latenciasDigitais.imprimir("  com digital pendente:", "us");
+    esperas.imprimir("espera modelada:", "us");
+    esperasDigitais.imprimir("  com digital pendente:", "us");
+    printf("broker: %lu conexoes, %lu falhas, %lu publicacoes, %lu bytes\n",
+           broker.conexoes, broker.falhasConexao, broker.publicacoes, broker.bytesPublicados);
+    printf("trava: %lu aberturas (%u acessos autorizados no cenario)\n", aberturasTrava, autorizadas);
+    const EstatisticasCaixaDeSaida &caixa = caixaDeSaida.estatisticas();
+    printf("caixa de saida: %lu anexados, %lu entregues em %lu lotes, %lu pendentes, %lu perdidos\n",
+           caixa.anexados, caixa.entregues, caixa.lotes, (unsigned long)caixaDeSaida.pendentes(), caixa.perdidos);
+
+    if (aberturasTrava < autorizadas)
+    {
+        printf("FALHA: %u acessos autorizados e so %lu aberturas\n", autorizadas, aberturasTrava);
+        return 1;
+    }
+    if (limiteMaxMs > 0 && esperas.maximo() > limiteMaxMs * 1000)
+    {
+        printf("FALHA: espera maxima acima de %.1f ms\n", limiteMaxMs);
+        return 1;
+    }
+    if (limiteDigitaisMs > 0 && esperasDigitais.maximo() > limiteDigitaisMs * 1000)
+    {
+        printf("FALHA: espera com digital pendente acima de %.1f ms\n", limiteDigitaisMs);
+        return 1;
+    }
+    return 0;
+}
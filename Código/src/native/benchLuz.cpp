@@ -0,0 +1,249 @@
+#include <Arduino.h>
+#include <math.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "hal.h"
+#include "luz.h"
+
+// ====================================================================================
+// BENCHMARK DO DETECTOR DE LUZ (TRACOS REPRODUZIVEIS)
+// ====================================================================================
+// Reproduz tracos de luz no detector (alimentarLuz, como o callback do ADC faria a
+// cada 1 ms) e compara com a regra antiga: uma conversao a cada 500 ms contra 100.
+// Os tracos embutidos sao deterministicos e trazem o resultado esperado: cenarios sem
+// mudanca brusca (anoitecer, nuvem, lampada cintilando) nao podem disparar e os com
+// mudanca brusca (lanterna, luz apagada, farol) devem disparar uma vez, logo depois dela.
+// Opcoes:
+//   --gravar DIR      grava cada traco embutido em DIR/<nome>.csv e sai
+//   --traco ARQUIVO   reproduz um traco gravado (linhas "ms,c0,c1,c2,c3" ou "ms,valor")
+//   --limiar N, --percentual N, --janela-ms N, --retencao-ms N   configuracao do detector
+
+static const double INICIO_MUDANCA_S = 10; // Mudancas bruscas dos tracos embutidos
+static const uint64_t JANELA_ESPERADA_MS = 500;
+static const uint16_t LIMIAR_ANTIGO = 100;
+static const uint32_t PERIODO_ANTIGO_MS = 500;
+
+struct Traco
+{
+    const char *nome;
+    double duracaoS;
+    double (*nivel)(double s);
+    double cintilacao; // Amplitude a 100 Hz (lampada na rede de 50 Hz)
+    uint16_t ruido;    // +- contagens por conversao
+    bool brusca;       // Espera um alarme a partir de INICIO_MUDANCA_S
+};
+
+static double rampa(double s, double inicio, double fim, double de, double para)
+{
+    if (s <= inicio)
+        return de;
+    if (s >= fim)
+        return para;
+    return de + (para - de) * (s - inicio) / (fim - inicio);
+}
+
+static const Traco TRACOS[] = {
+    {"anoitecer", 90, [](double s)
+     { return rampa(s, 10, 70, 400, 40); }, 0, 25, false},
+    {"nuvem", 40, [](double s)
+     { return s < 25 ? rampa(s, 10, 16, 500, 250) : rampa(s, 25, 31, 250, 500); }, 0, 20, false},
+    {"lampada-100hz", 20, [](double)
+     { return 300.0; }, 80, 15, false},
+    {"lanterna", 20, [](double s)
+     { return s >= 10 && s < 13 ? 350.0 : 40.0; }, 0, 20, true},
+    {"luz-apagada", 20, [](double s)
+     { return s < 10 ? 600.0 : 60.0; }, 40, 20, true},
+    {"farol", 20, [](double s)
+     { return s >= 10 && s < 10.3 ? 400.0 : 40.0; }, 0, 20, true},
+};
+
+struct Bloco
+{
+    uint32_t ms;
+    uint16_t conversoes[HAL_ADC_AMOSTRAS_POR_BLOCO];
+};
+
+static std::vector<Bloco> gerarTraco(const Traco &traco)
+{
+    std::vector<Bloco> blocos;
+    uint32_t semente = 2024;
+    for (uint32_t ms = 0; ms < traco.duracaoS * 1000; ms++)
+    {
+        Bloco bloco;
+        bloco.ms = ms;
+        for (uint8_t i = 0; i < HAL_ADC_AMOSTRAS_POR_BLOCO; i++)
+        {
+            double s = (ms + i * 0.25) / 1000.0;
+            double valor = traco.nivel(s) + traco.cintilacao * sin(2 * M_PI * 100 * s);
+            semente = semente * 1103515245 + 12345;
+            valor += (int32_t)((semente >> 8) % (2 * traco.ruido + 1)) - (int32_t)traco.ruido;
+            bloco.conversoes[i] = (uint16_t)(valor < 0 ? 0 : valor > 4095 ? 4095 : valor);
+        }
+        blocos.push_back(bloco);
+    }
+    return blocos;
+}
+
+static bool lerTraco(const char *caminho, std::vector<Bloco> &blocos)
+{
+    FILE *arquivo = fopen(caminho, "r");
+    if (!arquivo)
+        return false;
+    char linha[128];
+    while (fgets(linha, sizeof(linha), arquivo))
+    {
+        unsigned ms, c[HAL_ADC_AMOSTRAS_POR_BLOCO];
+        int lidos = sscanf(linha, "%u,%u,%u,%u,%u", &ms, &c[0], &c[1], &c[2], &c[3]);
+        if (lidos < 2)
+            continue; // Cabecalho ou linha vazia
+        Bloco bloco;
+        bloco.ms = ms;
+        for (uint8_t i = 0; i < HAL_ADC_AMOSTRAS_POR_BLOCO; i++)
+            bloco.conversoes[i] = (uint16_t)(lidos == 2 ? c[0] : c[i]);
+        blocos.push_back(bloco);
+    }
+    fclose(arquivo);
+    return !blocos.empty();
+}
+
+static bool gravarTraco(const char *caminho, const std::vector<Bloco> &blocos)
+{
+    FILE *arquivo = fopen(caminho, "w");
+    if (!arquivo)
+        return false;
+    fprintf(arquivo, "ms,c0,c1,c2,c3\n");
+    for (const Bloco &bloco : blocos)
+        fprintf(arquivo, "%u,%u,%u,%u,%u\n", bloco.ms, bloco.conversoes[0], bloco.conversoes[1],
+                bloco.conversoes[2], bloco.conversoes[3]);
+    fclose(arquivo);
+    return true;
+}
+
+struct Resultado
+{
+    std::vector<uint32_t> alarmesMs; // Bordas de subida do detector
+    unsigned long transicoesAntigas;
+    unsigned long leiturasAntigas;
+    unsigned long ligadoAntigo; // Leituras com o alarme antigo ligado
+    std::vector<uint32_t> alarmesAntigosMs;
+    uint64_t hostNs;
+    size_t blocos;
+};
+
+static Resultado reproduzir(const std::vector<Bloco> &blocos, const ConfiguracaoLuz &configuracao)
+{
+    Resultado resultado = {};
+    configurarLuz(configuracao);
+    bool alarme = false;
+    bool alarmeAntigo = !blocos.empty() && blocos[0].conversoes[0] > LIMIAR_ANTIGO;
+    for (const Bloco &bloco : blocos)
+    {
+        uint64_t t0 = relogioHostNs();
+        alimentarLuz(bloco.conversoes, HAL_ADC_AMOSTRAS_POR_BLOCO);
+        resultado.hostNs += relogioHostNs() - t0;
+        sim::avancarUs(HAL_ADC_BLOCO_US);
+
+        bool agora = leituraLuz().alarme;
+        if (agora && !alarme)
+            resultado.alarmesMs.push_back(bloco.ms);
+        alarme = agora;
+
+        if (bloco.ms % PERIODO_ANTIGO_MS == 0)
+        {
+            bool antigo = bloco.conversoes[0] > LIMIAR_ANTIGO;
+            if (antigo != alarmeAntigo)
+            {
+                resultado.transicoesAntigas++;
+                if (antigo)
+                    resultado.alarmesAntigosMs.push_back(bloco.ms);
+            }
+            alarmeAntigo = antigo;
+            resultado.leiturasAntigas++;
+            resultado.ligadoAntigo += antigo;
+        }
+    }
+    resultado.blocos = blocos.size();
+    return resultado;
+}
+
+static bool dentroDaJanela(const std::vector<uint32_t> &alarmes)
+{
+    uint32_t inicio = (uint32_t)(INICIO_MUDANCA_S * 1000);
+    return alarmes.size() == 1 && alarmes[0] >= inicio && alarmes[0] < inicio + JANELA_ESPERADA_MS;
+}
+
+int benchLuz(int argc, char **argv)
+{
+    ConfiguracaoLuz configuracao = LUZ_PADRAO;
+    configuracao.limiarMinimo = (uint16_t)opcaoNumero(argc, argv, "--limiar", configuracao.limiarMinimo);
+    configuracao.limiarPercentual = (uint8_t)opcaoNumero(argc, argv, "--percentual", configuracao.limiarPercentual);
+    configuracao.janelaMs = (uint16_t)opcaoNumero(argc, argv, "--janela-ms", configuracao.janelaMs);
+    configuracao.retencaoMs = (uint16_t)opcaoNumero(argc, argv, "--retencao-ms", configuracao.retencaoMs);
+
+    for (int i = 0; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--gravar") == 0)
+        {
+            for (const Traco &traco : TRACOS)
+            {
+                std::string caminho = std::string(argv[i + 1]) + "/" + traco.nome + ".csv";
+                if (!gravarTraco(caminho.c_str(), gerarTraco(traco)))
+                {
+                    printf("Falha ao gravar %s\n", caminho.c_str());
+                    return 1;
+                }
+                printf("%s\n", caminho.c_str());
+            }
+            return 0;
+        }
+        if (strcmp(argv[i], "--traco") == 0)
+        {
+            std::vector<Bloco> blocos;
+            if (!lerTraco(argv[i + 1], blocos))
+            {
+                printf("Traco vazio ou inexistente: %s\n", argv[i + 1]);
+                return 1;
+            }
+            Resultado resultado = reproduzir(blocos, configuracao);
+            printf("\n=== traco %s: %.1f s ===\n", argv[i + 1], blocos.size() / 1000.0);
+            printf("detector: %zu alarmes", resultado.alarmesMs.size());
+            for (uint32_t ms : resultado.alarmesMs)
+                printf(" %.3fs", ms / 1000.0);
+            printf("\nregra antiga: %lu transicoes, %zu alarmes, ligado %.0f%% do tempo\n",
+                   resultado.transicoesAntigas, resultado.alarmesAntigosMs.size(),
+                   100.0 * resultado.ligadoAntigo / resultado.leiturasAntigas);
+            return 0;
+        }
+    }
+
+    printf("\n=== benchmark luz (limiar %u, %u%%, janela %u ms, retencao %u ms) ===\n", configuracao.limiarMinimo,
+           configuracao.limiarPercentual, configuracao.janelaMs, configuracao.retencaoMs);
+    printf("%-15s %-9s | %-32s | %s\n", "traco", "esperado", "detector", "regra antiga (> 100 a cada 500 ms)");
+    bool ok = true;
+    uint64_t hostNs = 0;
+    size_t blocos = 0;
+    for (const Traco &traco : TRACOS)
+    {
+        Resultado resultado = reproduzir(gerarTraco(traco), configuracao);
+        hostNs += resultado.hostNs;
+        blocos += resultado.blocos;
+
+        bool certo = traco.brusca ? dentroDaJanela(resultado.alarmesMs) : resultado.alarmesMs.empty();
+        bool antigoCerto = traco.brusca ? dentroDaJanela(resultado.alarmesAntigosMs) : resultado.ligadoAntigo == 0;
+        ok = ok && certo;
+
+        char detector[64];
+        if (resultado.alarmesMs.empty())
+            snprintf(detector, sizeof(detector), "nenhum alarme");
+        else
+            snprintf(detector, sizeof(detector), "%zu alarme(s), 1o apos %ld ms", resultado.alarmesMs.size(),
+                     (long)resultado.alarmesMs[0] - (long)(INICIO_MUDANCA_S * 1000));
+        printf("%-15s %-9s | %-26s %-5s | %lu transicoes, ligado %3.0f%% (%s)\n", traco.nome,
+               traco.brusca ? "alarme" : "nenhum", detector, certo ? "ok" : "ERRO", resultado.transicoesAntigas,
+               100.0 * resultado.ligadoAntigo / resultado.leiturasAntigas, antigoCerto ? "ok" : "errado");
+    }
+    printf("custo: %.0f ns por bloco de 1 ms (%.2f%% de CPU do host a 4 kHz de ADC)\n", (double)hostNs / blocos,
+           (double)hostNs / blocos / 1e4);
+    printf("%s\n", ok ? "ok: so as mudancas bruscas disparam" : "FALHA");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,372 @@
+#include <Arduino.h>
+#include <string>
+#include "bancada.h"
+#include "simulador.h"
+#include "hal.h"
+#include "modelosDigitais.h"
+
+// ====================================================================================
+// BENCHMARK DA COPIA DE MODELOS DE DIGITAIS
+// ====================================================================================
+// 1) Pedacos: CRC-32 contra o valor de referencia, custo de codificar/decodificar no host
+//    e deteccao de bits trocados em qualquer posicao do pedaco.
+// 2) Firmware (loop() cooperativo) com o modulo emulado cheio de modelos: exportacao
+//    completa pelo broker (modelos/s no tempo simulado) e retomada a partir de um indice
+//    com o Wi-Fi caindo no meio; cada pedaco precisa chegar uma vez, em ordem.
+// 3) Restauracao num sensor vazio a partir do arquivo exportado, com pedaco corrompido,
+//    pedaco repetido, metade pelo topico da frota e um reinicio no meio: o envio continua
+//    do `proximo` lido da NVS. No fim a biblioteca do sensor e igual a original e um dedo
+//    restaurado libera a porta.
+// Opcoes:
+//   --modelos N    modelos no sensor (padrao 150, ate 162 no emulador)
+//   --pedacos N    pedacos por medida de custo (padrao 20000)
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const uint8_t PINO_BOTAO = 12;
+static const uint8_t PINO_TRAVA = 25;
+static const char *TOPICO_EXPORTAR = "safezone-digitais/134/exportar";
+static const char *TOPICO_ARQUIVO = "safezone-digitais/134/arquivo";
+static const char *TOPICO_IMPORTAR = "safezone-digitais/134/importar";
+static const char *TOPICO_IMPORTAR_TODOS = "safezone-digitais/todos/importar";
+static const char *TOPICO_STATUS = "safezone-digitais/134/status";
+static const uint16_t CAPACIDADE_EMULADOR = 162;
+
+extern ProgressoTransferencia progressoImportacao;
+bool carregarProgressoImportacao();
+
+static volatile uint32_t sumidouro;
+static std::vector<std::vector<uint8_t>> arquivo; // Pedacos recebidos no topico do arquivo
+static std::vector<std::string> respostas;        // Mensagens do topico de status
+static bool travaAberta = false;
+
+// ------------------- PEDACOS -------------------
+
+static bool medirPedacos(uint32_t pedacos)
+{
+    bool ok = true;
+    uint32_t referencia = crc32Pedaco(0, (const uint8_t *)"123456789", 9);
+    bool crcCerto = referencia == 0xCBF43926;
+    ok = ok && crcCerto;
+    printf("crc32(\"123456789\") = 0x%08lX: %s\n", (unsigned long)referencia, crcCerto ? "ok" : "ERRO");
+
+    PedacoModelo pedaco = {42, 3, 10, 7, {}};
+    for (size_t i = 0; i < TAMANHO_MODELO; i++)
+        pedaco.modelo[i] = (uint8_t)(i * 31 + 7);
+    uint8_t bytes[TAMANHO_PEDACO];
+    PedacoModelo lido;
+
+    uint64_t t0 = relogioHostNs();
+    for (uint32_t i = 0; i < pedacos; i++)
+    {
+        pedaco.indice = i % 10;
+        sumidouro += codificarPedaco(pedaco, bytes, sizeof(bytes));
+    }
+    double codificar = (double)(relogioHostNs() - t0) / pedacos;
+    t0 = relogioHostNs();
+    for (uint32_t i = 0; i < pedacos; i++)
+        sumidouro += decodificarPedaco(bytes, sizeof(bytes), lido);
+    double decodificar = (double)(relogioHostNs() - t0) / pedacos;
+
+    bool igual = decodificarPedaco(bytes, sizeof(bytes), lido) == PEDACO_OK && lido.transferencia == 42 &&
+                 lido.indice == pedaco.indice && lido.total == 10 && lido.slot == 7 &&
+                 memcmp(lido.modelo, pedaco.modelo, TAMANHO_MODELO) == 0;
+    ok = ok && igual;
+
+    // Cada bit de cada byte trocado, um por vez
+    uint32_t detectados = 0, trocas = 0;
+    for (size_t i = 0; i < TAMANHO_PEDACO; i++)
+    {
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            bytes[i] ^= 1 << bit;
+            detectados += decodificarPedaco(bytes, sizeof(bytes), lido) != PEDACO_OK;
+            trocas++;
+            bytes[i] ^= 1 << bit;
+        }
+    }
+    bool deteccao = detectados == trocas;
+    ok = ok && deteccao;
+    printf("pedaco de %zu bytes (modelo de %zu): ida e volta %s, %.0f ns para codificar, %.0f ns para decodificar (host)\n",
+           TAMANHO_PEDACO, TAMANHO_MODELO, igual ? "ok" : "ERRO", codificar, decodificar);
+    printf("bits trocados detectados: %lu de %lu: %s\n", (unsigned long)detectados, (unsigned long)trocas,
+           deteccao ? "ok" : "ERRO");
+    return ok;
+}
+
+// ------------------- FIRMWARE -------------------
+
+static void aoPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    if (strcmp(topico, TOPICO_ARQUIVO) == 0)
+        arquivo.emplace_back(dados, dados + tamanho);
+    else if (strcmp(topico, TOPICO_STATUS) == 0)
+        respostas.emplace_back((const char *)dados, tamanho);
+}
+
+static void rodar(uint64_t duracao)
+{
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        loop();
+        sim::avancarUs(200);
+    }
+}
+
+static bool contem(const std::string &texto, const char *trecho)
+{
+    return texto.find(trecho) != std::string::npos;
+}
+
+static long lerCampo(const std::string &mensagem, const char *nome)
+{
+    std::string chave = std::string("\"") + nome + "\":";
+    size_t posicao = mensagem.find(chave);
+    return posicao == std::string::npos ? -1 : atol(mensagem.c_str() + posicao + chave.size());
+}
+
+// Roda ate chegar uma resposta com `trecho` (ou `limite`); retorna a resposta ou "".
+static std::string esperarResposta(const char *trecho, uint64_t limite)
+{
+    uint64_t inicio = sim::agoraUs();
+    size_t vistas = 0;
+    while (sim::agoraUs() - inicio < limite)
+    {
+        for (; vistas < respostas.size(); vistas++)
+            if (contem(respostas[vistas], trecho))
+                return respostas[vistas];
+        loop();
+        sim::avancarUs(200);
+    }
+    return "";
+}
+
+// Pede a exportacao a partir de `inicio`; confere que os pedacos inicio..total-1
+// chegaram uma vez, em ordem, com o modelo da posicao certa. Retorna os segundos simulados.
+static double exportar(uint32_t transferencia, uint16_t inicio, uint16_t modelos, bool queda, bool &ok)
+{
+    arquivo.clear();
+    respostas.clear();
+    char pedido[64];
+    snprintf(pedido, sizeof(pedido), "{\"transferencia\":%lu,\"inicio\":%u}", (unsigned long)transferencia, inicio);
+    uint64_t t0 = sim::agoraUs();
+    sim::publicarNoBroker(TOPICO_EXPORTAR, pedido, false);
+    if (queda)
+    {
+        // O Wi-Fi cai depois de alguns pedacos: a tarefa de acesso para com a fila cheia
+        uint64_t agora = sim::agoraUs();
+        sim::agendar(agora + 2 * S, []
+                     { sim::definirWiFi(false); });
+        sim::agendar(agora + 5 * S, []
+                     { sim::definirWiFi(true); });
+    }
+    std::string fim = esperarResposta("\"status\":\"concluida\"", 120 * S);
+    double segundos = (sim::agoraUs() - t0) / 1e6;
+
+    bool ordem = arquivo.size() == (size_t)(modelos - inicio);
+    for (size_t i = 0; ordem && i < arquivo.size(); i++)
+    {
+        PedacoModelo pedaco;
+        ordem = decodificarPedaco(arquivo[i].data(), arquivo[i].size(), pedaco) == PEDACO_OK &&
+                pedaco.transferencia == transferencia && pedaco.indice == inicio + i && pedaco.total == modelos &&
+                pedaco.slot == inicio + i + 1 && ((pedaco.modelo[2] << 8) | pedaco.modelo[3]) == pedaco.slot;
+    }
+    bool certo = !fim.empty() && ordem;
+    ok = ok && certo;
+    printf("  exportacao %lu a partir de %u%s: %zu pedacos em %.1f s (%.1f modelos/s): %s\n",
+           (unsigned long)transferencia, inicio, queda ? " com o Wi-Fi caindo 3 s" : "", arquivo.size(), segundos,
+           arquivo.size() / segundos, certo ? "ok" : "ERRO");
+    return segundos;
+}
+
+// Publica um pedaco e espera a resposta de importacao dele.
+static std::string importar(const std::vector<uint8_t> &bytes, const char *topico)
+{
+    size_t vistas = respostas.size();
+    sim::publicarNoBroker(topico, bytes.data(), bytes.size(), false);
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < 3 * S)
+    {
+        for (; vistas < respostas.size(); vistas++)
+            if (contem(respostas[vistas], "\"operacao\":\"importacao\""))
+                return respostas[vistas];
+        loop();
+        sim::avancarUs(200);
+    }
+    return "";
+}
+
+static bool restaurar(const std::vector<std::vector<uint8_t>> &copia, uint16_t modelos)
+{
+    bool ok = true;
+    sim::apagarDigitais();
+    respostas.clear();
+
+    uint16_t corrompido = 10, repetido = 20, reinicio = modelos / 2;
+    uint32_t recusados = 0, repetidos = 0, gravados = 0;
+    uint64_t t0 = sim::agoraUs();
+    uint16_t indice = 0;
+    bool reiniciou = false;
+    while (indice < modelos)
+    {
+        if (indice == reinicio && !reiniciou)
+        {
+            // Reinicio: o progresso na RAM se perde e volta da NVS; ao reconectar o no
+            // publica de onde continuar
+            reiniciou = true;
+            progressoImportacao.zerar();
+            bool daNvs = carregarProgressoImportacao();
+            sim::definirWiFi(false);
+            rodar(2 * S);
+            respostas.clear();
+            sim::definirWiFi(true);
+            std::string conexao = esperarResposta("\"status\":\"conexao\"", 30 * S);
+            long proximo = lerCampo(conexao, "proximo");
+            bool certo = daNvs && proximo == reinicio;
+            ok = ok && certo;
+            printf("  reinicio no indice %u: progresso da NVS %s, proximo %ld na conexao: %s\n", reinicio,
+                   daNvs ? "lido" : "ausente", proximo, certo ? "ok" : "ERRO");
+            if (proximo >= 0)
+                indice = (uint16_t)proximo;
+        }
+
+        const char *topico = indice < modelos / 2 ? TOPICO_IMPORTAR : TOPICO_IMPORTAR_TODOS;
+        std::vector<uint8_t> bytes = copia[indice];
+        if (indice == corrompido)
+        {
+            corrompido = UINT16_MAX;
+            bytes[100] ^= 0x10;
+            std::string resposta = importar(bytes, topico);
+            bool certo = contem(resposta, "\"status\":\"recusado\"") && contem(resposta, "crc errado") &&
+                         lerCampo(resposta, "proximo") == indice;
+            ok = ok && certo;
+            recusados++;
+            printf("  pedaco %u corrompido: %s: %s\n", indice, resposta.c_str(), certo ? "ok" : "ERRO");
+            continue; // Reenvia o mesmo indice
+        }
+
+        std::string resposta = importar(bytes, topico);
+        if (contem(resposta, "\"status\":\"gravado\"") || contem(resposta, "\"status\":\"concluida\""))
+            gravados++;
+        else
+        {
+            ok = false;
+            printf("  pedaco %u: %s: ERRO\n", indice, resposta.empty() ? "(sem resposta)" : resposta.c_str());
+        }
+        if (indice == repetido)
+        {
+            repetido = UINT16_MAX;
+            std::string outra = importar(bytes, topico);
+            bool certo = contem(outra, "\"status\":\"repetido\"") && lerCampo(outra, "recebidos") == indice + 1;
+            ok = ok && certo;
+            repetidos++;
+            printf("  pedaco %u repetido: %s: %s\n", indice, outra.c_str(), certo ? "ok" : "ERRO");
+        }
+        indice++;
+    }
+    double segundos = (sim::agoraUs() - t0) / 1e6;
+    printf("  restauracao: %lu gravados, %lu recusados, %lu repetidos em %.1f s (inclui o reinicio)\n",
+           (unsigned long)gravados, (unsigned long)recusados, (unsigned long)repetidos, segundos);
+
+    // Taxa sem interrupcoes: mais uma restauracao completa, com outra transferencia
+    sim::apagarDigitais();
+    t0 = sim::agoraUs();
+    uint16_t certos = 0;
+    for (uint16_t i = 0; i < modelos; i++)
+    {
+        PedacoModelo pedaco;
+        decodificarPedaco(copia[i].data(), copia[i].size(), pedaco);
+        pedaco.transferencia = 99;
+        std::vector<uint8_t> bytes(TAMANHO_PEDACO);
+        codificarPedaco(pedaco, bytes.data(), bytes.size());
+        std::string resposta = importar(bytes, TOPICO_IMPORTAR_TODOS);
+        certos += contem(resposta, "\"status\":\"gravado\"") || contem(resposta, "\"status\":\"concluida\"");
+    }
+    segundos = (sim::agoraUs() - t0) / 1e6;
+    bool todos = certos == modelos;
+    ok = ok && todos;
+    printf("  restauracao sem falhas: %u de %u em %.1f s (%.1f modelos/s): %s\n", certos, modelos, segundos,
+           modelos / segundos, todos ? "ok" : "ERRO");
+
+    uint16_t iguais = 0;
+    for (uint16_t slot = 0; slot <= CAPACIDADE_EMULADOR; slot++)
+        iguais += sim::digitalGravada(slot) == (slot >= 1 && slot <= modelos ? slot : 0);
+    bool biblioteca = iguais == CAPACIDADE_EMULADOR + 1;
+    ok = ok && biblioteca;
+    printf("  biblioteca restaurada igual a original: %u de %u posicoes: %s\n", iguais, CAPACIDADE_EMULADOR + 1,
+           biblioteca ? "ok" : "ERRO");
+    return ok;
+}
+
+// Botao e dedo sobre o sensor; true se a porta destravou.
+static bool tentar(uint16_t dedo)
+{
+    travaAberta = false;
+    uint64_t t = sim::agoraUs();
+    sim::agendar(t, []
+                 { sim::definirEntrada(PINO_BOTAO, LOW); });
+    sim::agendar(t + 300 * MS, []
+                 { sim::definirEntrada(PINO_BOTAO, HIGH); });
+    sim::agendar(t + 500 * MS, [dedo]
+                 { sim::definirDedo(true, dedo); });
+    sim::agendar(t + 1500 * MS, []
+                 { sim::definirDedo(false); });
+    rodar(3 * S);
+    return travaAberta;
+}
+
+static bool executarFirmware(uint16_t modelos)
+{
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::aoPublicar(aoPublicar);
+    sim::aoEscreverPino([](uint64_t, uint8_t pino, uint8_t nivel)
+                        {
+        if (pino == PINO_TRAVA && nivel == HIGH)
+            travaAberta = true; });
+    setup();
+    for (uint16_t id = 1; id <= modelos; id++)
+        sim::cadastrarDigital(id);
+    rodar(5 * S);
+
+    bool ok = true;
+    printf("firmware (%u modelos, sensor a 57600 baud):\n", modelos);
+    exportar(7, 0, modelos, false, ok);
+    std::vector<std::vector<uint8_t>> copia = arquivo;
+    exportar(8, modelos / 2, modelos, true, ok);
+    ok = copia.size() == modelos && restaurar(copia, modelos) && ok;
+
+    bool liberado = tentar(modelos);
+    bool negado = !tentar(modelos + 1);
+    ok = ok && liberado && negado;
+    printf("  dedo %u restaurado libera: %s, dedo %u fora da copia nao libera: %s\n", modelos, liberado ? "ok" : "ERRO",
+           modelos + 1, negado ? "ok" : "ERRO");
+
+    sim::aoPublicar(nullptr);
+    sim::aoEscreverPino(nullptr);
+    remove("bench_caixa.bin");
+    remove("bench_nvs.bin");
+    return ok;
+}
+
+int benchModelos(int argc, char **argv)
+{
+    uint16_t modelos = (uint16_t)opcaoNumero(argc, argv, "--modelos", 150);
+    uint32_t pedacos = (uint32_t)opcaoNumero(argc, argv, "--pedacos", 20000);
+    if (modelos < 30 || modelos >= CAPACIDADE_EMULADOR)
+    {
+        printf("--modelos deve ficar entre 30 e %u\n", CAPACIDADE_EMULADOR - 1);
+        return 1;
+    }
+
+    printf("\n=== benchmark modelos ===\n");
+    bool ok = medirPedacos(pedacos);
+    ok = executarFirmware(modelos) && ok;
+
+    if (!ok)
+        printf("FALHA\n");
+    else
+        printf("ok: pedacos integros, copia exportada e restaurada com retomada\n");
+    return ok ? 0 : 1;
+}
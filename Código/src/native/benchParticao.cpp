@@ -0,0 +1,286 @@
+#include <Arduino.h>
+#include <math.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "diagnostico.h"
+#include "sensorDeDigitais.h"
+#include "particaoQuente.h"
+
+// ====================================================================================
+// BENCHMARK DA PARTICAO QUENTE DA BIBLIOTECA
+// ====================================================================================
+// Dirige a verificacao assincrona do FingerprintSensor (sem o restante do loop())
+// contra o modulo emulado com os tempos de um AS608 e uma biblioteca de 1000 posicoes,
+// com e sem a particao quente de 32 posicoes do firmware (iniciarParticaoQuente() e
+// passoParticaoQuente() de main.cpp, como com -D SAFEZONE_PARTICAO_QUENTE=32).
+// 1) Quem entra segue uma distribuicao de Zipf (s = 0,8 e 1,1) sobre os cadastrados, em
+//    posicoes sorteadas; 5% sao dedos sem cadastro, que percorrem as duas faixas. Depois
+//    de um aquecimento, mede do inicio da verificacao ate a decisao, os acertos e o tempo
+//    de cada camada da busca (etapas busca_quente e busca_completa do diagnostico). Cada
+//    decisao precisa sair com a posicao de cadastro certa.
+// 2) Modelos que mudam: um dedo com copia na particao tem o modelo trocado (como na
+//    importacao) e nao pode ser aceito pela copia antiga; uma queda no meio de uma copia
+//    nao pode deixar a posicao reservada apontando para o dedo errado; as copias
+//    confirmadas voltam da NVS no reinicio.
+// Opcoes:
+//   --acessos N      acessos medidos por linha da tabela (padrao 1500)
+//   --verbose        ecoa o console do firmware
+
+static const uint16_t CAPACIDADE = 1000;
+static const uint8_t PARTICAO = 32;
+static const uint16_t USUARIOS_MAXIMO = CAPACIDADE - PARTICAO; // Posicoes 1 a 968
+
+extern FingerprintSensor sensorDigital;
+extern ParticaoQuente particaoQuente;
+bool iniciarParticaoQuente(uint8_t tamanho);
+void passoParticaoQuente();
+bool gravarParticaoQuente();
+
+static uint32_t sortear(uint32_t &semente)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+// Posicoes sorteadas entre 1 e USUARIOS_MAXIMO, na ordem da popularidade.
+static std::vector<uint16_t> preencher(uint16_t usuarios, uint32_t &semente)
+{
+    std::vector<uint16_t> slots;
+    for (uint16_t slot = 1; slot <= USUARIOS_MAXIMO; slot++)
+        slots.push_back(slot);
+    for (size_t i = slots.size() - 1; i > 0; i--)
+        std::swap(slots[i], slots[sortear(semente) % (i + 1)]);
+    slots.resize(usuarios);
+
+    sim::apagarDigitais();
+    for (uint16_t slot : slots)
+        sim::cadastrarDigital(slot);
+    return slots;
+}
+
+// Distribuicao acumulada de Zipf: o usuario de ordem r entra com peso 1 / r^s.
+static std::vector<double> zipf(uint16_t usuarios, double s)
+{
+    std::vector<double> acumulada(usuarios);
+    double soma = 0;
+    for (uint16_t r = 0; r < usuarios; r++)
+        acumulada[r] = soma += 1.0 / pow(r + 1, s);
+    for (double &a : acumulada)
+        a /= soma;
+    return acumulada;
+}
+
+static uint16_t sortearUsuario(const std::vector<double> &acumulada, uint32_t &semente)
+{
+    double u = (sortear(semente) % 1000000) / 1e6;
+    return std::lower_bound(acumulada.begin(), acumulada.end(), u) - acumulada.begin();
+}
+
+// Verificacao com o dedo ja no vidro; retorna o codigo e o tempo ate a decisao (us).
+static uint8_t verificar(uint16_t dedo, uint64_t &tempo)
+{
+    sim::definirDedo(true, dedo);
+    uint64_t inicio = sim::agoraUs();
+    sensorDigital.startVerification();
+    while (!sensorDigital.pollVerification())
+        sim::avancarUs(200);
+    tempo = sim::agoraUs() - inicio;
+    sim::definirDedo(false);
+    return sensorDigital.verificationResult();
+}
+
+static bool certa(uint8_t codigo, uint16_t dedo)
+{
+    if (!dedo)
+        return codigo == FINGERPRINT_NOTFOUND;
+    return codigo == FINGERPRINT_OK && sensorDigital.matchedSlot() == dedo;
+}
+
+// Ativa (ou desliga) a particao com a NVS vazia, como na primeira vez.
+static bool usarParticao(bool ativa)
+{
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    if (ativa)
+        return iniciarParticaoQuente(PARTICAO);
+    particaoQuente.configurar(CAPACIDADE, 0);
+    sensorDigital.useHotPartition(nullptr);
+    return true;
+}
+
+struct Resultado
+{
+    Amostras decisao; // us, do inicio da verificacao ate a decisao
+    unsigned erradas = 0;
+    EstatisticasCamada camadas[NUM_CAMADAS_BUSCA] = {};
+    EstatisticasEtapa quente = {};
+    EstatisticasEtapa completa = {};
+};
+
+// Um acesso e o intervalo ate o proximo, em que a tarefa de acesso faz as copias.
+static void acessar(const std::vector<uint16_t> &slots, const std::vector<double> &acumulada, uint32_t &semente,
+                    Resultado *resultado)
+{
+    uint16_t dedo = sortear(semente) % 20 == 0 ? 0 : slots[sortearUsuario(acumulada, semente)];
+    uint64_t tempo;
+    uint8_t codigo = verificar(dedo, tempo);
+    passoParticaoQuente();
+    sim::avancarUs(100000);
+    if (!resultado)
+        return;
+    resultado->decisao.registrar(tempo);
+    resultado->erradas += !certa(codigo, dedo);
+}
+
+static Resultado medir(const std::vector<uint16_t> &slots, double s, int acessos, uint32_t &semente)
+{
+    Resultado resultado;
+    std::vector<double> acumulada = zipf(slots.size(), s);
+    for (int i = 0; i < acessos / 2; i++) // Aquecimento: a particao aprende quem entra
+        acessar(slots, acumulada, semente, nullptr);
+
+    particaoQuente.zerarEstatisticas();
+    char descarte[TAMANHO_DIAGNOSTICO_JSON];
+    serializarDiagnostico(descarte, sizeof(descarte), millis(), 0); // Janela nova
+    resultado.decisao.reservar(acessos);
+    for (int i = 0; i < acessos; i++)
+        acessar(slots, acumulada, semente, &resultado);
+    for (uint8_t c = 0; c < NUM_CAMADAS_BUSCA; c++)
+        resultado.camadas[c] = particaoQuente.estatisticas((CamadaBusca)c);
+    resultado.quente = estatisticasEtapa(ETAPA_BUSCA_QUENTE);
+    resultado.completa = estatisticasEtapa(ETAPA_BUSCA_COMPLETA);
+    return resultado;
+}
+
+static double taxa(const EstatisticasCamada &camada)
+{
+    return camada.buscas ? 100.0 * camada.acertos / camada.buscas : 0;
+}
+
+static void imprimir(uint16_t usuarios, double s, const char *modo, Resultado &r)
+{
+    printf("%7u | %3.1f | %-7s | %7.1f | %7.1f | %7.1f | %7.1f | %8.1f | %8.1f | %s\n", (unsigned)usuarios, s, modo,
+           r.decisao.percentil(50) / 1e3, r.decisao.percentil(99) / 1e3, r.decisao.media() / 1e3,
+           taxa(r.camadas[BUSCA_QUENTE]), r.quente.p50Us / 1e3, r.completa.p50Us / 1e3, r.erradas ? "ERRO" : "ok");
+}
+
+static uint16_t posicaoDaCopia(uint16_t original)
+{
+    for (uint8_t i = 0; i < particaoQuente.tamanho(); i++)
+        if (particaoQuente.copias()[i] == original)
+            return particaoQuente.inicio() + i;
+    return 0;
+}
+
+// Troca de um modelo com copia, queda no meio de uma copia e reinicio.
+static bool conferirMudancas(const std::vector<uint16_t> &slots)
+{
+    std::vector<uint16_t> comCopia;
+    for (uint8_t i = 0; i < particaoQuente.tamanho(); i++)
+        if (particaoQuente.copias()[i])
+            comCopia.push_back(particaoQuente.copias()[i]);
+    std::vector<uint16_t> semCopia; // Os dois menos populares sem copia
+    for (auto slot = slots.rbegin(); slot != slots.rend() && semCopia.size() < 2; ++slot)
+        if (!posicaoDaCopia(*slot))
+            semCopia.push_back(*slot);
+    if (comCopia.size() < 3 || semCopia.size() < 2)
+    {
+        printf("mudancas: so %zu copias na particao: ERRO\n", comCopia.size());
+        return false;
+    }
+
+    // O modelo de comCopia[0] passa a ser o de outro dedo, como na importacao: o dedo
+    // antigo so continua na copia, que deixou de valer antes da gravacao
+    static uint8_t modelo[TAMANHO_MODELO];
+    uint16_t trocado = comCopia[0];
+    bool gravou = sensorDigital.readTemplate(semCopia[0], modelo) == FINGERPRINT_OK &&
+                  sensorDigital.writeTemplate(trocado, modelo) == FINGERPRINT_OK;
+    uint64_t tempo;
+    uint8_t codigo = verificar(trocado, tempo);
+    bool trocaCerta = gravou && codigo == FINGERPRINT_NOTFOUND && !posicaoDaCopia(trocado);
+    printf("modelo trocado na posicao %u (com copia): dedo antigo %s: %s\n", (unsigned)trocado,
+           codigo == FINGERPRINT_NOTFOUND ? "nao encontrado" : "aceito", trocaCerta ? "ok" : "ERRO");
+
+    // Queda no meio de uma copia: invalidada e gravada na NVS, copiada no sensor, sem
+    // confirmar. Depois do reinicio a posicao nao vale para nenhum dos dois dedos.
+    uint16_t substituido = comCopia[1];
+    uint16_t destino = posicaoDaCopia(substituido);
+    particaoQuente.invalidar(destino);
+    bool copiou = gravarParticaoQuente() && sensorDigital.copyTemplate(semCopia[1], destino) == FINGERPRINT_OK;
+    particaoQuente.configurar(CAPACIDADE, 0);
+    bool reiniciou = iniciarParticaoQuente(PARTICAO);
+    particaoQuente.zerarEstatisticas();
+    bool novoCerto = certa(verificar(semCopia[1], tempo), semCopia[1]);
+    bool antigoCerto = certa(verificar(substituido, tempo), substituido);
+    bool quedaCerta =
+        copiou && reiniciou && novoCerto && antigoCerto && particaoQuente.estatisticas(BUSCA_QUENTE).acertos == 0;
+    printf("queda no meio da copia para a posicao %u: dedos %u e %u nas posicoes de cadastro: %s\n",
+           (unsigned)destino, (unsigned)semCopia[1], (unsigned)substituido, quedaCerta ? "ok" : "ERRO");
+
+    // As copias confirmadas voltaram da NVS e continuam acertando na particao
+    uint16_t mantido = comCopia[2];
+    particaoQuente.zerarEstatisticas();
+    codigo = verificar(mantido, tempo);
+    bool reinicioCerto = certa(codigo, mantido) && particaoQuente.estatisticas(BUSCA_QUENTE).acertos == 1;
+    printf("reinicio: %u copias recuperadas da NVS, dedo %u na particao em %.1f ms: %s\n",
+           (unsigned)(comCopia.size() - 2), (unsigned)mantido, tempo / 1e3, reinicioCerto ? "ok" : "ERRO");
+    return trocaCerta && quedaCerta && reinicioCerto;
+}
+
+int benchParticao(int argc, char **argv)
+{
+    int acessos = (int)opcaoNumero(argc, argv, "--acessos", 1500);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::definirCapacidadeDigitais(CAPACIDADE);
+    Serial.begin(9600);
+    if (!sensorDigital.begin(57600) || sensorDigital.capacity() != CAPACIDADE)
+    {
+        printf("Sensor de digitais simulado nao respondeu.\n");
+        return 1;
+    }
+    sim::definirLatenciasDigitais(sim::LATENCIAS_AS608);
+
+    static const uint16_t USUARIOS[] = {100, 500, USUARIOS_MAXIMO};
+    static const double EXPOENTES[] = {0.8, 1.1};
+    uint32_t semente = 134;
+    bool ok = true;
+
+    printf("verificacao com o dedo no vidro, 57600 baud, modulo AS608, %u posicoes, particao de %u, %d acessos:\n",
+           (unsigned)CAPACIDADE, (unsigned)PARTICAO, acessos);
+    printf("%7s | %3s | %-7s | %7s | %7s | %7s | %7s | %8s | %8s |\n", "modelos", "s", "busca", "p50 ms", "p99 ms",
+           "media", "quente%", "quente", "completa");
+    std::vector<uint16_t> slots;
+    for (uint16_t usuarios : USUARIOS)
+    {
+        for (double s : EXPOENTES)
+        {
+            slots = preencher(usuarios, semente);
+            uint32_t sementeMedida = semente; // Mesma sequencia de acessos nos dois modos
+            usarParticao(false);
+            Resultado inteira = medir(slots, s, acessos, semente);
+            imprimir(usuarios, s, "inteira", inteira);
+
+            semente = sementeMedida;
+            if (!usarParticao(true))
+            {
+                printf("particao nao iniciou: ERRO\n");
+                return 1;
+            }
+            Resultado quente = medir(slots, s, acessos, semente);
+            imprimir(usuarios, s, "quente", quente);
+            ok = ok && !inteira.erradas && !quente.erradas;
+            printf("%7s   acertos: %.1f%% na particao, %.1f%% no resto; p50 %.1f -> %.1f ms, p99 %.1f -> %.1f ms\n",
+                   "", taxa(quente.camadas[BUSCA_QUENTE]), taxa(quente.camadas[BUSCA_COMPLETA]),
+                   inteira.decisao.percentil(50) / 1e3, quente.decisao.percentil(50) / 1e3,
+                   inteira.decisao.percentil(99) / 1e3, quente.decisao.percentil(99) / 1e3);
+        }
+    }
+    if (!SAFEZONE_PERFIL)
+        printf("(perfil desligado: sem o tempo por camada)\n");
+
+    ok = conferirMudancas(slots) && ok;
+    return ok ? 0 : 1;
+}
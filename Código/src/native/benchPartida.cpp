@@ -0,0 +1,220 @@
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "partida.h"
+#include "tarefas.h"
+
+// ====================================================================================
+// BENCHMARK DA PARTIDA (BOOT)
+// ====================================================================================
+// Firmware inteiro desde o reset, com o modulo de digitais emulado com os tempos de um
+// AS608 e um dedo cadastrado ja no vidro; o botao e apertado a cada 500 ms desde o
+// reset ate a porta abrir. Mede, em ms desde o reset:
+// - trava: a primeira escrita (LOW) no pino da trava;
+// - setup: o retorno do setup();
+// - acesso: acessoLocalProntoMs() (trava, NVS e sensor de digitais prontos), com alvo
+//   abaixo de 500 ms em qualquer cenario de rede;
+// - abertura: a primeira borda de subida da trava;
+// - wifi, mqtt: o fim das fases no relatorio;
+// - relatorio: a chegada do relatorio no topico de boot, que precisa sair quando o
+//   broker esta (ou volta a ficar) disponivel, com todas as fases e o mesmo acesso_ms.
+// Cenarios: rede ok, Wi-Fi fora, broker fora (volta em 15 s), rede ok com tarefas e
+// com tarefas em que a terceira nao pode ser criada (o firmware segue no loop()
+// cooperativo). Em todos o sensor de digitais e a caixa de saida precisam subir uma
+// unica vez.
+// Cada cenario roda num processo filho (fork), pois o setup() so roda uma vez por reset.
+// Opcoes:
+//   --duracao-s N   tempo simulado por cenario (padrao 40)
+//   --verbose       ecoa o console do firmware
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const uint8_t PINO_BOTAO = 12;
+static const uint8_t PINO_TRAVA = 25;
+static const uint16_t SLOT = 7;
+static const uint32_t ALVO_ACESSO_MS = 500;
+static const char *TOPICO_BOOT = "safezone/134/boot";
+
+static std::atomic<uint64_t> travaEm{0};    // us + 1
+static std::atomic<uint64_t> aberturaEm{0}; // us + 1
+static std::atomic<uint64_t> relatorioEm{0};
+static std::string relatorio;
+
+// Conta as inicializacoes do sensor de digitais e da caixa de saida no console.
+class Console : public DispositivoSerial
+{
+public:
+    void receber(uint8_t byte) override
+    {
+        if (byte != '\n')
+        {
+            linha += (char)byte;
+            return;
+        }
+        if (linha.find("Iniciando o sistema de impressao digital") != std::string::npos)
+            iniciosSensor++;
+        if (linha.find("aixa de saida") != std::string::npos)
+            iniciosCaixa++;
+        linha.clear();
+    }
+
+    std::string linha;
+    unsigned iniciosSensor = 0;
+    unsigned iniciosCaixa = 0;
+};
+
+static Console console;
+
+struct CenarioPartida
+{
+    const char *nome;
+    bool wifi;
+    bool broker;
+    uint64_t brokerVoltaUs; // 0: nao muda
+    bool tarefas;
+    int limiteTarefas; // -1: todas sao criadas
+};
+
+// Inicio e fim da fase no JSON do relatorio; false se a fase saiu null ou nao esta la.
+static bool lerFase(const std::string &json, const char *nome, unsigned long &inicio, unsigned long &fim)
+{
+    std::string chave = std::string("\"") + nome + "\":[";
+    size_t posicao = json.find(chave);
+    return posicao != std::string::npos && sscanf(json.c_str() + posicao + chave.size(), "%lu,%lu", &inicio, &fim) == 2;
+}
+
+static bool formatoValido(const std::string &json, unsigned long acessoMs)
+{
+    unsigned long acesso = 0;
+    size_t posicao = json.find("\"acesso_ms\":");
+    if (json.compare(0, 10, "{\"fases\":{") != 0 || posicao == std::string::npos ||
+        sscanf(json.c_str() + posicao + 12, "%lu", &acesso) != 1 || acesso != acessoMs)
+        return false;
+    for (uint8_t i = 0; i < NUM_FASES_PARTIDA; i++)
+    {
+        unsigned long inicio, fim;
+        if (!lerFase(json, nomeFasePartida((FasePartida)i), inicio, fim) || fim < inicio)
+            return false;
+    }
+    return json.find("\"timestamp\":") != std::string::npos && json.back() == '}';
+}
+
+static double ms(uint64_t marcaUs)
+{
+    return marcaUs ? (marcaUs - 1) / 1e3 : -1;
+}
+
+static int executarCenario(const CenarioPartida &cenario, uint64_t duracao)
+{
+    sim::reiniciar(); // Reset: o relogio volta a zero
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::apagarDigitais();
+    sim::cadastrarDigital(SLOT);
+    sim::definirLatenciasDigitais(sim::LATENCIAS_AS608);
+    sim::definirDedo(true, SLOT);
+    sim::definirWiFi(cenario.wifi);
+    sim::definirBroker(cenario.broker);
+    if (cenario.brokerVoltaUs)
+        sim::agendar(cenario.brokerVoltaUs, []
+                     { sim::definirBroker(true); });
+    for (uint64_t t = 50 * MS; t < 10 * S; t += 500 * MS)
+    {
+        sim::agendar(t, []
+                     { sim::definirEntrada(PINO_BOTAO, LOW); });
+        sim::agendar(t + 150 * MS, []
+                     { sim::definirEntrada(PINO_BOTAO, HIGH); });
+    }
+    sim::aoEscreverPino([](uint64_t instante, uint8_t pino, uint8_t nivel)
+                        {
+        if (pino != PINO_TRAVA)
+            return;
+        uint64_t zero = 0;
+        travaEm.compare_exchange_strong(zero, instante + 1);
+        zero = 0;
+        if (nivel == HIGH)
+            aberturaEm.compare_exchange_strong(zero, instante + 1); });
+    sim::aoPublicar([](const char *topico, const uint8_t *dados, unsigned int tamanho)
+                    {
+        if (strcmp(topico, TOPICO_BOOT) == 0 && !relatorioEm)
+        {
+            relatorio.assign((const char *)dados, tamanho);
+            relatorioEm = sim::agoraUs() + 1;
+        } });
+    if (cenario.tarefas)
+    {
+        sim::usarTarefas(true);
+        sim::limitarTarefas(cenario.limiteTarefas);
+        sim::tempoReal(20);
+    }
+    Serial.conectar(&console);
+
+    setup();
+    uint64_t setupEm = sim::agoraUs() + 1;
+    while (sim::agoraUs() < duracao)
+    {
+        loop();
+        if (!cenario.tarefas)
+            sim::avancarUs(200);
+    }
+
+    char json[TAMANHO_PARTIDA_JSON];
+    std::string fases = serializarPartida(json, sizeof(json), 0) ? json : "";
+    unsigned long inicio, wifiMs = 0, mqttMs = 0;
+    bool wifi = lerFase(fases, "wifi", inicio, wifiMs);
+    bool mqtt = lerFase(fases, "mqtt", inicio, mqttMs);
+    uint32_t acesso = acessoLocalProntoMs();
+
+    // Sem broker o relatorio nao pode sair; com ele, completo
+    bool esperaRelatorio = cenario.wifi && (cenario.broker || cenario.brokerVoltaUs);
+    bool relatorioOk = esperaRelatorio ? relatorioEm && formatoValido(relatorio, acesso) : !relatorioEm;
+    bool tarefasOk = tarefasAtivas() == (cenario.tarefas && cenario.limiteTarefas < 0);
+    bool ok = travaEm && aberturaEm && acesso && acesso < ALVO_ACESSO_MS && relatorioOk && tarefasOk &&
+              console.iniciosSensor == 1 && console.iniciosCaixa == 1;
+    printf("%-22s | %6.1f | %6.1f | %6lu | %8.1f | %7.0f | %7.0f | %9.0f | %s\n", cenario.nome, ms(travaEm),
+           ms(setupEm), (unsigned long)acesso, ms(aberturaEm), wifi ? (double)wifiMs : -1.0,
+           mqtt ? (double)mqttMs : -1.0, ms(relatorioEm), ok ? "ok" : "ERRO");
+    if (esperaRelatorio && relatorioEm)
+        printf("  %s\n", relatorio.c_str());
+    if (console.iniciosSensor != 1 || console.iniciosCaixa != 1 || !tarefasOk)
+        printf("  sensor iniciado %u vezes, caixa %u vezes, tarefas %s\n", console.iniciosSensor,
+               console.iniciosCaixa, tarefasAtivas() ? "ativas" : "paradas");
+    fflush(stdout);
+    return ok ? 0 : 1;
+}
+
+int benchPartida(int argc, char **argv)
+{
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 40) * S);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    static const CenarioPartida CENARIOS[] = {
+        {"rede ok", true, true, 0, false, -1},
+        {"wifi fora", false, true, 0, false, -1},
+        {"broker volta em 15 s", true, false, 15 * S, false, -1},
+        {"rede ok, tarefas", true, true, 0, true, -1},
+        {"3a tarefa nao criada", true, true, 0, true, 2},
+    };
+
+    printf("partida desde o reset (ms; -1: nao aconteceu), AS608 a 57600 baud, dedo no vidro:\n");
+    printf("%-22s | %6s | %6s | %6s | %8s | %7s | %7s | %9s |\n", "cenario", "trava", "setup", "acesso",
+           "abertura", "wifi", "mqtt", "relatorio");
+    int falhas = 0;
+    for (const CenarioPartida &cenario : CENARIOS)
+    {
+        fflush(stdout);
+        pid_t filho = fork();
+        if (filho == 0)
+            _exit(executarCenario(cenario, duracao));
+        int estado = 0;
+        if (filho < 0 || waitpid(filho, &estado, 0) != filho || !WIFEXITED(estado) || WEXITSTATUS(estado) != 0)
+            falhas++;
+    }
+
+    printf("%s\n", falhas ? "ERRO: ver os cenarios acima" : "ok: acesso local sem esperar a rede, relatorio completo");
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+#include <Arduino.h>
+#include <queue>
+#include "bancada.h"
+#include "conexaoMqtt.h"
+
+// ====================================================================================
+// BENCHMARK DE RECUPERACAO DA FROTA APOS REINICIO DO BROKER
+// ====================================================================================
+// Simula N dispositivos aplicando a politica de esperaReconexaoMqtt() depois que o
+// broker cai e volta. O broker aceita no maximo C conexoes por segundo; as tentativas
+// excedentes falham e custam o timeout da tentativa. Compara com a politica antiga
+// (nova tentativa a cada 5 s) e com o backoff sem jitter.
+// Opcoes:
+//   --nos N          dispositivos (padrao 500)
+//   --queda-s N      duracao da queda do broker (padrao 30)
+//   --capacidade N   conexoes aceitas por segundo (padrao 50)
+
+struct Tentativa
+{
+    uint64_t instanteMs;
+    int no;
+    bool operator>(const Tentativa &outra) const { return instanteMs > outra.instanteMs; }
+};
+
+enum Politica
+{
+    POLITICA_FIXA_5S,
+    POLITICA_BACKOFF_SEM_JITTER,
+    POLITICA_BACKOFF_JITTER
+};
+
+static uint32_t sortear(uint32_t &estado)
+{
+    estado ^= estado << 13;
+    estado ^= estado >> 17;
+    estado ^= estado << 5;
+    return estado;
+}
+
+static void simular(const char *nome, Politica politica, int nos, uint64_t quedaMs, int capacidade)
+{
+    const uint64_t TIMEOUT_TENTATIVA_MS = 1000;
+    std::priority_queue<Tentativa, std::vector<Tentativa>, std::greater<Tentativa>> fila;
+    std::vector<uint8_t> falhas(nos, 0);
+    uint32_t semente = 134;
+
+    // Cada no percebe a queda em ate 1 s e agenda a primeira tentativa.
+    for (int no = 0; no < nos; no++)
+    {
+        uint64_t deteccao = sortear(semente) % 1000;
+        uint64_t espera = politica == POLITICA_FIXA_5S ? 0 : esperaReconexaoMqtt(0, politica == POLITICA_BACKOFF_JITTER ? sortear(semente) : 0);
+        fila.push({deteccao + espera, no});
+    }
+
+    Amostras recuperacao;
+    unsigned long tentativas = 0;
+    uint64_t segundoAtual = UINT64_MAX;
+    int aceitasNoSegundo = 0;
+    int picoTentativas = 0, tentativasNoSegundo = 0;
+
+    while (!fila.empty())
+    {
+        Tentativa t = fila.top();
+        fila.pop();
+        tentativas++;
+
+        uint64_t segundo = t.instanteMs / 1000;
+        if (segundo != segundoAtual)
+        {
+            segundoAtual = segundo;
+            aceitasNoSegundo = 0;
+            tentativasNoSegundo = 0;
+        }
+        tentativasNoSegundo++;
+        picoTentativas = std::max(picoTentativas, tentativasNoSegundo);
+
+        if (t.instanteMs >= quedaMs && aceitasNoSegundo < capacidade)
+        {
+            aceitasNoSegundo++;
+            recuperacao.registrar(t.instanteMs - quedaMs);
+            continue;
+        }
+
+        uint64_t espera;
+        if (politica == POLITICA_FIXA_5S)
+            espera = 5000;
+        else
+            espera = esperaReconexaoMqtt(falhas[t.no], politica == POLITICA_BACKOFF_JITTER ? sortear(semente) : 0);
+        if (falhas[t.no] < 255)
+            falhas[t.no]++;
+        fila.push({t.instanteMs + TIMEOUT_TENTATIVA_MS + espera, t.no});
+    }
+
+    printf("%-22s tentativas %7lu | pico %5d/s | apos a volta: p50 %6llu  p99 %6llu  max %6llu ms\n",
+           nome, tentativas, picoTentativas,
+           (unsigned long long)recuperacao.percentil(50), (unsigned long long)recuperacao.percentil(99),
+           (unsigned long long)recuperacao.maximo());
+}
+
+int benchReconexao(int argc, char **argv)
+{
+    int nos = (int)opcaoNumero(argc, argv, "--nos", 500);
+    uint64_t quedaMs = (uint64_t)(opcaoNumero(argc, argv, "--queda-s", 30) * 1000);
+    int capacidade = (int)opcaoNumero(argc, argv, "--capacidade", 50);
+
+    printf("\n=== benchmark reconexao (%d nos, queda de %llu s, broker aceita %d/s) ===\n",
+           nos, (unsigned long long)(quedaMs / 1000), capacidade);
+    simular("fixa 5 s (antiga)", POLITICA_FIXA_5S, nos, quedaMs, capacidade);
+    simular("backoff sem jitter", POLITICA_BACKOFF_SEM_JITTER, nos, quedaMs, capacidade);
+    simular("backoff com jitter", POLITICA_BACKOFF_JITTER, nos, quedaMs, capacidade);
+    return 0;
+}
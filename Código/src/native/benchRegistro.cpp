@@ -0,0 +1,323 @@
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "bancada.h"
+#include "simulador.h"
+#include "registro.h"
+
+// ====================================================================================
+// BENCHMARK DO REGISTRO ASSINCRONO
+// ====================================================================================
+// 1) Custo para quem chama, em tempo simulado, com o monitor serial a 9600 baud (FIFO de
+//    128 bytes): as linhas que o firmware escrevia a cada verificacao (espacadas de 2 s)
+//    e as do boot, de uma vez, escritas direto com Serial.printf() e pelo registro. A tarefa de registro roda a cada 10 ms; toda linha
+//    precisa sair, na ordem, e mede-se o atraso ate o fim da linha na serial.
+// 2) Custo de CPU do host por chamada: mensagem formatada na fila, nivel compilado fora
+//    (REGISTRAR_DEPURACAO com o padrao SAFEZONE_REGISTRO=3) e fila cheia.
+// 3) Fila cheia: mensagens alem da capacidade sao descartadas e contadas, e o aviso com a
+//    contagem sai no registro.
+// 4) Produtores em threads (cedendo a CPU a cada 8 mensagens) contra a tarefa de registro
+//    em outra: toda mensagem chega inteira e na ordem de cada produtor, ou e contada
+//    como descartada.
+// Opcoes:
+//   --chamadas N     chamadas por medida de custo (padrao 1000000)
+//   --mensagens N    mensagens por produtor no teste entre threads (padrao 20000)
+//   --produtores N   threads produtoras (padrao 3)
+
+static const uint64_t MS = 1000;
+static const uint64_t S = 1000000;
+
+static volatile uint32_t sumidouro;
+
+// Bytes que saem pela serial, com o instante (us simulados) de cada fim de linha.
+class Captura : public DispositivoSerial
+{
+public:
+    void receber(uint8_t byte) override
+    {
+        if (byte == '\n')
+        {
+            linhas.push_back(atual);
+            fins.push_back(sim::agoraUs());
+            atual.clear();
+        }
+        else if (byte != '\r')
+            atual += (char)byte;
+    }
+    void limpar()
+    {
+        linhas.clear();
+        fins.clear();
+        atual.clear();
+    }
+
+    std::vector<std::string> linhas;
+    std::vector<uint64_t> fins;
+    std::string atual;
+};
+
+static Captura captura;
+
+// Texto da linha sem o prefixo "[segundos.ms N] ".
+static const char *textoLinha(const std::string &linha)
+{
+    size_t fim = linha.find("] ");
+    return fim == std::string::npos ? "" : linha.c_str() + fim + 2;
+}
+
+// Esvazia a fila sem a linha limitar (serial sem baud).
+static void esvaziar()
+{
+    unsigned long baud = Serial.baudRate();
+    Serial.end();
+    passoRegistro();
+    if (baud)
+        Serial.begin(baud);
+}
+
+// O que o firmware escrevia a cada verificacao
+static const char *MENSAGENS_VERIFICACAO[] = {
+    "Coloque o dedo no sensor para verificar...",
+    "Aguardando o dedo...",
+    "Impressao digital encontrada!",
+    "ID: 17 | Confianca: 143",
+    "[MQTT] Acesso liberado (liberado)",
+};
+
+static const char *MENSAGENS_BOOT[] = {
+    "Conectando ao WiFi: SENAI-134",
+    "Caixa de saida: 12 eventos pendentes.",
+    "Configuracao carregada da NVS.",
+    "Sensor de pressão iniciado",
+    "Lista de acesso v42: 120 cadastros.",
+    "Iniciando o sistema de impressao digital...",
+    "Sensor de impressao digital encontrado!",
+    "Capacidade de armazenamento: 162 | Nivel de seguranca: 3",
+    "Sistema de seguranca iniciado (tarefas).",
+};
+
+struct Custo
+{
+    Amostras chamada; // us simulados dentro das chamadas de um grupo
+    Amostras atraso;  // us da chamada ate o fim da linha na serial (so no registro)
+    bool certo = true;
+};
+
+// Escreve `grupos` grupos de mensagens, um a cada `intervalo`, e roda a tarefa de
+// registro a cada 10 ms ate `intervalo` depois do ultimo.
+static Custo medirCusto(bool registro, const char *const *mensagens, size_t quantidade, int grupos, uint64_t intervalo)
+{
+    Custo custo;
+    captura.limpar();
+    std::vector<uint64_t> enviadas;
+    std::vector<std::string> esperadas;
+    for (int g = 0; g < grupos; g++)
+    {
+        uint64_t inicioGrupo = sim::agoraUs();
+        for (size_t i = 0; i < quantidade; i++)
+        {
+            enviadas.push_back(sim::agoraUs());
+            esperadas.push_back(mensagens[i]);
+            if (registro)
+                REGISTRAR_INFO("%s", mensagens[i]);
+            else
+                Serial.printf("%s\r\n", mensagens[i]);
+        }
+        custo.chamada.registrar(sim::agoraUs() - inicioGrupo);
+
+        uint64_t proximo = inicioGrupo + intervalo;
+        while (sim::agoraUs() < proximo)
+        {
+            if (registro)
+                passoRegistro();
+            sim::avancarUs(10 * MS);
+        }
+    }
+
+    custo.certo = captura.linhas.size() == esperadas.size();
+    for (size_t i = 0; custo.certo && i < esperadas.size(); i++)
+    {
+        const char *texto = registro ? textoLinha(captura.linhas[i]) : captura.linhas[i].c_str();
+        custo.certo = esperadas[i] == texto;
+        if (registro)
+            custo.atraso.registrar(captura.fins[i] - enviadas[i]);
+    }
+    return custo;
+}
+
+static bool compararCusto(const char *nome, const char *const *mensagens, size_t quantidade, int grupos,
+                          uint64_t intervalo)
+{
+    Custo direto = medirCusto(false, mensagens, quantidade, grupos, intervalo);
+    Custo fila = medirCusto(true, mensagens, quantidade, grupos, intervalo);
+    bool ok = direto.certo && fila.certo && fila.chamada.maximo() == 0;
+    printf("%-14s | %9.1f | %9.1f | %9.3f | %9.1f | %9.1f | %s\n", nome, direto.chamada.percentil(50) / 1e3,
+           direto.chamada.maximo() / 1e3, fila.chamada.maximo() / 1e3, fila.atraso.percentil(50) / 1e3,
+           fila.atraso.maximo() / 1e3, ok ? "ok" : "ERRO");
+    return ok;
+}
+
+static bool testarCustoChamador()
+{
+    printf("custo para quem chama (tempo simulado), monitor serial a 9600 baud:\n");
+    printf("%-14s | %9s | %9s | %9s | %9s | %9s |\n", "mensagens", "dir p50", "dir max", "fila max", "saida p50",
+           "saida max");
+    printf("%-14s | %9s | %9s | %9s | %9s | %9s |\n", "", "ms", "ms", "ms", "ms", "ms");
+    sim::congelarHost(true);
+    Serial.begin(9600);
+    bool ok = compararCusto("verificacao", MENSAGENS_VERIFICACAO,
+                            sizeof(MENSAGENS_VERIFICACAO) / sizeof(MENSAGENS_VERIFICACAO[0]), 20, 2 * S);
+    ok = compararCusto("boot", MENSAGENS_BOOT, sizeof(MENSAGENS_BOOT) / sizeof(MENSAGENS_BOOT[0]), 1, 3 * S) && ok;
+    sim::congelarHost(false);
+    return ok;
+}
+
+static bool testarCustoCpu(uint64_t chamadas)
+{
+    Serial.end();
+    esvaziar();
+
+    // Lotes que cabem na fila, esvaziada entre eles (fora da medida)
+    uint64_t total = 0;
+    for (uint64_t feitas = 0; feitas < chamadas; feitas += CAPACIDADE_REGISTRO)
+    {
+        uint64_t t0 = relogioHostNs();
+        for (uint8_t i = 0; i < CAPACIDADE_REGISTRO; i++)
+            REGISTRAR_INFO("Impressao digital encontrada! ID: %u | Confianca: %u", (unsigned)i, 143u);
+        total += relogioHostNs() - t0;
+        esvaziar();
+    }
+    double naFila = (double)total / chamadas;
+
+    uint64_t t0 = relogioHostNs();
+    for (uint64_t i = 0; i < chamadas; i++)
+    {
+        REGISTRAR_DEPURACAO("Passo %lu", (unsigned long)i);
+        sumidouro = (uint32_t)i;
+    }
+    double compiladoFora = (double)(relogioHostNs() - t0) / chamadas;
+
+    for (uint8_t i = 0; i < CAPACIDADE_REGISTRO; i++)
+        REGISTRAR_INFO("Enchendo a fila");
+    uint32_t descartesAntes = descartesRegistro();
+    t0 = relogioHostNs();
+    for (uint64_t i = 0; i < chamadas; i++)
+        REGISTRAR_INFO("Impressao digital encontrada! ID: %u | Confianca: %u", (unsigned)i, 143u);
+    double cheia = (double)(relogioHostNs() - t0) / chamadas;
+    bool contados = descartesRegistro() - descartesAntes == chamadas;
+    esvaziar();
+
+    printf("custo por chamada (host): na fila %.1f ns | nivel compilado fora %.2f ns | fila cheia %.1f ns%s\n", naFila,
+           compiladoFora, cheia, contados ? "" : " (descartes nao contados: ERRO)");
+    return contados;
+}
+
+static bool testarDescartes()
+{
+    Serial.end();
+    esvaziar();
+    captura.limpar();
+
+    const unsigned enviadas = 100;
+    uint32_t antes = descartesRegistro();
+    unsigned aceitas = 0;
+    for (unsigned i = 0; i < enviadas; i++)
+        aceitas += registrar(REGISTRO_INFO, "Mensagem %u", i);
+    uint32_t descartadas = descartesRegistro() - antes;
+    esvaziar();
+
+    char aviso[64];
+    snprintf(aviso, sizeof(aviso), "%lu mensagens do registro descartadas (fila cheia).", (unsigned long)descartadas);
+    bool avisou = false;
+    unsigned entregues = 0;
+    for (const std::string &linha : captura.linhas)
+    {
+        avisou = avisou || strcmp(textoLinha(linha), aviso) == 0;
+        entregues += strncmp(textoLinha(linha), "Mensagem ", 9) == 0;
+    }
+    bool ok = aceitas == CAPACIDADE_REGISTRO && descartadas == enviadas - aceitas && entregues == aceitas && avisou;
+    printf("fila cheia: %u mensagens, %u aceitas, %lu descartadas e contadas, %u entregues, aviso %s: %s\n", enviadas,
+           aceitas, (unsigned long)descartadas, entregues, avisou ? "sim" : "nao", ok ? "ok" : "ERRO");
+    return ok;
+}
+
+static bool testarThreads(unsigned produtores, unsigned long mensagens)
+{
+    Serial.end();
+    esvaziar();
+    captura.limpar();
+
+    std::atomic<bool> parar{false};
+    std::atomic<unsigned long> aceitas{0};
+    uint32_t descartesAntes = descartesRegistro();
+    std::thread consumidor([&]
+                           {
+        while (!parar.load(std::memory_order_acquire))
+            passoRegistro();
+        passoRegistro(); });
+
+    uint64_t t0 = relogioHostNs();
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < produtores; p++)
+        threads.emplace_back([&, p]
+                             {
+            unsigned long n = 0;
+            for (unsigned long i = 0; i < mensagens; i++)
+            {
+                n += registrar(REGISTRO_INFO, "p%u n%lu c%08lx", p, i, (unsigned long)((p + 1) * 2654435761u ^ i));
+                if (i % 8 == 7)
+                    std::this_thread::yield();
+            }
+            aceitas += n; });
+    for (std::thread &t : threads)
+        t.join();
+    parar.store(true, std::memory_order_release);
+    consumidor.join();
+    double segundos = (relogioHostNs() - t0) / 1e9;
+    uint32_t descartadas = descartesRegistro() - descartesAntes;
+
+    // Cada linha inteira, com a soma certa e na ordem do seu produtor
+    std::vector<long> ultima(produtores, -1);
+    unsigned long entregues = 0, rasgadas = 0;
+    for (const std::string &linha : captura.linhas)
+    {
+        const char *texto = textoLinha(linha);
+        if (strstr(texto, "descartadas"))
+            continue;
+        unsigned p;
+        unsigned long n, c;
+        if (sscanf(texto, "p%u n%lu c%08lx", &p, &n, &c) != 3 || p >= produtores ||
+            c != (unsigned long)((p + 1) * 2654435761u ^ n) || (long)n <= ultima[p])
+        {
+            rasgadas++;
+            continue;
+        }
+        ultima[p] = n;
+        entregues++;
+    }
+    unsigned long total = produtores * mensagens;
+    bool ok = rasgadas == 0 && entregues == aceitas && aceitas + descartadas == total;
+    printf("threads: %u produtores x %lu mensagens em %.2f s: %lu entregues, %lu descartadas, %lu rasgadas ou fora "
+           "de ordem: %s\n",
+           produtores, mensagens, segundos, entregues, (unsigned long)descartadas, rasgadas, ok ? "ok" : "ERRO");
+    return ok;
+}
+
+int benchRegistro(int argc, char **argv)
+{
+    uint64_t chamadas = (uint64_t)opcaoNumero(argc, argv, "--chamadas", 1000000);
+    unsigned long mensagens = (unsigned long)opcaoNumero(argc, argv, "--mensagens", 20000);
+    unsigned produtores = (unsigned)opcaoNumero(argc, argv, "--produtores", 3);
+
+    Serial.conectar(&captura);
+    iniciarRegistro(Serial);
+
+    bool ok = testarCustoChamador();
+    ok = testarCustoCpu(chamadas) && ok;
+    ok = testarDescartes() && ok;
+    ok = testarThreads(produtores, mensagens) && ok;
+
+    Serial.conectar(nullptr);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include <Arduino.h>
+#include <atomic>
+#include <thread>
+#include "bancada.h"
+#include "simulador.h"
+#include "filaSpsc.h"
+#include "tarefas.h"
+#include "Monitoramento.h"
+#include "eventos.h"
+
+// ====================================================================================
+// BENCHMARK DAS TAREFAS E FILAS SPSC
+// ====================================================================================
+// 1) Estresse da FilaSpsc com duas threads: vazao com o produtor insistindo e
+//    descartes com consumidor lento. Confere que os itens aceitos chegam em ordem, sem
+//    perda nem repeticao, e que aceitos + descartados fecha com o total enviado.
+// 2) Firmware com multitarefa (uma std::thread por tarefa, relogio em tempo real
+//    acelerado) contra o cenario do benchmark "loop". Com --custo-publicacao-ms alto a
+//    tarefa de rede trava em cada publicacao e o controle de acesso deve seguir igual.
+// Opcoes:
+//   --itens N                 itens por rodada de estresse (padrao 5000000)
+//   --duracao-s N             tempo simulado do firmware (padrao 180)
+//   --fator N                 aceleracao do relogio em relacao ao host (padrao 20)
+//   --custo-publicacao-ms N   tempo gasto em cada publicacao MQTT (padrao 0.3)
+//   --verbose                 ecoa o Serial do firmware no terminal
+
+static const uint8_t PINO_TRAVA = 25;
+static const uint64_t S = 1000000;
+
+extern FilaSpsc<LeituraSensores, 16> filaLeituras;
+extern FilaSpsc<EventoAcesso, 8> filaAcessos;
+
+static std::atomic<unsigned long> aberturasTrava{0};
+
+// ------------------- ESTRESSE DA FILA -------------------
+
+struct Item
+{
+    uint32_t sequencia;
+    uint32_t verificacao;
+};
+
+// insistir: o produtor repete enviar() com a fila cheia (mede a vazao, sem perdas).
+// Sem insistir o item e descartado, como no firmware, e o consumidor e lento.
+static bool estressarFila(const char *nome, uint32_t itens, bool insistir)
+{
+    FilaSpsc<Item, 64> fila;
+
+    std::atomic<bool> terminou{false};
+    uint32_t aceitos = 0;
+    uint64_t inicio = relogioHostNs();
+
+    std::thread produtor([&]
+                         {
+        for (uint32_t i = 0; i < itens; i++)
+        {
+            Item item = {i, i * 2654435761u};
+            if (fila.enviar(item))
+                aceitos++;
+            else if (insistir)
+            {
+                while (!fila.enviar(item))
+                    std::this_thread::yield();
+                aceitos++;
+            }
+        }
+        terminou.store(true, std::memory_order_release); });
+
+    uint32_t recebidos = 0;
+    uint32_t anterior = UINT32_MAX;
+    bool ordem = true;
+    Item item;
+    for (;;)
+    {
+        if (fila.receber(item))
+        {
+            if ((anterior != UINT32_MAX && item.sequencia <= anterior) || item.verificacao != item.sequencia * 2654435761u)
+                ordem = false;
+            anterior = item.sequencia;
+            if (++recebidos % 16 == 0 && !insistir)
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        if (terminou.load(std::memory_order_acquire) && fila.tamanho() == 0)
+            break;
+        std::this_thread::yield();
+    }
+    produtor.join();
+
+    double segundos = (relogioHostNs() - inicio) / 1e9;
+    bool ok = ordem && recebidos == aceitos && (insistir ? aceitos == itens : aceitos + fila.descartes() == itens);
+    printf("%-20s %6.2f Mitens/s | recebidos %9u | fila cheia %9u | ocupacao max %2u/%zu | %s\n",
+           nome, recebidos / segundos / 1e6, recebidos, fila.descartes(), fila.maiorOcupacao(),
+           fila.capacidade(), ok ? "ordem ok" : "ERRO DE ORDEM/PERDA");
+    return ok;
+}
+
+// ------------------- FIRMWARE EM TAREFAS -------------------
+
+int benchTarefas(int argc, char **argv)
+{
+    uint32_t itens = (uint32_t)opcaoNumero(argc, argv, "--itens", 5000000);
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 180) * S);
+    double fator = opcaoNumero(argc, argv, "--fator", 20);
+    double custoPublicacaoMs = opcaoNumero(argc, argv, "--custo-publicacao-ms", 0.3);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    printf("\n=== benchmark tarefas ===\n");
+    bool filaOk = estressarFila("produtor insiste:", itens, true);
+    filaOk = estressarFila("consumidor lento:", itens / 10, false) && filaOk;
+
+    sim::aoEscreverPino([](uint64_t, uint8_t pino, uint8_t nivel)
+                        {
+        if (pino == PINO_TRAVA && nivel == HIGH)
+            aberturasTrava++; });
+    sim::definirCustoPublicacaoUs((uint32_t)(custoPublicacaoMs * 1000));
+    sim::usarTarefas(true);
+    sim::tempoReal(fator);
+
+    sim::usarArquivoFlash("bench_caixa.bin", true); // Caixa de saida vazia a cada execucao
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+
+    uint64_t inicioSetup = sim::agoraUs();
+    setup();
+    uint64_t inicio = sim::agoraUs();
+    unsigned autorizadas = montarCenario(inicio, duracao);
+
+    // Como no ESP32, loop() segue rodando ao lado das tarefas.
+    uint64_t hostInicio = relogioHostNs();
+    while (sim::agoraUs() - inicio < duracao)
+        loop();
+
+    double hostS = (relogioHostNs() - hostInicio) / 1e9;
+    const sim::EstatisticasBroker &broker = sim::broker();
+
+    printf("firmware: setup() %.3f s, %.1f s simulados (host %.2f s, fator %.0f), publicacao %.1f ms\n",
+           (inicio - inicioSetup) / 1e6, (sim::agoraUs() - inicio) / 1e6, hostS, fator, custoPublicacaoMs);
+    for (uint8_t i = 0; i < numeroTarefas(); i++)
+    {
+        EstatisticasTarefa t = estatisticasTarefa(i);
+        printf("  tarefa %-9s passos %8lu | medio %7.1f us | max %9lu us\n", t.nome,
+               t.passos, t.passos ? (double)t.tempoTotalUs / t.passos : 0.0, t.maiorPassoUs);
+    }
+    printf("  fila leituras: %lu enviadas, %lu descartadas, ocupacao max %lu/%zu\n",
+           (unsigned long)filaLeituras.enviados(), (unsigned long)filaLeituras.descartes(),
+           (unsigned long)filaLeituras.maiorOcupacao(), filaLeituras.capacidade());
+    printf("  fila acessos:  %lu enviados, %lu descartados, ocupacao max %lu/%zu\n",
+           (unsigned long)filaAcessos.enviados(), (unsigned long)filaAcessos.descartes(),
+           (unsigned long)filaAcessos.maiorOcupacao(), filaAcessos.capacidade());
+    printf("broker: %lu conexoes, %lu falhas, %lu publicacoes, %lu bytes\n",
+           broker.conexoes, broker.falhasConexao, broker.publicacoes, broker.bytesPublicados);
+    printf("trava: %lu aberturas (%u acessos autorizados no cenario)\n", aberturasTrava.load(), autorizadas);
+
+    int codigo = 0;
+    if (!filaOk)
+    {
+        printf("FALHA: fila SPSC perdeu ou reordenou itens\n");
+        codigo = 1;
+    }
+    else if (aberturasTrava.load() != autorizadas)
+    {
+        printf("FALHA: o controle de acesso perdeu tentativas\n");
+        codigo = 1;
+    }
+
+    // As tarefas nunca terminam (como no FreeRTOS): encerra sem destruir o estado global.
+    fflush(stdout);
+    _Exit(codigo);
+}
@@ -0,0 +1,175 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "telemetria.h"
+
+// ====================================================================================
+// BENCHMARK DA TELEMETRIA POR ALTERACAO
+// ====================================================================================
+// Simula N nos com alarmes aleatorios (intrusoes de duracao variada, algumas com
+// oscilacao nas bordas) amostrados nos intervalos do Monitoramento.cpp, e compara o
+// snapshot fixo a cada 3 s com a classe Telemetria configurada como no firmware.
+// Mede mensagens por no, carga no broker e o atraso entre a borda real e a primeira
+// mensagem que a reflete. Bordas nao publicadas incluem oscilacoes absorvidas.
+// Opcoes:
+//   --nos N               nos no mesmo broker (padrao 200)
+//   --duracao-h N         tempo simulado (padrao 1)
+//   --eventos-por-hora N  intrusoes por sensor por hora (padrao 2)
+
+static const unsigned long PASSO_MS = 10; // Periodo da tarefa de rede
+static const uint8_t NUM_SENSORES_SIMULADOS = SENSOR_LUZ + 1; // O alarme fundido fica desligado
+static const unsigned long AMOSTRAGEM_MS[NUM_SENSORES_SIMULADOS] = {5000, 500, 500};
+static const ConfiguracaoTelemetria CONFIGURACAO_FIRMWARE = {{1000, 1000, 1000, 0}, 60000};
+
+struct Borda
+{
+    unsigned long instante;
+    bool valor;
+};
+
+struct SensorSimulado
+{
+    std::vector<Borda> bordas;
+    size_t proxima = 0;
+    bool valor = false;   // Estado real
+    bool amostra = false; // Ultimo valor lido pelo firmware
+    unsigned long fase = 0;
+    unsigned long instanteBorda = 0;
+    bool amostrada = true; // O firmware leu o sensor depois da ultima borda
+    bool reportada = true;
+    bool publicado = false; // Estado que o broker conhece
+};
+
+static uint32_t sortear(uint32_t &estado)
+{
+    estado ^= estado << 13;
+    estado ^= estado >> 17;
+    estado ^= estado << 5;
+    return estado;
+}
+
+static void gerarBordas(SensorSimulado &sensor, unsigned long duracaoMs, double eventosPorHora, uint32_t &semente)
+{
+    unsigned long mediaEntreEventos = (unsigned long)(3600000.0 / eventosPorHora);
+    unsigned long t = sortear(semente) % mediaEntreEventos;
+    while (t < duracaoMs)
+    {
+        // Ate 3 oscilacoes rapidas (100-700 ms) em 30% das bordas de subida
+        if (sortear(semente) % 10 < 3)
+        {
+            int oscilacoes = 1 + sortear(semente) % 3;
+            for (int i = 0; i < oscilacoes; i++)
+            {
+                sensor.bordas.push_back({t, true});
+                t += 100 + sortear(semente) % 600;
+                sensor.bordas.push_back({t, false});
+                t += 100 + sortear(semente) % 600;
+            }
+        }
+        sensor.bordas.push_back({t, true});
+        t += 1000 + sortear(semente) % 30000; // Intrusao de 1 a 31 s
+        sensor.bordas.push_back({t, false});
+        t += 1 + sortear(semente) % (2 * mediaEntreEventos);
+    }
+}
+
+struct Resultado
+{
+    unsigned long mensagens = 0;
+    unsigned long bordas = 0;
+    unsigned long naoPublicadas = 0;
+    Amostras atraso;
+};
+
+static void simular(bool porAlteracao, int nos, unsigned long duracaoMs, double eventosPorHora, Resultado &resultado)
+{
+    uint32_t semente = 134;
+    for (int no = 0; no < nos; no++)
+    {
+        SensorSimulado sensores[NUM_SENSORES_SIMULADOS];
+        for (uint8_t i = 0; i < NUM_SENSORES_SIMULADOS; i++)
+        {
+            gerarBordas(sensores[i], duracaoMs, eventosPorHora, semente);
+            sensores[i].fase = sortear(semente) % AMOSTRAGEM_MS[i];
+        }
+        Telemetria telemetria(CONFIGURACAO_FIRMWARE);
+        unsigned long faseSnapshot = sortear(semente) % 3000;
+
+        for (unsigned long t = 0; t < duracaoMs; t += PASSO_MS)
+        {
+            bool alarmes[NUM_SENSORES_ALARME] = {};
+            for (uint8_t i = 0; i < NUM_SENSORES_SIMULADOS; i++)
+            {
+                SensorSimulado &s = sensores[i];
+                while (s.proxima < s.bordas.size() && s.bordas[s.proxima].instante <= t)
+                {
+                    resultado.bordas++;
+                    if (!s.reportada)
+                        resultado.naoPublicadas++;
+                    s.valor = s.bordas[s.proxima].valor;
+                    s.instanteBorda = s.bordas[s.proxima].instante;
+                    s.amostrada = false;
+                    // Voltar ao estado que o broker ja conhece nao precisa de mensagem
+                    s.reportada = s.valor == s.publicado;
+                    s.proxima++;
+                }
+                if (t % AMOSTRAGEM_MS[i] == s.fase / PASSO_MS * PASSO_MS)
+                {
+                    s.amostra = s.valor;
+                    s.amostrada = true;
+                }
+                alarmes[i] = s.amostra;
+            }
+
+            bool publicar;
+            if (porAlteracao)
+            {
+                publicar = telemetria.avaliar(alarmes, t) != TELEMETRIA_NENHUM;
+                if (publicar)
+                    telemetria.confirmar(alarmes, t);
+            }
+            else
+                publicar = t % 3000 == faseSnapshot / PASSO_MS * PASSO_MS;
+
+            if (!publicar)
+                continue;
+            resultado.mensagens++;
+            for (uint8_t i = 0; i < NUM_SENSORES_SIMULADOS; i++)
+            {
+                SensorSimulado &s = sensores[i];
+                s.publicado = alarmes[i];
+                if (!s.reportada && s.amostrada && alarmes[i] == s.valor)
+                {
+                    resultado.atraso.registrar(t - s.instanteBorda);
+                    s.reportada = true;
+                }
+            }
+        }
+        for (uint8_t i = 0; i < NUM_SENSORES_SIMULADOS; i++)
+            resultado.naoPublicadas += !sensores[i].reportada;
+    }
+}
+
+static void imprimir(const char *nome, Resultado &r, int nos, double horas)
+{
+    printf("%-20s %7.1f msg/no/h | broker %7.2f msg/s | bordas nao publicadas %5.1f%%\n",
+           nome, r.mensagens / (double)nos / horas, r.mensagens / (horas * 3600),
+           r.bordas ? 100.0 * r.naoPublicadas / r.bordas : 0.0);
+    r.atraso.imprimir("  atraso borda->broker:", "ms");
+}
+
+int benchTelemetria(int argc, char **argv)
+{
+    int nos = (int)opcaoNumero(argc, argv, "--nos", 200);
+    double horas = opcaoNumero(argc, argv, "--duracao-h", 1);
+    double eventosPorHora = opcaoNumero(argc, argv, "--eventos-por-hora", 2);
+    unsigned long duracaoMs = (unsigned long)(horas * 3600000);
+
+    printf("\n=== benchmark telemetria (%d nos, %.1f h, %.1f intrusoes/sensor/h) ===\n", nos, horas, eventosPorHora);
+    Resultado fixa, alteracao;
+    simular(false, nos, duracaoMs, eventosPorHora, fixa);
+    simular(true, nos, duracaoMs, eventosPorHora, alteracao);
+    imprimir("snapshot a cada 3 s", fixa, nos, horas);
+    imprimir("por alteracao", alteracao, nos, horas);
+    printf("reducao de mensagens: %.1fx\n", alteracao.mensagens ? (double)fixa.mensagens / alteracao.mensagens : 0.0);
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "hal.h"
+#include "diagnostico.h"
+#include "sensorDeDigitais.h"
+
+// ====================================================================================
+// BENCHMARK DA CAPTURA PELO TOQUE
+// ====================================================================================
+// Firmware inteiro (loop() cooperativo) contra o modulo emulado com os tempos de um
+// AS608, a 57600 baud, com 100 modelos. Mede ate a porta destravar:
+// 1) Botao: a pessoa aperta o botao e encosta o dedo de 0,2 a 0,8 s depois; a
+//    verificacao pede imagens (NOFINGER) ate o dedo chegar. Espera contada do aperto e
+//    do dedo encostando.
+// 2) Toque (como com -D SAFEZONE_TOQUE=1): o dedo encosta e a saida de toque do modulo
+//    dispara a verificacao, sem botao nem debounce.
+// Cada tentativa precisa destravar a porta com a posicao certa. A espera que o proprio
+// firmware mede (etapa espera_digital do diagnostico) e comparada com a do benchmark,
+// numa janela do diagnostico so com as tentativas de cada modo.
+// Opcoes:
+//   --tentativas N   tentativas por modo (padrao 40, cabem numa janela de 60 s)
+//   --verbose        ecoa o console do firmware
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const uint8_t PINO_BOTAO = 12;
+static const uint8_t PINO_TRAVA = 25;
+static const uint8_t PINO_TOQUE = 4;
+static const uint16_t MODELOS = 100;
+static const char *TOPICO_DIAGNOSTICO = "safezone/134/diag";
+
+extern FingerprintSensor sensorDigital;
+
+static uint64_t destravouEm = 0;
+static bool diagnosticoPublicado = false;
+
+static uint32_t sortear(uint32_t &semente)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+static void passo()
+{
+    loop();
+    sim::avancarUs(200);
+}
+
+static void rodar(uint64_t duracao)
+{
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < duracao)
+        passo();
+}
+
+struct Modo
+{
+    Amostras aperto; // us, do aperto do botao ate destravar (so no modo botao)
+    Amostras dedo;   // us, do dedo encostando ate destravar
+    unsigned erradas = 0;
+};
+
+// Uma tentativa com o dedo de `slot`; sem `botao`, so o dedo encostando.
+static void tentar(bool botao, uint16_t slot, uint32_t &semente, Modo &modo)
+{
+    destravouEm = 0;
+    uint64_t inicio = sim::agoraUs();
+    uint64_t encosta = inicio;
+    if (botao)
+    {
+        encosta = inicio + (200 + sortear(semente) % 600) * MS;
+        sim::agendar(inicio, []
+                     { sim::definirEntrada(PINO_BOTAO, LOW); });
+        sim::agendar(inicio + 150 * MS, []
+                     { sim::definirEntrada(PINO_BOTAO, HIGH); });
+    }
+    sim::agendar(encosta, [slot]
+                 { sim::definirDedo(true, slot); });
+
+    while (!destravouEm && sim::agoraUs() - inicio < 3 * S)
+        passo();
+    sim::definirDedo(false);
+    rodar(300 * MS); // Dedo fora e botao parado antes da proxima
+
+    if (!destravouEm || sensorDigital.matchedSlot() != slot)
+    {
+        modo.erradas++;
+        return;
+    }
+    if (botao)
+        modo.aperto.registrar(destravouEm - inicio);
+    modo.dedo.registrar(destravouEm - encosta);
+}
+
+// Roda as tentativas de um modo dentro de uma janela do diagnostico: a janela comeca
+// na publicacao e as tentativas param antes da proxima.
+static Modo medir(bool botao, const std::vector<uint16_t> &slots, int tentativas, uint32_t &semente,
+                  EstatisticasEtapa &campo)
+{
+    diagnosticoPublicado = false;
+    while (SAFEZONE_PERFIL && !diagnosticoPublicado)
+        passo();
+    uint64_t janela = sim::agoraUs();
+
+    Modo modo;
+    for (int i = 0; i < tentativas && sim::agoraUs() - janela < 55 * S; i++)
+        tentar(botao, slots[sortear(semente) % slots.size()], semente, modo);
+    campo = estatisticasEtapa(ETAPA_ESPERA_DIGITAL);
+    return modo;
+}
+
+static void imprimir(const char *nome, Amostras &amostras)
+{
+    printf("  %-24s p50 %6.1f | p99 %6.1f | max %6.1f ms (n=%zu)\n", nome, amostras.percentil(50) / 1e3,
+           amostras.percentil(99) / 1e3, amostras.maximo() / 1e3, amostras.quantidade());
+}
+
+// A etapa vai ate depois do digitalWrite da trava: fica dentro de 1/16 (faixa do
+// histograma) mais uma passagem do loop da espera do benchmark.
+static bool conferirCampo(const EstatisticasEtapa &campo, Amostras &referencia)
+{
+    if (!SAFEZONE_PERFIL)
+        return true;
+    double p50 = referencia.percentil(50);
+    bool certo = campo.amostras == referencia.quantidade() && fabs(campo.p50Us - p50) <= p50 / 16 + 400;
+    printf("  %-24s p50 %6.1f | p99 %6.1f | max %6.1f ms (n=%lu): %s\n", "campo (espera_digital)", campo.p50Us / 1e3,
+           campo.p99Us / 1e3, campo.maximoUs / 1e3, (unsigned long)campo.amostras, certo ? "ok" : "ERRO");
+    return certo;
+}
+
+int benchToque(int argc, char **argv)
+{
+    int tentativas = (int)opcaoNumero(argc, argv, "--tentativas", 40);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::aoPublicar([](const char *topico, const uint8_t *, unsigned int)
+                    {
+        if (strcmp(topico, TOPICO_DIAGNOSTICO) == 0)
+            diagnosticoPublicado = true; });
+    sim::aoEscreverPino([](uint64_t instante, uint8_t pino, uint8_t nivel)
+                        {
+        if (pino == PINO_TRAVA && nivel == HIGH && !destravouEm)
+            destravouEm = instante; });
+    setup();
+    rodar(5 * S);
+
+    uint32_t semente = 134;
+    std::vector<uint16_t> slots;
+    sim::apagarDigitais();
+    while (slots.size() < MODELOS)
+    {
+        uint16_t slot = 1 + sortear(semente) % 162;
+        if (!sim::digitalGravada(slot))
+        {
+            sim::cadastrarDigital(slot);
+            slots.push_back(slot);
+        }
+    }
+    sim::definirLatenciasDigitais(sim::LATENCIAS_AS608);
+    printf("espera ate a porta destravar, 57600 baud, %u modelos, modulo AS608:\n", (unsigned)MODELOS);
+
+    EstatisticasEtapa campo;
+    bool ok = true;
+    Modo botao = medir(true, slots, tentativas, semente, campo);
+    printf("botao (dedo 0,2 a 0,8 s depois do aperto):\n");
+    imprimir("aperto ate destravar", botao.aperto);
+    imprimir("dedo ate destravar", botao.dedo);
+    ok = conferirCampo(campo, botao.aperto) && ok;
+
+    halToqueIniciar(PINO_TOQUE); // Como no setup() com SAFEZONE_TOQUE
+    Modo toque = medir(false, slots, tentativas, semente, campo);
+    printf("toque (saida de toque do modulo no pino %u):\n", (unsigned)PINO_TOQUE);
+    imprimir("dedo ate destravar", toque.dedo);
+    ok = conferirCampo(campo, toque.dedo) && ok;
+
+    bool certas = !botao.erradas && !toque.erradas;
+    ok = ok && certas;
+    printf("tentativas sem destravar ou com a posicao errada: %u no botao, %u no toque: %s\n", botao.erradas,
+           toque.erradas, certas ? "ok" : "ERRO");
+    printf("queda: p50 %.1f -> %.1f ms do gesto ate destravar (%.1f ms so depois do dedo encostar)\n",
+           botao.aperto.percentil(50) / 1e3, toque.dedo.percentil(50) / 1e3,
+           (botao.dedo.percentil(50) - toque.dedo.percentil(50)) / 1e3);
+
+    sim::aoPublicar(nullptr);
+    sim::aoEscreverPino(nullptr);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "simulador.h"
+#include "diagnostico.h"
+#include "sensorDeDigitais.h"
+
+// ====================================================================================
+// BENCHMARK DA RESPOSTA DA BUSCA ATE A TRAVA
+// ====================================================================================
+// Firmware inteiro (loop() cooperativo) contra o modulo emulado com os tempos de um
+// AS608, a 57600 baud, com 100 modelos. O dedo ja esta no vidro quando o botao e
+// apertado; mede ate a borda do pino da trava:
+// - resposta: do ultimo byte da resposta da busca chegando na UART (instante que o
+//   emulador conhece) ate a borda, o que inclui esperar a proxima passagem do passo de
+//   acesso;
+// - campo: a etapa destravar do diagnostico, da resposta lida pelo firmware ate a borda,
+//   com alvo abaixo de 1 ms.
+// Tres cenarios para a rede: broker conectado, broker lento (cada publicacao leva
+// 200 ms) e broker fora. A trava nao pode depender da rede: o evento de auditoria vai
+// para a fila e para a caixa de saida depois da borda. Com o broker de volta, todos os
+// eventos de acesso precisam chegar ao topico de eventos.
+// Opcoes:
+//   --tentativas N   tentativas por cenario (padrao 30)
+//   --verbose        ecoa o console do firmware
+
+static const uint64_t S = 1000000;
+static const uint64_t MS = 1000;
+static const uint8_t PINO_BOTAO = 12;
+static const uint8_t PINO_TRAVA = 25;
+static const uint16_t MODELOS = 100;
+static const double ALVO_CAMPO_US = 1000;
+
+extern FingerprintSensor sensorDigital;
+
+static uint64_t destravouEm = 0;
+static uint64_t respostaEm = 0; // Ultima resposta do modulo quando a trava abriu
+static unsigned eventosAcesso = 0;
+
+static uint32_t sortear(uint32_t &semente)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+static void passo()
+{
+    loop();
+    sim::avancarUs(200);
+}
+
+static void rodar(uint64_t duracao)
+{
+    uint64_t inicio = sim::agoraUs();
+    while (sim::agoraUs() - inicio < duracao)
+        passo();
+}
+
+struct Cenario
+{
+    Amostras resposta; // us, da resposta da busca na UART ate a borda
+    unsigned erradas = 0;
+};
+
+// Dedo no vidro e botao apertado por 150 ms.
+static void tentar(uint16_t slot, Cenario &cenario)
+{
+    destravouEm = 0;
+    sim::definirDedo(true, slot);
+    uint64_t inicio = sim::agoraUs();
+    sim::agendar(inicio, []
+                 { sim::definirEntrada(PINO_BOTAO, LOW); });
+    sim::agendar(inicio + 150 * MS, []
+                 { sim::definirEntrada(PINO_BOTAO, HIGH); });
+    while (!destravouEm && sim::agoraUs() - inicio < 3 * S)
+        passo();
+    sim::definirDedo(false);
+    rodar(400 * MS);
+
+    if (!destravouEm || sensorDigital.matchedSlot() != slot)
+    {
+        cenario.erradas++;
+        return;
+    }
+    cenario.resposta.registrar(destravouEm - respostaEm);
+}
+
+static bool medir(const char *nome, const std::vector<uint16_t> &slots, int tentativas, uint32_t &semente)
+{
+    // Janela do diagnostico nova, so com as tentativas deste cenario
+    char descarte[TAMANHO_DIAGNOSTICO_JSON];
+    serializarDiagnostico(descarte, sizeof(descarte), millis(), 0);
+
+    Cenario cenario;
+    for (int i = 0; i < tentativas; i++)
+        tentar(slots[sortear(semente) % slots.size()], cenario);
+    EstatisticasEtapa campo = estatisticasEtapa(ETAPA_DESTRAVAR);
+
+    // A publicacao do diagnostico (a cada minuto) pode zerar a janela no meio
+    bool noAlvo = !SAFEZONE_PERFIL || (campo.amostras > 0 && campo.maximoUs < ALVO_CAMPO_US);
+    bool ok = !cenario.erradas && noAlvo;
+    printf("%-18s | %8.2f | %8.2f | %8.2f | %7.1f | %7.1f | %7.1f | %3u | %s\n", nome,
+           cenario.resposta.percentil(50) / 1e3, cenario.resposta.percentil(99) / 1e3,
+           cenario.resposta.maximo() / 1e3, campo.p50Us, campo.p99Us, campo.maximoUs, cenario.erradas,
+           ok ? "ok" : "ERRO");
+    return ok;
+}
+
+int benchTrava(int argc, char **argv)
+{
+    int tentativas = (int)opcaoNumero(argc, argv, "--tentativas", 30);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+
+    sim::usarArquivoFlash("bench_caixa.bin", true);
+    sim::usarArquivoNvs("bench_nvs.bin", true);
+    sim::aoEscreverPino([](uint64_t instante, uint8_t pino, uint8_t nivel)
+                        {
+        if (pino == PINO_TRAVA && nivel == HIGH && !destravouEm)
+        {
+            destravouEm = instante;
+            respostaEm = sim::digitais().ultimaRespostaEmUs;
+        } });
+    sim::aoPublicar([](const char *topico, const uint8_t *dados, unsigned int tamanho)
+                    {
+        if (strcmp(topico, "safezone-events") == 0 && memmem(dados, tamanho, "\"dedo\"", 6))
+            eventosAcesso++; });
+    setup();
+    rodar(5 * S);
+
+    uint32_t semente = 134;
+    std::vector<uint16_t> slots;
+    sim::apagarDigitais();
+    while (slots.size() < MODELOS)
+    {
+        uint16_t slot = 1 + sortear(semente) % 162;
+        if (!sim::digitalGravada(slot))
+        {
+            sim::cadastrarDigital(slot);
+            slots.push_back(slot);
+        }
+    }
+    sim::definirLatenciasDigitais(sim::LATENCIAS_AS608);
+    rodar(2 * S);
+    unsigned eventosAntes = eventosAcesso;
+
+    printf("da resposta da busca ate a trava, 57600 baud, %u modelos, %d tentativas por cenario:\n",
+           (unsigned)MODELOS, tentativas);
+    printf("%-18s | %8s | %8s | %8s | %7s | %7s | %7s | %3s |\n", "rede", "resp p50", "resp p99", "resp max",
+           "campo50", "campo99", "campomx", "err");
+    printf("%-18s | %8s | %8s | %8s | %7s | %7s | %7s |\n", "", "ms", "ms", "ms", "us", "us", "us");
+
+    bool ok = medir("broker conectado", slots, tentativas, semente);
+    sim::definirCustoPublicacaoUs(200 * MS);
+    ok = medir("broker lento", slots, tentativas, semente) && ok;
+    sim::definirCustoPublicacaoUs(0);
+    sim::definirBroker(false);
+    ok = medir("broker fora", slots, tentativas, semente) && ok;
+
+    // Auditoria: com o broker de volta, a caixa de saida entrega todos os eventos
+    sim::definirBroker(true);
+    rodar(30 * S);
+    unsigned esperados = 3 * tentativas;
+    unsigned entregues = eventosAcesso - eventosAntes;
+    bool auditoria = entregues == esperados;
+    printf("eventos de acesso no topico de eventos: %u de %u: %s\n", entregues, esperados, auditoria ? "ok" : "ERRO");
+    if (!SAFEZONE_PERFIL)
+        printf("(perfil desligado: sem a etapa destravar)\n");
+
+    sim::aoPublicar(nullptr);
+    sim::aoEscreverPino(nullptr);
+    return ok && auditoria ? 0 : 1;
+}
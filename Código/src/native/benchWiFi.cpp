@@ -0,0 +1,112 @@
+#include <Arduino.h>
+#include "bancada.h"
+#include "hal.h"
+#include "simulador.h"
+#include "internet.h"
+
+// ====================================================================================
+// BENCHMARK DO WI-FI COM AP INSTAVEL
+// ====================================================================================
+// Chama checkWiFi() como o loop() faria enquanto o AP simulado cai e volta em
+// intervalos aleatorios, e mede o custo de cada chamada. O limite vale para o tempo
+// simulado com o relogio do host congelado: so a espera modelada (delay(), a pilha
+// Wi-Fi) conta, e uma pausa do host nao reprova a medida. O tempo de CPU do host sai a
+// parte, so informativo.
+// Depois de cada chamada o estado do firmware precisa bater com o enlace. No fim, a
+// conexao e a queda chegam entre duas passagens (conexao seguida de queda do AP) e o
+// firmware precisa voltar a tentar e reconectar.
+// Opcoes:
+//   --duracao-s N   tempo simulado (padrao 600)
+//   --limite-ms N   falha (codigo 1) se alguma chamada passar de N ms simulados (padrao 1)
+
+int benchWiFi(int argc, char **argv)
+{
+    uint64_t duracao = (uint64_t)(opcaoNumero(argc, argv, "--duracao-s", 600) * 1000000);
+    double limiteMs = opcaoNumero(argc, argv, "--limite-ms", 1);
+    sim::ecoarConsole(opcaoPresente(argc, argv, "--verbose"));
+    Serial.begin(9600);
+
+    // AP instavel: fica no ar de 2 a 20 s e cai por 1 a 10 s.
+    uint64_t inicio = sim::agoraUs();
+    srand(134);
+    unsigned quedasAP = 0;
+    for (uint64_t t = inicio; t < inicio + duracao;)
+    {
+        t += (uint64_t)(2000 + rand() % 18000) * 1000;
+        sim::agendar(t, []
+                     { sim::definirWiFi(false); });
+        quedasAP++;
+        t += (uint64_t)(1000 + rand() % 9000) * 1000;
+        int rssi = -45 - rand() % 45;
+        sim::agendar(t, [rssi]
+                     { sim::definirRSSI(rssi);
+                       sim::definirWiFi(true); });
+    }
+
+    Amostras custo;
+    Amostras custoHost;
+    uint64_t tempoConectado = 0;
+    unsigned semEnlace = 0; // Passagens marcadas como conectadas sem enlace
+    sim::congelarHost(true);
+    conectaWiFi();
+    while (sim::agoraUs() - inicio < duracao)
+    {
+        uint64_t antes = sim::agoraUs();
+        uint64_t antesHost = relogioHostNs();
+        checkWiFi();
+        custoHost.registrar(relogioHostNs() - antesHost);
+        custo.registrar(sim::agoraUs() - antes);
+        if (qualidadeWiFi().conectado && !halWiFiConectado())
+            semEnlace++;
+        sim::avancarUs(1000);
+        if (qualidadeWiFi().conectado)
+            tempoConectado += 1000;
+    }
+
+    QualidadeWiFi qualidade = qualidadeWiFi();
+    printf("\n=== benchmark wifi ===\n");
+    printf("quedas do AP: %u | quedas vistas: %lu | reconexoes: %lu\n",
+           quedasAP, qualidade.quedas, qualidade.reconexoes);
+    printf("tempo conectado: %.1f%% | RSSI atual: %d dBm | conectado ha %lu ms\n",
+           100.0 * tempoConectado / duracao, qualidade.rssi, qualidade.conectadoHa);
+    custo.imprimir("checkWiFi() (simulado):", "us");
+    custoHost.imprimir("checkWiFi() (CPU do host):", "ns");
+
+    // Conexao e queda na mesma passagem: uma nova tentativa e a associacao (1,5 s)
+    // inteira sem chamar checkWiFi(), e o AP cai logo depois de associar. Antes, as
+    // mudancas do AP agendadas alem do fim da medida passam.
+    sim::avancarUs(30000000);
+    sim::definirWiFi(true);
+    sim::definirWiFi(false);
+    checkWiFi();
+    sim::definirWiFi(true);
+    conectaWiFi();
+    sim::avancarUs(2000000);
+    sim::definirWiFi(false);
+    checkWiFi();
+    bool semEnlaceJunto = qualidadeWiFi().conectado;
+    sim::definirWiFi(true);
+    uint64_t retomada = sim::agoraUs();
+    while (!qualidadeWiFi().conectado && sim::agoraUs() - retomada < 60000000)
+    {
+        checkWiFi();
+        sim::avancarUs(1000);
+    }
+    bool reconectou = qualidadeWiFi().conectado && halWiFiConectado();
+    printf("conexao e queda na mesma passagem: %s, %s em %.1f s\n",
+           semEnlaceJunto ? "conectado sem enlace" : "queda vista", reconectou ? "reconectou" : "nao reconectou",
+           (sim::agoraUs() - retomada) / 1e6);
+    sim::congelarHost(false);
+
+    if (limiteMs > 0 && custo.maximo() > limiteMs * 1000)
+    {
+        printf("FALHA: checkWiFi() acima de %.1f ms\n", limiteMs);
+        return 1;
+    }
+    if (semEnlace || semEnlaceJunto || !reconectou)
+    {
+        printf("FALHA: estado do Wi-Fi diferente do enlace (%u passagens)\n", semEnlace);
+        return 1;
+    }
+    return 0;
+}
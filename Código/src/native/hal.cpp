@@ -0,0 +1,762 @@
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hal.h"
+#include "simulador.h"
+
+// ====================================================================================
+// HAL SIMULADA (BUILD NATIVO)
+// ====================================================================================
+// Os custos de tempo modelados abaixo seguem as folhas de dados dos perifericos e o
+// comportamento das bibliotecas usadas no ESP32, para que trechos bloqueantes do
+// firmware aparecam com a duracao que teriam na placa. O estado simulado e lido sob
+// sim::Trava, mas os custos (sim::avancarUs) sempre sao pagos fora dela.
+
+// ------------------- SENSOR DE PRESSAO (HX711) -------------------
+// A celula simulada tem a mesma calibracao configurada no firmware, um deslocamento
+// sem carga e ruido branco de algumas contagens. sim::definirRuidoBalanca acrescenta
+// picos isolados (interferencia), que o filtro de mediana do firmware deve rejeitar.
+static const uint32_t HX711_CONVERSAO_US = 100000; // 10 amostras/s (RATE em nivel baixo)
+static const float HX711_CONTAGENS_KG = 41795;
+static const int32_t HX711_SEM_CARGA = 84000;
+static float pesoSimuladoKg = 0.0;
+static uint32_t ruidoBalanca = 20;     // Amplitude (contagens)
+static uint32_t picosBalancaPorMil = 0; // Conversoes com pico a cada mil
+static uint32_t semeBalanca = 12345;
+static unsigned geracaoBalanca = 0;    // Um novo halBalancaContinua() para a cadeia anterior
+static void (*aoConverterBalanca)(int32_t bruto) = nullptr;
+
+static uint32_t aleatorioBalanca()
+{
+    semeBalanca = semeBalanca * 1103515245 + 12345;
+    return semeBalanca >> 8;
+}
+
+static void converterBalanca(unsigned geracao, uint64_t instante)
+{
+    int32_t bruto;
+    {
+        sim::Trava trava;
+        if (geracao != geracaoBalanca)
+            return;
+        bruto = HX711_SEM_CARGA + (int32_t)(pesoSimuladoKg * HX711_CONTAGENS_KG);
+        if (ruidoBalanca)
+            bruto += (int32_t)(aleatorioBalanca() % (2 * ruidoBalanca + 1)) - (int32_t)ruidoBalanca;
+        if (picosBalancaPorMil && aleatorioBalanca() % 1000 < picosBalancaPorMil)
+            bruto += (aleatorioBalanca() & 1) ? 400000 : -400000;
+        sim::agendar(instante + HX711_CONVERSAO_US, [geracao, instante]
+                     { converterBalanca(geracao, instante + HX711_CONVERSAO_US); });
+    }
+    aoConverterBalanca(bruto);
+}
+
+void halBalancaIniciar(int pinoDout, int pinoSck)
+{
+    (void)pinoDout;
+    (void)pinoSck;
+}
+
+void halBalancaLigar()
+{
+}
+
+bool halBalancaContinua(void (*aoConverter)(int32_t bruto))
+{
+    sim::Trava trava;
+    aoConverterBalanca = aoConverter;
+    unsigned geracao = ++geracaoBalanca;
+    uint64_t primeira = sim::agoraUs() + HX711_CONVERSAO_US;
+    sim::agendar(primeira, [geracao, primeira]
+                 { converterBalanca(geracao, primeira); });
+    return true;
+}
+
+void sim::definirPeso(float kg)
+{
+    sim::Trava trava;
+    pesoSimuladoKg = kg;
+}
+
+void sim::definirRuidoBalanca(uint32_t contagens, uint32_t picosPorMil)
+{
+    sim::Trava trava;
+    ruidoBalanca = contagens;
+    picosBalancaPorMil = picosPorMil;
+}
+
+// ------------------- SENSOR DE MOVIMENTO (VL53L0X) -------------------
+// Em medida continua o sensor completa uma medida a cada orcamento de tempo do perfil;
+// halDistanciaLer() so paga o I2C (resultado + limpar a interrupcao, a 400 kHz) quando
+// ha uma medida completa ainda nao lida. Alem do alcance do perfil a medida e invalida.
+static const uint32_t VL53L0X_ORCAMENTO_US[NUM_PERFIS_DISTANCIA] = {20000, 33000, 33000};
+static const uint16_t VL53L0X_ALCANCE_MM[NUM_PERFIS_DISTANCIA] = {1200, 1200, 2000};
+static const uint32_t VL53L0X_LEITURA_US = 400;
+static const uint32_t VL53L0X_CONFIGURACAO_US = 5000; // Parar, configurar e reiniciar
+static uint16_t distanciaSimuladaMM = 8190;           // Nada no alcance
+static PerfilDistancia perfilDistancia = DISTANCIA_PADRAO;
+static uint64_t inicioMedidasUs = 0;
+static uint64_t medidasLidas = 0;
+
+bool halDistanciaIniciar(int pinoPronto, PerfilDistancia perfil)
+{
+    (void)pinoPronto;
+    return halDistanciaPerfil(perfil);
+}
+
+bool halDistanciaPerfil(PerfilDistancia perfil)
+{
+    if (perfil >= NUM_PERFIS_DISTANCIA)
+        return false;
+    sim::avancarUs(VL53L0X_CONFIGURACAO_US);
+    sim::Trava trava;
+    perfilDistancia = perfil;
+    inicioMedidasUs = sim::agoraUs();
+    medidasLidas = 0;
+    return true;
+}
+
+MedidaDistancia halDistanciaLer(uint16_t &mm)
+{
+    {
+        sim::Trava trava;
+        uint64_t completas = (sim::agoraUs() - inicioMedidasUs) / VL53L0X_ORCAMENTO_US[perfilDistancia];
+        if (completas == medidasLidas)
+            return DISTANCIA_PENDENTE;
+        medidasLidas = completas; // Medidas nao lidas a tempo sao sobrescritas pelo sensor
+    }
+    sim::avancarUs(VL53L0X_LEITURA_US);
+    sim::Trava trava;
+    mm = distanciaSimuladaMM;
+    return mm <= VL53L0X_ALCANCE_MM[perfilDistancia] ? DISTANCIA_VALIDA : DISTANCIA_FORA_ALCANCE;
+}
+
+void sim::definirDistanciaMM(uint16_t mm)
+{
+    sim::Trava trava;
+    distanciaSimuladaMM = mm;
+}
+
+// ------------------- SENSOR DE LUZ (LDR NO ADC) -------------------
+// Cada bloco repete o valor definido com sim::definirAnalogico(); o ruido fica nos
+// tracos da bancada de luz. As 4 conversoes (~40 us) sao da tarefa do ADC na placa e
+// nao sao cobradas aqui: o evento roda dentro de quem leu o relogio, sob a trava.
+static unsigned geracaoAdc = 0;
+static void (*aoAmostrarAdc)(const uint16_t *amostras, uint8_t quantidade) = nullptr;
+
+static void amostrarAdc(unsigned geracao, uint8_t pino, uint64_t instante)
+{
+    sim::Trava trava;
+    if (geracao != geracaoAdc)
+        return;
+    sim::agendar(instante + HAL_ADC_BLOCO_US, [geracao, pino, instante]
+                 { amostrarAdc(geracao, pino, instante + HAL_ADC_BLOCO_US); });
+
+    uint16_t bloco[HAL_ADC_AMOSTRAS_POR_BLOCO];
+    uint16_t nivel = sim::nivelAnalogico(pino);
+    for (uint8_t i = 0; i < HAL_ADC_AMOSTRAS_POR_BLOCO; i++)
+        bloco[i] = nivel;
+    aoAmostrarAdc(bloco, HAL_ADC_AMOSTRAS_POR_BLOCO);
+}
+
+bool halAdcContinuo(uint8_t pino, void (*aoAmostrar)(const uint16_t *amostras, uint8_t quantidade))
+{
+    sim::Trava trava;
+    aoAmostrarAdc = aoAmostrar;
+    unsigned geracao = ++geracaoAdc;
+    uint64_t primeiro = sim::agoraUs() + HAL_ADC_BLOCO_US;
+    sim::agendar(primeiro, [geracao, pino, primeiro]
+                 { amostrarAdc(geracao, pino, primeiro); });
+    return true;
+}
+
+// ------------------- SENSOR DE DIGITAIS (SAIDA DE TOQUE) -------------------
+// halToqueIniciar() e halToqueLer() ficam em moduloDigitais.cpp, junto do dedo simulado.
+
+// ------------------- WIFI -------------------
+static const uint32_t WIFI_ASSOCIACAO_US = 1500000; // Associacao + DHCP
+static const uint32_t WIFI_SEM_AP_US = 2000000;     // Varredura sem encontrar o AP
+static bool apDisponivel = true;
+static bool wifiConectado = false;
+static unsigned long tentativaWiFi = 0;
+static int rssiSimulado = -60;
+static void (*callbackWiFi)(EventoWiFi evento) = nullptr;
+
+static void notificarWiFi(EventoWiFi evento)
+{
+    if (callbackWiFi)
+        callbackWiFi(evento);
+}
+
+void halWiFiAoEvento(void (*callback)(EventoWiFi evento))
+{
+    sim::Trava trava;
+    callbackWiFi = callback;
+}
+
+void halWiFiIniciar(const char *ssid, const char *senha)
+{
+    (void)ssid;
+    (void)senha;
+    sim::Trava trava;
+    wifiConectado = false;
+    unsigned long tentativa = ++tentativaWiFi;
+    uint64_t agora = sim::agoraUs();
+
+    // Como no driver do ESP32, o resultado chega depois, por evento.
+    if (!apDisponivel)
+    {
+        sim::agendar(agora + WIFI_SEM_AP_US, [tentativa]
+                     {
+            if (tentativa == tentativaWiFi)
+                notificarWiFi(WIFI_EVENTO_DESCONECTADO); });
+        return;
+    }
+    sim::agendar(agora + WIFI_ASSOCIACAO_US, [tentativa]
+                 {
+        if (tentativa != tentativaWiFi)
+            return;
+        if (!apDisponivel)
+        {
+            notificarWiFi(WIFI_EVENTO_DESCONECTADO);
+            return;
+        }
+        wifiConectado = true;
+        notificarWiFi(WIFI_EVENTO_CONECTADO); });
+}
+
+bool halWiFiConectado()
+{
+    sim::Trava trava;
+    return wifiConectado;
+}
+
+String halWiFiIP()
+{
+    sim::Trava trava;
+    return wifiConectado ? "192.168.0.134" : "0.0.0.0";
+}
+
+int halWiFiRSSI()
+{
+    sim::Trava trava;
+    return wifiConectado ? rssiSimulado : 0;
+}
+
+void sim::definirWiFi(bool disponivel)
+{
+    sim::Trava trava;
+    if (disponivel == apDisponivel)
+        return;
+    apDisponivel = disponivel;
+    if (!disponivel && wifiConectado)
+    {
+        wifiConectado = false;
+        notificarWiFi(WIFI_EVENTO_DESCONECTADO);
+    }
+}
+
+void sim::definirRSSI(int dbm)
+{
+    sim::Trava trava;
+    rssiSimulado = dbm;
+}
+
+// ------------------- MQTT (BROKER LOCAL) -------------------
+static uint32_t timeoutConexaoUs = 3000000; // Padrao do WiFiClient::connect
+static const uint32_t MQTT_HANDSHAKE_US = 20000;
+static bool conexaoPendente = false;
+static uint64_t inicioConexaoUs = 0;
+static uint32_t custoPublicacaoUs = 300;
+static bool brokerDisponivel = true;
+static bool sessaoAtiva = false;
+static int estadoMqtt = -1; // MQTT_DISCONNECTED
+static sim::EstatisticasBroker estatisticasBroker;
+static std::function<void(const char *, const uint8_t *, unsigned int)> observadorPublicacoes;
+static void (*aoReceberMqtt)(const char *topico, const uint8_t *dados, unsigned int tamanho) = nullptr;
+static std::set<std::string> assinaturas;                  // Da sessao atual
+static std::map<std::string, std::vector<uint8_t>> retidas; // Ultima mensagem retida por topico
+static std::vector<std::pair<std::string, std::vector<uint8_t>>> aEntregar;
+
+static void encerrarSessao()
+{
+    sessaoAtiva = false;
+    assinaturas.clear();
+    aEntregar.clear();
+}
+
+void halMqttServidor(const char *servidor, uint16_t porta)
+{
+    (void)servidor;
+    (void)porta;
+}
+
+void halMqttTimeoutConexao(uint16_t timeoutMs)
+{
+    sim::Trava trava;
+    timeoutConexaoUs = (uint32_t)timeoutMs * 1000;
+}
+
+// A tentativa leva MQTT_HANDSHAKE_US com o broker respondendo; sem resposta (broker ou
+// Wi-Fi fora) so o timeout a encerra. Nenhuma chamada avanca o relogio.
+bool halMqttIniciarConexao(const char *id)
+{
+    (void)id;
+    uint64_t agora = sim::agoraUs();
+    sim::Trava trava;
+    if (!wifiConectado)
+        return false;
+    conexaoPendente = true;
+    inicioConexaoUs = agora;
+    return true;
+}
+
+AndamentoConexaoMqtt halMqttAndamentoConexao()
+{
+    uint64_t agora = sim::agoraUs();
+    sim::Trava trava;
+    if (!conexaoPendente)
+        return CONEXAO_MQTT_FALHOU;
+    uint64_t decorrido = agora - inicioConexaoUs;
+    if (!wifiConectado || !brokerDisponivel)
+    {
+        if (decorrido < timeoutConexaoUs)
+            return CONEXAO_MQTT_PENDENTE;
+        conexaoPendente = false;
+        estatisticasBroker.falhasConexao++;
+        estadoMqtt = -2; // MQTT_CONNECT_FAILED
+        return CONEXAO_MQTT_FALHOU;
+    }
+    if (decorrido < MQTT_HANDSHAKE_US)
+        return CONEXAO_MQTT_PENDENTE;
+
+    conexaoPendente = false;
+    estatisticasBroker.conexoes++;
+    encerrarSessao(); // Sessao limpa, como no PubSubClient
+    sessaoAtiva = true;
+    estadoMqtt = 0; // MQTT_CONNECTED
+    return CONEXAO_MQTT_PRONTA;
+}
+
+void halMqttCancelarConexao()
+{
+    sim::Trava trava;
+    conexaoPendente = false;
+}
+
+bool halMqttConectado()
+{
+    sim::Trava trava;
+    if (sessaoAtiva && (!brokerDisponivel || !halWiFiConectado()))
+    {
+        encerrarSessao();
+        estadoMqtt = -3; // MQTT_CONNECTION_LOST
+    }
+    return sessaoAtiva;
+}
+
+int halMqttEstado()
+{
+    sim::Trava trava;
+    return estadoMqtt;
+}
+
+void halMqttLoop()
+{
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> mensagens;
+    {
+        sim::Trava trava;
+        if (!halMqttConectado() || aEntregar.empty())
+            return;
+        mensagens.swap(aEntregar);
+    }
+    // Fora da trava: o callback e codigo do firmware
+    for (const auto &mensagem : mensagens)
+        if (aoReceberMqtt)
+            aoReceberMqtt(mensagem.first.c_str(), mensagem.second.data(), mensagem.second.size());
+}
+
+bool halMqttPublicar(const char *topico, const char *payload)
+{
+    return halMqttPublicar(topico, (const uint8_t *)payload, strlen(payload));
+}
+
+bool halMqttPublicar(const char *topico, const uint8_t *dados, unsigned int tamanho)
+{
+    uint32_t custo;
+    {
+        sim::Trava trava;
+        custo = custoPublicacaoUs;
+    }
+    if (!halMqttConectado())
+        return false;
+    sim::avancarUs(custo);
+
+    sim::Trava trava;
+    estatisticasBroker.publicacoes++;
+    estatisticasBroker.bytesPublicados += tamanho;
+    if (observadorPublicacoes)
+        observadorPublicacoes(topico, dados, tamanho);
+    return true;
+}
+
+void halMqttAoReceber(void (*callback)(const char *topico, const uint8_t *dados, unsigned int tamanho))
+{
+    sim::Trava trava;
+    aoReceberMqtt = callback;
+}
+
+bool halMqttAssinar(const char *topico)
+{
+    sim::Trava trava;
+    if (!halMqttConectado())
+        return false;
+    assinaturas.insert(topico);
+    auto retida = retidas.find(topico);
+    if (retida != retidas.end())
+        aEntregar.push_back(*retida);
+    return true;
+}
+
+void sim::publicarNoBroker(const char *topico, const char *payload, bool reter)
+{
+    publicarNoBroker(topico, (const uint8_t *)payload, strlen(payload), reter);
+}
+
+void sim::publicarNoBroker(const char *topico, const uint8_t *payload, size_t tamanho, bool reter)
+{
+    sim::Trava trava;
+    std::vector<uint8_t> dados(payload, payload + tamanho);
+    if (reter)
+        retidas[topico] = dados;
+    if (sessaoAtiva && assinaturas.count(topico))
+        aEntregar.emplace_back(topico, dados);
+}
+
+void sim::definirBroker(bool disponivel)
+{
+    sim::Trava trava;
+    brokerDisponivel = disponivel;
+}
+
+void sim::definirCustoPublicacaoUs(uint32_t us)
+{
+    sim::Trava trava;
+    custoPublicacaoUs = us;
+}
+
+const sim::EstatisticasBroker &sim::broker()
+{
+    return estatisticasBroker;
+}
+
+void sim::aoPublicar(std::function<void(const char *, const uint8_t *, unsigned int)> observador)
+{
+    sim::Trava trava;
+    observadorPublicacoes = observador;
+}
+
+// ------------------- FLASH (PARTICAO "caixa") -------------------
+// Imagem em memoria espelhada num arquivo, para sobreviver entre execucoes como a
+// flash da placa. Tempos tipicos das memorias SPI NOR usadas nos modulos ESP32
+// (programacao de pagina ~0,7 ms para 256 bytes, apagamento de setor ~45 ms).
+static const uint32_t FLASH_TAMANHO = 0x40000; // Igual a particao do partitions.csv
+static const uint32_t FLASH_ESCRITA_US = 50;   // Por operacao, mais 2,5 us por byte
+static const uint32_t FLASH_APAGAR_SETOR_US = 45000;
+static std::string arquivoFlash = "caixa.bin";
+static std::vector<uint8_t> imagemFlash;
+static FILE *espelhoFlash = nullptr;
+static bool flashBloqueada = false;
+static sim::EstatisticasFlash estatisticasFlash;
+
+static void abrirFlash(bool apagar)
+{
+    imagemFlash.assign(FLASH_TAMANHO, 0xFF);
+    if (espelhoFlash)
+        fclose(espelhoFlash);
+    espelhoFlash = apagar ? nullptr : fopen(arquivoFlash.c_str(), "r+b");
+    if (espelhoFlash)
+    {
+        size_t lidos = fread(imagemFlash.data(), 1, FLASH_TAMANHO, espelhoFlash);
+        (void)lidos; // Arquivo mais curto: o restante segue apagado
+        return;
+    }
+    espelhoFlash = fopen(arquivoFlash.c_str(), "w+b");
+    if (espelhoFlash)
+    {
+        fwrite(imagemFlash.data(), 1, FLASH_TAMANHO, espelhoFlash);
+        fflush(espelhoFlash);
+    }
+}
+
+static void espelharFlash(uint32_t endereco, size_t tamanho)
+{
+    if (!espelhoFlash)
+        return;
+    fseek(espelhoFlash, endereco, SEEK_SET);
+    fwrite(imagemFlash.data() + endereco, 1, tamanho, espelhoFlash);
+    fflush(espelhoFlash);
+}
+
+uint32_t halFlashTamanho()
+{
+    sim::Trava trava;
+    if (imagemFlash.empty())
+        abrirFlash(false);
+    return FLASH_TAMANHO;
+}
+
+bool halFlashLer(uint32_t endereco, void *dados, size_t tamanho)
+{
+    sim::Trava trava;
+    if (imagemFlash.empty())
+        abrirFlash(false);
+    if (endereco + tamanho > FLASH_TAMANHO)
+        return false;
+    memcpy(dados, imagemFlash.data() + endereco, tamanho);
+    estatisticasFlash.leituras++;
+    estatisticasFlash.bytesLidos += tamanho;
+    return true;
+}
+
+bool halFlashEscrever(uint32_t endereco, const void *dados, size_t tamanho)
+{
+    {
+        sim::Trava trava;
+        if (imagemFlash.empty())
+            abrirFlash(false);
+        if (flashBloqueada || endereco + tamanho > FLASH_TAMANHO)
+            return false;
+        const uint8_t *bytes = (const uint8_t *)dados;
+        for (size_t i = 0; i < tamanho; i++)
+            imagemFlash[endereco + i] &= bytes[i]; // So leva bits de 1 para 0
+        espelharFlash(endereco, tamanho);
+        estatisticasFlash.escritas++;
+        estatisticasFlash.bytesEscritos += tamanho;
+    }
+    sim::avancarUs(FLASH_ESCRITA_US + tamanho * 5 / 2);
+    return true;
+}
+
+bool halFlashApagarSetor(uint32_t endereco)
+{
+    {
+        sim::Trava trava;
+        if (imagemFlash.empty())
+            abrirFlash(false);
+        if (flashBloqueada || endereco % HAL_SETOR_FLASH || endereco >= FLASH_TAMANHO)
+            return false;
+        memset(imagemFlash.data() + endereco, 0xFF, HAL_SETOR_FLASH);
+        espelharFlash(endereco, HAL_SETOR_FLASH);
+        estatisticasFlash.setoresApagados++;
+    }
+    sim::avancarUs(FLASH_APAGAR_SETOR_US);
+    return true;
+}
+
+void sim::usarArquivoFlash(const char *caminho, bool apagar)
+{
+    sim::Trava trava;
+    arquivoFlash = caminho;
+    abrirFlash(apagar);
+}
+
+void sim::bloquearFlash(bool bloquear)
+{
+    sim::Trava trava;
+    flashBloqueada = bloquear;
+}
+
+const sim::EstatisticasFlash &sim::flash()
+{
+    return estatisticasFlash;
+}
+
+// ------------------- NVS -------------------
+// Todas as chaves num arquivo, regravado inteiro a cada gravacao. Uma gravacao na NVS
+// do ESP32 (entrada nova na pagina e a antiga marcada como apagada) leva alguns ms.
+static const uint32_t NVS_GRAVACAO_US = 5000;
+static std::string arquivoNvs = "nvs.bin";
+static std::map<std::string, std::vector<uint8_t>> valoresNvs;
+static bool nvsCarregada = false;
+
+static void carregarNvs()
+{
+    nvsCarregada = true;
+    valoresNvs.clear();
+    FILE *arquivo = fopen(arquivoNvs.c_str(), "rb");
+    if (!arquivo)
+        return;
+    // Registros: tamanho da chave (1), chave, tamanho do valor (2, LE), valor
+    int n;
+    while ((n = fgetc(arquivo)) != EOF)
+    {
+        std::string chave(n, '\0');
+        uint8_t tamanho[2];
+        if (fread(&chave[0], 1, n, arquivo) != (size_t)n || fread(tamanho, 1, 2, arquivo) != 2)
+            break;
+        std::vector<uint8_t> valor(tamanho[0] | tamanho[1] << 8);
+        if (fread(valor.data(), 1, valor.size(), arquivo) != valor.size())
+            break;
+        valoresNvs[chave] = valor;
+    }
+    fclose(arquivo);
+}
+
+bool halNvsLer(const char *chave, void *dados, size_t tamanho)
+{
+    sim::Trava trava;
+    if (!nvsCarregada)
+        carregarNvs();
+    auto valor = valoresNvs.find(chave);
+    if (valor == valoresNvs.end() || valor->second.size() != tamanho)
+        return false;
+    memcpy(dados, valor->second.data(), tamanho);
+    return true;
+}
+
+bool halNvsGravar(const char *chave, const void *dados, size_t tamanho)
+{
+    {
+        sim::Trava trava;
+        if (!nvsCarregada)
+            carregarNvs();
+        if (strlen(chave) > 15 || tamanho > 0xFFFF || flashBloqueada) // Limites da NVS do ESP32
+            return false;
+        valoresNvs[chave].assign((const uint8_t *)dados, (const uint8_t *)dados + tamanho);
+        FILE *arquivo = fopen(arquivoNvs.c_str(), "wb");
+        if (!arquivo)
+            return false;
+        for (const auto &valor : valoresNvs)
+        {
+            fputc((int)valor.first.size(), arquivo);
+            fwrite(valor.first.data(), 1, valor.first.size(), arquivo);
+            uint8_t tamanhoValor[2] = {(uint8_t)(valor.second.size() & 0xFF), (uint8_t)(valor.second.size() >> 8)};
+            fwrite(tamanhoValor, 1, 2, arquivo);
+            fwrite(valor.second.data(), 1, valor.second.size(), arquivo);
+        }
+        fclose(arquivo);
+    }
+    sim::avancarUs(NVS_GRAVACAO_US);
+    return true;
+}
+
+void sim::usarArquivoNvs(const char *caminho, bool apagar)
+{
+    sim::Trava trava;
+    arquivoNvs = caminho;
+    if (apagar)
+        remove(caminho);
+    carregarNvs();
+}
+
+// ------------------- RELOGIO -------------------
+static const time_t EPOCA_SIMULADA = 1760000000; // Outubro de 2025
+
+static bool relogioPedido = false;
+static bool relogioSincronizado = false;
+
+void halRelogioLocal(const char *local)
+{
+    (void)local;
+    relogioPedido = true;
+}
+
+// Sincroniza na primeira consulta com o Wi-Fi no ar e fica sincronizado.
+bool halRelogioSincronizado()
+{
+    if (relogioPedido && !relogioSincronizado && halWiFiConectado())
+        relogioSincronizado = true;
+    return relogioSincronizado;
+}
+
+time_t halRelogioAgora()
+{
+    return EPOCA_SIMULADA + (time_t)(sim::agoraUs() / 1000000);
+}
+
+// ------------------- TAREFAS -------------------
+static bool multitarefa = false;
+static int tarefasDisponiveis = -1; // -1: sem limite
+
+bool halMultitarefa()
+{
+    sim::Trava trava;
+    return multitarefa;
+}
+
+bool halCriarTarefa(const char *nome, void (*funcao)(void *parametro), void *parametro,
+                    uint32_t pilha, uint8_t prioridade, int8_t nucleo)
+{
+    (void)nome;
+    (void)pilha;
+    (void)prioridade;
+    (void)nucleo;
+    {
+        sim::Trava trava;
+        if (tarefasDisponiveis == 0)
+            return false;
+        if (tarefasDisponiveis > 0)
+            tarefasDisponiveis--;
+    }
+    std::thread([funcao, parametro]
+                { funcao(parametro); })
+        .detach();
+    return true;
+}
+
+void halEncerrarTarefa()
+{
+}
+
+void sim::usarTarefas(bool usar)
+{
+    sim::Trava trava;
+    multitarefa = usar;
+}
+
+void sim::limitarTarefas(int quantidade)
+{
+    sim::Trava trava;
+    tarefasDisponiveis = quantidade;
+}
+
+// ------------------- CPU E MEMORIA -------------------
+// Sem heap simulado: um valor tipico do ESP32 com Wi-Fi e MQTT ativos.
+static const uint32_t CICLOS_POR_US = 240;
+static const uint32_t HEAP_SIMULADO = 180 * 1024;
+
+uint32_t halCiclos()
+{
+    return (uint32_t)(sim::agoraNs() * CICLOS_POR_US / 1000);
+}
+
+uint32_t halCiclosPorUs()
+{
+    return CICLOS_POR_US;
+}
+
+uint32_t halHeapLivre()
+{
+    return HEAP_SIMULADO;
+}
+
+uint32_t halHeapMinimo()
+{
+    return HEAP_SIMULADO;
+}
+
+// ------------------- ALEATORIO -------------------
+static uint32_t estadoAleatorio = 134;
+
+uint32_t halAleatorio()
+{
+    sim::Trava trava;
+    // xorshift32: deterministico para que as execucoes do benchmark sejam repetiveis
+    estadoAleatorio ^= estadoAleatorio << 13;
+    estadoAleatorio ^= estadoAleatorio >> 17;
+    estadoAleatorio ^= estadoAleatorio << 5;
+    return estadoAleatorio;
+}
@@ -0,0 +1,59 @@
+#include <Arduino.h>
+#include "bancada.h"
+
+// ====================================================================================
+// PONTO DE ENTRADA DO BUILD NATIVO
+// ====================================================================================
+// Uso: program [benchmark] [opcoes]
+// Sem argumentos executa o benchmark "loop" (setup() + loop() com cenario simulado).
+
+struct EntradaBenchmark
+{
+    const char *nome;
+    Benchmark executar;
+    const char *descricao;
+};
+
+static const EntradaBenchmark benchmarks[] = {
+    {"loop", benchLoop, "setup()/loop() contra o cenario simulado; latencia por iteracao"},
+    {"digitais", benchDigitais, "verificacao assincrona de digitais; custo por chamada"},
+    {"reconexao", benchReconexao, "recuperacao de uma frota apos reinicio do broker"},
+    {"wifi", benchWiFi, "checkWiFi() com AP instavel; custo por chamada e metricas"},
+    {"tarefas", benchTarefas, "filas SPSC sob estresse e firmware em tarefas (threads)"},
+    {"telemetria", benchTelemetria, "volume e atraso da telemetria por alteracao x snapshot"},
+    {"json", benchJson, "serializacao das mensagens: ns e alocacoes por mensagem"},
+    {"binario", benchBinario, "quadro binario x JSON: tamanho e tempo de codificacao"},
+    {"caixa", benchCaixa, "caixa de saida na flash: desgaste, reinicio e recuperacao"},
+    {"amostragem", benchAmostragem, "amostras/s de ponta a ponta em quadros x uma por mensagem"},
+    {"balanca", benchBalanca, "HX711 continuo: custo do caminho da pressao e filtro"},
+    {"distancia", benchDistancia, "VL53L0X continuo por perfil: custo, medidas/s e alarme"},
+    {"luz", benchLuz, "detector de luz contra tracos reproduziveis x regra antiga"},
+    {"fusao", benchFusao, "regras de alarme: custo por avaliacao e alarmes falsos x regras antigas"},
+    {"configuracao", benchConfiguracao, "configuracao pelo broker: custo da leitura, aplicacao, NVS e threads"},
+    {"agendador", benchAgendador, "roda de temporizadores: custo por passo x verificacoes ad hoc, atraso e estouro"},
+    {"diagnostico", benchDiagnostico, "perfil das etapas: precisao dos histogramas, custo e topico de diagnostico"},
+    {"acesso", benchAcesso, "lista de acesso local: custo da decisao, horarios, patches pelo broker e NVS"},
+    {"modelos", benchModelos, "copia das digitais: pedacos com CRC, exportacao e restauracao retomavel"},
+    {"espera", benchEspera, "espera na porta: botao ate a decisao por baud, biblioteca e erros na UART"},
+    {"toque", benchToque, "captura pelo toque no sensor x botao: espera ate destravar e medida de campo"},
+    {"trava", benchTrava, "resposta da busca ate a trava com o broker conectado, lento e fora; auditoria"},
+    {"particao", benchParticao, "particao quente da biblioteca x busca inteira: acessos de Zipf, acertos e camadas"},
+    {"registro", benchRegistro, "registro assincrono x Serial direto a 9600 baud, custo por chamada, descartes e threads"},
+    {"partida", benchPartida, "partida desde o reset: acesso local, primeira abertura e relatorio de boot por cenario de rede"},
+};
+
+int main(int argc, char **argv)
+{
+    const char *nome = argc > 1 && argv[1][0] != '-' ? argv[1] : "loop";
+
+    for (const EntradaBenchmark &entrada : benchmarks)
+    {
+        if (strcmp(entrada.nome, nome) == 0)
+            return entrada.executar(argc, argv);
+    }
+
+    printf("Benchmark desconhecido: %s\nDisponiveis:\n", nome);
+    for (const EntradaBenchmark &entrada : benchmarks)
+        printf("  %-12s %s\n", entrada.nome, entrada.descricao);
+    return 2;
+}
@@ -0,0 +1,503 @@
+#include <algorithm>
+#include <atomic>
+#include <Adafruit_Fingerprint.h>
+#include "simulador.h"
+#include "hal.h"
+#include "modelosDigitais.h"
+
+// ====================================================================================
+// MODULO DE DIGITAIS SIMULADO (PROTOCOLO UART DO R307/AS608)
+// ====================================================================================
+// Ligado a Serial2: recebe os pacotes de comando que a Adafruit_Fingerprint escreve e
+// devolve os pacotes de confirmacao, como o modulo real. receber() roda sob a trava do
+// simulador, tomada por HardwareSerial::write().
+//
+// Os modelos copiados (upload/download) sao 512 bytes gerados a partir da identidade do
+// dedo, que vai nos bytes 2 e 3: um modelo restaurado em outro slot ou em outro modulo
+// continua reconhecendo o mesmo dedo. Um modelo que nao bate com o gerado (corrompido no
+// caminho) fica no CharBuffer como vazio e nao e gravado.
+//
+// Para medir o caminho da digital sem um dedo no vidro: a biblioteca vai ate 1000
+// modelos, cada comando pode levar o tempo de processamento do modulo real
+// (sim::definirLatenciasDigitais) e as respostas podem se perder ou chegar com um bit
+// trocado (sim::injetarErrosDigitais). A busca percorre so a faixa pedida no comando.
+
+static const uint8_t CMD_DOWNCHAR = 0x09;
+static const uint8_t CMD_READINDEXTABLE = 0x1F;
+static const uint16_t TAMANHO_PACOTE_DADOS = 128; // packet_len informado no READSYSPARAM
+
+class ModuloDigitais : public DispositivoSerial
+{
+public:
+    static const uint16_t CAPACIDADE_MAXIMA = 1000;
+
+    ModuloDigitais() { Serial2.conectar(this); }
+
+    void receber(uint8_t byte) override;
+
+    bool dedoPresente = false;
+    uint16_t dedo = 0; // Identidade do dedo sobre o sensor
+    uint16_t capacidade = 162;
+    uint16_t biblioteca[CAPACIDADE_MAXIMA + 1]; // Dedo gravado em cada slot (0 = vazio)
+
+    sim::LatenciasDigitais latencias = {};
+    sim::ErrosDigitais erros = {};
+    sim::EstatisticasDigitais estatisticas = {};
+
+private:
+    uint8_t _pacote[9 + 256 + 2]; // Cabe um pacote de dados de 256 bytes
+    uint16_t _indice = 0;
+    uint16_t _tamanho = 0;
+
+    uint16_t _imagem = 0;
+    uint16_t _buffer[3] = {0, 0, 0};
+
+    // Download em andamento (CMD_DOWNCHAR) para o CharBuffer `_destino`
+    uint8_t _destino = 0;
+    uint16_t _recebidos = 0;
+    uint8_t _modeloRecebido[TAMANHO_MODELO];
+
+    uint64_t _linhaLivreEm = 0; // Fim do ultimo pacote posto na linha
+    uint64_t _prontoEm = 0;     // Fim do processamento do comando atual
+    uint32_t _sorteio = 134;
+
+    void processar(uint32_t us);
+    bool sortear(uint32_t porMil);
+
+    void executar(const uint8_t *dados, uint16_t tamanho);
+    void receberDados(uint8_t tipo, const uint8_t *dados, uint16_t tamanho);
+    void enviarPacote(uint8_t tipo, const uint8_t *dados, uint16_t tamanho);
+    void responder(const uint8_t *dados, uint16_t tamanho) { enviarPacote(FINGERPRINT_ACKPACKET, dados, tamanho); }
+    void responder(uint8_t codigo) { responder(&codigo, 1); }
+};
+
+static void gerarModelo(uint16_t dedo, uint8_t *modelo)
+{
+    uint32_t semente = 0x9E3779B9u * (dedo + 1);
+    modelo[0] = 0x03;
+    modelo[1] = 0x01;
+    modelo[2] = dedo >> 8;
+    modelo[3] = dedo & 0xFF;
+    for (size_t i = 4; i < TAMANHO_MODELO; i++)
+    {
+        semente ^= semente << 13;
+        semente ^= semente >> 17;
+        semente ^= semente << 5;
+        modelo[i] = semente & 0xFF;
+    }
+}
+
+// Dedo do modelo, ou 0 se ele nao for um modelo gerado por gerarModelo().
+static uint16_t dedoDoModelo(const uint8_t *modelo)
+{
+    uint8_t esperado[TAMANHO_MODELO];
+    uint16_t dedo = ((uint16_t)modelo[2] << 8) | modelo[3];
+    gerarModelo(dedo, esperado);
+    return dedo && memcmp(esperado, modelo, TAMANHO_MODELO) == 0 ? dedo : 0;
+}
+
+static ModuloDigitais modulo;
+
+void ModuloDigitais::processar(uint32_t us)
+{
+    _prontoEm += us;
+    estatisticas.processamentoUs += us;
+}
+
+bool ModuloDigitais::sortear(uint32_t porMil)
+{
+    if (!porMil)
+        return false;
+    _sorteio ^= _sorteio << 13;
+    _sorteio ^= _sorteio >> 17;
+    _sorteio ^= _sorteio << 5;
+    return _sorteio % 1000 < porMil;
+}
+
+void ModuloDigitais::receber(uint8_t byte)
+{
+    // Cabecalho: EF 01 | endereco (4) | tipo | tamanho (2) | dados | soma (2)
+    estatisticas.bytesRecebidos++;
+    if (_indice == 0 && byte != 0xEF)
+        return;
+    if (_indice == 1 && byte != 0x01)
+    {
+        _indice = 0;
+        return;
+    }
+    if (_indice < sizeof(_pacote))
+        _pacote[_indice] = byte;
+    _indice++;
+
+    if (_indice == 9)
+        _tamanho = ((uint16_t)_pacote[7] << 8) | _pacote[8];
+    if (_indice >= 9 && _indice == 9 + _tamanho)
+    {
+        if (_indice <= sizeof(_pacote) && _tamanho >= 2)
+        {
+            // A soma cobre tipo, tamanho e dados; um pacote com a soma errada e ignorado
+            uint16_t soma = 0;
+            for (uint16_t i = 6; i < _indice - 2; i++)
+                soma += _pacote[i];
+            bool integro = soma == (((uint16_t)_pacote[_indice - 2] << 8) | _pacote[_indice - 1]);
+            if (_pacote[6] == FINGERPRINT_COMMANDPACKET && _tamanho >= 3 && integro)
+                executar(&_pacote[9], _tamanho - 2);
+            else if (_pacote[6] == FINGERPRINT_DATAPACKET || _pacote[6] == FINGERPRINT_ENDDATAPACKET)
+                receberDados(_pacote[6], integro ? &_pacote[9] : nullptr, _tamanho - 2);
+        }
+        _indice = 0;
+    }
+}
+
+void ModuloDigitais::executar(const uint8_t *dados, uint16_t tamanho)
+{
+    // receber() ve cada byte quando o firmware o escreve; o comando so chega ao modulo
+    // quando o ultimo byte sai da linha.
+    estatisticas.comandos++;
+    _prontoEm = std::max(sim::agoraUs(), Serial2.txLivreEmUs());
+    switch (dados[0])
+    {
+    case FINGERPRINT_VERIFYPASSWORD:
+        processar(latencias.outrosUs);
+        responder(FINGERPRINT_OK);
+        break;
+
+    case FINGERPRINT_READSYSPARAM:
+    {
+        processar(latencias.outrosUs);
+        uint8_t resposta[17] = {FINGERPRINT_OK, 0x00, 0x00, 0x00, 0x09,
+                                (uint8_t)(capacidade >> 8), (uint8_t)(capacidade & 0xFF),
+                                0x00, 0x03, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x02, 0x00, 0x06};
+        responder(resposta, sizeof(resposta));
+        break;
+    }
+
+    case FINGERPRINT_GETIMAGE:
+        if (!dedoPresente)
+        {
+            processar(latencias.semDedoUs);
+            responder(FINGERPRINT_NOFINGER);
+            break;
+        }
+        processar(latencias.capturaUs);
+        if (sortear(erros.falhasCapturaPorMil))
+        {
+            estatisticas.falhasCaptura++;
+            responder(FINGERPRINT_IMAGEFAIL);
+            break;
+        }
+        _imagem = dedo;
+        responder(FINGERPRINT_OK);
+        break;
+
+    case FINGERPRINT_IMAGE2TZ:
+        processar(latencias.conversaoUs);
+        if (tamanho < 2 || dados[1] < 1 || dados[1] > 2)
+        {
+            responder(FINGERPRINT_PACKETRECIEVEERR);
+            break;
+        }
+        _buffer[dados[1]] = _imagem;
+        responder(FINGERPRINT_OK);
+        break;
+
+    case FINGERPRINT_REGMODEL:
+        processar(latencias.combinacaoUs);
+        if (_buffer[1] != _buffer[2])
+        {
+            responder(FINGERPRINT_ENROLLMISMATCH);
+            break;
+        }
+        _buffer[2] = _buffer[1]; // O modelo combinado fica nos dois CharBuffers
+        responder(FINGERPRINT_OK);
+        break;
+
+    case FINGERPRINT_STORE:
+    {
+        processar(latencias.gravacaoUs);
+        uint16_t slot = tamanho >= 4 ? ((uint16_t)dados[2] << 8) | dados[3] : 0;
+        if (slot > capacidade)
+        {
+            responder(FINGERPRINT_BADLOCATION);
+            break;
+        }
+        biblioteca[slot] = _buffer[dados[1] == 2 ? 2 : 1];
+        responder(FINGERPRINT_OK);
+        break;
+    }
+
+    case FINGERPRINT_LOAD:
+    {
+        processar(latencias.outrosUs);
+        uint16_t slot = tamanho >= 4 ? ((uint16_t)dados[2] << 8) | dados[3] : 0;
+        if (slot > capacidade)
+        {
+            responder(FINGERPRINT_BADLOCATION);
+            break;
+        }
+        if (!biblioteca[slot])
+        {
+            responder(FINGERPRINT_DBREADFAIL);
+            break;
+        }
+        _buffer[tamanho >= 2 && dados[1] == 2 ? 2 : 1] = biblioteca[slot];
+        responder(FINGERPRINT_OK);
+        break;
+    }
+
+    case FINGERPRINT_UPLOAD:
+    {
+        processar(latencias.outrosUs);
+        uint16_t modelo = _buffer[tamanho >= 2 && dados[1] == 2 ? 2 : 1];
+        if (!modelo)
+        {
+            responder(FINGERPRINT_UPLOADFEATUREFAIL);
+            break;
+        }
+        responder(FINGERPRINT_OK);
+        uint8_t bytes[TAMANHO_MODELO];
+        gerarModelo(modelo, bytes);
+        for (uint16_t enviados = 0; enviados < TAMANHO_MODELO; enviados += TAMANHO_PACOTE_DADOS)
+        {
+            bool ultimo = (size_t)(enviados + TAMANHO_PACOTE_DADOS) >= TAMANHO_MODELO;
+            enviarPacote(ultimo ? FINGERPRINT_ENDDATAPACKET : FINGERPRINT_DATAPACKET, bytes + enviados,
+                         TAMANHO_PACOTE_DADOS);
+        }
+        break;
+    }
+
+    case CMD_DOWNCHAR:
+        processar(latencias.outrosUs);
+        _destino = tamanho >= 2 && dados[1] == 2 ? 2 : 1;
+        _recebidos = 0;
+        _buffer[_destino] = 0;
+        responder(FINGERPRINT_OK);
+        break;
+
+    case CMD_READINDEXTABLE:
+    {
+        processar(latencias.outrosUs);
+        uint8_t resposta[33] = {FINGERPRINT_OK};
+        uint16_t primeiro = tamanho >= 2 ? dados[1] * 256 : 0;
+        for (uint16_t i = 0; i < 256; i++)
+            if (primeiro + i <= capacidade && biblioteca[primeiro + i])
+                resposta[1 + i / 8] |= 1 << (i % 8);
+        responder(resposta, sizeof(resposta));
+        break;
+    }
+
+    case FINGERPRINT_DELETE:
+    {
+        processar(latencias.exclusaoUs);
+        uint16_t slot = tamanho >= 3 ? ((uint16_t)dados[1] << 8) | dados[2] : 0;
+        if (slot > capacidade)
+        {
+            responder(FINGERPRINT_BADLOCATION);
+            break;
+        }
+        biblioteca[slot] = 0;
+        responder(FINGERPRINT_OK);
+        break;
+    }
+
+    case FINGERPRINT_TEMPLATECOUNT:
+    {
+        processar(latencias.outrosUs);
+        uint16_t total = 0;
+        for (uint16_t slot = 0; slot <= capacidade; slot++)
+            total += biblioteca[slot] != 0;
+        uint8_t resposta[3] = {FINGERPRINT_OK, (uint8_t)(total >> 8), (uint8_t)(total & 0xFF)};
+        responder(resposta, sizeof(resposta));
+        break;
+    }
+
+    case FINGERPRINT_SEARCH:
+    case FINGERPRINT_HISPEEDSEARCH:
+    {
+        // Faixa do comando: CharBuffer, pagina inicial (2 bytes), quantidade (2 bytes).
+        // A busca rapida para no primeiro modelo igual; a normal compara a faixa toda.
+        uint16_t procurado = _buffer[tamanho >= 2 ? (dados[1] == 2 ? 2 : 1) : 1];
+        uint16_t inicio = tamanho >= 4 ? ((uint16_t)dados[2] << 8) | dados[3] : 0;
+        uint16_t quantidade = tamanho >= 6 ? ((uint16_t)dados[4] << 8) | dados[5] : capacidade + 1;
+        uint32_t fim = std::min<uint32_t>((uint32_t)inicio + quantidade, capacidade + 1u);
+        bool rapida = dados[0] == FINGERPRINT_HISPEEDSEARCH;
+        uint32_t comparados = 0;
+        int32_t encontrado = -1;
+        for (uint32_t slot = inicio; slot < fim; slot++)
+        {
+            if (!biblioteca[slot])
+                continue;
+            comparados++;
+            if (procurado && biblioteca[slot] == procurado && encontrado < 0)
+            {
+                encontrado = slot;
+                if (rapida)
+                    break;
+            }
+        }
+        processar(latencias.buscaUs + comparados * latencias.buscaPorModeloUs);
+        uint8_t resposta[5] = {FINGERPRINT_NOTFOUND, 0x00, 0x00, 0x00, 0x00};
+        if (encontrado >= 0)
+        {
+            resposta[0] = FINGERPRINT_OK;
+            resposta[1] = encontrado >> 8;
+            resposta[2] = encontrado & 0xFF;
+            resposta[4] = 0x78;
+        }
+        responder(resposta, sizeof(resposta));
+        break;
+    }
+
+    default:
+        processar(latencias.outrosUs);
+        responder(FINGERPRINT_PACKETRECIEVEERR);
+        break;
+    }
+}
+
+// Pacotes de dados depois de CMD_DOWNCHAR; `dados` nulo se a soma nao bateu.
+void ModuloDigitais::receberDados(uint8_t tipo, const uint8_t *dados, uint16_t tamanho)
+{
+    if (!_destino)
+        return;
+    if (!dados || _recebidos + tamanho > TAMANHO_MODELO)
+    {
+        _destino = 0; // Download perdido: o CharBuffer fica vazio
+        return;
+    }
+    memcpy(_modeloRecebido + _recebidos, dados, tamanho);
+    _recebidos += tamanho;
+    if (tipo == FINGERPRINT_ENDDATAPACKET)
+    {
+        _buffer[_destino] = _recebidos == TAMANHO_MODELO ? dedoDoModelo(_modeloRecebido) : 0;
+        _destino = 0;
+    }
+}
+
+void ModuloDigitais::enviarPacote(uint8_t tipo, const uint8_t *dados, uint16_t tamanho)
+{
+    uint8_t pacote[9 + 256 + 2];
+    uint16_t comprimento = tamanho + 2;
+    uint16_t n = 0;
+
+    pacote[n++] = 0xEF;
+    pacote[n++] = 0x01;
+    for (int i = 0; i < 4; i++)
+        pacote[n++] = 0xFF;
+    pacote[n++] = tipo;
+    pacote[n++] = comprimento >> 8;
+    pacote[n++] = comprimento & 0xFF;
+
+    uint16_t soma = tipo + (comprimento >> 8) + (comprimento & 0xFF);
+    for (uint16_t i = 0; i < tamanho; i++)
+    {
+        pacote[n++] = dados[i];
+        soma += dados[i];
+    }
+    pacote[n++] = soma >> 8;
+    pacote[n++] = soma & 0xFF;
+
+    // A resposta sai quando o processamento termina e chega depois de atravessar a linha
+    // na baud configurada, atras dos pacotes que ja estavam saindo (o upload manda varios
+    // seguidos).
+    if (_linhaLivreEm < _prontoEm)
+        _linhaLivreEm = _prontoEm;
+    _linhaLivreEm += (uint64_t)n * Serial2.tempoByteUs();
+
+    if (sortear(erros.perdidasPorMil))
+    {
+        estatisticas.perdidas++;
+        return;
+    }
+    if (sortear(erros.corrompidasPorMil))
+    {
+        // Depois do endereco: tipo, tamanho, dados ou soma
+        estatisticas.corrompidas++;
+        pacote[6 + _sorteio % (n - 6)] ^= 1 << (_sorteio / 1000 % 8);
+    }
+    estatisticas.bytesEnviados += n;
+    estatisticas.ultimaRespostaEmUs = _linhaLivreEm;
+    Serial2.injetar(pacote, n, _linhaLivreEm);
+}
+
+// ------------------- SAIDA DE TOQUE -------------------
+// Sobe quando o dedo simulado encosta; o instante fica como o CCOUNT guardado pela
+// interrupcao no ESP32.
+static std::atomic<bool> toqueLigado{false};
+static std::atomic<bool> toque{false};
+static std::atomic<uint32_t> ciclosToque{0};
+
+bool halToqueIniciar(int pino)
+{
+    (void)pino;
+    toqueLigado = true;
+    return true;
+}
+
+bool halToqueLer(uint32_t &ciclos)
+{
+    if (!toque.exchange(false))
+        return false;
+    ciclos = ciclosToque;
+    return true;
+}
+
+void sim::definirDedo(bool presente, uint16_t id)
+{
+    bool encostou;
+    {
+        sim::Trava trava;
+        encostou = presente && !modulo.dedoPresente;
+        modulo.dedoPresente = presente;
+        modulo.dedo = id;
+    }
+    if (encostou && toqueLigado)
+    {
+        ciclosToque = halCiclos();
+        toque = true;
+    }
+}
+
+void sim::cadastrarDigital(uint16_t id)
+{
+    sim::Trava trava;
+    if (id >= 1 && id <= modulo.capacidade)
+        modulo.biblioteca[id] = id;
+}
+
+void sim::apagarDigitais()
+{
+    sim::Trava trava;
+    memset(modulo.biblioteca, 0, sizeof(modulo.biblioteca));
+}
+
+uint16_t sim::digitalGravada(uint16_t slot)
+{
+    sim::Trava trava;
+    return slot <= modulo.capacidade ? modulo.biblioteca[slot] : 0;
+}
+
+void sim::definirCapacidadeDigitais(uint16_t capacidade)
+{
+    sim::Trava trava;
+    modulo.capacidade = std::min(capacidade, ModuloDigitais::CAPACIDADE_MAXIMA);
+    for (uint16_t slot = modulo.capacidade + 1; slot <= ModuloDigitais::CAPACIDADE_MAXIMA; slot++)
+        modulo.biblioteca[slot] = 0;
+}
+
+void sim::definirLatenciasDigitais(const LatenciasDigitais &latencias)
+{
+    sim::Trava trava;
+    modulo.latencias = latencias;
+}
+
+void sim::injetarErrosDigitais(const ErrosDigitais &erros)
+{
+    sim::Trava trava;
+    modulo.erros = erros;
+}
+
+const sim::EstatisticasDigitais &sim::digitais()
+{
+    return modulo.estatisticas;
+}
@@ -0,0 +1,174 @@
+#ifndef SIMULADOR_H
+#define SIMULADOR_H
+
+#include <Arduino.h>
+#include <functional>
+#include <mutex>
+
+// ====================================================================================
+// CONTROLE DA SIMULACAO (BUILD NATIVO)
+// ====================================================================================
+// O relogio simulado e hibrido: avanca com o tempo real de CPU do host e salta
+// instantaneamente em delay() e nos custos modelados dos perifericos (I2C do
+// VL53L0X, UART, rede). Assim um trecho bloqueante aparece na latencia do loop() sem
+// precisar esperar por ele no relogio de parede. As conversoes do HX711 sao eventos
+// agendados, como a borda de DOUT na placa.
+//
+// Com tarefas (std::thread) o salto nao faz sentido, pois cada tarefa tem o seu proprio
+// tempo ocioso: em tempoReal() o relogio acompanha o host multiplicado por um fator e
+// delay() e os custos modelados dormem de verdade (divididos pelo fator).
+
+namespace sim
+{
+    // ------------------- RELOGIO -------------------
+    uint64_t agoraUs();
+    // O mesmo relogio com a resolucao do host, sem executar eventos (para medidas).
+    uint64_t agoraNs();
+    void avancarUs(uint64_t us);
+    // Agenda uma acao para o instante (em us simulados). Executada na primeira leitura
+    // do relogio igual ou posterior ao instante, inclusive dentro de um loop() bloqueado.
+    void agendar(uint64_t instanteUs, std::function<void()> acao);
+    void reiniciar();
+    void tempoReal(double fator);
+    // O tempo do host deixa de correr no relogio: so avancarUs() o move. Para medidas
+    // que precisam de passos exatos de relogio (uma unica thread, sem tempoReal()).
+    void congelarHost(bool congelar);
+
+    // ------------------- TAREFAS -------------------
+    // halMultitarefa() passa a retornar true; ligar antes do setup().
+    void usarTarefas(bool usar);
+    // halCriarTarefa() falha depois de `quantidade` tarefas (-1: sem limite).
+    void limitarTarefas(int quantidade);
+
+    // Todo estado simulado e protegido por esta trava (recursiva), pois as tarefas, os
+    // eventos agendados e o benchmark o acessam de threads diferentes. Nunca segura-la
+    // enquanto o relogio dorme.
+    std::recursive_mutex &estado();
+    class Trava
+    {
+    public:
+        Trava() { estado().lock(); }
+        ~Trava() { estado().unlock(); }
+        Trava(const Trava &) = delete;
+        Trava &operator=(const Trava &) = delete;
+    };
+
+    // ------------------- GPIO E ADC -------------------
+    void definirEntrada(uint8_t pino, int nivel);
+    int nivelSaida(uint8_t pino);
+    void definirAnalogico(uint8_t pino, uint16_t valor);
+    uint16_t nivelAnalogico(uint8_t pino);
+    // Chamado a cada digitalWrite() (instante, pino, nivel).
+    void aoEscreverPino(std::function<void(uint64_t, uint8_t, uint8_t)> observador);
+
+    // ------------------- SENSORES -------------------
+    void definirPeso(float kg);
+    // Ruido do HX711 (+- contagens) e picos isolados a cada mil conversoes. Padrao 20, 0.
+    void definirRuidoBalanca(uint32_t contagens, uint32_t picosPorMil);
+    // Alem do alcance do perfil atual (1,2 m ou 2 m) a medida sai invalida.
+    void definirDistanciaMM(uint16_t mm);
+
+    // ------------------- REDE -------------------
+    // O AP some ou volta. A reconexao depende do firmware (auto-reconexao desligada).
+    void definirWiFi(bool disponivel);
+    void definirRSSI(int dbm);
+    void definirBroker(bool disponivel);
+    // Tempo gasto em cada publicacao (rede lenta ou congestionada).
+    void definirCustoPublicacaoUs(uint32_t us);
+
+    struct EstatisticasBroker
+    {
+        unsigned long conexoes;
+        unsigned long falhasConexao;
+        unsigned long publicacoes;
+        unsigned long bytesPublicados;
+    };
+    const EstatisticasBroker &broker();
+    // Chamado a cada publicacao aceita pelo broker local (topico, payload, tamanho).
+    void aoPublicar(std::function<void(const char *, const uint8_t *, unsigned int)> observador);
+    // Outro cliente publica no broker: entregue ao firmware no proximo halMqttLoop() se
+    // o topico estiver assinado. Retida, tambem e entregue a cada nova assinatura.
+    void publicarNoBroker(const char *topico, const char *payload, bool reter);
+    void publicarNoBroker(const char *topico, const uint8_t *dados, size_t tamanho, bool reter);
+
+    // ------------------- FLASH -------------------
+    // Arquivo que guarda a particao simulada (padrao "caixa.bin", no diretorio atual).
+    // apagar=true comeca com a flash toda em 0xFF, como numa placa nova.
+    void usarArquivoFlash(const char *caminho, bool apagar);
+    // Queda de energia: escritas e apagamentos passam a falhar sem alterar a flash.
+    void bloquearFlash(bool bloquear);
+
+    struct EstatisticasFlash
+    {
+        unsigned long leituras;
+        unsigned long bytesLidos;
+        unsigned long escritas;
+        unsigned long bytesEscritos;
+        unsigned long setoresApagados;
+    };
+    const EstatisticasFlash &flash();
+
+    // ------------------- NVS -------------------
+    // Arquivo das chaves da NVS (padrao "nvs.bin"). apagar=true comeca sem nenhuma.
+    void usarArquivoNvs(const char *caminho, bool apagar);
+
+    // ------------------- SENSOR DE DIGITAIS -------------------
+    // Coloca (ou retira) um dedo no sensor. id 0 representa um dedo nao cadastrado. Com
+    // halToqueIniciar(), encostar o dedo tambem e um toque para halToqueLer().
+    void definirDedo(bool presente, uint16_t id = 0);
+    // Cadastra um template simulado no slot indicado.
+    void cadastrarDigital(uint16_t id);
+    // Esvazia a biblioteca do modulo (um sensor novo, para restaurar uma copia).
+    void apagarDigitais();
+    // Dedo gravado no slot (0 vazio).
+    uint16_t digitalGravada(uint16_t slot);
+    // Tamanho da biblioteca informado no READSYSPARAM: padrao 162, ate 1000 (R307).
+    void definirCapacidadeDigitais(uint16_t capacidade);
+
+    // Tempo de processamento do modulo por comando, contado a partir do fim do pacote na
+    // linha; so depois a resposta comeca a sair. Padrao: tudo zero, resposta imediata.
+    struct LatenciasDigitais
+    {
+        uint32_t capturaUs;        // GETIMAGE com dedo
+        uint32_t semDedoUs;        // GETIMAGE sem dedo
+        uint32_t conversaoUs;      // IMAGE2TZ
+        uint32_t buscaUs;          // SEARCH/HISPEEDSEARCH, fixo
+        uint32_t buscaPorModeloUs; // mais isto por modelo comparado
+        uint32_t combinacaoUs;     // REGMODEL
+        uint32_t gravacaoUs;       // STORE
+        uint32_t exclusaoUs;       // DELETE
+        uint32_t outrosUs;         // Senha, parametros, contagem, copia de modelos
+    };
+    // Ordem de grandeza do datasheet do AS608: captura < 0,5 s, busca < 0,3 s em 1000
+    // modelos.
+    const LatenciasDigitais LATENCIAS_AS608 = {150000, 40000, 60000, 2000, 300, 60000, 30000, 15000, 1000};
+    void definirLatenciasDigitais(const LatenciasDigitais &latencias);
+
+    // Erros sorteados por resposta (por mil): resposta que nao chega, um bit trocado em
+    // algum byte depois do endereco, e captura que falha com o dedo no sensor.
+    struct ErrosDigitais
+    {
+        uint32_t perdidasPorMil;
+        uint32_t corrompidasPorMil;
+        uint32_t falhasCapturaPorMil;
+    };
+    void injetarErrosDigitais(const ErrosDigitais &erros);
+
+    struct EstatisticasDigitais
+    {
+        unsigned long comandos;
+        unsigned long bytesRecebidos;
+        unsigned long bytesEnviados;
+        uint64_t processamentoUs; // Soma das latencias dos comandos
+        unsigned long perdidas;
+        unsigned long corrompidas;
+        unsigned long falhasCaptura;
+        uint64_t ultimaRespostaEmUs; // Ultimo byte da ultima resposta entregue na RX
+    };
+    const EstatisticasDigitais &digitais();
+
+    // ------------------- CONSOLE -------------------
+    void ecoarConsole(bool ecoar);
+}
+
+#endif
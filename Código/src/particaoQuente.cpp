@@ -0,0 +1,146 @@
+#include <string.h>
+#include "particaoQuente.h"
+
+static const uint16_t PONTOS_ACERTO = 16;
+static const uint16_t ACERTOS_POR_DECAIMENTO = 256;
+
+bool ParticaoQuente::configurar(uint16_t capacidade, uint8_t tamanho)
+{
+    *this = ParticaoQuente();
+    if (tamanho > MAX_PARTICAO_QUENTE || (uint32_t)tamanho * 8 > capacidade + 1u)
+        return tamanho == 0;
+    _tamanho = tamanho;
+    _inicio = capacidade + 1 - tamanho;
+    return true;
+}
+
+uint16_t ParticaoQuente::original(uint16_t posicao) const
+{
+    return reservada(posicao) ? _copias[posicao - _inicio] : 0;
+}
+
+void ParticaoQuente::registrarBusca(CamadaBusca camada, bool achou)
+{
+    _estatisticas[camada].buscas++;
+    _estatisticas[camada].acertos += achou;
+}
+
+void ParticaoQuente::zerarEstatisticas()
+{
+    memset(_estatisticas, 0, sizeof(_estatisticas));
+}
+
+// Contagem com um numero fixo de candidatos (space-saving): quem nao esta na tabela
+// entra no lugar do que tem menos pontos e herda os pontos dele, entao quem entra com
+// frequencia nao sai antes do segundo acerto. Com o decaimento, quem parou de entrar
+// chega a zero.
+void ParticaoQuente::registrarAcerto(uint16_t original)
+{
+    if (!_tamanho || !original || reservada(original))
+        return;
+
+    Candidato *menor = &_candidatos[0];
+    Candidato *achado = nullptr;
+    for (Candidato &c : _candidatos)
+    {
+        if (c.original == original)
+        {
+            achado = &c;
+            break;
+        }
+        if (c.pontos < menor->pontos)
+            menor = &c;
+    }
+    if (achado)
+        achado->pontos += PONTOS_ACERTO;
+    else
+        *menor = {original, (uint16_t)(menor->pontos + PONTOS_ACERTO)};
+
+    if (++_acertosAteDecair >= ACERTOS_POR_DECAIMENTO)
+    {
+        _acertosAteDecair = 0;
+        for (Candidato &c : _candidatos)
+            c.pontos /= 2;
+    }
+}
+
+uint16_t ParticaoQuente::pontos(uint16_t original) const
+{
+    for (const Candidato &c : _candidatos)
+        if (c.original == original)
+            return c.pontos;
+    return 0;
+}
+
+bool ParticaoQuente::temCopia(uint16_t original) const
+{
+    for (uint8_t i = 0; i < _tamanho; i++)
+        if (_copias[i] == original)
+            return true;
+    return false;
+}
+
+bool ParticaoQuente::proximaPromocao(uint16_t &original, uint16_t &destino) const
+{
+    const Candidato *melhor = nullptr;
+    for (const Candidato &c : _candidatos)
+        if (c.original && c.pontos >= PONTOS_ACERTO && (!melhor || c.pontos > melhor->pontos) && !temCopia(c.original))
+            melhor = &c;
+    if (!melhor)
+        return false;
+
+    // Posicao livre, ou a copia mais fria se o candidato tiver o dobro dos pontos dela
+    // mais um acerto: uma copia nao e trocada por quem entrou uma vez a mais
+    uint8_t fria = 0;
+    uint16_t pontosFria = UINT16_MAX;
+    for (uint8_t i = 0; i < _tamanho && pontosFria; i++)
+    {
+        uint16_t p = _copias[i] ? pontos(_copias[i]) : 0;
+        if (!_copias[i] || p < pontosFria)
+        {
+            fria = i;
+            pontosFria = _copias[i] ? p : 0;
+            if (!_copias[i])
+                break;
+        }
+    }
+    if (_copias[fria] && melhor->pontos < 2 * pontosFria + PONTOS_ACERTO)
+        return false;
+    original = melhor->original;
+    destino = _inicio + fria;
+    return true;
+}
+
+void ParticaoQuente::invalidar(uint16_t destino)
+{
+    if (reservada(destino))
+        _copias[destino - _inicio] = 0;
+}
+
+void ParticaoQuente::confirmar(uint16_t destino, uint16_t original)
+{
+    if (reservada(destino) && !reservada(original))
+        _copias[destino - _inicio] = original;
+}
+
+uint16_t ParticaoQuente::esquecer(uint16_t original)
+{
+    for (Candidato &c : _candidatos)
+        if (c.original == original)
+            c = {0, 0};
+    for (uint8_t i = 0; i < _tamanho; i++)
+    {
+        if (original && _copias[i] == original)
+        {
+            _copias[i] = 0;
+            return _inicio + i;
+        }
+    }
+    return 0;
+}
+
+void ParticaoQuente::restaurar(const uint16_t *copias)
+{
+    for (uint8_t i = 0; i < _tamanho; i++)
+        _copias[i] = reservada(copias[i]) ? 0 : copias[i];
+}
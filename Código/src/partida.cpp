@@ -0,0 +1,94 @@
+#include <atomic>
+#include "partida.h"
+
+static const char *NOMES_FASES[NUM_FASES_PARTIDA] = {
+    "trava", "configuracao", "digitais", "sensores", "caixa", "wifi", "mqtt", "relogio",
+};
+
+// ms + 1 (0: ainda nao)
+static std::atomic<uint32_t> inicios[NUM_FASES_PARTIDA] = {};
+static std::atomic<uint32_t> fins[NUM_FASES_PARTIDA] = {};
+static std::atomic<uint32_t> falhas{0}; // Um bit por fase
+
+void reiniciarPartida()
+{
+    for (uint8_t i = 0; i < NUM_FASES_PARTIDA; i++)
+    {
+        inicios[i].store(0, std::memory_order_relaxed);
+        fins[i].store(0, std::memory_order_relaxed);
+    }
+    falhas.store(0, std::memory_order_release);
+}
+
+void iniciarFase(FasePartida fase)
+{
+    inicios[fase].store(millis() + 1, std::memory_order_release);
+    fins[fase].store(0, std::memory_order_release);
+    falhas.fetch_and(~(1u << fase), std::memory_order_relaxed);
+}
+
+void concluirFase(FasePartida fase, bool ok)
+{
+    if (!inicios[fase].load(std::memory_order_acquire))
+        iniciarFase(fase);
+    if (!ok)
+        falhas.fetch_or(1u << fase, std::memory_order_relaxed);
+    fins[fase].store(millis() + 1, std::memory_order_release);
+}
+
+bool faseIniciada(FasePartida fase)
+{
+    return inicios[fase].load(std::memory_order_acquire) != 0;
+}
+
+bool faseConcluida(FasePartida fase)
+{
+    return fins[fase].load(std::memory_order_acquire) != 0;
+}
+
+uint32_t acessoLocalProntoMs()
+{
+    static const FasePartida LOCAIS[] = {PARTIDA_TRAVA, PARTIDA_CONFIGURACAO, PARTIDA_DIGITAIS};
+    uint32_t pronto = 0;
+    for (FasePartida fase : LOCAIS)
+    {
+        uint32_t fim = fins[fase].load(std::memory_order_acquire);
+        if (!fim)
+            return 0;
+        if (fim - 1 > pronto)
+            pronto = fim - 1;
+    }
+    return pronto ? pronto : 1; // Pronto no primeiro ms ainda e pronto
+}
+
+const char *nomeFasePartida(FasePartida fase)
+{
+    return fase < NUM_FASES_PARTIDA ? NOMES_FASES[fase] : "?";
+}
+
+size_t serializarPartida(char *buffer, size_t capacidade, time_t timestamp)
+{
+    size_t usado = 0;
+    int n = snprintf(buffer, capacidade, "{\"fases\":{");
+    for (uint8_t i = 0; i < NUM_FASES_PARTIDA && n >= 0 && usado + n < capacidade; i++)
+    {
+        usado += n;
+        uint32_t inicio = inicios[i].load(std::memory_order_acquire);
+        uint32_t fim = fins[i].load(std::memory_order_acquire);
+        if (inicio && fim)
+            n = snprintf(buffer + usado, capacidade - usado, "%s\"%s\":[%lu,%lu,%s]", i ? "," : "", NOMES_FASES[i],
+                         (unsigned long)(inicio - 1), (unsigned long)(fim - 1),
+                         falhas.load(std::memory_order_relaxed) & (1u << i) ? "false" : "true");
+        else
+            n = snprintf(buffer + usado, capacidade - usado, "%s\"%s\":null", i ? "," : "", NOMES_FASES[i]);
+    }
+    if (n >= 0 && usado + n < capacidade)
+    {
+        usado += n;
+        n = snprintf(buffer + usado, capacidade - usado, "},\"acesso_ms\":%lu,\"timestamp\":%ld}",
+                     (unsigned long)acessoLocalProntoMs(), (long)timestamp);
+    }
+    if (n < 0 || usado + n >= capacidade)
+        return 0;
+    return usado + n;
+}
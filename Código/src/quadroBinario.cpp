@@ -0,0 +1,244 @@
+#include <string.h>
+#include "quadroBinario.h"
+
+// ------------------- ESCRITA E LEITURA LITTLE-ENDIAN -------------------
+
+static uint8_t *escrever16(uint8_t *p, uint16_t valor)
+{
+    p[0] = valor & 0xFF;
+    p[1] = valor >> 8;
+    return p + 2;
+}
+
+static uint8_t *escrever32(uint8_t *p, uint32_t valor)
+{
+    p[0] = valor & 0xFF;
+    p[1] = (valor >> 8) & 0xFF;
+    p[2] = (valor >> 16) & 0xFF;
+    p[3] = valor >> 24;
+    return p + 4;
+}
+
+static uint16_t ler16(const uint8_t *p)
+{
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t ler32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t *escreverCabecalho(uint8_t *p, TipoQuadro tipo, uint8_t alarmes, uint16_t no,
+                                  uint32_t sequencia, uint32_t timestamp)
+{
+    *p++ = QUADRO_MARCA;
+    *p++ = QUADRO_VERSAO;
+    *p++ = (uint8_t)tipo;
+    *p++ = alarmes;
+    p = escrever16(p, no);
+    p = escrever32(p, sequencia);
+    return escrever32(p, timestamp);
+}
+
+static ResultadoQuadro conferirCabecalho(const uint8_t *dados, size_t tamanho)
+{
+    if (tamanho < QUADRO_TAMANHO_CABECALHO)
+        return QUADRO_CURTO;
+    if (dados[0] != QUADRO_MARCA)
+        return QUADRO_MARCA_ERRADA;
+    if (dados[1] != QUADRO_VERSAO)
+        return QUADRO_VERSAO_DESCONHECIDA;
+    return QUADRO_OK;
+}
+
+static size_t tamanhoCorpo(uint8_t tipo)
+{
+    switch (tipo)
+    {
+    case QUADRO_LEITURA:
+        return 10;
+    case QUADRO_ACESSO:
+        return 6;
+    case QUADRO_WIFI:
+        return 9;
+    default:
+        return 0;
+    }
+}
+
+// Menor corpo aceito na decodificacao: o da primeira versao do tipo.
+static size_t tamanhoMinimoCorpo(uint8_t tipo)
+{
+    switch (tipo)
+    {
+    case QUADRO_LEITURA:
+        return 9;
+    case QUADRO_ACESSO:
+        return 1;
+    default:
+        return tamanhoCorpo(tipo);
+    }
+}
+
+// ------------------- CODIFICACAO -------------------
+
+size_t codificarQuadro(const QuadroSafezone &quadro, uint8_t *buffer, size_t capacidade)
+{
+    size_t corpo = tamanhoCorpo(quadro.tipo);
+    size_t total = QUADRO_TAMANHO_CABECALHO + corpo;
+    if (corpo == 0 || capacidade < total)
+        return 0;
+
+    uint8_t *p = escreverCabecalho(buffer, quadro.tipo, quadro.alarmes, quadro.no, quadro.sequencia, quadro.timestamp);
+
+    switch (quadro.tipo)
+    {
+    case QUADRO_LEITURA:
+        p = escrever32(p, (uint32_t)quadro.medidaGramas);
+        p = escrever16(p, quadro.distanciaCM);
+        p = escrever16(p, quadro.leituraLDR);
+        *p++ = quadro.motivo;
+        *p++ = quadro.causaAlarme;
+        break;
+    case QUADRO_ACESSO:
+        *p++ = quadro.liberado ? 1 : 0;
+        p = escrever16(p, quadro.dedo);
+        p = escrever16(p, quadro.usuario);
+        *p++ = quadro.decisao;
+        break;
+    case QUADRO_WIFI:
+        *p++ = (uint8_t)quadro.rssi;
+        p = escrever32(p, quadro.conectadoS);
+        p = escrever16(p, quadro.reconexoes);
+        p = escrever16(p, quadro.quedas);
+        break;
+    default:
+        break;
+    }
+    return p - buffer;
+}
+
+// ------------------- DECODIFICACAO -------------------
+
+ResultadoQuadro decodificarQuadro(const uint8_t *dados, size_t tamanho, QuadroSafezone &quadro)
+{
+    ResultadoQuadro cabecalho = conferirCabecalho(dados, tamanho);
+    if (cabecalho != QUADRO_OK)
+        return cabecalho;
+
+    size_t corpo = tamanhoMinimoCorpo(dados[2]);
+    if (corpo == 0)
+        return QUADRO_TIPO_DESCONHECIDO;
+    if (tamanho < QUADRO_TAMANHO_CABECALHO + corpo)
+        return QUADRO_CURTO;
+
+    memset(&quadro, 0, sizeof(quadro));
+    quadro.tipo = (TipoQuadro)dados[2];
+    quadro.alarmes = dados[3];
+    quadro.no = ler16(dados + 4);
+    quadro.sequencia = ler32(dados + 6);
+    quadro.timestamp = ler32(dados + 10);
+
+    const uint8_t *p = dados + QUADRO_TAMANHO_CABECALHO;
+    switch (quadro.tipo)
+    {
+    case QUADRO_LEITURA:
+        quadro.medidaGramas = (int32_t)ler32(p);
+        quadro.distanciaCM = ler16(p + 4);
+        quadro.leituraLDR = ler16(p + 6);
+        quadro.motivo = p[8];
+        if (tamanho > QUADRO_TAMANHO_CABECALHO + 9)
+            quadro.causaAlarme = p[9];
+        break;
+    case QUADRO_ACESSO:
+        quadro.liberado = p[0] != 0;
+        quadro.decisao = QUADRO_DECISAO_DESCONHECIDA;
+        if (tamanho >= QUADRO_TAMANHO_CABECALHO + 6)
+        {
+            quadro.dedo = ler16(p + 1);
+            quadro.usuario = ler16(p + 3);
+            quadro.decisao = p[5];
+        }
+        break;
+    case QUADRO_WIFI:
+        quadro.rssi = (int8_t)p[0];
+        quadro.conectadoS = ler32(p + 1);
+        quadro.reconexoes = ler16(p + 5);
+        quadro.quedas = ler16(p + 7);
+        break;
+    default:
+        break;
+    }
+    return QUADRO_OK;
+}
+
+// ------------------- QUADRO DE AMOSTRAS -------------------
+
+size_t codificarQuadroAmostras(const QuadroAmostras &quadro, uint8_t *buffer, size_t capacidade)
+{
+    size_t total = QUADRO_TAMANHO_CABECALHO + 6 + 6 * (size_t)quadro.quantidade;
+    if (quadro.quantidade == 0 || quadro.quantidade > QUADRO_MAX_AMOSTRAS || capacidade < total)
+        return 0;
+
+    uint8_t *p = escreverCabecalho(buffer, QUADRO_AMOSTRAS, quadro.alarmes, quadro.no, quadro.sequencia, quadro.timestamp);
+    *p++ = quadro.sensor;
+    *p++ = quadro.quantidade;
+    p = escrever32(p, quadro.instanteMs);
+    for (uint8_t i = 0; i < quadro.quantidade; i++)
+    {
+        p = escrever16(p, quadro.amostras[i].deslocamentoMs);
+        p = escrever32(p, (uint32_t)quadro.amostras[i].valor);
+    }
+    return p - buffer;
+}
+
+ResultadoQuadro decodificarQuadroAmostras(const uint8_t *dados, size_t tamanho, QuadroAmostras &quadro)
+{
+    ResultadoQuadro cabecalho = conferirCabecalho(dados, tamanho);
+    if (cabecalho != QUADRO_OK)
+        return cabecalho;
+    if (dados[2] != QUADRO_AMOSTRAS)
+        return QUADRO_TIPO_DESCONHECIDO;
+    if (tamanho < QUADRO_TAMANHO_CABECALHO + 6)
+        return QUADRO_CURTO;
+
+    const uint8_t *p = dados + QUADRO_TAMANHO_CABECALHO;
+    uint8_t quantidade = p[1];
+    if (quantidade > QUADRO_MAX_AMOSTRAS)
+        return QUADRO_TIPO_DESCONHECIDO;
+    if (tamanho < QUADRO_TAMANHO_CABECALHO + 6 + 6 * (size_t)quantidade)
+        return QUADRO_CURTO;
+
+    quadro.alarmes = dados[3];
+    quadro.no = ler16(dados + 4);
+    quadro.sequencia = ler32(dados + 6);
+    quadro.timestamp = ler32(dados + 10);
+    quadro.sensor = p[0];
+    quadro.quantidade = quantidade;
+    quadro.instanteMs = ler32(p + 2);
+    p += 6;
+    for (uint8_t i = 0; i < quantidade; i++, p += 6)
+    {
+        quadro.amostras[i].deslocamentoMs = ler16(p);
+        quadro.amostras[i].valor = (int32_t)ler32(p + 2);
+    }
+    return QUADRO_OK;
+}
+
+const char *descreverResultadoQuadro(ResultadoQuadro resultado)
+{
+    switch (resultado)
+    {
+    case QUADRO_OK:
+        return "ok";
+    case QUADRO_CURTO:
+        return "quadro curto";
+    case QUADRO_MARCA_ERRADA:
+        return "nao e um quadro safezone";
+    case QUADRO_VERSAO_DESCONHECIDA:
+        return "versao desconhecida";
+    default:
+        return "tipo desconhecido";
+    }
+}
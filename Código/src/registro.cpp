@@ -0,0 +1,169 @@
+#include <atomic>
+#include <stdarg.h>
+#include "registro.h"
+
+static_assert((CAPACIDADE_REGISTRO & (CAPACIDADE_REGISTRO - 1)) == 0, "A capacidade do registro deve ser potencia de 2");
+
+// ------------------- FILA (VARIOS PRODUTORES, UM CONSUMIDOR) -------------------
+// Fila circular com numero de sequencia por celula: o produtor reserva a posicao com
+// compare-and-swap no fim, formata o texto na celula e so entao a publica; o consumidor
+// so le a celula publicada. `sequencia` guarda a volta da fila relativa ao indice da
+// celula, entao a fila zerada ja esta pronta para a primeira volta.
+struct CelulaRegistro
+{
+    std::atomic<uint32_t> sequencia;
+    uint32_t instanteMs;
+    NivelRegistro nivel;
+    char texto[TAMANHO_MENSAGEM_REGISTRO];
+};
+
+static const uint32_t MASCARA = CAPACIDADE_REGISTRO - 1;
+
+static CelulaRegistro celulas[CAPACIDADE_REGISTRO];
+static std::atomic<uint32_t> fim{0};
+static std::atomic<uint32_t> inicio{0}; // So o consumidor escreve
+static std::atomic<uint32_t> descartes{0};
+
+static inline uint32_t volta(uint32_t posicao)
+{
+    return posicao & ~MASCARA;
+}
+
+bool registrar(NivelRegistro nivel, const char *formato, ...)
+{
+    uint32_t posicao = fim.load(std::memory_order_relaxed);
+    CelulaRegistro *celula;
+    for (;;)
+    {
+        celula = &celulas[posicao & MASCARA];
+        int32_t diferenca = (int32_t)(celula->sequencia.load(std::memory_order_acquire) - volta(posicao));
+        if (diferenca == 0)
+        {
+            if (fim.compare_exchange_weak(posicao, posicao + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diferenca < 0) // Celula da volta anterior ainda nao lida: fila cheia
+        {
+            descartes.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+            posicao = fim.load(std::memory_order_relaxed);
+    }
+
+    celula->instanteMs = millis();
+    celula->nivel = nivel;
+    va_list argumentos;
+    va_start(argumentos, formato);
+    vsnprintf(celula->texto, sizeof(celula->texto), formato, argumentos);
+    va_end(argumentos);
+    celula->sequencia.store(volta(posicao) + 1, std::memory_order_release);
+    return true;
+}
+
+static bool retirar(uint32_t &instanteMs, NivelRegistro &nivel, char *texto)
+{
+    uint32_t posicao = inicio.load(std::memory_order_relaxed);
+    CelulaRegistro &celula = celulas[posicao & MASCARA];
+    if (celula.sequencia.load(std::memory_order_acquire) != volta(posicao) + 1)
+        return false; // Vazia, ou o produtor ainda esta formatando
+
+    instanteMs = celula.instanteMs;
+    nivel = celula.nivel;
+    memcpy(texto, celula.texto, sizeof(celula.texto));
+    celula.sequencia.store(volta(posicao) + CAPACIDADE_REGISTRO, std::memory_order_release);
+    inicio.store(posicao + 1, std::memory_order_release);
+    return true;
+}
+
+// ------------------- TAREFA DE REGISTRO -------------------
+
+static HardwareSerial *saida = nullptr;
+static char linha[24 + TAMANHO_MENSAGEM_REGISTRO]; // "[segundos.ms N] texto\r\n"
+static uint16_t tamanhoLinha = 0;
+static uint16_t escritos = 0;        // Bytes da linha atual ja na FIFO
+static uint32_t descartesInformados = 0;
+static bool linhaDeAviso = false; // Sem dois avisos seguidos: descartes sem parar nao travam a fila
+
+static void montarLinha(uint32_t instanteMs, NivelRegistro nivel, const char *texto)
+{
+    int n = snprintf(linha, sizeof(linha), "[%lu.%03lu %c] %s\r\n", (unsigned long)(instanteMs / 1000),
+                     (unsigned long)(instanteMs % 1000), nomeNivelRegistro(nivel)[0], texto);
+    tamanhoLinha = n < 0 ? 0 : (n < (int)sizeof(linha) ? n : sizeof(linha) - 1);
+    escritos = 0;
+}
+
+// Proxima linha: o aviso de descartes, se houve novos, senao a proxima mensagem.
+static bool proximaLinha()
+{
+    uint32_t total = descartes.load(std::memory_order_relaxed);
+    if (total != descartesInformados && !linhaDeAviso)
+    {
+        char aviso[TAMANHO_MENSAGEM_REGISTRO];
+        snprintf(aviso, sizeof(aviso), "%lu mensagens do registro descartadas (fila cheia).",
+                 (unsigned long)(total - descartesInformados));
+        descartesInformados = total;
+        linhaDeAviso = true;
+        montarLinha(millis(), REGISTRO_AVISO, aviso);
+        return true;
+    }
+
+    uint32_t instanteMs;
+    NivelRegistro nivel;
+    char texto[TAMANHO_MENSAGEM_REGISTRO];
+    if (!retirar(instanteMs, nivel, texto))
+        return linhaDeAviso = false;
+    linhaDeAviso = false;
+    montarLinha(instanteMs, nivel, texto);
+    return true;
+}
+
+void iniciarRegistro(HardwareSerial &serial)
+{
+    saida = &serial;
+}
+
+void passoRegistro()
+{
+    if (!saida)
+        return;
+    for (;;)
+    {
+        if (escritos == tamanhoLinha && !proximaLinha())
+            return;
+        int livre = saida->availableForWrite();
+        if (livre <= 0)
+            return; // A FIFO esvazia sozinha; o resto fica para o proximo passo
+        uint16_t parte = tamanhoLinha - escritos;
+        if ((int)parte > livre)
+            parte = livre;
+        saida->write((const uint8_t *)linha + escritos, parte);
+        escritos += parte;
+    }
+}
+
+uint32_t descartesRegistro()
+{
+    return descartes.load(std::memory_order_relaxed);
+}
+
+uint32_t pendentesRegistro()
+{
+    return fim.load(std::memory_order_relaxed) - inicio.load(std::memory_order_acquire);
+}
+
+const char *nomeNivelRegistro(NivelRegistro nivel)
+{
+    switch (nivel)
+    {
+    case REGISTRO_ERRO:
+        return "ERRO";
+    case REGISTRO_AVISO:
+        return "AVISO";
+    case REGISTRO_INFO:
+        return "INFO";
+    case REGISTRO_DEPURACAO:
+        return "DEPURACAO";
+    }
+    return "?";
+}
@@ -1,9 +1,32 @@
 #include "sensorDeDigitais.h"
 #include <Arduino.h>
+#include "hal.h"
+#include "diagnostico.h"
+#include "registro.h"
+
+// Comandos do protocolo sem define na Adafruit_Fingerprint
+static const uint8_t CMD_DOWNCHAR = 0x09;       // Recebe um modelo no CharBuffer
+static const uint8_t CMD_READINDEXTABLE = 0x1F; // Mapa das posicoes ocupadas, 256 por pagina
+
+// --- Confere a soma de uma confirmacao ---
+// getStructuredPacket() nao confere: um bit trocado na linha viraria outro codigo de
+// resposta ou outra posicao encontrada.
+static bool ackValid(const Adafruit_Fingerprint_Packet &packet)
+{
+    if (packet.type != FINGERPRINT_ACKPACKET || packet.length < 3)
+        return false;
+    uint16_t sum = packet.type + (packet.length >> 8) + (packet.length & 0xFF);
+    for (uint16_t i = 0; i < packet.length - 2; i++)
+        sum += packet.data[i];
+    return (((uint16_t)packet.data[packet.length - 2] << 8) | packet.data[packet.length - 1]) == sum;
+}
 
 // --- Construtor: Inicializa os objetos e variaveis da classe ---
 FingerprintSensor::FingerprintSensor(HardwareSerial *serial, uint32_t password, int rxPin, int txPin)
-    : _finger(serial, password), _mySerial(serial), _rxPin(rxPin), _txPin(txPin), _liberacaoAcesso(false)
+    : _finger(serial, password), _mySerial(serial), _liberacaoAcesso(false), _decisao(ACESSO_NAO_ENCONTRADO), _slot(0),
+      _usuario(0), _rxPin(rxPin), _txPin(txPin), _verifyState(VERIFY_IDLE), _verifyResult(FINGERPRINT_NOFINGER), _awaitingResponse(false),
+      _captureTimeout(DEFAULT_CAPTURE_TIMEOUT), _verifyStart(0), _commandSentAt(0), _decisionCycles(0), _partition(nullptr),
+      _searchTier(BUSCA_COMPLETA), _searchMark(0), _templateChange(nullptr)
 {
     // O construtor usa uma lista de inicializacao para configurar os membros da classe.
 }
@@ -11,35 +34,27 @@ FingerprintSensor::FingerprintSensor(HardwareSerial *serial, uint32_t password,
 // --- Inicializa o sensor e verifica a comunicacao ---
 bool FingerprintSensor::begin(long baudRate)
 {
+    // O monitor serial ja foi aberto no setup(); esperar por ele aqui seguraria a partida.
     _mySerial->begin(baudRate, SERIAL_8N1, _rxPin, _txPin);
-    Serial.begin(9600);
-    while (!Serial)
-    {
-        delay(100); // Espera o monitor serial ficar pronto.
-    }
-    Serial.println("Iniciando o sistema de impressao digital...");
+    REGISTRAR_INFO("Iniciando o sistema de impressao digital...");
 
     // Tenta se comunicar com o sensor usando a senha.
     if (_finger.verifyPassword())
     {
-        Serial.println("Sensor de impressao digital encontrado!");
+        REGISTRAR_INFO("Sensor de impressao digital encontrado!");
     }
     else
     {
-        Serial.println("Sensor de impressao digital nao encontrado :(");
-        Serial.println("Verifique as conexoes e a baud rate.");
+        REGISTRAR_ERRO("Sensor de impressao digital nao encontrado :( Verifique as conexoes e a baud rate.");
         return false;
     }
 
     // Pega informacoes basicas do sensor, como capacidade de armazenamento.
-    _finger.getParameters();
-    Serial.print("Capacidade de armazenamento: ");
-    Serial.println(_finger.capacity);
-    Serial.print("Nivel de seguranca: ");
-    Serial.println(_finger.security_level);
-
-    Serial.println("Sistema pronto. Escolha uma opcao:");
-    printMenu();
+    // A lista de acesso so aceita posicoes que existem no sensor.
+    if (_finger.getParameters() == FINGERPRINT_OK)
+        limitarSlotsAcesso(_finger.capacity);
+    REGISTRAR_INFO("Capacidade de armazenamento: %u | Nivel de seguranca: %u", (unsigned)_finger.capacity,
+                   (unsigned)_finger.security_level);
     return true;
 }
 
@@ -62,14 +77,14 @@ void FingerprintSensor::enrollFingerprint()
     int id;
     // Pede ao usuario um ID para salvar a digital.
     Serial.print("Digite o ID para a nova impressao digital (1 a ");
-    Serial.print(_finger.capacity);
+    Serial.print(lastUserSlot());
     Serial.print("): ");
     while (!Serial.available())
         delay(100);
     id = Serial.parseInt();
     Serial.readStringUntil('\n');
 
-    if (id < 1 || id > _finger.capacity)
+    if (id < 1 || id > lastUserSlot())
     {
         Serial.println("ID invalido. Tente novamente.");
         return;
@@ -83,7 +98,7 @@ void FingerprintSensor::enrollFingerprint()
     if (p == FINGERPRINT_OK)
     {
         // Se a leitura foi bem sucedida, salva o modelo na memoria do sensor.
-        p = _finger.storeModel(id);
+        p = templateChanging(id) ? _finger.storeModel(id) : FINGERPRINT_FLASHERR;
         switch (p)
         {
         case FINGERPRINT_OK:
@@ -111,42 +126,15 @@ void FingerprintSensor::enrollFingerprint()
     printMenu();
 }
 
-// --- Verifica se a digital apresentada existe no banco de dados ---
+// --- Verifica se a digital apresentada existe no banco de dados (modo menu, bloqueante) ---
 void FingerprintSensor::verifyFingerprint()
 {
-    Serial.println("Coloque o dedo no sensor para verificar...");
-    Serial.println("Aguardando o dedo...");
-
-    _liberacaoAcesso = false; // Reseta a permissao antes de cada nova verificacao.
-
-    // Chama a funcao de busca rapida.
-    uint8_t p = getFingerprintIDez();
-    if (p == FINGERPRINT_OK)
+    startVerification();
+    while (!pollVerification())
     {
-        Serial.println("Impressao digital encontrada!");
-        Serial.print("ID: ");
-        Serial.print(_finger.fingerID);
-        Serial.print(" | Confianca: ");
-        Serial.println(_finger.confidence);
-        _liberacaoAcesso = true; // Permite o acesso se a digital for encontrada.
-    }
-    else if (p == FINGERPRINT_NOFINGER)
-    {
-        Serial.println("Nenhum dedo detectado.");
-    }
-    else if (p == FINGERPRINT_NOTFOUND)
-    {
-        Serial.println("Impressao digital nao encontrada no banco de dados.");
-    }
-    else if (p == FINGERPRINT_PACKETRECIEVEERR)
-    {
-        Serial.println("Erro de comunicacao.");
-    }
-    else
-    {
-        Serial.print("Erro desconhecido: ");
-        Serial.println(p);
+        delay(1);
     }
+    reportVerification();
     Serial.println("Sistema pronto. Escolha uma opcao:");
     printMenu();
 }
@@ -161,7 +149,7 @@ void FingerprintSensor::deleteFingerprint()
     id = Serial.parseInt();
     Serial.readStringUntil('\n');
 
-    if (id < 1 || id > _finger.capacity)
+    if (id < 1 || id > lastUserSlot())
     {
         Serial.println("ID invalido. Tente novamente.");
         return;
@@ -171,7 +159,7 @@ void FingerprintSensor::deleteFingerprint()
     Serial.println(id);
 
     // Manda o comando de exclusao para o sensor.
-    uint8_t p = _finger.deleteModel(id);
+    uint8_t p = templateChanging(id) ? _finger.deleteModel(id) : FINGERPRINT_FLASHERR;
     switch (p)
     {
     case FINGERPRINT_OK:
@@ -217,6 +205,426 @@ bool FingerprintSensor::isAccessGranted()
     return _liberacaoAcesso;
 }
 
+DecisaoAcesso FingerprintSensor::accessDecision()
+{
+    return _decisao;
+}
+
+uint16_t FingerprintSensor::matchedSlot()
+{
+    return _slot;
+}
+
+uint16_t FingerprintSensor::matchedUser()
+{
+    return _usuario;
+}
+
+// --- Tempo maximo esperando o dedo depois de iniciar uma verificacao ---
+void FingerprintSensor::setCaptureTimeout(unsigned long timeoutMs)
+{
+    _captureTimeout = timeoutMs;
+}
+
+// --- Inicia uma verificacao assincrona; o progresso acontece em pollVerification() ---
+void FingerprintSensor::startVerification()
+{
+    REGISTRAR_INFO("Coloque o dedo no sensor para verificar...");
+
+    _liberacaoAcesso = false; // Reseta a permissao antes de cada nova verificacao.
+    _decisao = ACESSO_NAO_ENCONTRADO;
+    _slot = 0;
+    _usuario = 0;
+    _verifyResult = FINGERPRINT_NOFINGER;
+    _verifyState = VERIFY_CAPTURE;
+    _awaitingResponse = false;
+    _verifyStart = millis();
+}
+
+bool FingerprintSensor::isVerificationPending()
+{
+    return _verifyState != VERIFY_IDLE && _verifyState != VERIFY_DONE;
+}
+
+// --- Codigo FINGERPRINT_* da ultima verificacao concluida ---
+uint8_t FingerprintSensor::verificationResult()
+{
+    return _verifyResult;
+}
+
+uint32_t FingerprintSensor::decisionCycles()
+{
+    return _decisionCycles;
+}
+
+// --- Avanca a verificacao sem esperar pelo sensor ---
+// Cada chamada le a resposta que ja chegou pela serial e, na mesma chamada, envia o
+// comando da etapa seguinte: a conversao sai assim que a imagem foi capturada e a busca
+// assim que o modelo foi gerado, sem esperar outra passagem do loop.
+bool FingerprintSensor::pollVerification()
+{
+    if (!isVerificationPending())
+        return false;
+
+    if (!_awaitingResponse)
+        return sendStageCommand();
+
+    // Aguarda a resposta completa chegar antes de ler, sem bloquear.
+    if (_mySerial->available() < MIN_ACK_SIZE)
+    {
+        if (millis() - _commandSentAt >= RESPONSE_TIMEOUT)
+            return finishVerification(FINGERPRINT_PACKETRECIEVEERR);
+        return false;
+    }
+
+    _awaitingResponse = false;
+    Adafruit_Fingerprint_Packet packet(FINGERPRINT_ACKPACKET, 0, NULL);
+    if (_finger.getStructuredPacket(&packet, 20) != FINGERPRINT_OK || !ackValid(packet))
+        return finishVerification(FINGERPRINT_PACKETRECIEVEERR);
+
+    uint8_t p = packet.data[0];
+    switch (_verifyState)
+    {
+    case VERIFY_CAPTURE:
+        switch (p)
+        {
+        case FINGERPRINT_OK:
+            _verifyState = VERIFY_CONVERT;
+            return sendStageCommand();
+        case FINGERPRINT_NOFINGER:
+            return false; // Tenta de novo na proxima chamada, ate o timeout de captura.
+        case FINGERPRINT_IMAGEFAIL:
+            REGISTRAR_AVISO("Erro na captura da imagem.");
+            return finishVerification(p);
+        default:
+            return finishVerification(p);
+        }
+
+    case VERIFY_CONVERT:
+        if (p != FINGERPRINT_OK)
+            return finishVerification(p);
+        _verifyState = VERIFY_SEARCH;
+        _searchTier = _partition && _partition->ativa() ? BUSCA_QUENTE : BUSCA_COMPLETA;
+        return sendStageCommand();
+
+    case VERIFY_SEARCH:
+        _finger.fingerID = ((uint16_t)packet.data[1] << 8) | packet.data[2];
+        _finger.confidence = ((uint16_t)packet.data[3] << 8) | packet.data[4];
+        return finishSearch(p);
+
+    default:
+        return false;
+    }
+}
+
+// --- Envia o comando da etapa atual; true se a verificacao terminou (timeout de captura) ---
+bool FingerprintSensor::sendStageCommand()
+{
+    switch (_verifyState)
+    {
+    case VERIFY_CAPTURE:
+    {
+        if (millis() - _verifyStart >= _captureTimeout)
+            return finishVerification(FINGERPRINT_NOFINGER);
+        const uint8_t command[] = {FINGERPRINT_GETIMAGE};
+        sendCommand(command, sizeof(command));
+        break;
+    }
+    case VERIFY_CONVERT:
+    {
+        const uint8_t command[] = {FINGERPRINT_IMAGE2TZ, 1};
+        sendCommand(command, sizeof(command));
+        break;
+    }
+    case VERIFY_SEARCH:
+    {
+        // Mesmo pacote que Adafruit_Fingerprint::fingerFastSearch(), que sempre procura
+        // nas 163 primeiras posicoes; num sensor maior a faixa cobre a biblioteca inteira.
+        // Com a particao quente: primeiro so as posicoes reservadas, depois as anteriores.
+        uint16_t start = 0;
+        uint16_t count = _finger.capacity > 0xA2 ? _finger.capacity + 1 : 0xA3;
+        if (_partition && _partition->ativa())
+        {
+            start = _searchTier == BUSCA_QUENTE ? _partition->inicio() : 0;
+            count = _searchTier == BUSCA_QUENTE ? _partition->tamanho() : _partition->inicio();
+        }
+        const uint8_t command[] = {FINGERPRINT_HISPEEDSEARCH, 0x01, (uint8_t)(start >> 8), (uint8_t)(start & 0xFF),
+                                   (uint8_t)(count >> 8), (uint8_t)(count & 0xFF)};
+        sendCommand(command, sizeof(command));
+        _searchMark = marcarEtapa();
+        break;
+    }
+    default:
+        break;
+    }
+    return false;
+}
+
+// --- Resposta de uma busca: acerto na particao vira a posicao original ---
+// Sem acerto na particao (ou num acerto numa copia que ja nao vale), a busca segue no
+// resto da biblioteca na mesma chamada.
+bool FingerprintSensor::finishSearch(uint8_t result)
+{
+    medirEtapa(_searchTier == BUSCA_QUENTE ? ETAPA_BUSCA_QUENTE : ETAPA_BUSCA_COMPLETA, _searchMark);
+    if (!_partition || !_partition->ativa())
+        return finishVerification(result);
+
+    bool found = result == FINGERPRINT_OK;
+    if (_searchTier == BUSCA_QUENTE)
+    {
+        uint16_t original = found ? _partition->original(_finger.fingerID) : 0;
+        _partition->registrarBusca(BUSCA_QUENTE, original != 0);
+        if (original)
+        {
+            _finger.fingerID = original;
+            _partition->registrarAcerto(original);
+            return finishVerification(result);
+        }
+        if (!found && result != FINGERPRINT_NOTFOUND)
+            return finishVerification(result);
+        _searchTier = BUSCA_COMPLETA;
+        return sendStageCommand();
+    }
+
+    _partition->registrarBusca(BUSCA_COMPLETA, found);
+    if (found)
+        _partition->registrarAcerto(_finger.fingerID);
+    return finishVerification(result);
+}
+
+// --- Envia um pacote de comando sem esperar pela resposta ---
+void FingerprintSensor::sendCommand(const uint8_t *data, uint8_t length)
+{
+    // Descarta respostas atrasadas de um comando anterior que expirou.
+    while (_mySerial->available())
+        _mySerial->read();
+
+    Adafruit_Fingerprint_Packet packet(FINGERPRINT_COMMANDPACKET, length, (uint8_t *)data);
+    _finger.writeStructuredPacket(packet);
+    _awaitingResponse = true;
+    _commandSentAt = millis();
+}
+
+// --- Registra o resultado da verificacao (sem log: ver reportVerification()) ---
+bool FingerprintSensor::finishVerification(uint8_t result)
+{
+    _decisionCycles = halCiclos();
+    _verifyResult = result;
+    _verifyState = VERIFY_DONE;
+    _awaitingResponse = false;
+
+    if (result == FINGERPRINT_OK)
+    {
+        // Encontrar a digital nao basta: a lista de acesso local decide, sem rede.
+        ResultadoAcesso acesso = avaliarAcesso(_finger.fingerID, _finger.confidence, halRelogioAgora());
+        _slot = _finger.fingerID;
+        _usuario = acesso.usuario;
+        _decisao = acesso.decisao;
+        _liberacaoAcesso = acesso.decisao == ACESSO_LIBERADO;
+    }
+    return true;
+}
+
+// --- Informa o resultado da ultima verificacao no registro ---
+void FingerprintSensor::reportVerification()
+{
+    uint8_t result = _verifyResult;
+    if (result == FINGERPRINT_OK)
+    {
+        REGISTRAR_INFO("Impressao digital encontrada! ID: %u | Confianca: %u", (unsigned)_finger.fingerID,
+                       (unsigned)_finger.confidence);
+        if (!_liberacaoAcesso)
+            REGISTRAR_INFO("Acesso negado: %s", nomeDecisaoAcesso(_decisao));
+    }
+    else if (result == FINGERPRINT_NOFINGER)
+    {
+        REGISTRAR_INFO("Nenhum dedo detectado.");
+    }
+    else if (result == FINGERPRINT_NOTFOUND)
+    {
+        REGISTRAR_INFO("Impressao digital nao encontrada no banco de dados.");
+    }
+    else if (result == FINGERPRINT_PACKETRECIEVEERR)
+    {
+        REGISTRAR_AVISO("Erro de comunicacao.");
+    }
+    else
+    {
+        REGISTRAR_ERRO("Erro desconhecido: %u", (unsigned)result);
+    }
+}
+
+// --- Capacidade lida do sensor em begin() ---
+uint16_t FingerprintSensor::capacity()
+{
+    return _finger.capacity;
+}
+
+// --- Mapa das posicoes ocupadas de uma pagina (256 posicoes) ---
+uint8_t FingerprintSensor::readIndexTable(uint8_t page, uint8_t *bitmap)
+{
+    const uint8_t command[] = {CMD_READINDEXTABLE, page};
+    Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, NULL);
+    uint8_t p = sendAndWait(command, sizeof(command), reply);
+    if (p != FINGERPRINT_OK)
+        return p;
+    if (reply.length < 1 + INDEX_TABLE_SIZE)
+        return FINGERPRINT_PACKETRECIEVEERR;
+    memcpy(bitmap, &reply.data[1], INDEX_TABLE_SIZE);
+    return FINGERPRINT_OK;
+}
+
+// --- Le o modelo gravado em `slot` ---
+// loadModel() leva o modelo para o CharBuffer 1 e getModel() pede o upload: depois da
+// confirmacao o sensor manda pacotes de dados de packet_len bytes, o ultimo do tipo
+// FINGERPRINT_ENDDATAPACKET. Sao lidos aqui porque a Adafruit_Fingerprint_Packet guarda
+// so 64 bytes.
+uint8_t FingerprintSensor::readTemplate(uint16_t slot, uint8_t *model)
+{
+    uint8_t p = _finger.loadModel(slot);
+    if (p != FINGERPRINT_OK)
+        return p;
+    p = _finger.getModel();
+    if (p != FINGERPRINT_OK)
+        return p;
+
+    uint16_t received = 0;
+    uint8_t type = FINGERPRINT_DATAPACKET;
+    while (type == FINGERPRINT_DATAPACKET)
+    {
+        uint16_t length;
+        if (!readDataPacket(model + received, TAMANHO_MODELO - received, type, length))
+            return FINGERPRINT_PACKETRECIEVEERR;
+        received += length;
+    }
+    return received == TAMANHO_MODELO ? FINGERPRINT_OK : FINGERPRINT_PACKETRECIEVEERR;
+}
+
+// --- Grava um modelo em `slot` (substitui o que houver la) ---
+// O sensor confirma o comando de download e recebe os pacotes de dados sem responder;
+// storeModel() grava o CharBuffer 1 na flash e confirma a copia inteira.
+uint8_t FingerprintSensor::writeTemplate(uint16_t slot, const uint8_t *model)
+{
+    const uint8_t command[] = {CMD_DOWNCHAR, 0x01};
+    Adafruit_Fingerprint_Packet reply(FINGERPRINT_ACKPACKET, 0, NULL);
+    uint8_t p = sendAndWait(command, sizeof(command), reply);
+    if (p != FINGERPRINT_OK)
+        return p;
+
+    // packet_len vem de getParameters(); sem ele, 128 bytes (padrao de fabrica)
+    uint16_t packetSize = _finger.packet_len >= 32 && _finger.packet_len <= 256 ? _finger.packet_len : 128;
+    for (uint16_t sent = 0; sent < TAMANHO_MODELO; sent += packetSize)
+    {
+        uint16_t length = TAMANHO_MODELO - sent < packetSize ? TAMANHO_MODELO - sent : packetSize;
+        bool last = sent + length >= TAMANHO_MODELO;
+        writeDataPacket(last ? FINGERPRINT_ENDDATAPACKET : FINGERPRINT_DATAPACKET, model + sent, length);
+    }
+    if (!templateChanging(slot))
+        return FINGERPRINT_FLASHERR;
+    return _finger.storeModel(slot);
+}
+
+// --- Copia o modelo de `from` para `to` dentro do sensor, sem passar pela serial ---
+uint8_t FingerprintSensor::copyTemplate(uint16_t from, uint16_t to)
+{
+    uint8_t p = _finger.loadModel(from);
+    if (p != FINGERPRINT_OK)
+        return p;
+    return _finger.storeModel(to);
+}
+
+void FingerprintSensor::useHotPartition(ParticaoQuente *partition)
+{
+    _partition = partition;
+}
+
+void FingerprintSensor::onTemplateChange(bool (*callback)(uint16_t slot))
+{
+    _templateChange = callback;
+}
+
+uint16_t FingerprintSensor::lastUserSlot()
+{
+    return _partition && _partition->ativa() ? _partition->inicio() - 1 : _finger.capacity;
+}
+
+bool FingerprintSensor::templateChanging(uint16_t slot)
+{
+    return !_templateChange || _templateChange(slot);
+}
+
+// --- Envia um comando e espera a confirmacao (modo bloqueante) ---
+uint8_t FingerprintSensor::sendAndWait(const uint8_t *data, uint8_t length, Adafruit_Fingerprint_Packet &reply)
+{
+    while (_mySerial->available())
+        _mySerial->read();
+
+    Adafruit_Fingerprint_Packet packet(FINGERPRINT_COMMANDPACKET, length, (uint8_t *)data);
+    _finger.writeStructuredPacket(packet);
+    if (_finger.getStructuredPacket(&reply, RESPONSE_TIMEOUT) != FINGERPRINT_OK || !ackValid(reply))
+        return FINGERPRINT_PACKETRECIEVEERR;
+    return reply.data[0];
+}
+
+// --- Le um pacote de dados inteiro e confere a soma ---
+bool FingerprintSensor::readDataPacket(uint8_t *data, uint16_t capacity, uint8_t &type, uint16_t &length)
+{
+    uint8_t header[9];
+    uint8_t checksum[2];
+    if (!readBytes(header, sizeof(header)) || header[0] != 0xEF || header[1] != 0x01)
+        return false;
+
+    type = header[6];
+    uint16_t wireLength = ((uint16_t)header[7] << 8) | header[8];
+    if ((type != FINGERPRINT_DATAPACKET && type != FINGERPRINT_ENDDATAPACKET) || wireLength < 2 ||
+        wireLength - 2 > capacity)
+        return false;
+    length = wireLength - 2;
+    if (!readBytes(data, length) || !readBytes(checksum, sizeof(checksum)))
+        return false;
+
+    uint16_t sum = type + header[7] + header[8];
+    for (uint16_t i = 0; i < length; i++)
+        sum += data[i];
+    return (((uint16_t)checksum[0] << 8) | checksum[1]) == sum;
+}
+
+// --- Escreve um pacote de dados (o mesmo formato de writeStructuredPacket) ---
+void FingerprintSensor::writeDataPacket(uint8_t type, const uint8_t *data, uint16_t length)
+{
+    uint16_t wireLength = length + 2;
+    const uint8_t header[9] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, type, (uint8_t)(wireLength >> 8),
+                               (uint8_t)(wireLength & 0xFF)};
+    uint16_t sum = type + (wireLength >> 8) + (wireLength & 0xFF);
+    for (uint16_t i = 0; i < length; i++)
+        sum += data[i];
+
+    _mySerial->write(header, sizeof(header));
+    _mySerial->write(data, length);
+    _mySerial->write((uint8_t)(sum >> 8));
+    _mySerial->write((uint8_t)(sum & 0xFF));
+}
+
+// --- Le `length` bytes da serial, com o mesmo limite de espera das respostas ---
+bool FingerprintSensor::readBytes(uint8_t *data, uint16_t length)
+{
+    unsigned long start = millis();
+    uint16_t received = 0;
+    while (received < length)
+    {
+        if (_mySerial->available())
+        {
+            data[received++] = _mySerial->read();
+            start = millis();
+        }
+        else if (millis() - start >= RESPONSE_TIMEOUT)
+            return false;
+        else
+            delay(1);
+    }
+    return true;
+}
+
 // --- Funcao interna que faz o processo de leitura em duas etapas para o cadastro ---
 uint8_t FingerprintSensor::getFingerprintEnroll()
 {
@@ -397,6 +805,12 @@ uint8_t FingerprintSensor::getFingerprintID()
     p = _finger.fingerFastSearch();
     if (p == FINGERPRINT_OK)
     {
+        // A busca rapida pode cair numa copia da particao quente
+        if (_partition && _partition->reservada(_finger.fingerID))
+        {
+            _finger.fingerID = _partition->original(_finger.fingerID);
+            return _finger.fingerID ? FINGERPRINT_OK : FINGERPRINT_NOTFOUND;
+        }
         return FINGERPRINT_OK;
     }
     else if (p == FINGERPRINT_NOTFOUND)
@@ -407,42 +821,4 @@ uint8_t FingerprintSensor::getFingerprintID()
     {
         return p;
     }
-}
-
-// --- Funcao otimizada para busca: captura a imagem e procura no banco de dados ---
-uint8_t FingerprintSensor::getFingerprintIDez()
-{
-    uint8_t p = -1;
-    // Fica em loop ate conseguir uma imagem valida do dedo.
-    while (p != FINGERPRINT_OK)
-    {
-        p = _finger.getImage();
-        switch (p)
-        {
-        case FINGERPRINT_OK:
-            // Serial.println("Imagem capturada."); // Comentado para nao poluir a serial na operacao normal.
-            break;
-        case FINGERPRINT_NOFINGER:
-            break;
-        case FINGERPRINT_PACKETRECIEVEERR:
-            Serial.println("Erro de comunicacao.");
-            return p;
-        case FINGERPRINT_IMAGEFAIL:
-            Serial.println("Erro na captura da imagem.");
-            return p;
-        default:
-            Serial.print("Erro desconhecido: ");
-            Serial.println(p);
-            return p;
-        }
-    }
-
-    // Converte a imagem em template.
-    p = _finger.image2Tz(1);
-    if (p != FINGERPRINT_OK)
-        return p;
-
-    // Executa a busca rapida do template no banco de dados do sensor.
-    p = _finger.fingerFastSearch();
-    return p;
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include <atomic>
+#include "tarefas.h"
+#include "hal.h"
+#include "registro.h"
+
+// Escritos apenas pela tarefa dona do indice; lidos por qualquer uma.
+struct ContadoresTarefa
+{
+    std::atomic<uint32_t> passos{0};
+    std::atomic<uint32_t> maiorPassoUs{0};
+    std::atomic<uint32_t> tempoTotalUs{0};
+};
+
+static ContadoresTarefa contadores[MAX_TAREFAS];
+static const Tarefa *tarefas = nullptr;
+static uint8_t quantidadeTarefas = 0;
+static bool ativas = false;
+
+// As tarefas criadas esperam aqui ate todas existirem: se uma falhar, as outras
+// terminam sem ter tocado em nada, e o setup() segue no modo cooperativo.
+enum LiberacaoTarefas : uint8_t
+{
+    TAREFAS_ESPERANDO,
+    TAREFAS_LIBERADAS,
+    TAREFAS_CANCELADAS
+};
+static std::atomic<uint8_t> liberacao{TAREFAS_ESPERANDO};
+
+static void executarPasso(const Tarefa &tarefa, ContadoresTarefa &contador)
+{
+    unsigned long inicio = micros();
+    tarefa.passo();
+    if (tarefa.agenda)
+        tarefa.agenda->executar(millis());
+    uint32_t duracao = micros() - inicio;
+
+    contador.passos.fetch_add(1, std::memory_order_relaxed);
+    contador.tempoTotalUs.fetch_add(duracao, std::memory_order_relaxed);
+    if (duracao > contador.maiorPassoUs.load(std::memory_order_relaxed))
+        contador.maiorPassoUs.store(duracao, std::memory_order_relaxed);
+}
+
+// O periodo, ou menos se o agendador tiver um prazo antes (no minimo 1 ms, para ceder
+// o nucleo as tarefas de prioridade menor).
+static unsigned long espera(const Tarefa &tarefa)
+{
+    unsigned long ms = tarefa.periodoMs;
+    if (tarefa.agenda)
+    {
+        uint32_t prazo = tarefa.agenda->msAteProximo(millis());
+        if (prazo < ms)
+            ms = prazo;
+    }
+    return ms ? ms : 1;
+}
+
+static void executarTarefa(void *parametro)
+{
+    uint8_t indice = (uint8_t)(uintptr_t)parametro;
+    const Tarefa &tarefa = tarefas[indice];
+
+    while (liberacao.load(std::memory_order_acquire) == TAREFAS_ESPERANDO)
+        delay(1);
+    if (liberacao.load(std::memory_order_acquire) == TAREFAS_CANCELADAS)
+    {
+        halEncerrarTarefa();
+        return;
+    }
+    if (tarefa.iniciar)
+        tarefa.iniciar();
+    for (;;)
+    {
+        executarPasso(tarefa, contadores[indice]);
+        delay(espera(tarefa));
+    }
+}
+
+bool iniciarTarefas(const Tarefa *tabela, uint8_t quantidade)
+{
+    if (ativas || quantidade > MAX_TAREFAS)
+        return false;
+    tarefas = tabela;
+    quantidadeTarefas = quantidade;
+    liberacao.store(TAREFAS_ESPERANDO, std::memory_order_release);
+
+    for (uint8_t i = 0; i < quantidade; i++)
+    {
+        if (!halCriarTarefa(tabela[i].nome, executarTarefa, (void *)(uintptr_t)i,
+                            tabela[i].pilha, tabela[i].prioridade, tabela[i].nucleo))
+        {
+            REGISTRAR_ERRO("Falha ao criar a tarefa %s: seguindo sem tarefas.", tabela[i].nome);
+            liberacao.store(TAREFAS_CANCELADAS, std::memory_order_release);
+            return false;
+        }
+    }
+
+    ativas = true;
+    liberacao.store(TAREFAS_LIBERADAS, std::memory_order_release);
+    return true;
+}
+
+bool tarefasAtivas()
+{
+    return ativas;
+}
+
+void iniciarPassos(const Tarefa *tabela, uint8_t quantidade)
+{
+    bool feitas[MAX_TAREFAS] = {};
+    for (uint8_t n = 0; n < quantidade && n < MAX_TAREFAS; n++)
+    {
+        int8_t proxima = -1;
+        for (uint8_t i = 0; i < quantidade && i < MAX_TAREFAS; i++)
+            if (!feitas[i] && (proxima < 0 || tabela[i].prioridade > tabela[proxima].prioridade))
+                proxima = i;
+        feitas[proxima] = true;
+        if (tabela[proxima].iniciar)
+            tabela[proxima].iniciar();
+    }
+}
+
+void executarPassos(const Tarefa *tabela, uint8_t quantidade)
+{
+    tarefas = tabela;
+    quantidadeTarefas = quantidade < MAX_TAREFAS ? quantidade : MAX_TAREFAS;
+    for (uint8_t i = 0; i < quantidade && i < MAX_TAREFAS; i++)
+        executarPasso(tabela[i], contadores[i]);
+}
+
+uint8_t numeroTarefas()
+{
+    return quantidadeTarefas;
+}
+
+EstatisticasTarefa estatisticasTarefa(uint8_t indice)
+{
+    EstatisticasTarefa estatisticas = {"", 0, 0, 0};
+    if (indice >= quantidadeTarefas)
+        return estatisticas;
+
+    estatisticas.nome = tarefas[indice].nome;
+    estatisticas.passos = contadores[indice].passos.load(std::memory_order_relaxed);
+    estatisticas.maiorPassoUs = contadores[indice].maiorPassoUs.load(std::memory_order_relaxed);
+    estatisticas.tempoTotalUs = contadores[indice].tempoTotalUs.load(std::memory_order_relaxed);
+    return estatisticas;
+}
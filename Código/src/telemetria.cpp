@@ -0,0 +1,45 @@
+#include "telemetria.h"
+
+MotivoTelemetria Telemetria::avaliar(const bool alarmes[NUM_SENSORES_ALARME], unsigned long agora) const
+{
+    if (!_jaEnviou)
+        return TELEMETRIA_HEARTBEAT;
+
+    for (uint8_t i = 0; i < NUM_SENSORES_ALARME; i++)
+    {
+        // Uma borda dentro do intervalo minimo fica para depois; se o sensor voltar ao
+        // estado publicado antes disso, a oscilacao nem chega ao broker.
+        if (alarmes[i] != _publicado[i] && agora - _ultimaBorda[i] >= _configuracao.intervaloMinimoMs[i])
+            return TELEMETRIA_ALTERACAO;
+    }
+
+    if (agora - _ultimoEnvio >= _configuracao.heartbeatMs)
+        return TELEMETRIA_HEARTBEAT;
+
+    return TELEMETRIA_NENHUM;
+}
+
+void Telemetria::confirmar(const bool alarmes[NUM_SENSORES_ALARME], unsigned long agora)
+{
+    for (uint8_t i = 0; i < NUM_SENSORES_ALARME; i++)
+    {
+        if (_jaEnviou && alarmes[i] != _publicado[i])
+            _ultimaBorda[i] = agora;
+        _publicado[i] = alarmes[i];
+    }
+    _ultimoEnvio = agora;
+    _jaEnviou = true;
+}
+
+const char *Telemetria::nomeMotivo(MotivoTelemetria motivo)
+{
+    switch (motivo)
+    {
+    case TELEMETRIA_ALTERACAO:
+        return "alteracao";
+    case TELEMETRIA_HEARTBEAT:
+        return "heartbeat";
+    default:
+        return "nenhum";
+    }
+}